@@ -306,6 +306,8 @@ public void readExternal(java.io.ObjectInput in) throws java.io.IOException, jav
 %ignore sg_print_warning;
 %ignore sg_print_error;
 %ignore sg_cancel_computations;
+%ignore shogun::Parallel::get_thread_pool;
+%ignore shogun::Parallel::parallel_for;
 
 
 %rename(SGObject) CSGObject;
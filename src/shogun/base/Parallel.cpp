@@ -7,8 +7,10 @@
 
 #include <shogun/base/Parallel.h>
 #include <shogun/lib/RefCount.h>
+#include <shogun/lib/ThreadPool.h>
 #include <shogun/lib/config.h>
 #include <shogun/lib/memory.h>
+#include <shogun/mathematics/Math.h>
 
 #include <thread>
 
@@ -85,6 +87,11 @@ void Parallel::set_num_threads(int32_t n)
 #ifdef HAVE_OPENMP
 	omp_set_num_threads(num_threads);
 #endif
+
+	// restarted with the new number of threads on next use, the old pool
+	// is only stopped once the calls running on it have released it
+	std::lock_guard<std::mutex> guard(m_thread_pool_lock);
+	m_thread_pool.reset();
 }
 
 int32_t Parallel::get_num_threads() const
@@ -92,6 +99,23 @@ int32_t Parallel::get_num_threads() const
 	return num_threads;
 }
 
+std::shared_ptr<ThreadPool> Parallel::get_thread_pool()
+{
+	std::lock_guard<std::mutex> guard(m_thread_pool_lock);
+	if (!m_thread_pool)
+		m_thread_pool=std::make_shared<ThreadPool>(CMath::max(1, num_threads));
+
+	return m_thread_pool;
+}
+
+void Parallel::parallel_for(int64_t begin, int64_t end,
+		const std::function<void(int64_t, int64_t)>& body, int64_t grain)
+{
+	// keeps the pool alive if the number of threads is changed meanwhile
+	std::shared_ptr<ThreadPool> pool=get_thread_pool();
+	pool->parallel_for(begin, end, body, grain);
+}
+
 int32_t Parallel::ref()
 {
 	return m_refcount->ref();
@@ -12,9 +12,14 @@
 
 #include <shogun/lib/common.h>
 
+#include <functional>
+#include <memory>
+#include <mutex>
+
 namespace shogun
 {
 class RefCount;
+class ThreadPool;
 /** @brief Class Parallel provides helper functions for multithreading.
  *
  * For example it can be used to determine the number of CPU cores in your
@@ -48,6 +53,24 @@ public:
 	 */
 	int32_t get_num_threads() const;
 
+	/** get the work-stealing pool shared by all users of this object,
+	 * it is started on first use with get_num_threads() threads. A pool
+	 * replaced by set_num_threads() stays alive as long as it is referenced.
+	 * @return thread pool
+	 */
+	std::shared_ptr<ThreadPool> get_thread_pool();
+
+	/** split the range [begin, end) into chunks and process them in
+	 * parallel on the thread pool, see ThreadPool::parallel_for. Safe to
+	 * nest, nested calls share the threads of the pool.
+	 * @param begin start of the range
+	 * @param end end of the range
+	 * @param body function called with the bounds of each chunk
+	 * @param grain size of the chunks, 0 chooses four chunks per thread
+	 */
+	void parallel_for(int64_t begin, int64_t end,
+			const std::function<void(int64_t, int64_t)>& body, int64_t grain=0);
+
 	/** ref
 	 * @return current ref counter
 	 */
@@ -69,6 +92,12 @@ private:
 
 	/** number of threads */
 	int32_t num_threads;
+
+	/** thread pool, started on first use */
+	std::shared_ptr<ThreadPool> m_thread_pool;
+
+	/** guards m_thread_pool */
+	std::mutex m_thread_pool_lock;
 };
 }
 #endif
@@ -7,6 +7,7 @@
  */
 #include <shogun/lib/config.h>
 
+#include <shogun/base/Parallel.h>
 #include <shogun/base/Parameter.h>
 #include <shogun/base/progress.h>
 #include <shogun/classifier/svm/LibLinear.h>
@@ -17,6 +18,8 @@
 #include <shogun/lib/Time.h>
 #include <shogun/optimization/liblinear/tron.h>
 
+#include <vector>
+
 using namespace shogun;
 
 CLibLinear::CLibLinear() : CLinearMachine()
@@ -45,6 +48,7 @@ CLibLinear::CLibLinear(float64_t C, CDotFeatures* traindat, CLabels* trainlab)
 void CLibLinear::init()
 {
 	set_liblinear_solver_type(L2R_L1LOSS_SVC_DUAL);
+	set_liblinear_parallel_mode(LL_SEQUENTIAL);
 	set_bias_enabled(true);
 	set_C(1, 1);
 	set_max_iterations();
@@ -62,6 +66,9 @@ void CLibLinear::init()
 	SG_ADD(
 	    (machine_int_t*)&liblinear_solver_type, "liblinear_solver_type",
 	    "Type of LibLinear solver.", MS_NOT_AVAILABLE);
+	SG_ADD(
+	    (machine_int_t*)&liblinear_parallel_mode, "liblinear_parallel_mode",
+	    "How the dual solvers use several threads.", MS_NOT_AVAILABLE);
 }
 
 CLibLinear::~CLibLinear()
@@ -260,14 +267,103 @@ bool CLibLinear::train_machine(CFeatures* data)
 #define GETI(i) (y[i] + 1)
 // To support weights for instances, use GETI(i) (i)
 
+// One pass of the coordinate descent over the active instances
+// index[0..active_size), shared by solve_l2r_l1l2_svc and its parallel
+// variant. Instances at a bound whose gradient lies outside the projected
+// gradient range of the previous pass are shrunk, i.e. moved behind
+// active_size. Each step is taken as if scale copies of w moved in the
+// same way, scale is 1 but for LL_REPRODUCIBLE, see
+// solve_l2r_l1l2_svc_parallel.
+
+static void l2r_l1l2_svc_pass(
+    const liblinear_problem* prob, int n, float64_t* w, double* alpha,
+    const int32_t* y, const double* QD, const double* diag,
+    const double* upper_bound, const float64_t* linear_term, double scale,
+    int32_t* index, int32_t& active_size, double PGmax_old, double PGmin_old,
+    double& PGmax_new, double& PGmin_new)
+{
+	PGmax_new = -CMath::INFTY;
+	PGmin_new = CMath::INFTY;
+
+	for (int32_t s = 0; s < active_size; s++)
+	{
+		int32_t i = index[s];
+		int32_t yi = y[i];
+
+		double G = prob->x->dense_dot(i, w, n);
+		if (prob->use_bias)
+			G += w[n];
+
+		if (linear_term)
+			G = G * yi + linear_term[i];
+		else
+			G = G * yi - 1;
+
+		double C = upper_bound[GETI(i)];
+		G += alpha[i] * diag[GETI(i)];
+
+		double PG = 0;
+		if (alpha[i] == 0)
+		{
+			if (G > PGmax_old)
+			{
+				active_size--;
+				CMath::swap(index[s], index[active_size]);
+				s--;
+				continue;
+			}
+			else if (G < 0)
+				PG = G;
+		}
+		else if (alpha[i] == C)
+		{
+			if (G < PGmin_old)
+			{
+				active_size--;
+				CMath::swap(index[s], index[active_size]);
+				s--;
+				continue;
+			}
+			else if (G > 0)
+				PG = G;
+		}
+		else
+			PG = G;
+
+		PGmax_new = CMath::max(PGmax_new, PG);
+		PGmin_new = CMath::min(PGmin_new, PG);
+
+		if (fabs(PG) > 1.0e-12)
+		{
+			double alpha_old = alpha[i];
+			double Q = QD[i];
+			if (scale != 1)
+				Q = diag[GETI(i)] + scale * (QD[i] - diag[GETI(i)]);
+			alpha[i] = CMath::min(CMath::max(alpha[i] - G / Q, 0.0), C);
+			double d = (alpha[i] - alpha_old) * yi * scale;
+
+			prob->x->add_to_dense_vec(d, i, w, n);
+
+			if (prob->use_bias)
+				w[n] += d;
+		}
+	}
+}
+
 void CLibLinear::solve_l2r_l1l2_svc(
     SGVector<float64_t>& w, const liblinear_problem* prob, double eps,
     double Cp, double Cn, LIBLINEAR_SOLVER_TYPE st)
 {
+	if (get_liblinear_parallel_mode() != LL_SEQUENTIAL &&
+	    parallel->get_num_threads() > 1)
+	{
+		solve_l2r_l1l2_svc_parallel(w, prob, eps, Cp, Cn, st);
+		return;
+	}
+
 	int l = prob->l;
 	int w_size = prob->n;
-	int i, s, iter = 0;
-	double C, d, G;
+	int i, iter = 0;
 	double* QD = SG_MALLOC(double, l);
 	int* index = SG_MALLOC(int, l);
 	double* alpha = SG_MALLOC(double, l);
@@ -275,7 +371,6 @@ void CLibLinear::solve_l2r_l1l2_svc(
 	int active_size = l;
 
 	// PG: projected gradient, for shrinking and stopping
-	double PG;
 	double PGmax_old = CMath::INFTY;
 	double PGmin_old = -CMath::INFTY;
 	double PGmax_new, PGmin_new;
@@ -340,66 +435,10 @@ void CLibLinear::solve_l2r_l1l2_svc(
 			CMath::swap(index[i], index[j]);
 		}
 
-		for (s = 0; s < active_size; s++)
-		{
-			i = index[s];
-			int32_t yi = y[i];
-
-			G = prob->x->dense_dot(i, w.vector, n);
-			if (prob->use_bias)
-				G += w.vector[n];
-
-			if (linear_term.vector)
-				G = G * yi + linear_term.vector[i];
-			else
-				G = G * yi - 1;
-
-			C = upper_bound[GETI(i)];
-			G += alpha[i] * diag[GETI(i)];
-
-			PG = 0;
-			if (alpha[i] == 0)
-			{
-				if (G > PGmax_old)
-				{
-					active_size--;
-					CMath::swap(index[s], index[active_size]);
-					s--;
-					continue;
-				}
-				else if (G < 0)
-					PG = G;
-			}
-			else if (alpha[i] == C)
-			{
-				if (G < PGmin_old)
-				{
-					active_size--;
-					CMath::swap(index[s], index[active_size]);
-					s--;
-					continue;
-				}
-				else if (G > 0)
-					PG = G;
-			}
-			else
-				PG = G;
-
-			PGmax_new = CMath::max(PGmax_new, PG);
-			PGmin_new = CMath::min(PGmin_new, PG);
-
-			if (fabs(PG) > 1.0e-12)
-			{
-				double alpha_old = alpha[i];
-				alpha[i] = CMath::min(CMath::max(alpha[i] - G / QD[i], 0.0), C);
-				d = (alpha[i] - alpha_old) * yi;
-
-				prob->x->add_to_dense_vec(d, i, w.vector, n);
-
-				if (prob->use_bias)
-					w.vector[n] += d;
-			}
-		}
+		l2r_l1l2_svc_pass(
+		    prob, n, w.vector, alpha, y, QD, diag, upper_bound,
+		    linear_term.vector, 1, index, active_size, PGmax_old, PGmin_old,
+		    PGmax_new, PGmin_new);
 
 		iter++;
 
@@ -457,6 +496,222 @@ void CLibLinear::solve_l2r_l1l2_svc(
 	SG_FREE(index);
 }
 
+// Parallel variants of the coordinate descent above
+//
+// The instances are shuffled and split into one partition per thread, of
+// about the same number of non-zero features. Every thread runs the updates
+// of the sequential solver, including shrinking, on its own partition.
+//
+// LL_ASYNCHRONOUS: all threads read and update the shared w without
+// locking, as in PASSCoDe-Wild (Hsieh et al., 2015).
+//
+// LL_REPRODUCIBLE: with K partitions, thread k works on a private copy w_k
+// of w and takes its steps as if all partitions moved w in the same way:
+//
+//    alpha_i <- alpha_i - G_i / (K xi^T xi + D_ii),  w_k += K d yi xi
+//
+// After a pass, w is the average of the w_k, which decreases the dual
+// objective just like the sequential steps do (CoCoA+, Ma et al., 2015).
+// Neither the order in which the threads run nor their number of steps
+// in flight changes the result.
+
+void CLibLinear::solve_l2r_l1l2_svc_parallel(
+    SGVector<float64_t>& w, const liblinear_problem* prob, double eps,
+    double Cp, double Cn, LIBLINEAR_SOLVER_TYPE st)
+{
+	int l = prob->l;
+	int w_size = prob->n;
+	int i, s, k, iter = 0;
+	bool reproducible = get_liblinear_parallel_mode() == LL_REPRODUCIBLE;
+	int num_parts = CMath::max(CMath::min(parallel->get_num_threads(), l), 1);
+	double scale = reproducible ? num_parts : 1;
+
+	SGVector<float64_t> QD(l);
+	SGVector<float64_t> alpha(l);
+	SGVector<int32_t> y(l);
+	SGVector<int32_t> index(l);
+
+	double PGmax_old = CMath::INFTY;
+	double PGmin_old = -CMath::INFTY;
+
+	SGVector<float64_t> linear_term;
+	if (linear_term_inited())
+	{
+		linear_term = get_linear_term();
+	}
+
+	double diag[3] = {0.5 / Cn, 0, 0.5 / Cp};
+	double upper_bound[3] = {CMath::INFTY, 0, CMath::INFTY};
+	if (st == L2R_L1LOSS_SVC_DUAL)
+	{
+		diag[0] = 0;
+		diag[2] = 0;
+		upper_bound[0] = Cn;
+		upper_bound[2] = Cp;
+	}
+
+	int n = prob->n;
+
+	if (prob->use_bias)
+		n--;
+
+	for (i = 0; i < w_size; i++)
+		w.vector[i] = 0;
+
+	std::vector<int32_t> nnz(l);
+	int64_t total_nnz = 0;
+	for (i = 0; i < l; i++)
+	{
+		alpha[i] = 0;
+		y[i] = prob->y[i] > 0 ? +1 : -1;
+		QD[i] = diag[GETI(i)];
+
+		QD[i] += prob->x->dot(i, prob->x, i);
+		index[i] = i;
+
+		// one for the overhead of visiting a vector
+		nnz[i] = prob->x->get_nnz_features_for_vector(i) + 1;
+		total_nnz += nnz[i];
+	}
+
+	for (i = 0; i < l; i++)
+		CMath::swap(index[i], index[CMath::random(i, l - 1)]);
+
+	std::vector<int32_t> part_begin(num_parts + 1, l);
+	part_begin[0] = 0;
+	int64_t cumulative_nnz = 0;
+	for (s = 0, k = 1; s < l && k < num_parts; s++)
+	{
+		cumulative_nnz += nnz[index[s]];
+		if (cumulative_nnz * num_parts >= total_nnz * k)
+			part_begin[k++] = s + 1;
+	}
+
+	std::vector<int32_t> active_size(num_parts);
+	for (k = 0; k < num_parts; k++)
+		active_size[k] = part_begin[k + 1] - part_begin[k];
+
+	SGVector<float64_t> PGmax_part(num_parts);
+	SGVector<float64_t> PGmin_part(num_parts);
+	std::vector<SGVector<float64_t>> w_part;
+	if (reproducible)
+	{
+		for (k = 0; k < num_parts; k++)
+			w_part.push_back(SGVector<float64_t>(w_size));
+	}
+
+	auto update_part = [&](int32_t part) {
+		float64_t* wk = reproducible ? w_part[part].vector : w.vector;
+		l2r_l1l2_svc_pass(
+		    prob, n, wk, alpha.vector, y.vector, QD.vector, diag, upper_bound,
+		    linear_term.vector, scale, index.vector + part_begin[part],
+		    active_size[part], PGmax_old, PGmin_old, PGmax_part[part],
+		    PGmin_part[part]);
+	};
+
+	auto pb = SG_PROGRESS(range(10));
+	CTime start_time;
+	while (iter < get_max_iterations())
+	{
+		COMPUTATION_CONTROLLERS
+		if (m_max_train_time > 0 &&
+		    start_time.cur_time_diff() > m_max_train_time)
+			break;
+
+		// shuffling stays on this thread, so that the order is reproducible
+		for (k = 0; k < num_parts; k++)
+		{
+			int32_t* part_index = index.vector + part_begin[k];
+			for (i = 0; i < active_size[k]; i++)
+			{
+				int j = CMath::random(i, active_size[k] - 1);
+				CMath::swap(part_index[i], part_index[j]);
+			}
+
+			if (reproducible)
+				sg_memcpy(w_part[k].vector, w.vector, sizeof(float64_t) * w_size);
+		}
+
+		parallel->parallel_for(
+		    0, num_parts,
+		    [&](int64_t first, int64_t last) {
+			    for (int64_t part = first; part < last; part++)
+				    update_part(part);
+		    },
+		    1);
+
+		if (reproducible)
+		{
+			parallel->parallel_for(
+			    0, w_size, [&](int64_t first, int64_t last) {
+				    for (int64_t j = first; j < last; j++)
+				    {
+					    double sum = 0;
+					    for (int32_t part = 0; part < num_parts; part++)
+						    sum += w_part[part].vector[j];
+					    w.vector[j] = sum / num_parts;
+				    }
+			    });
+		}
+
+		double PGmax_new = -CMath::INFTY;
+		double PGmin_new = CMath::INFTY;
+		int total_active_size = 0;
+		for (k = 0; k < num_parts; k++)
+		{
+			PGmax_new = CMath::max(PGmax_new, PGmax_part[k]);
+			PGmin_new = CMath::min(PGmin_new, PGmin_part[k]);
+			total_active_size += active_size[k];
+		}
+
+		iter++;
+
+		float64_t gap=PGmax_new - PGmin_new;
+		pb.print_absolute(
+		    gap, -CMath::log10(gap), -CMath::log10(1), -CMath::log10(eps));
+
+		if (gap <= eps)
+		{
+			if (total_active_size == l)
+				break;
+			else
+			{
+				for (k = 0; k < num_parts; k++)
+					active_size[k] = part_begin[k + 1] - part_begin[k];
+				PGmax_old = CMath::INFTY;
+				PGmin_old = -CMath::INFTY;
+				continue;
+			}
+		}
+		PGmax_old = PGmax_new;
+		PGmin_old = PGmin_new;
+		if (PGmax_old <= 0)
+			PGmax_old = CMath::INFTY;
+		if (PGmin_old >= 0)
+			PGmin_old = -CMath::INFTY;
+	}
+
+	pb.complete_absolute();
+	SG_INFO("optimization finished, #iter = %d\n",iter)
+	if (iter >= get_max_iterations())
+		SG_WARNING("reaching max number of iterations\n")
+
+	// calculate objective value
+
+	double v = 0;
+	int nSV = 0;
+	for (i = 0; i < w_size; i++)
+		v += w.vector[i] * w.vector[i];
+	for (i = 0; i < l; i++)
+	{
+		v += alpha[i] * (alpha[i] * diag[GETI(i)] - 2);
+		if (alpha[i] > 0)
+			++nSV;
+	}
+	SG_INFO("Objective value = %lf\n", v / 2)
+	SG_INFO("nSV = %d\n", nSV)
+}
+
 // A coordinate descent algorithm for
 // L1-regularized L2-loss support vector classification
 //
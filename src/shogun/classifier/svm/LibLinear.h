@@ -37,6 +37,23 @@ namespace shogun
 		L2R_LR_DUAL
 	};
 
+	/** how the dual coordinate descent solvers (L2R_L2LOSS_SVC_DUAL and
+	 * L2R_L1LOSS_SVC_DUAL) use several threads
+	 */
+	enum LIBLINEAR_PARALLEL_MODE
+	{
+		/// a single thread, the original solver
+		LL_SEQUENTIAL,
+		/// every thread updates the alphas of its own partition of the
+		/// vectors and all of them add to the shared w without locking
+		/// (PASSCoDe-Wild), fastest but results vary between runs
+		LL_ASYNCHRONOUS,
+		/// every thread takes steps on a private copy of w, scaled so
+		/// that the copies can be averaged after each pass (CoCoA+), gives
+		/// the same result for the same number of threads
+		LL_REPRODUCIBLE
+	};
+
 	/** @brief This class provides an interface to the LibLinear library for
 	 * large-
 	 * scale linear learning focusing on SVM [1]. This is the classification
@@ -99,6 +116,24 @@ namespace shogun
 			liblinear_solver_type = st;
 		}
 
+		/** @return how the dual solvers use several threads */
+		inline LIBLINEAR_PARALLEL_MODE get_liblinear_parallel_mode()
+		{
+			return liblinear_parallel_mode;
+		}
+
+		/** set how the dual coordinate descent solvers use several
+		 * threads. The training vectors are split into one partition
+		 * per thread of the parallel object, balanced by their number
+		 * of non-zero features.
+		 *
+		 * @param mode parallel mode, LL_SEQUENTIAL by default
+		 */
+		inline void set_liblinear_parallel_mode(LIBLINEAR_PARALLEL_MODE mode)
+		{
+			liblinear_parallel_mode = mode;
+		}
+
 		/** get classifier type
 		 *
 		 * @return the classifier type
@@ -232,6 +267,9 @@ namespace shogun
 		void solve_l2r_l1l2_svc(
 		    SGVector<float64_t>& w, const liblinear_problem* prob, double eps,
 		    double Cp, double Cn, LIBLINEAR_SOLVER_TYPE st);
+		void solve_l2r_l1l2_svc_parallel(
+		    SGVector<float64_t>& w, const liblinear_problem* prob, double eps,
+		    double Cp, double Cn, LIBLINEAR_SOLVER_TYPE st);
 
 		void solve_l1r_l2_svc(
 		    SGVector<float64_t>& w, liblinear_problem* prob_col, double eps,
@@ -260,6 +298,9 @@ namespace shogun
 
 		/** solver type */
 		LIBLINEAR_SOLVER_TYPE liblinear_solver_type;
+
+		/** parallel mode of the dual solvers */
+		LIBLINEAR_PARALLEL_MODE liblinear_parallel_mode;
 	};
 
 } /* namespace shogun  */
@@ -108,10 +108,23 @@ void COnlineLibLinear::start_train()
 
 	v = 0;
 	nSV = 0;
+
+	learner_stats_t stats = {PGmax_new, PGmin_new, v, nSV};
+	learner_stats.assign(m_num_learners, stats);
 }
 
 void COnlineLibLinear::stop_train()
 {
+	if (m_num_learners > 1)
+	{
+		for (const auto& stats : learner_stats)
+		{
+			PGmax_new = CMath::max(PGmax_new, stats.PGmax_new);
+			PGmin_new = CMath::min(PGmin_new, stats.PGmin_new);
+			nSV += stats.nSV;
+		}
+	}
+
 	float64_t gap = PGmax_new - PGmin_new;
 
 	SG_DONE()
@@ -194,70 +207,72 @@ void COnlineLibLinear::train_one(SGVector<float32_t> ex, float64_t label)
 
 void COnlineLibLinear::train_one(SGSparseVector<float32_t> ex, float64_t label)
 {
-	alpha_current = 0;
+	learner_stats_t stats = {PGmax_new, PGmin_new, v, nSV};
+	dual_step(ex, label, m_w.vector, bias, stats);
+
+	PGmax_new = stats.PGmax_new;
+	PGmin_new = stats.PGmin_new;
+	v = stats.v;
+	nSV = stats.nSV;
+}
+
+void COnlineLibLinear::train_learner_example(int32_t learner,
+	const SGSparseVector<float32_t>& example, float64_t label, float32_t* w,
+	float32_t& b)
+{
+	dual_step(example, label, w, b, learner_stats[learner]);
+}
+
+void COnlineLibLinear::dual_step(const SGSparseVector<float32_t>& ex,
+	float64_t label, float32_t* w, float32_t& b, learner_stats_t& stats) const
+{
+	float64_t alpha = 0;
 	int32_t y_current = 0;
 	if (label > 0)
 		y_current = +1;
 	else
 		y_current = -1;
 
-	QD = diag[y_current + 1];
+	float64_t qd = diag[y_current + 1];
 	// Dot product of vector with itself
-	QD += SGSparseVector<float32_t>::sparse_dot(ex, ex);
+	qd += SGSparseVector<float32_t>::sparse_dot(ex, ex);
 
 	// Dot product of vector with learned weights
-	G = ex.dense_dot(1.0,m_w.vector,m_w.vlen,0.0);
+	float64_t g = 0;
+	for (int32_t i=0; i < ex.num_feat_entries; i++)
+		g += w[ex.features[i].feat_index]*ex.features[i].entry;
 
 	if (use_bias)
-		G += bias;
-	G = G*y_current - 1;
-	// LINEAR TERM PART?
+		g += b;
+	g = g*y_current - 1;
 
-	C = upper_bound[y_current + 1];
-	G += alpha_current*diag[y_current + 1]; // Can be eliminated, since diag = 0 vector
+	float64_t c = upper_bound[y_current + 1];
 
-	PG = 0;
-	if (alpha_current == 0) // This condition will always be true in the online version
-	{
-		if (G > PGmax_old)
-		{
-			return;
-		}
-		else if (G < 0)
-			PG = G;
-	}
-	else if (alpha_current == C)
-	{
-		if (G < PGmin_old)
-		{
-			return;
-		}
-		else if (G > 0)
-			PG = G;
-	}
-	else
-		PG = G;
+	// alpha is always 0 in the online version
+	float64_t pg = 0;
+	if (g > PGmax_old)
+		return;
+	else if (g < 0)
+		pg = g;
 
-	PGmax_new = CMath::max(PGmax_new, PG);
-	PGmin_new = CMath::min(PGmin_new, PG);
+	stats.PGmax_new = CMath::max(stats.PGmax_new, pg);
+	stats.PGmin_new = CMath::min(stats.PGmin_new, pg);
 
-	if (fabs(PG) > 1.0e-12)
+	if (fabs(pg) > 1.0e-12)
 	{
-		float64_t alpha_old = alpha_current;
-		alpha_current = CMath::min(CMath::max(alpha_current - G/QD, 0.0), C);
-		d = (alpha_current - alpha_old) * y_current;
+		alpha = CMath::min(CMath::max(-g/qd, 0.0), c);
+		float64_t step = alpha * y_current;
 
 		for (int32_t i=0; i < ex.num_feat_entries; i++)
-			m_w[ex.features[i].feat_index] += d*ex.features[i].entry;
-
+			w[ex.features[i].feat_index] += step*ex.features[i].entry;
 
 		if (use_bias)
-			bias += d;
+			b += step;
 	}
 
-	v += alpha_current*(alpha_current*diag[y_current + 1] - 2);
-	if (alpha_current > 0)
-		nSV++;
+	stats.v += alpha*(alpha*diag[y_current + 1] - 2);
+	if (alpha > 0)
+		stats.nSV++;
 }
 
 void COnlineLibLinear::train_example(CStreamingDotFeatures *feature, float64_t label)
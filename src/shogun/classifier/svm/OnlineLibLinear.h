@@ -121,7 +121,34 @@ public:
 		 */
 		virtual void train_example(CStreamingDotFeatures *feature, float64_t label);
 
+protected:
+		/** train a learner on one example, see
+		 * COnlineLinearMachine::set_num_learners()
+		 *
+		 * @param learner index of the learner
+		 * @param example example
+		 * @param label label of the example
+		 * @param w weights of the learner
+		 * @param b bias of the learner
+		 */
+		virtual void train_learner_example(int32_t learner,
+				const SGSparseVector<float32_t>& example, float64_t label,
+				float32_t* w, float32_t& b);
+
 private:
+		/** optimization statistics of a learner */
+		struct learner_stats_t
+		{
+			/** maximum projected gradient */
+			float64_t PGmax_new;
+			/** minimum projected gradient */
+			float64_t PGmin_new;
+			/** objective value times two */
+			float64_t v;
+			/** number of support vectors */
+			int32_t nSV;
+		};
+
 		/** Set up parameters */
 		void init();
 
@@ -138,6 +165,17 @@ private:
 		 */
 		void train_one(SGSparseVector<float32_t> ex, float64_t label);
 
+		/** dual coordinate step on one *sparse* vector, which only
+		 * touches the arguments
+		 * @param ex the example being trained
+		 * @param label label of this example
+		 * @param w weights to update
+		 * @param b bias to update
+		 * @param stats statistics to update
+		 */
+		void dual_step(const SGSparseVector<float32_t>& ex, float64_t label,
+				float32_t* w, float32_t& b, learner_stats_t& stats) const;
+
 private:
 		/// use bias or not
 		bool use_bias;
@@ -175,6 +213,9 @@ private:
 		float64_t v;
 		// Number of support vectors
 		int32_t nSV;
+
+		// Statistics of each learner when training with several
+		std::vector<learner_stats_t> learner_stats;
 };
 }
 #endif // _ONLINELIBLINEAR_H__
@@ -95,40 +95,45 @@ bool COnlineSVMSGD::train(CFeatures* data)
 		COMPUTATION_CONTROLLERS
 		vec_count=0;
 		count = skip;
-		while (features->get_next_example())
+		if (m_num_learners>1)
+			train_learners();
+		else
 		{
-			vec_count++;
-			// Expand w vector if more features are seen in this example
-			features->expand_if_required(m_w.vector, m_w.vlen);
+			while (features->get_next_example())
+			{
+				vec_count++;
+				// Expand w vector if more features are seen in this example
+				features->expand_if_required(m_w.vector, m_w.vlen);
 
-			float64_t eta = 1.0 / (lambda * t);
-			float64_t y = features->get_label();
-			float64_t z = y * (features->dense_dot(m_w.vector, m_w.vlen) + bias);
+				float64_t eta = 1.0 / (lambda * t);
+				float64_t y = features->get_label();
+				float64_t z = y * (features->dense_dot(m_w.vector, m_w.vlen) + bias);
 
-			if (z < 1 || is_log_loss)
-			{
-				float64_t etd = -eta * loss->first_derivative(z,1);
-				features->add_to_dense_vec(etd * y / wscale, m_w.vector, m_w.vlen);
+				if (z < 1 || is_log_loss)
+				{
+					float64_t etd = -eta * loss->first_derivative(z,1);
+					features->add_to_dense_vec(etd * y / wscale, m_w.vector, m_w.vlen);
+
+					if (use_bias)
+					{
+						if (use_regularized_bias)
+							bias *= 1 - eta * lambda * bscale;
+						bias += etd * y * bscale;
+					}
+				}
 
-				if (use_bias)
+				if (--count <= 0)
 				{
-					if (use_regularized_bias)
-						bias *= 1 - eta * lambda * bscale;
-					bias += etd * y * bscale;
+					float32_t r = 1 - eta * lambda * skip;
+					if (r < 0.8)
+						r = pow(1 - eta * lambda, skip);
+					linalg::scale(m_w, m_w, r);
+					count = skip;
 				}
-			}
+				t++;
 
-			if (--count <= 0)
-			{
-				float32_t r = 1 - eta * lambda * skip;
-				if (r < 0.8)
-					r = pow(1 - eta * lambda, skip);
-				linalg::scale(m_w, m_w, r);
-				count = skip;
+				features->release_example();
 			}
-			t++;
-
-			features->release_example();
 		}
 
 		// If the stream is seekable, reset the stream to the first
@@ -147,6 +152,51 @@ bool COnlineSVMSGD::train(CFeatures* data)
 	return true;
 }
 
+void COnlineSVMSGD::train_learner_example(int32_t learner,
+	const SGSparseVector<float32_t>& example, float64_t label, float32_t* w,
+	float32_t& b)
+{
+	ELossType loss_type = loss->get_loss_type();
+	bool is_log_loss = (loss_type == L_LOGLOSS) || (loss_type == L_LOGLOSSMARGIN);
+
+	float64_t eta = 1.0 / (lambda * t);
+	float64_t y = label;
+	float64_t dot = 0;
+	for (index_t i=0; i<example.num_feat_entries; i++)
+		dot += w[example.features[i].feat_index] * example.features[i].entry;
+	float64_t z = y * (dot + b);
+
+	if (z < 1 || is_log_loss)
+	{
+		float64_t etd = -eta * loss->first_derivative(z,1);
+		float32_t scale = etd * y / wscale;
+		for (index_t i=0; i<example.num_feat_entries; i++)
+			w[example.features[i].feat_index] += scale * example.features[i].entry;
+
+		if (use_bias)
+		{
+			if (use_regularized_bias)
+				b *= 1 - eta * lambda * bscale;
+			b += etd * y * bscale;
+		}
+	}
+}
+
+void COnlineSVMSGD::end_learner_batch(int32_t num_examples)
+{
+	float64_t eta = 1.0 / (lambda * t);
+	count -= num_examples;
+	while (count <= 0)
+	{
+		float32_t r = 1 - eta * lambda * skip;
+		if (r < 0.8)
+			r = pow(1 - eta * lambda, skip);
+		linalg::scale(m_w, m_w, r);
+		count += skip;
+	}
+	t += num_examples;
+}
+
 void COnlineSVMSGD::calibrate(int32_t max_vec_num)
 {
 	int32_t c_dim=1;
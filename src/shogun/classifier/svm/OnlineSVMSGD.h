@@ -149,6 +149,25 @@ class COnlineSVMSGD : public COnlineLinearMachine
 		 * */
 		void calibrate(int32_t max_vec_num=1000);
 
+		/** sgd step of a learner on one example, the step size is fixed
+		 * during a batch
+		 *
+		 * @param learner index of the learner
+		 * @param example example
+		 * @param label label of the example
+		 * @param w weights of the learner
+		 * @param b bias of the learner
+		 */
+		virtual void train_learner_example(int32_t learner,
+				const SGSparseVector<float32_t>& example, float64_t label,
+				float32_t* w, float32_t& b);
+
+		/** apply the weight decay of a batch and advance the step count
+		 *
+		 * @param num_examples number of examples in the batch
+		 */
+		virtual void end_learner_batch(int32_t num_examples);
+
 	private:
 		void init();
 
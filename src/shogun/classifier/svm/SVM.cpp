@@ -36,6 +36,7 @@ CSVM::CSVM(float64_t C, CKernel* k, CLabels* lab)
 CSVM::~CSVM()
 {
 	SG_UNREF(mkl);
+	SG_UNREF(m_row_cache);
 }
 
 void CSVM::set_defaults(int32_t num_sv)
@@ -55,9 +56,12 @@ void CSVM::set_defaults(int32_t num_sv)
 			MS_NOT_AVAILABLE);
 	SG_ADD(&m_linear_term, "linear_term", "Linear term in qp.",
 			MS_NOT_AVAILABLE);
+	SG_ADD((CSGObject**) &m_row_cache, "row_cache",
+			"Kernel row cache shared with other solvers.", MS_NOT_AVAILABLE);
 
 	callback=NULL;
 	mkl=NULL;
+	m_row_cache=NULL;
 
 	set_loaded_status(false);
 
@@ -325,3 +329,16 @@ SGVector<float64_t> CSVM::get_linear_term()
 {
 	return m_linear_term;
 }
+
+void CSVM::set_row_cache(CKernelRowCache* row_cache)
+{
+	SG_REF(row_cache);
+	SG_UNREF(m_row_cache);
+	m_row_cache=row_cache;
+}
+
+CKernelRowCache* CSVM::get_row_cache()
+{
+	SG_REF(m_row_cache);
+	return m_row_cache;
+}
@@ -13,6 +13,7 @@
 #include <shogun/lib/common.h>
 #include <shogun/features/Features.h>
 #include <shogun/kernel/Kernel.h>
+#include <shogun/kernel/KernelRowCache.h>
 #include <shogun/machine/KernelMachine.h>
 
 namespace shogun
@@ -86,6 +87,21 @@ class CSVM : public CKernelMachine
 		 */
 		virtual void set_linear_term(const SGVector<float64_t> linear_term);
 
+		/** set a kernel row cache that the solver fetches kernel rows from
+		 * instead of computing them itself. A single cache can be shared by
+		 * any number of SVMs that are trained on the same kernel, also
+		 * concurrently. Cached rows have to be dropped via
+		 * CKernelRowCache::clear() when the kernel is initialized with
+		 * other features. Currently used by the LibSVM based solvers.
+		 *
+		 * @param row_cache row cache of the kernel of this SVM, NULL to not
+		 * use a shared cache
+		 */
+		void set_row_cache(CKernelRowCache* row_cache);
+
+		/** @return shared kernel row cache or NULL if none is set */
+		CKernelRowCache* get_row_cache();
+
 
 		/** load a SVM from file
 		 * @param svm_file the file handle
@@ -257,6 +273,9 @@ class CSVM : public CKernelMachine
 		/** linear term in qp */
 		SGVector<float64_t> m_linear_term;
 
+		/** kernel row cache shared with other solvers */
+		CKernelRowCache* m_row_cache;
+
 		/** if SVM is loaded */
 		bool svm_loaded;
 		/** epsilon */
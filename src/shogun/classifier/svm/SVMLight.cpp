@@ -58,6 +58,9 @@
 
 using namespace shogun;
 
+// minimal number of active examples per chunk when updating lin from cached rows
+#define UPDATE_LINEAR_GRAIN 8192
+
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 struct S_THREAD_PARAM_REACTIVATE_LINADD
 {
@@ -1472,54 +1475,24 @@ void CSVMLight::update_linear_component(
 
 			if (num_working>0)
 			{
-				// TODO: port to use OpenMP backend instead of pthread
-#ifdef HAVE_PTHREAD
-				int32_t num_threads=parallel->get_num_threads();
-#else
-				int32_t num_threads=1;
-#endif
-				if (num_threads < 2)
-				{
-					for (jj=0;(j=active2dnum[jj])>=0;jj++) {
-						lin[j]+=kernel->compute_optimized(docs[j]);
-					}
-				}
-#ifdef HAVE_PTHREAD
-				else
-				{
-					int32_t num_elem = 0 ;
-					for (jj=0;(j=active2dnum[jj])>=0;jj++) num_elem++ ;
+				int32_t num_active=0;
+				while (active2dnum[num_active]>=0)
+					num_active++;
 
-					pthread_t* threads = SG_MALLOC(pthread_t, num_threads-1);
-					S_THREAD_PARAM_SVMLIGHT* params = SG_MALLOC(S_THREAD_PARAM_SVMLIGHT, num_threads-1);
-					int32_t start = 0 ;
-					int32_t step = num_elem/num_threads;
-					int32_t end = step ;
-
-					for (int32_t t=0; t<num_threads-1; t++)
-					{
-						params[t].kernel = kernel ;
-						params[t].lin = lin ;
-						params[t].docs = docs ;
-						params[t].active2dnum=active2dnum ;
-						params[t].start = start ;
-						params[t].end = end ;
-						start=end ;
-						end+=step ;
-						pthread_create(&threads[t], NULL, update_linear_component_linadd_helper, (void*)&params[t]) ;
-					}
-
-					for (jj=params[num_threads-2].end;(j=active2dnum[jj])>=0;jj++) {
-						lin[j]+=kernel->compute_optimized(docs[j]);
-					}
-					void* ret;
-					for (int32_t t=0; t<num_threads-1; t++)
-						pthread_join(threads[t], &ret) ;
-
-					SG_FREE(params);
-					SG_FREE(threads);
-				}
-#endif
+				// entries of lin are independent, chunks of the active set
+				// are updated on the thread pool
+				parallel->parallel_for(0, num_active, [&](int64_t start, int64_t end)
+				{
+					S_THREAD_PARAM_SVMLIGHT params;
+					params.kernel=kernel;
+					params.lin=lin;
+					params.docs=docs;
+					params.active2dnum=active2dnum;
+					params.start=start;
+					params.end=end;
+
+					update_linear_component_linadd_helper(&params);
+				});
 			}
 		}
 	}
@@ -1531,11 +1504,27 @@ void CSVMLight::update_linear_component(
 					a, a_old, working2dnum, totdoc,	lin, aicache);
 		}
 		else {
+			int32_t num_active=0;
+			while (active2dnum[num_active]>=0)
+				num_active++;
+
+			// rows of the working set are in the kernel cache already (see
+			// cache_multiple_kernel_rows in optimize loop), only the O(l)
+			// update of the active set is worth splitting
+			int64_t grain=CMath::max(int64_t(UPDATE_LINEAR_GRAIN),
+				int64_t(num_active/parallel->get_num_threads()+1));
 			for (jj=0;(i=working2dnum[jj])>=0;jj++) {
 				if(a[i] != a_old[i]) {
 					kernel->get_kernel_row(i,active2dnum,aicache);
-					for (ii=0;(j=active2dnum[ii])>=0;ii++)
-						lin[j]+=(a[i]-a_old[i])*aicache[j]*(float64_t)label[i];
+					float64_t coef=(a[i]-a_old[i])*(float64_t)label[i];
+					parallel->parallel_for(0, num_active, [&](int64_t start, int64_t end)
+					{
+						for (int64_t k=start; k<end; k++)
+						{
+							int32_t idx=active2dnum[k];
+							lin[idx]+=coef*aicache[idx];
+						}
+					}, grain);
 				}
 			}
 		}
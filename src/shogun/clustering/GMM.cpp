@@ -7,6 +7,7 @@
  */
 #include <shogun/lib/config.h>
 
+#include <shogun/base/Parallel.h>
 #include <shogun/base/Parameter.h>
 #include <shogun/base/progress.h>
 #include <shogun/base/some.h>
@@ -15,13 +16,48 @@
 #include <shogun/distance/EuclideanDistance.h>
 #include <shogun/labels/MulticlassLabels.h>
 #include <shogun/mathematics/Math.h>
+#include <shogun/mathematics/eigen3.h>
 #include <shogun/mathematics/linalg/LinalgNamespace.h>
 #include <shogun/multiclass/KNN.h>
+#include <functional>
 #include <vector>
 
 using namespace shogun;
 using namespace std;
 
+/** log(exp(a)+exp(b)) */
+static float64_t log_add(float64_t a, float64_t b)
+{
+	if (a<b)
+		std::swap(a, b);
+	if (a==-CMath::INFTY)
+		return a;
+	return a+std::log1p(std::exp(b-a));
+}
+
+/** sum body(first, last, sum) over [0, num) in parallel. Each chunk adds to
+ * its own partial sum and the partial sums are added in chunk order, so the
+ * result does not depend on the scheduling
+ */
+template <class T>
+static T parallel_sum(Parallel* parallel, int64_t num, const T& zero,
+		const std::function<void(int64_t, int64_t, T&)>& body)
+{
+	int64_t num_chunks=CMath::max<int64_t>(1,
+			CMath::min<int64_t>(parallel->get_num_threads(), num/1024));
+	int64_t grain=(num+num_chunks-1)/num_chunks;
+	std::vector<T> partial(num_chunks, zero);
+	parallel->parallel_for(0, num, [&](int64_t first, int64_t last)
+	{
+		body(first, last, partial[first/grain]);
+	}, grain);
+
+	T result=zero;
+	for (const auto& p: partial)
+		result+=p;
+	return result;
+}
+
 CGMM::CGMM() : CDistribution(), m_components(),	m_coefficients()
 {
 	register_params();
@@ -147,38 +183,29 @@ float64_t CGMM::train_em(float64_t min_cov, int32_t max_iter, float64_t min_chan
 	int32_t iter=0;
 	float64_t log_likelihood_prev=0;
 	float64_t log_likelihood_cur=0;
-	SGVector<float64_t> logPxy(num_vectors * m_components.size());
-	SGVector<float64_t> logPx(num_vectors);
-	//float64_t* logPost=SG_MALLOC(float64_t, num_vectors*m_components.vlen);
+	index_t num_components=m_components.size();
 	auto pb = SG_PROGRESS(range(max_iter));
 	while (iter<max_iter)
 	{
 		log_likelihood_prev=log_likelihood_cur;
 		log_likelihood_cur=0;
 
+		SGMatrix<float64_t> logPxy=log_joint_densities(m_components, m_coefficients);
+		SGVector<float64_t> logPx=log_sum_exp(logPxy);
 		for (int32_t i=0; i<num_vectors; i++)
-		{
-			logPx[i]=0;
-			SGVector<float64_t> v=dotdata->get_computed_dot_feature_vector(i);
-			for (int32_t j=0; j<int32_t(m_components.size()); j++)
-			{
-				logPxy[index_t(i * m_components.size() + j)] =
-				    m_components[j]->compute_log_PDF(v) +
-				    std::log(m_coefficients[j]);
-				logPx[i] +=
-				    std::exp(logPxy[index_t(i * m_components.size() + j)]);
-			}
-
-			logPx[i] = std::log(logPx[i]);
 			log_likelihood_cur+=logPx[i];
 
-			for (int32_t j=0; j<int32_t(m_components.size()); j++)
+		parallel->parallel_for(0, num_vectors, [&](int64_t first, int64_t last)
+		{
+			for (int64_t i=first; i<last; i++)
 			{
-				//logPost[i*m_components.vlen+j]=logPxy[i*m_components.vlen+j]-logPx[i];
-				alpha.matrix[i * m_components.size() + j] = std::exp(
-				    logPxy[index_t(i * m_components.size() + j)] - logPx[i]);
+				for (index_t j=0; j<num_components; j++)
+				{
+					alpha.matrix[i*num_components+j]=
+						std::exp(logPxy(i, j)-logPx[i]);
+				}
 			}
-		}
+		});
 
 		if (iter>0 && log_likelihood_cur-log_likelihood_prev<min_change)
 			break;
@@ -205,9 +232,7 @@ float64_t CGMM::train_smem(int32_t max_iter, int32_t max_cand, float64_t min_cov
 	float64_t cur_likelihood=train_em(min_cov, max_em_iter, min_change);
 
 	int32_t iter=0;
-	SGVector<float64_t> logPxy(num_vectors * m_components.size());
-	SGVector<float64_t> logPx(num_vectors);
-	SGVector<float64_t> logPost(num_vectors * m_components.size());
+	index_t num_components=m_components.size();
 	SGVector<float64_t> logPostSum(m_components.size());
 	SGVector<float64_t> logPostSum2(m_components.size());
 	SGVector<float64_t> logPostSumSum(
@@ -222,63 +247,59 @@ float64_t CGMM::train_smem(int32_t max_iter, int32_t max_cand, float64_t min_cov
 	auto pb = SG_PROGRESS(range(max_iter));
 	while (iter<max_iter)
 	{
-		linalg::zero(logPostSum);
-		linalg::zero(logPostSum2);
-		linalg::zero(logPostSumSum);
-		for (int32_t i=0; i<num_vectors; i++)
+		SGMatrix<float64_t> logPxy=log_joint_densities(m_components, m_coefficients);
+		SGVector<float64_t> logPx=log_sum_exp(logPxy);
+
+		/* posteriors, their sums and the sums of their pairwise products,
+		 * the latter as one rank update per chunk of vectors */
+		Eigen::MatrixXd post(num_vectors, num_components);
+		parallel->parallel_for(0, num_components, [&](int64_t first, int64_t last)
 		{
-			logPx[i]=0;
-			SGVector<float64_t> v=dotdata->get_computed_dot_feature_vector(i);
-			for (int32_t j=0; j<int32_t(m_components.size()); j++)
+			for (int64_t j=first; j<last; j++)
 			{
-				logPxy[index_t(i * m_components.size() + j)] =
-				    m_components[j]->compute_log_PDF(v) +
-				    std::log(m_coefficients[j]);
-				logPx[i] +=
-				    std::exp(logPxy[index_t(i * m_components.size() + j)]);
+				for (index_t i=0; i<num_vectors; i++)
+					post(i, j)=std::exp(logPxy(i, j)-logPx[i]);
 			}
+		}, 1);
 
-			logPx[i] = std::log(logPx[i]);
-
-			for (int32_t j=0; j<int32_t(m_components.size()); j++)
+		Eigen::MatrixXd post_products=parallel_sum<Eigen::MatrixXd>(parallel,
+			num_vectors, Eigen::MatrixXd::Zero(num_components, num_components),
+			[&](int64_t first, int64_t last, Eigen::MatrixXd& sum)
 			{
-				logPost[index_t(i * m_components.size() + j)] =
-				    logPxy[index_t(i * m_components.size() + j)] - logPx[i];
-				logPostSum[j] +=
-				    std::exp(logPost[index_t(i * m_components.size() + j)]);
-				logPostSum2[j] +=
-				    std::exp(2 * logPost[index_t(i * m_components.size() + j)]);
-			}
+				sum.selfadjointView<Eigen::Lower>().rankUpdate(
+					post.middleRows(first, last-first).transpose());
+			});
 
-			int32_t counter=0;
-			for (int32_t j=0; j<int32_t(m_components.size()); j++)
+		int32_t counter=0;
+		for (index_t j=0; j<num_components; j++)
+		{
+			logPostSum[j]=post.col(j).sum();
+			logPostSum2[j]=post_products(j, j);
+			for (index_t k=j+1; k<num_components; k++)
+				logPostSumSum[counter++]=post_products(k, j);
+		}
+
+		parallel->parallel_for(0, num_components, [&](int64_t first, int64_t last)
+		{
+			for (int64_t i=first; i<last; i++)
 			{
-				for (int32_t k=j+1; k<int32_t(m_components.size()); k++)
+				float64_t log_post_sum=std::log(logPostSum[i]);
+				float64_t log_coef=std::log(m_coefficients[i]);
+				float64_t crit=0;
+				for (index_t j=0; j<num_vectors; j++)
 				{
-					logPostSumSum[counter] += std::exp(
-					    logPost[index_t(i * m_components.size() + j)] +
-					    logPost[index_t(i * m_components.size() + k)]);
-					counter++;
+					float64_t log_post=logPxy(j, i)-logPx[j];
+					crit+=(log_post-log_post_sum-logPxy(j, i)+log_coef)*
+						post(j, i)/logPostSum[i];
 				}
+				split_crit[i]=crit;
+				split_ind[i]=i;
 			}
-		}
+		}, 1);
 
-		int32_t counter=0;
+		counter=0;
 		for (int32_t i=0; i<int32_t(m_components.size()); i++)
 		{
-			logPostSum[i] = std::log(logPostSum[i]);
-			split_crit[i]=0;
-			split_ind[i]=i;
-			for (int32_t j=0; j<num_vectors; j++)
-			{
-				split_crit[i] +=
-				    (logPost[index_t(j * m_components.size() + i)] -
-				     logPostSum[i] -
-				     logPxy[index_t(j * m_components.size() + i)] +
-				     std::log(m_coefficients[i])) *
-				    (std::exp(logPost[index_t(j * m_components.size() + i)]) /
-				     std::exp(logPostSum[i]));
-			}
 			for (int32_t j=i+1; j<int32_t(m_components.size()); j++)
 			{
 				merge_crit[counter] = std::log(logPostSumSum[counter]) -
@@ -347,43 +368,30 @@ void CGMM::partial_em(int32_t comp1, int32_t comp2, int32_t comp3, float64_t min
 	CDotFeatures* dotdata=(CDotFeatures *) features;
 	int32_t num_vectors=dotdata->get_num_vectors();
 
-	SGVector<float64_t> init_logPxy(num_vectors * m_components.size());
-	SGVector<float64_t> init_logPx(num_vectors);
+	SGMatrix<float64_t> init_logPxy=log_joint_densities(m_components, m_coefficients);
 	SGVector<float64_t> init_logPx_fix(num_vectors);
 	SGVector<float64_t> post_add(num_vectors);
 
-	for (int32_t i=0; i<num_vectors; i++)
+	/* log density of the components which are kept and log posterior of the
+	 * three which are split and merged */
+	parallel->parallel_for(0, num_vectors, [&](int64_t first, int64_t last)
 	{
-		init_logPx[i]=0;
-		init_logPx_fix[i]=0;
-
-		SGVector<float64_t> v=dotdata->get_computed_dot_feature_vector(i);
-		for (int32_t j=0; j<int32_t(m_components.size()); j++)
+		for (int64_t i=first; i<last; i++)
 		{
-			init_logPxy[index_t(i * m_components.size() + j)] =
-			    m_components[j]->compute_log_PDF(v) +
-			    std::log(m_coefficients[j]);
-			init_logPx[i] +=
-			    std::exp(init_logPxy[index_t(i * m_components.size() + j)]);
-			if (j!=comp1 && j!=comp2 && j!=comp3)
+			float64_t fixed=-CMath::INFTY;
+			float64_t moved=-CMath::INFTY;
+			for (int32_t j=0; j<int32_t(m_components.size()); j++)
 			{
-				init_logPx_fix[i] +=
-				    std::exp(init_logPxy[index_t(i * m_components.size() + j)]);
+				if (j!=comp1 && j!=comp2 && j!=comp3)
+					fixed=log_add(fixed, init_logPxy(i, j));
+				else
+					moved=log_add(moved, init_logPxy(i, j));
 			}
-		}
 
-		init_logPx[i] = std::log(init_logPx[i]);
-		post_add[i] = std::log(
-		    std::exp(
-		        init_logPxy[index_t(i * m_components.size() + comp1)] -
-		        init_logPx[i]) +
-		    std::exp(
-		        init_logPxy[index_t(i * m_components.size() + comp2)] -
-		        init_logPx[i]) +
-		    std::exp(
-		        init_logPxy[index_t(i * m_components.size() + comp3)] -
-		        init_logPx[i]));
-	}
+			init_logPx_fix[i]=fixed;
+			post_add[i]=moved-log_add(fixed, moved);
+		}
+	});
 
 	vector<CGaussian*> components(3);
 	SGVector<float64_t> coefficients(3);
@@ -489,34 +497,23 @@ void CGMM::partial_em(int32_t comp1, int32_t comp2, int32_t comp3, float64_t min
 	float64_t log_likelihood_cur=0;
 	int32_t iter=0;
 	SGMatrix<float64_t> alpha(num_vectors, 3);
-	SGVector<float64_t> logPxy(num_vectors * 3);
-	SGVector<float64_t> logPx(num_vectors);
-	//float64_t* logPost=SG_MALLOC(float64_t, num_vectors*m_components.vlen);
 
 	while (iter<max_em_iter)
 	{
 		log_likelihood_prev=log_likelihood_cur;
 		log_likelihood_cur=0;
 
+		SGMatrix<float64_t> logPxy=log_joint_densities(components, coefficients);
+		SGVector<float64_t> logPx=log_sum_exp(logPxy);
 		for (int32_t i=0; i<num_vectors; i++)
 		{
-			logPx[i]=0;
-			SGVector<float64_t> v=dotdata->get_computed_dot_feature_vector(i);
-			for (int32_t j=0; j<3; j++)
-			{
-				logPxy[i * 3 + j] = components[j]->compute_log_PDF(v) +
-				                    std::log(coefficients[j]);
-				logPx[i] += std::exp(logPxy[i * 3 + j]);
-			}
-
-			logPx[i] = std::log(logPx[i] + init_logPx_fix[i]);
+			logPx[i]=log_add(logPx[i], init_logPx_fix[i]);
 			log_likelihood_cur+=logPx[i];
 
 			for (int32_t j=0; j<3; j++)
 			{
-				//logPost[i*m_components.vlen+j]=logPxy[i*m_components.vlen+j]-logPx[i];
 				alpha.matrix[i * 3 + j] =
-				    std::exp(logPxy[i * 3 + j] - logPx[i] + post_add[i]);
+				    std::exp(logPxy(i, j) - logPx[i] + post_add[i]);
 			}
 		}
 
@@ -539,124 +536,195 @@ void CGMM::partial_em(int32_t comp1, int32_t comp2, int32_t comp3, float64_t min
 
 void CGMM::max_likelihood(SGMatrix<float64_t> alpha, float64_t min_cov)
 {
-	CDotFeatures* dotdata=(CDotFeatures *) features;
-	int32_t num_dim=dotdata->get_dim_feature_space();
+	SGMatrix<float64_t> data=get_feature_matrix();
+	int32_t num_components=alpha.num_cols;
+	REQUIRE(alpha.num_rows==data.num_cols,
+		"Assignments of %d vectors for %d training vectors\n", alpha.num_rows,
+		data.num_cols);
+
+	parallel->parallel_for(0, num_components, [&](int64_t first, int64_t last)
+	{
+		for (int64_t i=first; i<last; i++)
+		{
+			// the assignments of one vector are adjacent
+			SGVector<float64_t> weights(alpha.num_rows);
+			for (index_t j=0; j<alpha.num_rows; j++)
+				weights[j]=alpha.matrix[j*num_components+i];
+
+			m_coefficients[i]=update_component(m_components[i], data, weights,
+				min_cov);
+		}
+	}, 1);
 
-	float64_t alpha_sum;
 	float64_t alpha_sum_sum=0;
+	for (int32_t i=0; i<num_components; i++)
+		alpha_sum_sum+=m_coefficients[i];
 
-	for (int32_t i=0; i<alpha.num_cols; i++)
-	{
-		alpha_sum=0;
-		SGVector<float64_t> mean_sum(num_dim);
-		linalg::zero(mean_sum);
+	linalg::scale(m_coefficients, m_coefficients, 1.0 / alpha_sum_sum);
+}
 
-		for (int32_t j=0; j<alpha.num_rows; j++)
+float64_t CGMM::update_component(CGaussian* component,
+		SGMatrix<float64_t> data, SGVector<float64_t> weights,
+		float64_t min_cov) const
+{
+	const int32_t num_dim=data.num_rows;
+	const int64_t block_size=256;
+	Eigen::Map<Eigen::MatrixXd> x(data.matrix, num_dim, data.num_cols);
+	Eigen::Map<Eigen::VectorXd> w(weights.vector, weights.vlen);
+	float64_t weight_sum=w.sum();
+
+	SGVector<float64_t> mean(num_dim);
+	Eigen::Map<Eigen::VectorXd> mu(mean.vector, num_dim);
+	mu=parallel_sum<Eigen::VectorXd>(parallel, data.num_cols,
+		Eigen::VectorXd::Zero(num_dim),
+		[&](int64_t first, int64_t last, Eigen::VectorXd& sum)
 		{
-			alpha_sum+=alpha.matrix[j*alpha.num_cols+i];
-			SGVector<float64_t> v=dotdata->get_computed_dot_feature_vector(j);
-			linalg::add(
-			    v, mean_sum, mean_sum, alpha.matrix[j * alpha.num_cols + i],
-			    1.0);
-		}
+			sum.noalias()+=x.middleCols(first, last-first)*
+				w.segment(first, last-first);
+		});
+	mu/=weight_sum;
+	component->set_mean(mean);
+
+	// the centered vectors are only formed block by block
+	ECovType cov_type=component->get_cov_type();
+	if (cov_type==FULL)
+	{
+		Eigen::MatrixXd scatter=parallel_sum<Eigen::MatrixXd>(parallel,
+			data.num_cols, Eigen::MatrixXd::Zero(num_dim, num_dim),
+			[&](int64_t first, int64_t last, Eigen::MatrixXd& sum)
+			{
+				for (int64_t b=first; b<last; b+=block_size)
+				{
+					int64_t n=CMath::min(block_size, last-b);
+					Eigen::MatrixXd y=(x.middleCols(b, n).colwise()-mu)*
+						w.segment(b, n).cwiseSqrt().asDiagonal();
+					sum.noalias()+=y*y.transpose();
+				}
+			});
 
-		linalg::scale(mean_sum, mean_sum, 1.0 / alpha_sum);
+		SGMatrix<float64_t> cov_sum(num_dim, num_dim);
+		Eigen::Map<Eigen::MatrixXd>(cov_sum.matrix, num_dim, num_dim)=
+			scatter/weight_sum;
 
-		m_components[i]->set_mean(mean_sum);
+		SGVector<float64_t> d0(num_dim);
+		linalg::eigen_solver_symmetric(cov_sum, d0, cov_sum);
 
-		SGMatrix<float64_t> cov_sum;
+		for (auto& v: d0)
+			v = CMath::max(min_cov, v);
 
-		ECovType cov_type = m_components[i]->get_cov_type();
-		if (cov_type==FULL)
-		{
-			cov_sum = SGMatrix<float64_t>(num_dim, num_dim);
-			linalg::zero(cov_sum);
-		}
-		else if(cov_type==DIAG)
-		{
-			cov_sum = SGMatrix<float64_t>(1, num_dim);
-			linalg::zero(cov_sum);
-		}
-		else if(cov_type==SPHERICAL)
+		component->set_d(d0);
+		component->set_u(cov_sum);
+	}
+	else
+	{
+		Eigen::VectorXd variance=parallel_sum<Eigen::VectorXd>(parallel,
+			data.num_cols, Eigen::VectorXd::Zero(num_dim),
+			[&](int64_t first, int64_t last, Eigen::VectorXd& sum)
+			{
+				for (int64_t b=first; b<last; b+=block_size)
+				{
+					int64_t n=CMath::min(block_size, last-b);
+					sum.noalias()+=(x.middleCols(b, n).colwise()-mu).array()
+						.square().matrix()*w.segment(b, n);
+				}
+			});
+		variance/=weight_sum;
+
+		SGVector<float64_t> d0(cov_type==DIAG ? num_dim : 1);
+		if (cov_type==DIAG)
 		{
-			cov_sum = SGMatrix<float64_t>(1, 1);
-			linalg::zero(cov_sum);
+			for (int32_t j=0; j<num_dim; j++)
+				d0[j]=CMath::max(min_cov, variance[j]);
 		}
+		else
+			d0[0]=CMath::max(min_cov, variance.sum()/num_dim);
 
-		for (int32_t j=0; j<alpha.num_rows; j++)
-		{
-			SGVector<float64_t> v=dotdata->get_computed_dot_feature_vector(j);
+		component->set_d(d0);
+	}
 
-			linalg::add(v, mean_sum, v, 1.0, -1.0);
-			switch (cov_type)
-			{
-				case FULL:
-				    linalg::rank_update(
-				        cov_sum, v, alpha.matrix[j * alpha.num_cols + i]);
-				    break;
-			    case DIAG:
-			    {
-				    auto temp_matrix = SGMatrix<float64_t>(v.vector, 1, v.vlen);
-				    auto temp_result = linalg::matrix_prod(
-				        temp_matrix, temp_matrix, true, false);
-				    cov_sum = temp_result.get_diagonal_vector().clone();
-				    linalg::scale(
-				        cov_sum, cov_sum, alpha.matrix[j * alpha.num_cols + i]);
-			    }
-
-			    break;
-			    case SPHERICAL:
-				    float64_t temp = 0;
-
-				    temp = linalg::dot(v, v);
-
-				    cov_sum(0, 0) +=
-				        temp * alpha.matrix[j * alpha.num_cols + i];
-				    break;
-			}
-		}
+	return weight_sum;
+}
 
-		switch (cov_type)
-		{
-			case FULL:
-		    {
-			    linalg::scale(cov_sum, cov_sum, 1.0 / alpha_sum);
+SGMatrix<float64_t> CGMM::get_feature_matrix() const
+{
+	REQUIRE(features, "No features to train on.\n")
 
-			    SGVector<float64_t> d0(num_dim);
-			    linalg::eigen_solver_symmetric(cov_sum, d0, cov_sum);
+	if (features->get_feature_class()==C_DENSE &&
+			features->get_feature_type()==F_DREAL)
+		return features->as<CDenseFeatures<float64_t>>()->get_feature_matrix();
 
-			    for (auto& v: d0)
-				    v = CMath::max(min_cov, v);
+	CDotFeatures* dotdata=features->as<CDotFeatures>();
+	SGMatrix<float64_t> data(
+		dotdata->get_dim_feature_space(), dotdata->get_num_vectors());
+	for (index_t i=0; i<data.num_cols; i++)
+	{
+		SGVector<float64_t> v=dotdata->get_computed_dot_feature_vector(i);
+		sg_memcpy(data.get_column_vector(i), v.vector,
+			sizeof(float64_t)*data.num_rows);
+	}
+	return data;
+}
 
-			    m_components[i]->set_d(d0);
-			    m_components[i]->set_u(cov_sum);
+SGMatrix<float64_t> CGMM::log_joint_densities(
+		const vector<CGaussian*>& components,
+		SGVector<float64_t> coefficients) const
+{
+	SGMatrix<float64_t> data=get_feature_matrix();
+	index_t num_vectors=data.num_cols;
+	SGMatrix<float64_t> log_pxy(num_vectors, index_t(components.size()));
 
-			    break;
-		    }
-		    case DIAG:
-			    for (int32_t j = 0; j < num_dim; j++)
-			    {
-				    cov_sum(0, j) /= alpha_sum;
-				    cov_sum(0, j) = CMath::max(min_cov, cov_sum(0, j));
-			    }
+	// each component evaluates its blocks of vectors in parallel as well
+	parallel->parallel_for(0, components.size(), [&](int64_t first, int64_t last)
+	{
+		for (int64_t j=first; j<last; j++)
+		{
+			SGVector<float64_t> column(
+				log_pxy.get_column_vector(j), num_vectors, false);
+			components[j]->compute_log_PDF(data, column);
 
-			    m_components[i]->set_d(cov_sum.get_row_vector(0));
+			float64_t log_coef=std::log(coefficients[j]);
+			for (index_t i=0; i<num_vectors; i++)
+				column[i]+=log_coef;
+		}
+	}, 1);
 
-			    break;
-		    case SPHERICAL:
-			    cov_sum[0] /= alpha_sum * num_dim;
-			    cov_sum[0] = CMath::max(min_cov, cov_sum[0]);
+	return log_pxy;
+}
 
-			    m_components[i]->set_d(cov_sum.get_row_vector(0));
+SGVector<float64_t> CGMM::log_sum_exp(SGMatrix<float64_t> log_pxy) const
+{
+	index_t num_vectors=log_pxy.num_rows;
+	SGVector<float64_t> result(num_vectors);
 
-			    break;
+	// the components are the outer loop so that columns are read in order
+	parallel->parallel_for(0, num_vectors, [&](int64_t first, int64_t last)
+	{
+		for (int64_t i=first; i<last; i++)
+			result[i]=-CMath::INFTY;
+		for (index_t j=0; j<log_pxy.num_cols; j++)
+		{
+			for (int64_t i=first; i<last; i++)
+				result[i]=CMath::max(result[i], log_pxy(i, j));
 		}
 
-		m_coefficients.vector[i]=alpha_sum;
-		alpha_sum_sum+=alpha_sum;
-	}
+		std::vector<float64_t> sum(last-first, 0.0);
+		for (index_t j=0; j<log_pxy.num_cols; j++)
+		{
+			for (int64_t i=first; i<last; i++)
+			{
+				if (result[i]>-CMath::INFTY)
+					sum[i-first]+=std::exp(log_pxy(i, j)-result[i]);
+			}
+		}
 
-	linalg::scale(m_coefficients, m_coefficients, 1.0 / alpha_sum_sum);
+		for (int64_t i=first; i<last; i++)
+		{
+			if (result[i]>-CMath::INFTY)
+				result[i]+=std::log(sum[i-first]);
+		}
+	}, 1024);
+
+	return result;
 }
 
 int32_t CGMM::get_num_model_parameters()
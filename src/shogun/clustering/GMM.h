@@ -214,6 +214,41 @@ class CGMM : public CDistribution
 		virtual const char* get_name() const { return "GMM"; }
 
 	private:
+		/** @return training vectors, one per column */
+		SGMatrix<float64_t> get_feature_matrix() const;
+
+		/** E-step on all training vectors, evaluated in blocks of vectors
+		 * against all components
+		 *
+		 * @param components mixture components
+		 * @param coefficients mixing coefficients
+		 * @return log(coefficient*PDF) of each vector (row) and component
+		 * (column)
+		 */
+		SGMatrix<float64_t> log_joint_densities(
+				const std::vector<CGaussian*>& components,
+				SGVector<float64_t> coefficients) const;
+
+		/** log of the row sums of exp(log_pxy), stable even if all
+		 * densities of a vector underflow
+		 *
+		 * @param log_pxy log densities of each vector and component
+		 * @return log density of each vector
+		 */
+		SGVector<float64_t> log_sum_exp(SGMatrix<float64_t> log_pxy) const;
+
+		/** M-step of one component
+		 *
+		 * @param component component to update
+		 * @param data training vectors
+		 * @param weights weight of each training vector
+		 * @param min_cov minimum covariance
+		 * @return sum of the weights
+		 */
+		float64_t update_component(CGaussian* component,
+				SGMatrix<float64_t> data, SGVector<float64_t> weights,
+				float64_t min_cov) const;
+
 		/** 1NN assignment initialization
 		 *
 		 * @param init_means initial means
@@ -13,18 +13,34 @@
 #include <shogun/labels/Labels.h>
 #include <shogun/mathematics/Math.h>
 
+#include <algorithm>
+#include <vector>
+
 using namespace shogun;
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
-struct pair
+struct edge
 {
 	/** index 1 */
 	int32_t idx1;
 	/** index 2 */
 	int32_t idx2;
+	/** distance between the two */
+	float64_t dist;
 };
 #endif // DOXYGEN_SHOULD_SKIP_THIS
 
+/** root of a point in a union-find forest, halving the path */
+static int32_t find_root(int32_t* parent, int32_t i)
+{
+	while (parent[i]!=i)
+	{
+		parent[i]=parent[parent[i]];
+		i=parent[i];
+	}
+	return i;
+}
+
 CHierarchical::CHierarchical()
 : CDistanceMachine()
 {
@@ -88,8 +104,8 @@ bool CHierarchical::train_machine(CFeatures* data)
 
 	int32_t num=lhs->get_num_vectors();
 	ASSERT(num>0)
-
-	const int32_t num_pairs=num*(num-1)/2;
+	REQUIRE(num>merges, "Number of vectors (%d) must exceed merges (%d)\n",
+			num, merges);
 
 	SG_FREE(merge_distance);
 	merge_distance=SG_MALLOC(float64_t, num);
@@ -99,79 +115,91 @@ bool CHierarchical::train_machine(CFeatures* data)
 	SG_FREE(assignment);
 	assignment=SG_MALLOC(int32_t, num);
 	assignment_len = num;
-	SGVector<int32_t>::range_fill_vector(assignment, num);
 
 	SG_FREE(pairs);
 	pairs=SG_MALLOC(int32_t, 2*num);
 	SGVector<int32_t>::fill_vector(pairs, 2*num, -1);
 
-	pair* index=SG_MALLOC(pair, num_pairs);
-	float64_t* distances=SG_MALLOC(float64_t, num_pairs);
-
-	int32_t offs=0;
-	for (auto i : SG_PROGRESS(range(0, num)))
+	/* Single linkage merges the clusters along the edges of a minimum
+	 * spanning tree, shortest first. Prim's algorithm grows the tree with
+	 * O(n^2) distance computations and O(n) memory, the distances from the
+	 * last added point are computed in parallel. */
+	SGVector<float64_t> min_dist(num);
+	SGVector<int32_t> nearest(num);
+	SGVector<int32_t> remaining(num);
+	min_dist.set_const(CMath::INFTY);
+	SGVector<int32_t>::range_fill_vector(remaining.vector, num);
+
+	std::vector<edge> tree(num-1);
+	int32_t current=0;
+	int32_t num_remaining=num-1;
+	remaining[0]=num-1;
+
+	for (auto step : SG_PROGRESS(range(0, num-1)))
 	{
-		for (int32_t j=i+1; j<num; j++)
+		parallel->parallel_for(0, num_remaining, [&](int64_t first, int64_t last)
 		{
-			distances[offs] = distance->distance(i, j);
-			index[offs].idx1 = i;
-			index[offs].idx2 = j;
-			offs++; // offs=i*(i+1)/2+j
-		}
-	}
-
-	CMath::qsort_index<float64_t,pair>(distances, index, (num-1)*num/2);
-	//CMath::display_vector(distances, (num-1)*num/2, "dists");
+			for (int64_t r=first; r<last; r++)
+			{
+				int32_t j=remaining[r];
+				float64_t dist=distance->distance(current, j);
+				if (dist<min_dist[j])
+				{
+					min_dist[j]=dist;
+					nearest[j]=current;
+				}
+			}
+		}, 256);
 
-	auto pb = SG_PROGRESS(range(0, num_pairs - 1));
-	int32_t k=-1;
-	int32_t l=0;
-	for (; l<num && (num-l)>=merges && k<num_pairs-1; l++)
-	{
-		while (k<num_pairs-1)
+		int32_t best=0;
+		for (int32_t r=1; r<num_remaining; r++)
 		{
-			k++;
+			if (min_dist[remaining[r]]<min_dist[remaining[best]])
+				best=r;
+		}
 
-			int32_t i=index[k].idx1;
-			int32_t j=index[k].idx2;
-			int32_t c1=assignment[i];
-			int32_t c2=assignment[j];
+		current=remaining[best];
+		remaining[best]=remaining[--num_remaining];
+		tree[step].idx1=nearest[current];
+		tree[step].idx2=current;
+		tree[step].dist=min_dist[current];
+	}
 
-			if (c1==c2)
-				continue;
+	std::stable_sort(tree.begin(), tree.end(),
+			[](const edge& a, const edge& b) { return a.dist<b.dist; });
 
-			pb.print_progress();
+	/* clusters are tracked by a union-find forest, each root knows the
+	 * index of its cluster */
+	SGVector<int32_t> parent(num);
+	SGVector<int32_t> cluster(num);
+	SGVector<int32_t>::range_fill_vector(parent.vector, num);
+	SGVector<int32_t>::range_fill_vector(cluster.vector, num);
 
-			if (c1<c2)
-			{
-				pairs[2*l]=c1;
-				pairs[2*l+1]=c2;
-			}
-			else
-			{
-				pairs[2*l]=c2;
-				pairs[2*l+1]=c1;
-			}
-			merge_distance[l]=distances[k];
+	int32_t num_merges=CMath::min(num-1, num-merges+1);
+	for (int32_t l=0; l<num_merges; l++)
+	{
+		int32_t r1=find_root(parent.vector, tree[l].idx1);
+		int32_t r2=find_root(parent.vector, tree[l].idx2);
+		int32_t c1=cluster[r1];
+		int32_t c2=cluster[r2];
 
-			int32_t c=num+l;
-			for (int32_t m=0; m<num; m++)
-			{
-				if (assignment[m] == c1 || assignment[m] == c2)
-					assignment[m] = c;
-			}
+		pairs[2*l]=CMath::min(c1, c2);
+		pairs[2*l+1]=CMath::max(c1, c2);
+		merge_distance[l]=tree[l].dist;
+
+		parent[r2]=r1;
+		cluster[r1]=num+l;
 #ifdef DEBUG_HIERARCHICAL
-			SG_PRINT("l=%04i i=%04i j=%04i c1=%+04d c2=%+04d c=%+04d dist=%6.6f\n", l,i,j, c1,c2,c, merge_distance[l])
+		SG_PRINT("l=%04i i=%04i j=%04i c1=%+04d c2=%+04d c=%+04d dist=%6.6f\n", l,
+				tree[l].idx1, tree[l].idx2, c1, c2, num+l, merge_distance[l])
 #endif
-			break;
-		}
 	}
-	pb.complete();
 
-	table_size=l-1;
+	for (int32_t m=0; m<num; m++)
+		assignment[m]=cluster[find_root(parent.vector, m)];
+
+	table_size=num-merges;
 	ASSERT(table_size>0)
-	SG_FREE(distances);
-	SG_FREE(index);
 	SG_UNREF(lhs)
 
 	return true;
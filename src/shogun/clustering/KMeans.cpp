@@ -6,6 +6,7 @@
  *          Bjoern Esser, parijat
  */
 
+#include <shogun/base/Parallel.h>
 #include <shogun/base/progress.h>
 #include <shogun/clustering/KMeans.h>
 #include <shogun/distance/Distance.h>
@@ -14,6 +15,9 @@
 #include <shogun/io/SGIO.h>
 #include <shogun/mathematics/linalg/LinalgNamespace.h>
 
+#include <atomic>
+#include <vector>
+
 using namespace Eigen;
 using namespace shogun;
 
@@ -23,20 +27,61 @@ namespace shogun
 
 CKMeans::CKMeans():CKMeansBase()
 {
+	init();
 }
 
 CKMeans::CKMeans(int32_t k_i, CDistance* d_i, bool use_kmpp_i):CKMeansBase(k_i, d_i, use_kmpp_i)
 {
+	init();
 }
 
 CKMeans::CKMeans(int32_t k_i, CDistance* d_i, SGMatrix<float64_t> centers_i):CKMeansBase(k_i, d_i, centers_i)
 {
+	init();
 }
 
 CKMeans::~CKMeans()
 {
 }
 
+void CKMeans::init()
+{
+	m_use_hamerly=true;
+	SG_ADD(&m_use_hamerly, "use_hamerly",
+		"Whether Lloyd's iterations use Hamerly's bounds", MS_NOT_AVAILABLE);
+}
+
+void CKMeans::set_use_hamerly(bool use_hamerly)
+{
+	m_use_hamerly=use_hamerly;
+}
+
+bool CKMeans::get_use_hamerly() const
+{
+	return m_use_hamerly;
+}
+
+bool CKMeans::can_use_hamerly()
+{
+	if (!m_use_hamerly || fixed_centers)
+		return false;
+
+	if (distance->get_distance_type()!=D_EUCLIDEAN)
+		return false;
+
+	/* squared distances violate the triangle inequality */
+	return !((CEuclideanDistance*) distance)->get_disable_sqrt();
+}
+
+static float64_t euclidean(const float64_t* a, const float64_t* b, int32_t dim)
+{
+	float64_t sum=0;
+	for (int32_t i=0; i<dim; i++)
+		sum+=CMath::sq(a[i]-b[i]);
+
+	return std::sqrt(sum);
+}
+
 void CKMeans::Lloyd_KMeans(SGMatrix<float64_t> centers, int32_t num_centers)
 {
 	CDenseFeatures<float64_t>* lhs =
@@ -176,10 +221,235 @@ void CKMeans::Lloyd_KMeans(SGMatrix<float64_t> centers, int32_t num_centers)
 	SG_UNREF(rhs_cache);
 }
 
+void CKMeans::Hamerly_KMeans(SGMatrix<float64_t> centers, int32_t num_centers)
+{
+	CDenseFeatures<float64_t>* lhs =
+		distance->get_lhs()->as<CDenseFeatures<float64_t>>();
+	SGMatrix<float64_t> data=lhs->get_feature_matrix();
+	SG_UNREF(lhs);
+
+	const int32_t num_vectors=data.num_cols;
+	const int32_t dim=data.num_rows;
+
+	SGVector<int32_t> cluster_assignments(num_vectors);
+	/* distance to the own center and lower bound to all other centers */
+	SGVector<float64_t> upper(num_vectors);
+	SGVector<float64_t> lower(num_vectors);
+
+	/* half the distance of each center to the closest other center, a
+	 * vector closer than that to its center cannot be closer to another */
+	SGVector<float64_t> half_gap(num_centers);
+	SGVector<float64_t> moves(num_centers);
+	moves.zero();
+
+	SGMatrix<float64_t> sums(dim, num_centers);
+	SGVector<int64_t> weights_set(num_centers);
+	sums.zero();
+	weights_set.zero();
+
+	/* one block of vectors per thread, each with its own changes of the
+	 * center sums, which are added up after every pass */
+	int64_t num_threads=parallel->get_num_threads();
+	int64_t block_size=(num_vectors+num_threads-1)/num_threads;
+	int64_t num_blocks=(num_vectors+block_size-1)/block_size;
+	std::vector<SGMatrix<float64_t> > block_sums(num_blocks);
+	std::vector<SGVector<int64_t> > block_weights(num_blocks);
+	for (int64_t b=0; b<num_blocks; b++)
+	{
+		block_sums[b]=SGMatrix<float64_t>(dim, num_centers);
+		block_sums[b].zero();
+		block_weights[b]=SGVector<int64_t>(num_centers);
+		block_weights[b].zero();
+	}
+
+	/* distances to all centers, the closest one wins ties by index */
+	auto assign=[&](int32_t i)
+	{
+		const float64_t* vec=data.get_column_vector(i);
+		int32_t min_cluster=0;
+		float64_t min_dist=euclidean(vec, centers.get_column_vector(0), dim);
+		float64_t second_dist=CMath::INFTY;
+		for (int32_t j=1; j<num_centers; j++)
+		{
+			float64_t dist=euclidean(vec, centers.get_column_vector(j), dim);
+			if (dist<min_dist)
+			{
+				second_dist=min_dist;
+				min_dist=dist;
+				min_cluster=j;
+			}
+			else if (dist<second_dist)
+				second_dist=dist;
+		}
+
+		upper[i]=min_dist;
+		lower[i]=second_dist;
+		return min_cluster;
+	};
+
+	/* moves a vector between the sums of its block */
+	auto move=[&](int64_t block, int32_t i, int32_t from, int32_t to)
+	{
+		const float64_t* vec=data.get_column_vector(i);
+		float64_t* sum_to=block_sums[block].get_column_vector(to);
+		for (int32_t j=0; j<dim; j++)
+			sum_to[j]+=vec[j];
+		block_weights[block][to]++;
+
+		if (from<0)
+			return;
+
+		float64_t* sum_from=block_sums[block].get_column_vector(from);
+		for (int32_t j=0; j<dim; j++)
+			sum_from[j]-=vec[j];
+		block_weights[block][from]--;
+	};
+
+	auto merge_blocks=[&]()
+	{
+		parallel->parallel_for(0, num_centers, [&](int64_t first, int64_t last)
+		{
+			for (int64_t b=0; b<num_blocks; b++)
+			{
+				for (int64_t c=first; c<last; c++)
+				{
+					float64_t* sum=sums.get_column_vector(c);
+					float64_t* block_sum=block_sums[b].get_column_vector(c);
+					for (int32_t j=0; j<dim; j++)
+					{
+						sum[j]+=block_sum[j];
+						block_sum[j]=0;
+					}
+					weights_set[c]+=block_weights[b][c];
+					block_weights[b][c]=0;
+				}
+			}
+		});
+	};
+
+	/* first assignment computes all distances */
+	parallel->parallel_for(0, num_vectors, [&](int64_t first, int64_t last)
+	{
+		int64_t block=first/block_size;
+		for (int64_t i=first; i<last; i++)
+		{
+			cluster_assignments[i]=assign(i);
+			move(block, i, -1, cluster_assignments[i]);
+		}
+	}, block_size);
+	merge_blocks();
+
+	for (auto iter : SG_PROGRESS(range(max_iter)))
+	{
+		if (iter==max_iter-1)
+			SG_SWARNING("KMeans clustering has reached maximum number of ( %d ) iterations without having converged. \
+				   	Terminating. \n", iter)
+
+		/* Update Step : Calculate new means, empty clusters are set to
+		 * zero as in the plain iterations */
+		parallel->parallel_for(0, num_centers, [&](int64_t first, int64_t last)
+		{
+			for (int64_t c=first; c<last; c++)
+			{
+				float64_t* center=centers.get_column_vector(c);
+				const float64_t* sum=sums.get_column_vector(c);
+				float64_t scale=weights_set[c] ? 1.0/weights_set[c] : 0.0;
+				float64_t move_sq=0;
+				for (int32_t j=0; j<dim; j++)
+				{
+					float64_t mean=sum[j]*scale;
+					move_sq+=CMath::sq(mean-center[j]);
+					center[j]=mean;
+				}
+				moves[c]=std::sqrt(move_sq);
+			}
+		});
+
+		/* the furthest moving center and the next one bound how much the
+		 * other centers came closer */
+		int32_t max_move_center=0;
+		float64_t max_move=0;
+		float64_t second_move=0;
+		for (int32_t c=0; c<num_centers; c++)
+		{
+			if (moves[c]>max_move)
+			{
+				second_move=max_move;
+				max_move=moves[c];
+				max_move_center=c;
+			}
+			else if (moves[c]>second_move)
+				second_move=moves[c];
+		}
+
+		parallel->parallel_for(0, num_centers, [&](int64_t first, int64_t last)
+		{
+			for (int64_t c=first; c<last; c++)
+			{
+				float64_t min_dist=CMath::INFTY;
+				for (int32_t j=0; j<num_centers; j++)
+				{
+					if (j!=c)
+					{
+						min_dist=CMath::min(min_dist, euclidean(
+							centers.get_column_vector(c),
+							centers.get_column_vector(j), dim));
+					}
+				}
+				half_gap[c]=0.5*min_dist;
+			}
+		});
+
+		/* Assigment step : only vectors whose bounds overlap are compared
+		 * to all centers */
+		std::atomic<int64_t> changed(0);
+		parallel->parallel_for(0, num_vectors, [&](int64_t first, int64_t last)
+		{
+			int64_t block=first/block_size;
+			int64_t block_changed=0;
+			for (int64_t i=first; i<last; i++)
+			{
+				const int32_t cluster_i=cluster_assignments[i];
+				upper[i]+=moves[cluster_i];
+				lower[i]-=cluster_i==max_move_center ? second_move : max_move;
+
+				float64_t bound=CMath::max(half_gap[cluster_i], lower[i]);
+				if (upper[i]<=bound)
+					continue;
+
+				upper[i]=euclidean(data.get_column_vector(i),
+						centers.get_column_vector(cluster_i), dim);
+				if (upper[i]<=bound)
+					continue;
+
+				int32_t min_cluster=assign(i);
+				if (min_cluster!=cluster_i)
+				{
+					move(block, i, cluster_i, min_cluster);
+					cluster_assignments[i]=min_cluster;
+					block_changed++;
+				}
+			}
+			changed+=block_changed;
+		}, block_size);
+
+		if (changed==0)
+			break;
+
+		merge_blocks();
+
+		if (max_iter>=10 && iter%(max_iter/10) == 0)
+			SG_SINFO("Iteration[%d/%d]: Assignment of %i patterns changed.\n", iter, max_iter, (int32_t) changed.load())
+	}
+}
+
 bool CKMeans::train_machine(CFeatures* data)
 {
 	initialize_training(data);
-	Lloyd_KMeans(mus, k);
+	if (can_use_hamerly())
+		Hamerly_KMeans(mus, k);
+	else
+		Lloyd_KMeans(mus, k);
 	compute_cluster_variances();
 	return true;
 }
@@ -35,6 +35,9 @@ class CKMeansBase;
  *
  * To use mini-batch based training was see CKMeansMiniBatch 
  *
+ * For the Euclidean distance, Lloyd's iterations are accelerated with
+ * Hamerly's bounds, see set_use_hamerly().
+ *
  * cf. http://en.wikipedia.org/wiki/K-means_algorithm
  * cf. http://en.wikipedia.org/wiki/Lloyd's_algorithm
  *
@@ -64,6 +67,32 @@ class CKMeans : public CKMeansBase
 
 		virtual ~CKMeans();
 
+		/** set whether Lloyd's iterations skip distance computations using
+		 * Hamerly's bounds, see
+		 *
+		 * Hamerly, G. (2010). Making k-means even faster. In SIAM
+		 * International Conference on Data Mining.
+		 *
+		 * Every vector keeps an upper bound of the distance to its center
+		 * and a lower bound of the distance to all other centers. Both are
+		 * updated by how far the centers moved, and the distances to all
+		 * centers are only computed when the bounds overlap, which after the
+		 * first few iterations is the case for few vectors. Only one pair of
+		 * bounds per vector is stored, so the memory does not grow with k.
+		 * The bounds never skip a strictly closer center, so the iterations
+		 * match those without them, except that a vector which is equally
+		 * close to several centers may keep its current center instead of
+		 * moving to the first of them. They rely on the triangle inequality
+		 * and are only used for the Euclidean distance without fixed
+		 * centers.
+		 *
+		 * @param use_hamerly whether to use the bounds (default true)
+		 */
+		void set_use_hamerly(bool use_hamerly);
+
+		/** @return whether Lloyd's iterations use Hamerly's bounds */
+		bool get_use_hamerly() const;
+
 		/** @return object name */
 		virtual const char* get_name() const { return "KMeans"; }		
 
@@ -82,6 +111,20 @@ class CKMeans : public CKMeansBase
 		/** Lloyd's KMeans training method
 		 */
 		void Lloyd_KMeans(SGMatrix<float64_t> centers, int32_t num_centers);
+
+		/** Lloyd's KMeans training method with Hamerly's bounds, center
+		 * sums are accumulated per thread
+		 */
+		void Hamerly_KMeans(SGMatrix<float64_t> centers, int32_t num_centers);
+
+		/** @return whether Hamerly's bounds can be used with the distance */
+		bool can_use_hamerly();
+
+		void init();
+
+	private:
+		/** whether Lloyd's iterations use Hamerly's bounds */
+		bool m_use_hamerly;
 };
 }
 #endif
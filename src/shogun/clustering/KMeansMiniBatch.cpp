@@ -4,12 +4,17 @@
  * Authors: Saurabh Mahindre, Michele Mazzoni, Heiko Strathmann, Viktor Gal
  */
 
+#include <shogun/base/Parallel.h>
 #include <shogun/base/progress.h>
 #include <shogun/clustering/KMeansMiniBatch.h>
 #include <shogun/distance/Distance.h>
 #include <shogun/features/DenseFeatures.h>
+#include <shogun/features/streaming/StreamingDenseFeatures.h>
 #include <shogun/mathematics/Math.h>
 
+#include <functional>
+#include <vector>
+
 #ifdef _WIN32
 #undef far
 #undef near
@@ -57,6 +62,28 @@ void CKMeansMiniBatch::set_mb_params(int32_t b, int32_t t)
 	max_iter = t;
 }
 
+void CKMeansMiniBatch::set_init_rounds(int32_t rounds)
+{
+	REQUIRE(rounds>0, "Number of k-means|| rounds (%d) should be > 0\n", rounds);
+	init_rounds=rounds;
+}
+
+int32_t CKMeansMiniBatch::get_init_rounds() const
+{
+	return init_rounds;
+}
+
+void CKMeansMiniBatch::set_oversampling(float64_t factor)
+{
+	REQUIRE(factor>0, "Oversampling factor (%f) should be > 0\n", factor);
+	oversampling=factor;
+}
+
+float64_t CKMeansMiniBatch::get_oversampling() const
+{
+	return oversampling;
+}
+
 void CKMeansMiniBatch::minibatch_KMeans()
 {
 	REQUIRE(batch_size>0,
@@ -135,19 +162,325 @@ SGVector<int32_t> CKMeansMiniBatch::mbchoose_rand(int32_t b, int32_t num)
 	return ret;
 }
 
+int32_t CKMeansMiniBatch::read_batch(
+	CStreamingDenseFeatures<float64_t>* stream, SGMatrix<float64_t>& batch)
+{
+	int32_t num=0;
+	while (num<batch_size && stream->get_next_example())
+	{
+		SGVector<float64_t> vec=stream->get_vector();
+		if (!batch.matrix)
+			batch=SGMatrix<float64_t>(vec.vlen, batch_size);
+
+		REQUIRE(vec.vlen==batch.num_rows,
+			"Streamed vector has %d features, expected %d\n", vec.vlen,
+			batch.num_rows);
+		sg_memcpy(batch.get_column_vector(num), vec.vector,
+			sizeof(float64_t)*vec.vlen);
+		stream->release_example();
+		num++;
+	}
+	return num;
+}
+
+void CKMeansMiniBatch::assign_batch(int32_t num, SGVector<int32_t>& closest,
+	SGVector<float64_t>& dists)
+{
+	int32_t num_centers=distance->get_num_vec_rhs();
+	parallel->parallel_for(0, num, [&](int64_t first, int64_t last)
+	{
+		for (int64_t j=first; j<last; j++)
+		{
+			int32_t imin=0;
+			float64_t min=distance->distance(j, 0);
+			for (int32_t p=1; p<num_centers; p++)
+			{
+				float64_t dist=distance->distance(j, p);
+				if (dist<min)
+				{
+					imin=p;
+					min=dist;
+				}
+			}
+			closest[j]=imin;
+			dists[j]=min;
+		}
+	});
+}
+
+SGMatrix<float64_t> CKMeansMiniBatch::weighted_kmeanspp(
+	SGMatrix<float64_t> points, SGVector<float64_t> weights)
+{
+	int32_t num=points.num_cols;
+	SGMatrix<float64_t> centers(dimensions, k);
+	SGVector<float64_t> min_dist(num);
+	SGVector<float64_t> mass=weights.clone();
+	distance->init(new CDenseFeatures<float64_t>(points),
+		new CDenseFeatures<float64_t>(points));
+
+	for (int32_t c=0; c<k; c++)
+	{
+		/* draw a point with probability proportional to its weight times
+		 * its squared distance to the chosen centers */
+		float64_t sum=0;
+		for (int32_t i=0; i<num; i++)
+			sum+=mass[i];
+		REQUIRE(sum>0, "Only %d distinct points for %d centers\n", c, k);
+
+		float64_t r=CMath::random(0.0, sum);
+		float64_t cumulative=0;
+		int32_t chosen=-1;
+		for (int32_t i=0; i<num && cumulative<r; i++)
+		{
+			if (mass[i]>0)
+			{
+				cumulative+=mass[i];
+				chosen=i;
+			}
+		}
+		if (chosen<0)
+		{
+			for (chosen=0; mass[chosen]==0; chosen++);
+		}
+
+		sg_memcpy(centers.get_column_vector(c), points.get_column_vector(chosen),
+			sizeof(float64_t)*dimensions);
+
+		parallel->parallel_for(0, num, [&](int64_t first, int64_t last)
+		{
+			for (int64_t i=first; i<last; i++)
+			{
+				float64_t dist=CMath::sq(distance->distance(i, chosen));
+				if (c==0 || dist<min_dist[i])
+					min_dist[i]=dist;
+				mass[i]=weights[i]*min_dist[i];
+			}
+		});
+	}
+	return centers;
+}
+
+SGMatrix<float64_t> CKMeansMiniBatch::kmeans_parallel(
+	CStreamingDenseFeatures<float64_t>* stream)
+{
+	REQUIRE(stream->is_seekable(), "%s::kmeans_parallel(): k-means|| "
+		"needs a seekable stream, it reads the data once per pass\n",
+		get_name());
+
+	float64_t num_samples=oversampling*k;
+	SGMatrix<float64_t> batch(dimensions, batch_size);
+	SGVector<int32_t> closest(batch_size);
+	SGVector<float64_t> dists(batch_size);
+	std::vector<float64_t> candidates(dimensions);
+
+	/* first candidate uniformly at random by reservoir sampling */
+	stream->reset_stream();
+	int64_t num_vectors=0;
+	for (int32_t num; (num=read_batch(stream, batch))>0;)
+	{
+		for (int32_t j=0; j<num; j++)
+		{
+			if (CMath::random((int64_t) 0, num_vectors++)==0)
+			{
+				sg_memcpy(candidates.data(), batch.get_column_vector(j),
+					sizeof(float64_t)*dimensions);
+			}
+		}
+	}
+
+	/* one pass over the stream, with the distances of each batch to the
+	 * closest candidate */
+	auto pass=[&](const std::function<void(int32_t)>& visit)
+	{
+		stream->reset_stream();
+		for (int32_t num; (num=read_batch(stream, batch))>0;)
+		{
+			SGMatrix<float64_t> centers(dimensions,
+				candidates.size()/dimensions);
+			sg_memcpy(centers.matrix, candidates.data(),
+				sizeof(float64_t)*candidates.size());
+			distance->init(new CDenseFeatures<float64_t>(batch),
+				new CDenseFeatures<float64_t>(centers));
+			assign_batch(num, closest, dists);
+			visit(num);
+		}
+	};
+
+	float64_t cost=0;
+	pass([&](int32_t num)
+	{
+		for (int32_t j=0; j<num; j++)
+			cost+=CMath::sq(dists[j]);
+	});
+
+	/* the cost of the next round is accumulated while sampling, vectors
+	 * are compared to the candidates of the batches before their own. This
+	 * overestimates the cost and slightly lowers the sampling probability,
+	 * but saves a pass per round */
+	for (int32_t round=0; round<init_rounds && cost>0; round++)
+	{
+		float64_t next_cost=0;
+		pass([&](int32_t num)
+		{
+			for (int32_t j=0; j<num; j++)
+			{
+				float64_t dist=CMath::sq(dists[j]);
+				if (CMath::random(0.0, 1.0)*cost<num_samples*dist)
+				{
+					float64_t* x=batch.get_column_vector(j);
+					candidates.insert(candidates.end(), x, x+dimensions);
+				}
+				else
+					next_cost+=dist;
+			}
+		});
+		cost=next_cost;
+	}
+
+	/* weight the candidates by the number of vectors closest to them */
+	int32_t num_candidates=candidates.size()/dimensions;
+	SGVector<float64_t> weights(num_candidates);
+	weights.zero();
+	pass([&](int32_t num)
+	{
+		for (int32_t j=0; j<num; j++)
+			weights[closest[j]]+=1;
+	});
+	SG_DEBUG("k-means|| sampled %d candidates from %d vectors\n",
+		num_candidates, num_vectors);
+
+	REQUIRE(num_candidates>=k,
+		"k-means|| sampled %d candidates for %d centers\n", num_candidates, k);
+	SGMatrix<float64_t> points(dimensions, num_candidates);
+	sg_memcpy(points.matrix, candidates.data(),
+		sizeof(float64_t)*candidates.size());
+	return weighted_kmeanspp(points, weights);
+}
+
+void CKMeansMiniBatch::streaming_KMeans(
+	CStreamingDenseFeatures<float64_t>* stream)
+{
+	REQUIRE(batch_size>0,
+		"batch size not set to positive value. Current batch size %d \n", batch_size);
+	REQUIRE(
+		max_iter > 0, "number of iterations not set to positive value. Current "
+		              "iterations %d \n",
+		max_iter);
+
+	bool seekable=stream->is_seekable();
+	stream->start_parser();
+
+	/* joins the parser on every exit, also when an error is thrown */
+	struct ParserGuard
+	{
+		~ParserGuard() { stream->end_parser(); }
+		CStreamingDenseFeatures<float64_t>* stream;
+	} parser_guard={stream};
+
+	SGMatrix<float64_t> batch;
+	int32_t num=read_batch(stream, batch);
+	REQUIRE(num>0, "Stream does not contain any vectors\n");
+	dimensions=batch.num_rows;
+
+	if (mus_initial.matrix)
+	{
+		REQUIRE(mus_initial.num_rows==dimensions && mus_initial.num_cols==k,
+			"Initial centers (%dx%d) should be %dx%d\n", mus_initial.num_rows,
+			mus_initial.num_cols, dimensions, k);
+		mus=mus_initial.clone();
+	}
+	else if (seekable)
+	{
+		mus=kmeans_parallel(stream);
+		stream->reset_stream();
+		num=read_batch(stream, batch);
+	}
+	else
+	{
+		SG_WARNING("%s: the stream cannot be reset, the centers are "
+			"initialized by k-means++ on the first batch instead of by "
+			"k-means||\n", get_name());
+		REQUIRE(num>=k, "First batch has %d vectors, at least %d are needed to "
+			"initialize the centers\n", num, k);
+		SGVector<float64_t> weights(num);
+		weights.set_const(1.0);
+		mus=weighted_kmeanspp(
+			SGMatrix<float64_t>(batch.matrix, dimensions, num, false), weights);
+	}
+
+	SGVector<float64_t> v=SGVector<float64_t>(k);
+	v.zero();
+	SGVector<int32_t> closest(batch_size);
+	SGVector<float64_t> dists(batch_size);
+
+	for (auto i : SG_PROGRESS(range(max_iter)))
+	{
+		/* the first iteration uses the batch read above */
+		if (i>0)
+			num=read_batch(stream, batch);
+		if (!num)
+		{
+			if (!seekable)
+			{
+				SG_INFO("Stream ended after %d of %d iterations\n", i, max_iter);
+				break;
+			}
+			stream->reset_stream();
+			num=read_batch(stream, batch);
+		}
+
+		/* distances of the whole batch, then the updates in stream order */
+		distance->init(new CDenseFeatures<float64_t>(batch),
+			new CDenseFeatures<float64_t>(mus));
+		assign_batch(num, closest, dists);
+
+		for (int32_t j=0; j<num; j++)
+		{
+			float64_t* c_alive=mus.get_column_vector(closest[j]);
+			float64_t* x=batch.get_column_vector(j);
+			v[closest[j]]+=1.0;
+			float64_t eta=1.0/v[closest[j]];
+			for (int32_t c=0; c<dimensions; c++)
+				c_alive[c]=(1.0-eta)*c_alive[c]+eta*x[c];
+		}
+	}
+
+	CDenseFeatures<float64_t>* centers=new CDenseFeatures<float64_t>(mus);
+	distance->init(centers, centers);
+	R=SGVector<float64_t>(k);
+}
+
 void CKMeansMiniBatch::init_mb_params()
 {
 	batch_size=-1;
+	init_rounds=5;
+	oversampling=2.0;
 
 	SG_ADD(
 		&batch_size, "batch_size", "batch size for mini-batch KMeans",
 		MS_NOT_AVAILABLE);
+	SG_ADD(
+		&init_rounds, "init_rounds", "number of sampling passes of k-means||",
+		MS_NOT_AVAILABLE);
+	SG_ADD(
+		&oversampling, "oversampling", "oversampling factor of k-means||",
+		MS_NOT_AVAILABLE);
 }
 
 bool CKMeansMiniBatch::train_machine(CFeatures* data)
 {
-	initialize_training(data);
-	minibatch_KMeans();
+	if (data && data->get_feature_class()==C_STREAMING_DENSE)
+	{
+		REQUIRE(data->get_feature_type()==F_DREAL,
+			"Streaming features should be of type REAL\n");
+		REQUIRE(distance, "Distance is not provided\n");
+		streaming_KMeans((CStreamingDenseFeatures<float64_t>*) data);
+	}
+	else
+	{
+		initialize_training(data);
+		minibatch_KMeans();
+	}
 	compute_cluster_variances();
 	return true;
 }
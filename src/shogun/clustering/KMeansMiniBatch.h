@@ -18,8 +18,29 @@
 namespace shogun
 {
 class CKMeansBase;
+template <class T> class CStreamingDenseFeatures;
 	
-/** Class for the mini batch KMeans */
+/** Class for the mini batch KMeans
+ *
+ * Besides in-memory CDenseFeatures, the training data may be
+ * CStreamingDenseFeatures<float64_t>. Then each iteration reads the next
+ * batch of the stream, only one batch is kept in memory and its vectors are
+ * assigned to the centers in parallel. Seekable streams are reset when they
+ * end, other streams stop the training.
+ *
+ * Without initial centers, a seekable stream is initialized by k-means||
+ * in a fixed number of passes (init_rounds+3), see
+ *
+ * Bahmani, B. et al. (2012). Scalable K-Means++. Proceedings of the VLDB
+ * Endowment 5(7).
+ *
+ * k-means|| reads the whole stream once per pass, so it needs a seekable
+ * stream, i.e. one created from in-memory features or read from a file.
+ * Streams that cannot be reset, e.g. pipes, are initialized by k-means++ on
+ * their first batch with a warning, and the training stops at their end.
+ * To avoid the first-batch initialization for such streams, supply initial
+ * centers with set_initial_centers().
+ */
 class CKMeansMiniBatch : public CKMeansBase
 {
 	public:
@@ -65,6 +86,27 @@ class CKMeansMiniBatch : public CKMeansBase
 		 */
 		void set_mb_params(int32_t b, int32_t t);
 
+		/** set the number of sampling passes of the k-means||
+		 * initialization of streams, only used for seekable streams
+		 *
+		 *@param rounds number of passes (greater than 0)
+		 */
+		void set_init_rounds(int32_t rounds);
+
+		/** @return number of sampling passes of k-means|| */
+		int32_t get_init_rounds() const;
+
+		/** set the oversampling factor of k-means||, each pass samples
+		 * about oversampling*k candidate centers, only used for seekable
+		 * streams
+		 *
+		 *@param oversampling oversampling factor (greater than 0)
+		 */
+		void set_oversampling(float64_t oversampling);
+
+		/** @return oversampling factor of k-means|| */
+		float64_t get_oversampling() const;
+
 	protected:
 
 		/** train k-means
@@ -81,6 +123,20 @@ class CKMeansMiniBatch : public CKMeansBase
 		 */
 		void minibatch_KMeans();
 
+		/** mini-batch KMeans training method for streams
+		 *
+		 * @param stream training data
+		 */
+		void streaming_KMeans(CStreamingDenseFeatures<float64_t>* stream);
+
+		/** k-means|| initialization of the centers
+		 *
+		 * @param stream seekable training data, it is reset before each pass
+		 * @return initial cluster centers: matrix (k columns, dim rows)
+		 */
+		SGMatrix<float64_t> kmeans_parallel(
+			CStreamingDenseFeatures<float64_t>* stream);
+
 	private:
 
 		void init_mb_params();
@@ -90,10 +146,44 @@ class CKMeansMiniBatch : public CKMeansBase
 		 */
 		SGVector<int32_t> mbchoose_rand(int32_t b, int32_t num);
 
+		/* read the next vectors of a stream into the columns of batch
+		 *
+		 * @return number of vectors read, less than the batch size only at
+		 * the end of the stream
+		 */
+		int32_t read_batch(CStreamingDenseFeatures<float64_t>* stream,
+			SGMatrix<float64_t>& batch);
+
+		/* distance of the first num vectors of a batch to their closest
+		 * center, the distance's lhs must be the batch and its rhs the
+		 * centers
+		 *
+		 * @param num number of vectors
+		 * @param closest written with the index of the closest center
+		 * @param dists written with the distance to the closest center
+		 */
+		void assign_batch(int32_t num, SGVector<int32_t>& closest,
+			SGVector<float64_t>& dists);
+
+		/* k-means++ on weighted points
+		 *
+		 * @param points points, one per column
+		 * @param weights weight of each point
+		 * @return k points chosen as centers
+		 */
+		SGMatrix<float64_t> weighted_kmeanspp(SGMatrix<float64_t> points,
+			SGVector<float64_t> weights);
+
 	protected:
 
 		/** Batch size for mini-batch KMeans */
 		int32_t batch_size;
+
+		/** Number of sampling passes of k-means|| */
+		int32_t init_rounds;
+
+		/** Oversampling factor of k-means|| */
+		float64_t oversampling;
 };
 }
 #endif
@@ -22,6 +22,21 @@ class CFeatures;
 class CDistance;
 class CKernel;
 
+/** methods to find the nearest neighbors of local embedding methods */
+enum ENeighborsMethod
+{
+	/** exact, sorts the distances to all vectors */
+	NEIGHBORS_BRUTE,
+	/** exact, vantage point tree */
+	NEIGHBORS_VP_TREE,
+	/** exact, cover tree */
+	NEIGHBORS_COVER_TREE,
+	/** approximate, hierarchical navigable small world graph built in
+	 * parallel, see CHNSWIndex
+	 */
+	NEIGHBORS_HNSW
+};
+
 /** @brief class EmbeddingConverter (part of the Efficient Dimensionality
  * Reduction Toolkit) used to construct embeddings of
  * features, e.g. construct dense numeric embedding of string features
@@ -73,6 +88,16 @@ public:
 	 */
 	CKernel* get_kernel() const;
 
+	/** setter for the nearest neighbors method of local methods
+	 * @param method nearest neighbors method
+	 */
+	void set_neighbors_method(ENeighborsMethod method);
+
+	/** getter for the nearest neighbors method of local methods
+	 * @return nearest neighbors method
+	 */
+	ENeighborsMethod get_neighbors_method() const;
+
 	virtual const char* get_name() const { return "EmbeddingConverter"; };
 
 protected:
@@ -90,6 +115,9 @@ protected:
 
 	/** kernel to be used */
 	CKernel* m_kernel;
+
+	/** method to find the nearest neighbors */
+	ENeighborsMethod m_neighbors_method;
 };
 }
 
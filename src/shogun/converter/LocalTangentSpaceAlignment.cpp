@@ -32,6 +32,7 @@ CLocalTangentSpaceAlignment::transform(CFeatures* features, bool inplace)
 	CKernel* kernel = new CLinearKernel((CDotFeatures*)features,(CDotFeatures*)features);
 	TAPKEE_PARAMETERS_FOR_SHOGUN parameters;
 	parameters.n_neighbors = m_k;
+	parameters.neighbors_method = m_neighbors_method;
 	parameters.eigenshift = m_nullspace_shift;
 	parameters.method = SHOGUN_LOCAL_TANGENT_SPACE_ALIGNMENT;
 	parameters.target_dimension = m_target_dim;
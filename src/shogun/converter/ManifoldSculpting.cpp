@@ -81,6 +81,7 @@ CFeatures* CManifoldSculpting::transform(CFeatures* features, bool inplace)
 
 	TAPKEE_PARAMETERS_FOR_SHOGUN parameters;
 	parameters.n_neighbors = m_k;
+	parameters.neighbors_method = m_neighbors_method;
 	parameters.squishing_rate = m_squishing_rate;
 	parameters.max_iteration = m_max_iteration;
 	parameters.features = feats;
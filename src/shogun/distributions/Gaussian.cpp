@@ -6,6 +6,7 @@
  */
 #include <shogun/lib/config.h>
 
+#include <shogun/base/Parallel.h>
 #include <shogun/base/Parameter.h>
 #include <shogun/distributions/Gaussian.h>
 #include <shogun/mathematics/Math.h>
@@ -267,6 +268,52 @@ float64_t CGaussian::compute_log_PDF(SGVector<float64_t> point)
 	return -0.5 * answer;
 }
 
+void CGaussian::compute_log_PDF(SGMatrix<float64_t> points, SGVector<float64_t> result)
+{
+	ASSERT(m_mean.vector && m_d.vector)
+	REQUIRE(points.num_rows==m_mean.vlen,
+		"Points have %d dimensions, the Gaussian has %d\n", points.num_rows,
+		m_mean.vlen);
+	REQUIRE(result.vlen==points.num_cols,
+		"Result has %d entries for %d points\n", result.vlen, points.num_cols);
+
+	const int32_t dim=m_mean.vlen;
+	const int64_t block_size=256;
+
+	// with W'W the inverse covariance the exponent is |W*x-W*mean|^2
+	Eigen::VectorXd scale(dim);
+	for (int32_t i=0; i<dim; i++)
+		scale[i]=1.0/std::sqrt(m_cov_type==SPHERICAL ? m_d[0] : m_d[i]);
+
+	Eigen::Map<Eigen::VectorXd> mean(m_mean.vector, dim);
+	Eigen::MatrixXd whitening;
+	Eigen::VectorXd shift;
+	if (m_cov_type==FULL)
+	{
+		Eigen::Map<Eigen::MatrixXd> u(m_u.matrix, dim, dim);
+		whitening=scale.asDiagonal()*u.transpose();
+		shift=whitening*mean;
+	}
+
+	parallel->parallel_for(0, points.num_cols, [&](int64_t first, int64_t last)
+	{
+		Eigen::Map<Eigen::MatrixXd> block(
+			points.get_column_vector(first), dim, last-first);
+
+		Eigen::MatrixXd z;
+		if (m_cov_type==FULL)
+		{
+			z.noalias()=whitening*block;
+			z.colwise()-=shift;
+		}
+		else
+			z=scale.asDiagonal()*(block.colwise()-mean);
+
+		for (int64_t i=first; i<last; i++)
+			result[i]=-0.5*(m_constant+z.col(i-first).squaredNorm());
+	}, block_size);
+}
+
 SGVector<float64_t> CGaussian::get_mean()
 {
 	return m_mean;
@@ -121,6 +121,17 @@ class CGaussian : public CDistribution
 		 */
 		virtual float64_t compute_log_PDF(SGVector<float64_t> point);
 
+		/** compute log PDF of many points
+		 *
+		 * The whitening factor of the covariance is derived once, then each
+		 * block of points is evaluated by a single matrix product. Blocks
+		 * are processed in parallel.
+		 *
+		 * @param points points, one per column
+		 * @param result written with the log PDF of each point
+		 */
+		void compute_log_PDF(SGMatrix<float64_t> points, SGVector<float64_t> result);
+
 		/** get mean
 		 *
 		 * @return mean
@@ -13,12 +13,18 @@
 #include <shogun/base/Parallel.h>
 #include <shogun/features/StringFeatures.h>
 #include <shogun/features/Alphabet.h>
+#include <shogun/mathematics/eigen3.h>
 
 #include <stdlib.h>
 #include <stdio.h>
 #include <time.h>
 #include <ctype.h>
 
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <vector>
+
 #define VAL_MACRO log((default_value == 0) ? (CMath::random(MIN_RAND, MAX_RAND)) : default_value)
 #define ARRAY_SIZE 65336
 
@@ -1146,6 +1152,420 @@ float64_t CHMM::backward_comp_old(
 	}
 }
 
+/** model of a CHMM in the layouts used by the batched engine below. All
+ * per position quantities are state major, i.e. contiguous over the N
+ * states, so that the recursions work on whole vectors.
+ */
+struct HMMBatchModel
+{
+	HMMBatchModel(const CHMM* hmm) : N(hmm->get_N()), M(hmm->get_M()),
+		p(N), q(N), log_a(N*N), lin_a(N*N), log_b(N*M)
+	{
+		const float64_t log_min=std::log(std::numeric_limits<float64_t>::min());
+		for (int32_t i=0; i<N; i++)
+		{
+			p[i]=hmm->get_p(i);
+			q[i]=hmm->get_q(i);
+			for (int32_t j=0; j<N; j++)
+			{
+				// flush denormal probabilities so that the scaled counts
+				// of the E step stay finite
+				float64_t a=hmm->get_a(i, j);
+				log_a[j*N+i]=a;
+				lin_a[j*N+i]=a>log_min ? std::exp(a) : 0;
+			}
+			for (int32_t o=0; o<M; o++)
+				log_b[o*N+i]=hmm->get_b(i, o);
+		}
+	}
+
+	/** @return log emission probabilities of all states for a symbol */
+	const float64_t* emissions(uint16_t symbol) const
+	{
+		return &log_b[int64_t(symbol)*N];
+	}
+
+	int32_t N;
+	int32_t M;
+	/** log initial and end state distributions */
+	std::vector<float64_t> p, q;
+	/** log transitions, a(i,j) at j*N+i like CHMM::transition_matrix_a */
+	std::vector<float64_t> log_a;
+	/** transition probabilities in the same layout */
+	std::vector<float64_t> lin_a;
+	/** log emissions, b(i,o) at o*N+i */
+	std::vector<float64_t> log_b;
+};
+
+/** expected counts of the Baum-Welch E step in linear space, or the
+ * counts along the best paths for viterbi training */
+struct HMMCounts
+{
+	HMMCounts(int32_t N, int32_t M) : log_prob(0), p(N), q(N), xi(N*N), b(N*M)
+	{
+	}
+
+	HMMCounts& operator+=(const HMMCounts& other)
+	{
+		log_prob+=other.log_prob;
+		for (size_t i=0; i<p.size(); i++)
+		{
+			p[i]+=other.p[i];
+			q[i]+=other.q[i];
+		}
+		for (size_t i=0; i<xi.size(); i++)
+			xi[i]+=other.xi[i];
+		for (size_t i=0; i<b.size(); i++)
+			b[i]+=other.b[i];
+		return *this;
+	}
+
+	/** sum of the log likelihoods */
+	float64_t log_prob;
+	/** expected initial and end states */
+	std::vector<float64_t> p, q;
+	/** transitions, a(i,j) at j*N+i. For Baum-Welch divided by the
+	 * transition probability, which is multiplied in once at the end
+	 */
+	std::vector<float64_t> xi;
+	/** expected emissions, b(i,o) at o*N+i */
+	std::vector<float64_t> b;
+};
+
+/** trellis buffers of one chunk of sequences, grown on demand and reused
+ * across the sequences of the chunk
+ */
+struct HMMTrellis
+{
+	void resize(int32_t T, int32_t N)
+	{
+		if (alpha.size()<size_t(T)*N)
+			alpha.resize(size_t(T)*N);
+		if (psi.size()<size_t(T)*N)
+			psi.resize(size_t(T)*N);
+		if (path.size()<size_t(T))
+			path.resize(T);
+		if (beta.size()<size_t(N))
+		{
+			beta.resize(N);
+			next.resize(N);
+			scaled.resize(N);
+			weights.resize(N);
+		}
+	}
+
+	/** T x N forward variables or viterbi scores */
+	std::vector<float64_t> alpha;
+	/** T x N viterbi back pointers */
+	std::vector<T_STATES> psi;
+	/** best path */
+	std::vector<T_STATES> path;
+	/** buffers of N values */
+	std::vector<float64_t> beta, next, scaled, weights;
+};
+
+/** @return log(sum(exp(x))) over n values */
+static float64_t log_sum_exp(const float64_t* x, int32_t n)
+{
+	float64_t shift=*std::max_element(x, x+n);
+	if (shift==-CMath::INFTY)
+		return shift;
+
+	float64_t sum=0;
+	for (int32_t i=0; i<n; i++)
+		sum+=std::exp(x[i]-shift);
+	return shift+std::log(sum);
+}
+
+/** forward pass over a sequence. The log-sum-exp over the predecessor
+ * states shares one shift per position: with e=exp(alpha_{t-1}-max) the
+ * sums of all states are a single matrix vector product with the
+ * transition probabilities, instead of N^2 pairwise logarithmic sums.
+ * States whose sum underflows to zero are summed in log space on their own.
+ *
+ * @param model model
+ * @param obs sequence
+ * @param T length of the sequence
+ * @param trellis written with the log forward variables
+ * @return log likelihood of the sequence
+ */
+static float64_t forward_trellis(const HMMBatchModel& model,
+		const uint16_t* obs, int32_t T, HMMTrellis& trellis)
+{
+	int32_t N=model.N;
+	Eigen::Map<const Eigen::MatrixXd> A(model.lin_a.data(), N, N);
+	Eigen::Map<Eigen::VectorXd> scaled(trellis.scaled.data(), N);
+	float64_t* alpha=trellis.alpha.data();
+
+	const float64_t* b=model.emissions(obs[0]);
+	for (int32_t i=0; i<N; i++)
+		alpha[i]=model.p[i]+b[i];
+
+	for (int32_t t=1; t<T; t++)
+	{
+		const float64_t* prev=alpha+int64_t(t-1)*N;
+		float64_t* cur=alpha+int64_t(t)*N;
+		float64_t shift=*std::max_element(prev, prev+N);
+		if (shift==-CMath::INFTY)
+		{
+			std::fill(cur, cur+N, -CMath::INFTY);
+			continue;
+		}
+
+		for (int32_t i=0; i<N; i++)
+			scaled[i]=std::exp(prev[i]-shift);
+
+		Eigen::Map<Eigen::VectorXd>(cur, N).noalias()=A.transpose()*scaled;
+
+		b=model.emissions(obs[t]);
+		for (int32_t j=0; j<N; j++)
+		{
+			if (cur[j]>0)
+			{
+				cur[j]=shift+std::log(cur[j])+b[j];
+				continue;
+			}
+
+			// all products underflowed, e.g. for predecessors far below the
+			// maximum or flushed transitions, sum this state in log space
+			float64_t* terms=trellis.next.data();
+			const float64_t* log_a=&model.log_a[int64_t(j)*N];
+			for (int32_t i=0; i<N; i++)
+				terms[i]=prev[i]+log_a[i];
+			cur[j]=log_sum_exp(terms, N)+b[j];
+		}
+	}
+
+	const float64_t* last=alpha+int64_t(T-1)*N;
+	float64_t* scores=trellis.next.data();
+	for (int32_t i=0; i<N; i++)
+		scores[i]=last[i]+model.q[i];
+	return log_sum_exp(scores, N);
+}
+
+/** backward pass over a sequence whose forward trellis was computed by
+ * forward_trellis(), adding its expected state, transition and emission
+ * counts. Sequences the model cannot emit carry no counts. Like in the
+ * forward pass, states whose scaled sum underflows are summed in log
+ * space.
+ *
+ * @param model model
+ * @param obs sequence
+ * @param T length of the sequence
+ * @param log_prob log likelihood of the sequence
+ * @param trellis trellis with the forward variables
+ * @param counts counts to add to
+ */
+static void backward_counts(const HMMBatchModel& model, const uint16_t* obs,
+		int32_t T, float64_t log_prob, HMMTrellis& trellis, HMMCounts& counts)
+{
+	if (!CMath::is_finite(log_prob))
+		return;
+
+	int32_t N=model.N;
+	Eigen::Map<const Eigen::MatrixXd> A(model.lin_a.data(), N, N);
+	Eigen::Map<Eigen::MatrixXd> xi(counts.xi.data(), N, N);
+	Eigen::Map<Eigen::VectorXd> beta(trellis.beta.data(), N);
+	Eigen::Map<Eigen::VectorXd> scaled(trellis.scaled.data(), N);
+	Eigen::Map<Eigen::VectorXd> weights(trellis.weights.data(), N);
+	float64_t* next=trellis.next.data();
+	const float64_t* alpha=trellis.alpha.data();
+
+	const float64_t* alpha_t=alpha+int64_t(T-1)*N;
+	float64_t* b_count=&counts.b[int64_t(obs[T-1])*N];
+	for (int32_t i=0; i<N; i++)
+	{
+		beta[i]=model.q[i];
+		float64_t gamma=std::exp(alpha_t[i]+beta[i]-log_prob);
+		counts.q[i]+=gamma;
+		b_count[i]+=gamma;
+	}
+
+	for (int32_t t=T-2; t>=0; t--)
+	{
+		alpha_t=alpha+int64_t(t)*N;
+
+		// next=b(.,o_t+1)+beta_t+1, scaled=exp(next-shift)
+		const float64_t* b=model.emissions(obs[t+1]);
+		for (int32_t j=0; j<N; j++)
+			next[j]=b[j]+beta[j];
+		float64_t shift=*std::max_element(next, next+N);
+		if (shift==-CMath::INFTY)
+		{
+			beta.setConstant(-CMath::INFTY);
+			continue;
+		}
+		for (int32_t j=0; j<N; j++)
+			scaled[j]=std::exp(next[j]-shift);
+
+		// xi(i,j)*a(i,j)=exp(alpha_t(i)+shift-log_prob)*a(i,j)*scaled(j),
+		// the rank one update adds the first and last factor
+		bool overflow=false;
+		for (int32_t i=0; i<N; i++)
+		{
+			float64_t exponent=alpha_t[i]+shift-log_prob;
+			overflow|=exponent>700;
+			weights[i]=std::exp(exponent);
+		}
+		if (!overflow)
+			xi.noalias()+=weights*scaled.transpose();
+		else
+		{
+			// states which can only reach very unlikely successors,
+			// fall back to one exponential per transition
+			for (int32_t j=0; j<N; j++)
+			{
+				for (int32_t i=0; i<N; i++)
+				{
+					if (A(i, j)>0)
+						xi(i, j)+=std::exp(alpha_t[i]+next[j]-log_prob);
+				}
+			}
+		}
+
+		beta.noalias()=A*scaled;
+		b_count=&counts.b[int64_t(obs[t])*N];
+		for (int32_t i=0; i<N; i++)
+		{
+			if (beta[i]>0)
+				beta[i]=shift+std::log(beta[i]);
+			else
+			{
+				// all successors underflowed, sum this state in log space
+				float64_t* terms=trellis.scaled.data();
+				for (int32_t j=0; j<N; j++)
+					terms[j]=model.log_a[int64_t(j)*N+i]+next[j];
+				beta[i]=log_sum_exp(terms, N);
+			}
+			float64_t gamma=std::exp(alpha_t[i]+beta[i]-log_prob);
+			b_count[i]+=gamma;
+			if (t==0)
+				counts.p[i]+=gamma;
+		}
+	}
+
+	if (T==1)
+	{
+		for (int32_t i=0; i<N; i++)
+			counts.p[i]+=std::exp(alpha[i]+model.q[i]-log_prob);
+	}
+}
+
+/** viterbi algorithm on a sequence
+ *
+ * @param model model
+ * @param obs sequence
+ * @param T length of the sequence
+ * @param trellis workspace, written with the best path if with_path
+ * @param with_path whether to backtrack the best path
+ * @return log probability of the best path
+ */
+static float64_t viterbi_trellis(const HMMBatchModel& model,
+		const uint16_t* obs, int32_t T, HMMTrellis& trellis, bool with_path)
+{
+	int32_t N=model.N;
+	float64_t* delta=trellis.beta.data();
+	float64_t* delta_new=trellis.next.data();
+	T_STATES* psi=trellis.psi.data();
+
+	const float64_t* b=model.emissions(obs[0]);
+	for (int32_t i=0; i<N; i++)
+		delta[i]=model.p[i]+b[i];
+
+	for (int32_t t=1; t<T; t++)
+	{
+		b=model.emissions(obs[t]);
+		T_STATES* psi_t=psi+int64_t(t)*N;
+		for (int32_t j=0; j<N; j++)
+		{
+			const float64_t* a=&model.log_a[int64_t(j)*N];
+			float64_t maxj=delta[0]+a[0];
+			int32_t argmax=0;
+			for (int32_t i=1; i<N; i++)
+			{
+				float64_t temp=delta[i]+a[i];
+				if (temp>maxj)
+				{
+					maxj=temp;
+					argmax=i;
+				}
+			}
+			delta_new[j]=maxj+b[j];
+			psi_t[j]=argmax;
+		}
+		std::swap(delta, delta_new);
+	}
+
+	float64_t maxj=delta[0]+model.q[0];
+	int32_t argmax=0;
+	for (int32_t i=1; i<N; i++)
+	{
+		float64_t temp=delta[i]+model.q[i];
+		if (temp>maxj)
+		{
+			maxj=temp;
+			argmax=i;
+		}
+	}
+
+	if (with_path)
+	{
+		T_STATES* path=trellis.path.data();
+		path[T-1]=argmax;
+		for (int32_t t=T-1; t>0; t--)
+			path[t-1]=psi[int64_t(t)*N+path[t]];
+	}
+	return maxj;
+}
+
+/** run a body over the sequences of a CHMM on the thread pool, one chunk
+ * of sequences per thread, and sum up the per chunk results in chunk order
+ * so that the result does not depend on the scheduling. The trellis
+ * buffers are only kept for the duration of the call.
+ *
+ * @param parallel thread pool
+ * @param obs sequences
+ * @param N number of states
+ * @param zero neutral element, also the initial chunk result
+ * @param body called with a sequence, its length, the trellis of the
+ * chunk, sized for the sequence, and the chunk result
+ * @return sum of the chunk results
+ */
+template <class R>
+static R sum_over_sequences(Parallel* parallel, CStringFeatures<uint16_t>* obs,
+		int32_t N, const R& zero, const std::function<void(const uint16_t*,
+			int32_t, HMMTrellis&, R&)>& body)
+{
+	int64_t num=obs->get_num_vectors();
+	int64_t num_chunks=CMath::max<int64_t>(1,
+			CMath::min<int64_t>(parallel->get_num_threads(), num));
+	int64_t grain=(num+num_chunks-1)/num_chunks;
+	std::vector<R> partial(num_chunks, zero);
+	std::vector<HMMTrellis> trellises(num_chunks);
+	parallel->parallel_for(0, num, [&](int64_t first, int64_t last)
+	{
+		R& result=partial[first/grain];
+		HMMTrellis& trellis=trellises[first/grain];
+		for (int64_t dim=first; dim<last; dim++)
+		{
+			int32_t len=0;
+			bool free_vec=false;
+			uint16_t* vec=obs->get_feature_vector(dim, len, free_vec);
+			if (len>0)
+			{
+				trellis.resize(len, N);
+				body(vec, len, trellis, result);
+			}
+			obs->free_feature_vector(vec, dim, free_vec);
+		}
+	}, grain);
+
+	R result=zero;
+	for (const auto& p: partial)
+		result+=p;
+	return result;
+}
+
 //calculates probability  of best path through the model lambda AND path itself
 //using viterbi algorithm
 float64_t CHMM::best_path(int32_t dimension)
@@ -1158,9 +1578,13 @@ float64_t CHMM::best_path(int32_t dimension)
 		if (!all_path_prob_updated)
 		{
 			SG_INFO("computing full viterbi likelihood\n")
-			float64_t sum = 0 ;
-			for (int32_t i=0; i<p_observations->get_num_vectors(); i++)
-				sum+=best_path(i) ;
+			HMMBatchModel batch(this);
+			float64_t sum=sum_over_sequences<float64_t>(parallel, p_observations,
+				N, 0.0, [&](const uint16_t* obs, int32_t len, HMMTrellis& trellis,
+					float64_t& result)
+				{
+					result+=viterbi_trellis(batch, obs, len, trellis, false);
+				});
 			sum /= p_observations->get_num_vectors() ;
 			all_pat_prob=sum ;
 			all_path_prob_updated=true ;
@@ -1275,61 +1699,93 @@ float64_t CHMM::best_path(int32_t dimension)
 	}
 }
 
-#ifndef USE_HMMPARALLEL
 float64_t CHMM::model_probability_comp()
 {
 	//for faster calculation cache model probability
-	mod_prob=0 ;
-	for (int32_t dim=0; dim<p_observations->get_num_vectors(); dim++) //sum in log space
-		mod_prob+=forward(p_observations->get_vector_length(dim), 0, dim);
+	HMMBatchModel batch(this);
+	mod_prob=sum_over_sequences<float64_t>(parallel, p_observations, N, 0.0,
+		[&](const uint16_t* obs, int32_t len, HMMTrellis& trellis,
+			float64_t& result)
+		{
+			result+=forward_trellis(batch, obs, len, trellis);
+		});
 
 	mod_prob_updated=true;
 	return mod_prob;
 }
 
-#else
-
-float64_t CHMM::model_probability_comp()
+//estimates new model lambda out of lambda_estimate using baum welch algorithm
+void CHMM::estimate_model_baum_welch(CHMM* estimate)
 {
-	pthread_t *threads=SG_MALLOC(pthread_t, parallel->get_num_threads());
-	S_BW_THREAD_PARAM *params=SG_MALLOC(S_BW_THREAD_PARAM, parallel->get_num_threads());
-
-	SG_INFO("computing full model probablity\n")
-	mod_prob=0;
-
-	for (int32_t cpu=0; cpu<parallel->get_num_threads(); cpu++)
-	{
-		params[cpu].hmm=this ;
-		params[cpu].dim_start= p_observations->get_num_vectors()*cpu/parallel->get_num_threads();
-		params[cpu].dim_stop= p_observations->get_num_vectors()*(cpu+1)/parallel->get_num_threads();
-		params[cpu].p_buf=SG_MALLOC(float64_t, N);
-		params[cpu].q_buf=SG_MALLOC(float64_t, N);
-		params[cpu].a_buf=SG_MALLOC(float64_t, N*N);
-		params[cpu].b_buf=SG_MALLOC(float64_t, N*M);
-		pthread_create(&threads[cpu], NULL, bw_dim_prefetch, (void*)&params[cpu]);
-	}
+	int32_t i,j;
 
-	for (int32_t cpu=0; cpu<parallel->get_num_threads(); cpu++)
+	//clear actual model a,b,p,q are used as numerator
+	for (i=0; i<N; i++)
 	{
-		pthread_join(threads[cpu], NULL);
-		mod_prob+=params[cpu].ret;
+		if (estimate->get_p(i)>CMath::ALMOST_NEG_INFTY)
+			set_p(i,log(PSEUDO));
+		else
+			set_p(i,estimate->get_p(i));
+		if (estimate->get_q(i)>CMath::ALMOST_NEG_INFTY)
+			set_q(i,log(PSEUDO));
+		else
+			set_q(i,estimate->get_q(i));
+
+		for (j=0; j<N; j++)
+			if (estimate->get_a(i,j)>CMath::ALMOST_NEG_INFTY)
+				set_a(i,j, log(PSEUDO));
+			else
+				set_a(i,j,estimate->get_a(i,j));
+		for (j=0; j<M; j++)
+			if (estimate->get_b(i,j)>CMath::ALMOST_NEG_INFTY)
+				set_b(i,j, log(PSEUDO));
+			else
+				set_b(i,j,estimate->get_b(i,j));
 	}
+	invalidate_model();
 
-	for (int32_t i=0; i<parallel->get_num_threads(); i++)
+	//expected counts of all sequences, computed in parallel
+	HMMBatchModel batch(estimate);
+	HMMCounts counts=sum_over_sequences<HMMCounts>(parallel, p_observations,
+		N, HMMCounts(N, M), [&](const uint16_t* obs, int32_t len,
+			HMMTrellis& trellis, HMMCounts& result)
+		{
+			float64_t dimmodprob=forward_trellis(batch, obs, len, trellis);
+			backward_counts(batch, obs, len, dimmodprob, trellis, result);
+			result.log_prob+=dimmodprob;
+		});
+
+	auto add_count=[](float64_t numerator, float64_t count)
+	{
+		return count>0 ? CMath::logarithmic_sum(numerator, log(count)) : numerator;
+	};
+
+	for (i=0; i<N; i++)
 	{
-		SG_FREE(params[i].p_buf);
-		SG_FREE(params[i].q_buf);
-		SG_FREE(params[i].a_buf);
-		SG_FREE(params[i].b_buf);
+		//estimate initial+end state distribution numerator
+		set_p(i, add_count(get_p(i), counts.p[i]));
+		set_q(i, add_count(get_q(i), counts.q[i]));
+
+		//estimate numerator for a
+		for (j=0; j<N; j++)
+			set_a(i,j, add_count(get_a(i,j), batch.lin_a[j*N+i]*counts.xi[j*N+i]));
+
+		//estimate numerator for b
+		for (j=0; j<M; j++)
+			set_b(i,j, add_count(get_b(i,j), counts.b[j*N+i]));
 	}
 
-	SG_FREE(threads);
-	SG_FREE(params);
+	//cache estimate model probability
+	estimate->mod_prob=counts.log_prob;
+	estimate->mod_prob_updated=true ;
 
-	mod_prob_updated=true;
-	return mod_prob;
+	//new model probability is unknown
+	normalize();
+	invalidate_model();
 }
 
+#ifdef USE_HMMPARALLEL
+
 void* CHMM::bw_dim_prefetch(void* params)
 {
 	CHMM* hmm=((S_BW_THREAD_PARAM*) params)->hmm;
@@ -1368,10 +1824,6 @@ void* CHMM::vit_dim_prefetch(void * params)
 	return NULL ;
 }
 
-#endif //USE_HMMPARALLEL
-
-
-#ifdef USE_HMMPARALLEL
 
 void CHMM::ab_buf_comp(
 	float64_t* p_buf, float64_t* q_buf, float64_t *a_buf, float64_t* b_buf,
@@ -1418,197 +1870,8 @@ void CHMM::ab_buf_comp(
 	}
 }
 
-//estimates new model lambda out of lambda_train using baum welch algorithm
-void CHMM::estimate_model_baum_welch(CHMM* hmm)
-{
-	int32_t i,j,cpu;
-	float64_t fullmodprob=0;	//for all dims
-
-	//clear actual model a,b,p,q are used as numerator
-	for (i=0; i<N; i++)
-	{
-	  if (hmm->get_p(i)>CMath::ALMOST_NEG_INFTY)
-	    set_p(i,log(PSEUDO));
-	  else
-	    set_p(i,hmm->get_p(i));
-	  if (hmm->get_q(i)>CMath::ALMOST_NEG_INFTY)
-	    set_q(i,log(PSEUDO));
-	  else
-	    set_q(i,hmm->get_q(i));
-
-	  for (j=0; j<N; j++)
-	    if (hmm->get_a(i,j)>CMath::ALMOST_NEG_INFTY)
-	      set_a(i,j, log(PSEUDO));
-	    else
-	      set_a(i,j,hmm->get_a(i,j));
-	  for (j=0; j<M; j++)
-	    if (hmm->get_b(i,j)>CMath::ALMOST_NEG_INFTY)
-	      set_b(i,j, log(PSEUDO));
-	    else
-	      set_b(i,j,hmm->get_b(i,j));
-	}
-	invalidate_model();
-
-	int32_t num_threads = parallel->get_num_threads();
-
-	pthread_t *threads=SG_MALLOC(pthread_t, num_threads);
-	S_BW_THREAD_PARAM *params=SG_MALLOC(S_BW_THREAD_PARAM, num_threads);
-
-	if (p_observations->get_num_vectors()<num_threads)
-		num_threads=p_observations->get_num_vectors();
-
-	for (cpu=0; cpu<num_threads; cpu++)
-	{
-		params[cpu].p_buf=SG_MALLOC(float64_t, N);
-		params[cpu].q_buf=SG_MALLOC(float64_t, N);
-		params[cpu].a_buf=SG_MALLOC(float64_t, N*N);
-		params[cpu].b_buf=SG_MALLOC(float64_t, N*M);
-
-		params[cpu].hmm=hmm;
-		int32_t start = p_observations->get_num_vectors()*cpu / num_threads;
-		int32_t stop=p_observations->get_num_vectors()*(cpu+1) / num_threads;
-
-		if (cpu == parallel->get_num_threads()-1)
-			stop=p_observations->get_num_vectors();
-
-		ASSERT(start<stop)
-		params[cpu].dim_start=start;
-		params[cpu].dim_stop=stop;
-
-		pthread_create(&threads[cpu], NULL, bw_dim_prefetch, &params[cpu]);
-	}
-
-	for (cpu=0; cpu<num_threads; cpu++)
-	{
-		pthread_join(threads[cpu], NULL);
-
-		for (i=0; i<N; i++)
-		{
-			//estimate initial+end state distribution numerator
-			set_p(i, CMath::logarithmic_sum(get_p(i), params[cpu].p_buf[i]));
-			set_q(i, CMath::logarithmic_sum(get_q(i), params[cpu].q_buf[i]));
-
-			//estimate numerator for a
-			for (j=0; j<N; j++)
-				set_a(i,j, CMath::logarithmic_sum(get_a(i,j), params[cpu].a_buf[N*i+j]));
-
-			//estimate numerator for b
-			for (j=0; j<M; j++)
-				set_b(i,j, CMath::logarithmic_sum(get_b(i,j), params[cpu].b_buf[M*i+j]));
-		}
-
-		fullmodprob+=params[cpu].ret;
-
-	}
-
-	for (cpu=0; cpu<num_threads; cpu++)
-	{
-		SG_FREE(params[cpu].p_buf);
-		SG_FREE(params[cpu].q_buf);
-		SG_FREE(params[cpu].a_buf);
-		SG_FREE(params[cpu].b_buf);
-	}
-
-	SG_FREE(threads);
-	SG_FREE(params);
-
-	//cache hmm model probability
-	hmm->mod_prob=fullmodprob;
-	hmm->mod_prob_updated=true ;
-
-	//new model probability is unknown
-	normalize();
-	invalidate_model();
-}
-
 #else // USE_HMMPARALLEL
 
-//estimates new model lambda out of lambda_estimate using baum welch algorithm
-void CHMM::estimate_model_baum_welch(CHMM* estimate)
-{
-	int32_t i,j,t,dim;
-	float64_t a_sum, b_sum;	//numerator
-	float64_t dimmodprob=0;	//model probability for dim
-	float64_t fullmodprob=0;	//for all dims
-
-	//clear actual model a,b,p,q are used as numerator
-	for (i=0; i<N; i++)
-	{
-		if (estimate->get_p(i)>CMath::ALMOST_NEG_INFTY)
-			set_p(i,log(PSEUDO));
-		else
-			set_p(i,estimate->get_p(i));
-		if (estimate->get_q(i)>CMath::ALMOST_NEG_INFTY)
-			set_q(i,log(PSEUDO));
-		else
-			set_q(i,estimate->get_q(i));
-
-		for (j=0; j<N; j++)
-			if (estimate->get_a(i,j)>CMath::ALMOST_NEG_INFTY)
-				set_a(i,j, log(PSEUDO));
-			else
-				set_a(i,j,estimate->get_a(i,j));
-		for (j=0; j<M; j++)
-			if (estimate->get_b(i,j)>CMath::ALMOST_NEG_INFTY)
-				set_b(i,j, log(PSEUDO));
-			else
-				set_b(i,j,estimate->get_b(i,j));
-	}
-	invalidate_model();
-
-	//change summation order to make use of alpha/beta caches
-	for (dim=0; dim<p_observations->get_num_vectors(); dim++)
-	{
-		dimmodprob=estimate->model_probability(dim);
-		fullmodprob+=dimmodprob ;
-
-		for (i=0; i<N; i++)
-		{
-			//estimate initial+end state distribution numerator
-			set_p(i, CMath::logarithmic_sum(get_p(i), estimate->get_p(i)+estimate->get_b(i,p_observations->get_feature(dim,0))+estimate->backward(0,i,dim) - dimmodprob));
-			set_q(i, CMath::logarithmic_sum(get_q(i), estimate->forward(p_observations->get_vector_length(dim)-1, i, dim)+estimate->get_q(i) - dimmodprob ));
-
-			int32_t num = trans_list_backward_cnt[i] ;
-
-			//estimate a
-			for (j=0; j<num; j++)
-			{
-				int32_t jj = trans_list_backward[i][j] ;
-				a_sum=-CMath::INFTY;
-
-				for (t=0; t<p_observations->get_vector_length(dim)-1; t++)
-				{
-					a_sum= CMath::logarithmic_sum(a_sum, estimate->forward(t,i,dim)+
-							estimate->get_a(i,jj)+estimate->get_b(jj,p_observations->get_feature(dim,t+1))+estimate->backward(t+1,jj,dim));
-				}
-				set_a(i,jj, CMath::logarithmic_sum(get_a(i,jj), a_sum-dimmodprob));
-			}
-
-			//estimate b
-			for (j=0; j<M; j++)
-			{
-				b_sum=-CMath::INFTY;
-
-				for (t=0; t<p_observations->get_vector_length(dim); t++)
-				{
-					if (p_observations->get_feature(dim,t)==j)
-						b_sum=CMath::logarithmic_sum(b_sum, estimate->forward(t,i,dim)+estimate->backward(t, i, dim));
-				}
-
-				set_b(i,j, CMath::logarithmic_sum(get_b(i,j), b_sum-dimmodprob));
-			}
-		}
-	}
-
-	//cache estimate model probability
-	estimate->mod_prob=fullmodprob;
-	estimate->mod_prob_updated=true ;
-
-	//new model probability is unknown
-	normalize();
-	invalidate_model();
-}
-
 //estimates new model lambda out of lambda_estimate using baum welch algorithm
 void CHMM::estimate_model_baum_welch_old(CHMM* estimate)
 {
@@ -1943,86 +2206,47 @@ void CHMM::estimate_model_baum_welch_defined(CHMM* estimate)
 //estimates new model lambda out of lambda_estimate using viterbi algorithm
 void CHMM::estimate_model_viterbi(CHMM* estimate)
 {
-	int32_t i,j,t;
+	int32_t i,j;
 	float64_t sum;
 	float64_t* P=ARRAYN1(0);
 	float64_t* Q=ARRAYN2(0);
 
 	path_deriv_updated=false ;
 
-	//initialize with pseudocounts
-	for (i=0; i<N; i++)
-	{
-		for (j=0; j<N; j++)
-			set_A(i,j, PSEUDO);
-
-		for (j=0; j<M; j++)
-			set_B(i,j, PSEUDO);
-
-		P[i]=PSEUDO;
-		Q[i]=PSEUDO;
-	}
-
-	float64_t allpatprob=0 ;
-
-#ifdef USE_HMMPARALLEL
-	int32_t num_threads = parallel->get_num_threads();
-	pthread_t *threads=SG_MALLOC(pthread_t, num_threads);
-	S_DIM_THREAD_PARAM *params=SG_MALLOC(S_DIM_THREAD_PARAM, num_threads);
-
-	if (p_observations->get_num_vectors()<num_threads)
-		num_threads=p_observations->get_num_vectors();
-#endif
-
-	for (int32_t dim=0; dim<p_observations->get_num_vectors(); dim++)
-	{
-
-#ifdef USE_HMMPARALLEL
-		if (dim%num_threads==0)
+	//counting occurences along the best paths of all sequences in parallel
+	HMMBatchModel batch(estimate);
+	HMMCounts counts=sum_over_sequences<HMMCounts>(parallel, p_observations,
+		N, HMMCounts(N, M), [&](const uint16_t* obs, int32_t len,
+			HMMTrellis& trellis, HMMCounts& result)
 		{
-			for (i=0; i<num_threads; i++)
-			{
-				if (dim+i<p_observations->get_num_vectors())
-				{
-					params[i].hmm=estimate ;
-					params[i].dim=dim+i ;
-					pthread_create(&threads[i], NULL, vit_dim_prefetch, (void*)&params[i]) ;
-				}
-			}
-			for (i=0; i<num_threads; i++)
+			result.log_prob+=viterbi_trellis(batch, obs, len, trellis, true);
+
+			const T_STATES* best=trellis.path.data();
+			for (int32_t t=0; t<len-1; t++)
 			{
-				if (dim+i<p_observations->get_num_vectors())
-				{
-					pthread_join(threads[i], NULL);
-					allpatprob += params[i].prob_sum;
-				}
+				result.xi[best[t+1]*N+best[t]]++;
+				result.b[obs[t]*N+best[t]]++;
 			}
-		}
-#else
-		//using viterbi to find best path
-		allpatprob += estimate->best_path(dim);
-#endif // USE_HMMPARALLEL
+			result.b[obs[len-1]*N+best[len-1]]++;
 
-		//counting occurences for A and B
-		for (t=0; t<p_observations->get_vector_length(dim)-1; t++)
-		{
-			set_A(estimate->PATH(dim)[t], estimate->PATH(dim)[t+1], get_A(estimate->PATH(dim)[t], estimate->PATH(dim)[t+1])+1);
-			set_B(estimate->PATH(dim)[t], p_observations->get_feature(dim,t),  get_B(estimate->PATH(dim)[t], p_observations->get_feature(dim,t))+1);
-		}
+			result.p[best[0]]++;
+			result.q[best[len-1]]++;
+		});
 
-		set_B(estimate->PATH(dim)[p_observations->get_vector_length(dim)-1], p_observations->get_feature(dim,p_observations->get_vector_length(dim)-1),  get_B(estimate->PATH(dim)[p_observations->get_vector_length(dim)-1], p_observations->get_feature(dim,p_observations->get_vector_length(dim)-1)) + 1 );
+	//add pseudocounts
+	for (i=0; i<N; i++)
+	{
+		for (j=0; j<N; j++)
+			set_A(i,j, PSEUDO+counts.xi[j*N+i]);
 
-		P[estimate->PATH(dim)[0]]++;
-		Q[estimate->PATH(dim)[p_observations->get_vector_length(dim)-1]]++;
-	}
+		for (j=0; j<M; j++)
+			set_B(i,j, PSEUDO+counts.b[j*N+i]);
 
-#ifdef USE_HMMPARALLEL
-	SG_FREE(threads);
-	SG_FREE(params);
-#endif
+		P[i]=PSEUDO+counts.p[i];
+		Q[i]=PSEUDO+counts.q[i];
+	}
 
-	allpatprob/=p_observations->get_num_vectors() ;
-	estimate->all_pat_prob=allpatprob ;
+	estimate->all_pat_prob=counts.log_prob/p_observations->get_num_vectors();
 	estimate->all_path_prob_updated=true ;
 
 	//converting A to probability measure a
@@ -554,6 +554,7 @@ class CHMM : public CDistribution
 		/** calculates probability of best state sequence s_0,...,s_T-1 AND path itself using viterbi algorithm.
 		 * The path can be found in the array PATH(dimension)[0..T-1] afterwards
 		 * @param dimension dimension of observation for which the most probable path is calculated (observations are a matrix, where a row stands for one dimension i.e. 0_0,O_1,...,O_{T-1}
+		 * or -1 for the average over all observations, computed in parallel without storing the paths
 		 */
 		float64_t best_path(int32_t dimension);
 		inline uint16_t get_best_path_state(int32_t dim, int32_t t)
@@ -563,7 +564,8 @@ class CHMM : public CDistribution
 		}
 
 		/// calculates probability that observations were generated
-		/// by the model using forward algorithm.
+		/// by the model using forward algorithm, the sequences are
+		/// processed in parallel.
 		float64_t model_probability_comp() ;
 
 		/// inline proxy for model probability.
@@ -632,6 +634,8 @@ class CHMM : public CDistribution
 		*/
 		//@{
 		/** uses baum-welch-algorithm to train a fully connected HMM.
+		 * The expected counts are computed in parallel over the sequences,
+		 * each worker reusing its forward trellis across iterations.
 		 * @param train model from which the new model is estimated
 		 */
 		void estimate_model_baum_welch(CHMM* train);
@@ -650,7 +654,8 @@ class CHMM : public CDistribution
 		 */
 		void estimate_model_baum_welch_defined(CHMM* train);
 
-		/** uses viterbi training to train a fully connected HMM
+		/** uses viterbi training to train a fully connected HMM, the best
+		 * paths are computed in parallel over the sequences
 		 * @param train model from which the new model is estimated
 		 */
 		void estimate_model_viterbi(CHMM* train);
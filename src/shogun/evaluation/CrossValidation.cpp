@@ -6,6 +6,7 @@
  *          Leon Kuchenbecker
  */
 
+#include <shogun/base/Parallel.h>
 #include <shogun/base/Parameter.h>
 #include <shogun/base/progress.h>
 #include <shogun/evaluation/CrossValidation.h>
@@ -50,8 +51,16 @@ CCrossValidation::~CCrossValidation()
 void CCrossValidation::init()
 {
 	m_num_runs = 1;
+	m_parallel_evaluation = false;
+	m_num_evaluated_folds = 0;
 
 	SG_ADD(&m_num_runs, "num_runs", "Number of repetitions", MS_NOT_AVAILABLE);
+	SG_ADD(
+	    &m_parallel_evaluation, "parallel_evaluation",
+	    "Whether folds and runs are evaluated in parallel", MS_NOT_AVAILABLE);
+	SG_ADD(
+	    &m_num_evaluated_folds, "num_evaluated_folds",
+	    "Number of folds evaluated in each run", MS_NOT_AVAILABLE);
 }
 
 CEvaluationResult* CCrossValidation::evaluate_impl()
@@ -91,30 +100,62 @@ CEvaluationResult* CCrossValidation::evaluate_impl()
 
 	/* perform all the x-val runs */
 	SG_DEBUG("starting %d runs of cross-validation\n", m_num_runs)
-	for (auto i : SG_PROGRESS(range(m_num_runs)))
+	if (m_parallel_evaluation && !m_machine->is_data_locked() &&
+	    m_num_runs > 1)
 	{
-		/* evtl. update xvalidation output class */
-		SG_DEBUG("Creating CrossValidationStorage.\n")
-		CrossValidationStorage* storage = new CrossValidationStorage();
-		SG_REF(storage)
-		storage->set_num_runs(m_num_runs);
-		storage->set_num_folds(m_splitting_strategy->get_num_subsets());
-		storage->set_expose_labels(m_labels);
-		storage->post_init();
-		SG_DEBUG("Ending CrossValidationStorage initilization.\n")
-
-		SG_DEBUG("entering cross-validation run %d \n", i)
-		results[i] = evaluate_one_run(i, storage);
-		SG_DEBUG("result of cross-validation run %d is %f\n", i, results[i])
-
-		/* Emit the value*/
-		std::string obs_value_name{"cross_validation_run"};
-		ObservedValue cv_data{i, obs_value_name, make_any(storage),
-		                      CROSSVALIDATION};
-		observe(cv_data);
-		SG_UNREF(storage)
+		/* draw the splits of all runs in run order, so that they do not
+		 * depend on the order the runs are executed in */
+		if (m_run_train_indices.empty())
+			build_run_subsets();
+
+		std::vector<CrossValidationStorage*> storages(m_num_runs);
+		for (int32_t i = 0; i < m_num_runs; ++i)
+			storages[i] = create_run_storage();
+
+		auto pb = SG_PROGRESS(range(m_num_runs));
+		parallel->parallel_for(
+		    0, m_num_runs,
+		    [&](int64_t begin, int64_t end) {
+			    for (int64_t i = begin; i < end; ++i)
+			    {
+				    SG_DEBUG("entering cross-validation run %d \n", i)
+				    results[i] = evaluate_one_run(i, storages[i]);
+				    SG_DEBUG(
+				        "result of cross-validation run %d is %f\n", i,
+				        results[i])
+				    pb.print_progress();
+			    }
+		    },
+		    1);
+		pb.complete();
+
+		/* emit the runs in order */
+		for (int32_t i = 0; i < m_num_runs; ++i)
+		{
+			observe_run(i, storages[i]);
+			SG_UNREF(storages[i]);
+		}
+	}
+	else
+	{
+		for (auto i : SG_PROGRESS(range(m_num_runs)))
+		{
+			/* evtl. update xvalidation output class */
+			CrossValidationStorage* storage = create_run_storage();
+
+			SG_DEBUG("entering cross-validation run %d \n", i)
+			results[i] = evaluate_one_run(i, storage);
+			SG_DEBUG("result of cross-validation run %d is %f\n", i, results[i])
+
+			observe_run(i, storage);
+			SG_UNREF(storage)
+		}
 	}
 
+	/* the next evaluation draws new index sets */
+	m_run_train_indices.clear();
+	m_run_test_indices.clear();
+
 	/* construct evaluation result */
 	CCrossValidationResult* result = new CCrossValidationResult();
 	result->set_mean(CStatistics::mean(results));
@@ -134,6 +175,26 @@ CEvaluationResult* CCrossValidation::evaluate_impl()
 	return result;
 }
 
+void CCrossValidation::build_run_subsets()
+{
+	index_t num_subsets = m_splitting_strategy->get_num_subsets();
+	m_run_train_indices.clear();
+	m_run_test_indices.clear();
+	m_run_train_indices.resize(m_num_runs);
+	m_run_test_indices.resize(m_num_runs);
+	for (int32_t i = 0; i < m_num_runs; ++i)
+	{
+		m_splitting_strategy->build_subsets();
+		for (index_t j = 0; j < num_subsets; ++j)
+		{
+			m_run_train_indices[i].push_back(
+			    m_splitting_strategy->generate_subset_inverse(j));
+			m_run_test_indices[i].push_back(
+			    m_splitting_strategy->generate_subset_indices(j));
+		}
+	}
+}
+
 void CCrossValidation::set_num_runs(int32_t num_runs)
 {
 	if (num_runs < 1)
@@ -142,19 +203,98 @@ void CCrossValidation::set_num_runs(int32_t num_runs)
 	m_num_runs = num_runs;
 }
 
+void CCrossValidation::set_parallel_evaluation(bool parallel_evaluation)
+{
+	m_parallel_evaluation = parallel_evaluation;
+}
+
+bool CCrossValidation::get_parallel_evaluation() const
+{
+	return m_parallel_evaluation;
+}
+
+void CCrossValidation::set_num_evaluated_folds(index_t num_folds)
+{
+	REQUIRE(
+	    num_folds >= 0, "Number of evaluated folds (%d) must not be "
+	                    "negative\n",
+	    num_folds);
+	m_num_evaluated_folds = num_folds;
+}
+
+index_t CCrossValidation::get_num_evaluated_folds() const
+{
+	return m_num_evaluated_folds;
+}
+
+index_t CCrossValidation::get_num_folds() const
+{
+	REQUIRE(m_splitting_strategy, "No splitting strategy set\n");
+	return m_splitting_strategy->get_num_subsets();
+}
+
+CrossValidationStorage* CCrossValidation::create_run_storage()
+{
+	SG_DEBUG("Creating CrossValidationStorage.\n")
+	CrossValidationStorage* storage = new CrossValidationStorage();
+	SG_REF(storage)
+	storage->set_num_runs(m_num_runs);
+	storage->set_num_folds(m_splitting_strategy->get_num_subsets());
+	storage->set_expose_labels(m_labels);
+	storage->post_init();
+	SG_DEBUG("Ending CrossValidationStorage initilization.\n")
+
+	return storage;
+}
+
+void CCrossValidation::observe_run(
+    int64_t index, CrossValidationStorage* storage)
+{
+	/* Emit the value*/
+	std::string obs_value_name{"cross_validation_run"};
+	ObservedValue cv_data{index, obs_value_name, make_any(storage),
+	                      CROSSVALIDATION};
+	observe(cv_data);
+}
+
 float64_t CCrossValidation::evaluate_one_run(
     int64_t index, CrossValidationStorage* storage)
 {
 	SG_DEBUG("entering %s::evaluate_one_run()\n", get_name())
 	index_t num_subsets = m_splitting_strategy->get_num_subsets();
 
-	SG_DEBUG("building index sets for %d-fold cross-validation\n", num_subsets)
+	/* index sets of all folds, drawn up front for parallel runs */
+	std::vector<SGVector<index_t>> train_indices;
+	std::vector<SGVector<index_t>> test_indices;
+	if (index < (int64_t)m_run_train_indices.size())
+	{
+		train_indices = m_run_train_indices[index];
+		test_indices = m_run_test_indices[index];
+	}
+	else
+	{
+		SG_DEBUG(
+		    "building index sets for %d-fold cross-validation\n", num_subsets)
 
-	/* build index sets */
-	m_splitting_strategy->build_subsets();
+		/* build index sets */
+		m_splitting_strategy->build_subsets();
+		for (index_t i = 0; i < num_subsets; ++i)
+		{
+			train_indices.push_back(
+			    m_splitting_strategy->generate_subset_inverse(i));
+			test_indices.push_back(
+			    m_splitting_strategy->generate_subset_indices(i));
+		}
+	}
+
+	/* only the first folds are evaluated if desired */
+	index_t num_folds = num_subsets;
+	if (m_num_evaluated_folds > 0)
+		num_folds = CMath::min(m_num_evaluated_folds, num_subsets);
 
 	/* results array */
-	SGVector<float64_t> results(num_subsets);
+	SGVector<float64_t> results(num_folds);
+	results.zero();
 
 	/* different behavior whether data is locked or not */
 	if (m_machine->is_data_locked())
@@ -162,7 +302,7 @@ float64_t CCrossValidation::evaluate_one_run(
 		m_machine->set_store_model_features(true);
 		SG_DEBUG("starting locked evaluation\n", get_name())
 		/* do actual cross-validation */
-		for (auto i : SG_PROGRESS(range(num_subsets)))
+		for (auto i : SG_PROGRESS(range(num_folds)))
 		{
 			COMPUTATION_CONTROLLERS
 
@@ -172,16 +312,14 @@ float64_t CCrossValidation::evaluate_one_run(
 			fold->set_run_index(index);
 			fold->set_fold_index(i);
 
-			/* index subset for training, will be freed below */
-			SGVector<index_t> inverse_subset_indices =
-			    m_splitting_strategy->generate_subset_inverse(i);
+			/* index subset for training */
+			SGVector<index_t> inverse_subset_indices = train_indices[i];
 
 			/* train machine on training features */
 			m_machine->train_locked(inverse_subset_indices);
 
 			/* feature subset for testing */
-			SGVector<index_t> subset_indices =
-			    m_splitting_strategy->generate_subset_indices(i);
+			SGVector<index_t> subset_indices = test_indices[i];
 
 			/* evtl. update xvalidation output class */
 			fold->set_train_indices(inverse_subset_indices);
@@ -230,117 +368,138 @@ float64_t CCrossValidation::evaluate_one_run(
 		 * (otherwise changing subset of features will kaboom the classifier) */
 		m_machine->set_store_model_features(true);
 
-		/* do actual cross-validation */
-
-		// TODO parallel xvalidation needs some serious fixing, see #3743
-		//#pragma omp parallel for
-		for (index_t i = 0; i < num_subsets; ++i)
-		{
-			COMPUTATION_CONTROLLERS
-
-			CrossValidationFoldStorage* fold = new CrossValidationFoldStorage();
-			SG_REF(fold)
+		/* do actual cross-validation, every fold works on its own clones */
+		std::vector<CrossValidationFoldStorage*> folds(num_folds, nullptr);
+		auto evaluate_folds = [&](int64_t begin, int64_t end) {
+			for (int64_t i = begin; i < end; ++i)
+			{
+				COMPUTATION_CONTROLLERS
 
-			auto machine = (CMachine*)m_machine->clone();
+				folds[i] = new CrossValidationFoldStorage();
+				SG_REF(folds[i])
+				results[i] = evaluate_fold(
+				    index, i, train_indices[i], test_indices[i], folds[i]);
+			}
+		};
 
-			// TODO while these are not used through const interfaces,
-			// we unfortunately have to clone, even though these could be shared
-			auto features = (CFeatures*)m_features->clone();
-			auto labels = (CLabels*)m_labels->clone();
-			auto evaluation_criterion =
-			    (CEvaluation*)m_evaluation_criterion->clone();
+		if (m_parallel_evaluation)
+			parallel->parallel_for(0, num_folds, evaluate_folds, 1);
+		else
+			evaluate_folds(0, num_folds);
 
-			/* evtl. update xvalidation output class */
-			fold->set_run_index(index);
-			fold->set_fold_index(i);
+		/* store the folds in order, independent of their scheduling */
+		for (auto fold : folds)
+		{
+			if (!fold)
+				continue;
 
-			/* set feature subset for training */
-			SGVector<index_t> inverse_subset_indices =
-			    m_splitting_strategy->generate_subset_inverse(i);
+			storage->append_fold_result(fold);
+			SG_UNREF(fold)
+		}
 
-			features->add_subset(inverse_subset_indices);
+		SG_DEBUG("done unlocked evaluation\n", get_name())
+	}
 
-			/* set label subset for training */
-			labels->add_subset(inverse_subset_indices);
+	/* build arithmetic mean of results */
+	float64_t mean = CStatistics::mean(results);
 
-			SG_DEBUG("training set %d:\n", i)
-			if (io->get_loglevel() == MSG_DEBUG)
-			{
-				SGVector<index_t>::display_vector(
-				    inverse_subset_indices.vector, inverse_subset_indices.vlen,
-				    "training indices");
-			}
+	SG_DEBUG("leaving %s::evaluate_one_run()\n", get_name())
+	return mean;
+}
 
-			/* train machine on training features and remove subset */
-			SG_DEBUG("starting training\n")
-			machine->set_labels(labels);
-			machine->train(features);
-			SG_DEBUG("finished training\n")
+float64_t CCrossValidation::evaluate_fold(
+    int64_t run_index, index_t fold_index, SGVector<index_t> train_indices,
+    SGVector<index_t> test_indices, CrossValidationFoldStorage* fold)
+{
+	auto machine = (CMachine*)m_machine->clone();
 
-			/* evtl. update xvalidation output class */
-			fold->set_train_indices(inverse_subset_indices);
-			auto fold_machine = (CMachine*)machine->clone();
-			fold->set_trained_machine(fold_machine);
-			SG_UNREF(fold_machine)
+	// folds evaluated in parallel share the feature data and only get their
+	// own subset stack, labels and the criterion are small enough to clone
+	CFeatures* features;
+	if (m_parallel_evaluation)
+	{
+		features = m_features->duplicate();
+		SG_REF(features);
+	}
+	else
+		features = (CFeatures*)m_features->clone();
+	auto labels = (CLabels*)m_labels->clone();
+	auto evaluation_criterion = (CEvaluation*)m_evaluation_criterion->clone();
 
-			features->remove_subset();
-			labels->remove_subset();
+	/* evtl. update xvalidation output class */
+	fold->set_run_index(run_index);
+	fold->set_fold_index(fold_index);
 
-			/* set feature subset for testing (subset method that stores
-			 * pointer) */
-			SGVector<index_t> subset_indices =
-			    m_splitting_strategy->generate_subset_indices(i);
-			features->add_subset(subset_indices);
+	/* set feature subset for training */
+	features->add_subset(train_indices);
 
-			/* set label subset for testing */
-			labels->add_subset(subset_indices);
+	/* set label subset for training */
+	labels->add_subset(train_indices);
 
-			SG_DEBUG("test set %d:\n", i)
-			if (io->get_loglevel() == MSG_DEBUG)
-			{
-				SGVector<index_t>::display_vector(
-				    subset_indices.vector, subset_indices.vlen, "test indices");
-			}
+	SG_DEBUG("training set %d:\n", fold_index)
+	if (io->get_loglevel() == MSG_DEBUG)
+	{
+		SGVector<index_t>::display_vector(
+		    train_indices.vector, train_indices.vlen, "training indices");
+	}
 
-			/* apply machine to test features and remove subset */
-			SG_DEBUG("starting evaluation\n")
-			SG_DEBUG("%p\n", features)
-			CLabels* result_labels = machine->apply(features);
-			SG_DEBUG("finished evaluation\n")
-			features->remove_subset();
-			SG_REF(result_labels);
+	/* train machine on training features and remove subset */
+	SG_DEBUG("starting training\n")
+	machine->set_labels(labels);
+	machine->train(features);
+	SG_DEBUG("finished training\n")
 
-			/* evaluate */
-			results[i] = evaluation_criterion->evaluate(result_labels, labels);
-			SG_DEBUG("result on fold %d is %f\n", i, results[i])
+	/* evtl. update xvalidation output class */
+	fold->set_train_indices(train_indices);
+	auto fold_machine = (CMachine*)machine->clone();
+	fold->set_trained_machine(fold_machine);
+	SG_UNREF(fold_machine)
 
-			/* evtl. update xvalidation output class */
-			fold->set_test_indices(subset_indices);
-			fold->set_test_result(result_labels);
-			CLabels* true_labels = (CLabels*)labels->clone();
-			fold->set_test_true_result(true_labels);
-			SG_UNREF(true_labels)
-			fold->post_update_results();
-			fold->set_evaluation_result(results[i]);
+	features->remove_subset();
+	labels->remove_subset();
 
-			storage->append_fold_result(fold);
+	/* set feature subset for testing (subset method that stores
+	 * pointer) */
+	features->add_subset(test_indices);
 
-			/* clean up, remove subsets */
-			labels->remove_subset();
-			SG_UNREF(machine);
-			SG_UNREF(features);
-			SG_UNREF(labels);
-			SG_UNREF(evaluation_criterion);
-			SG_UNREF(result_labels);
-			SG_UNREF(fold)
-		}
+	/* set label subset for testing */
+	labels->add_subset(test_indices);
 
-		SG_DEBUG("done unlocked evaluation\n", get_name())
+	SG_DEBUG("test set %d:\n", fold_index)
+	if (io->get_loglevel() == MSG_DEBUG)
+	{
+		SGVector<index_t>::display_vector(
+		    test_indices.vector, test_indices.vlen, "test indices");
 	}
 
-	/* build arithmetic mean of results */
-	float64_t mean = CStatistics::mean(results);
+	/* apply machine to test features and remove subset */
+	SG_DEBUG("starting evaluation\n")
+	SG_DEBUG("%p\n", features)
+	CLabels* result_labels = machine->apply(features);
+	SG_DEBUG("finished evaluation\n")
+	features->remove_subset();
+	SG_REF(result_labels);
+
+	/* evaluate */
+	float64_t result = evaluation_criterion->evaluate(result_labels, labels);
+	SG_DEBUG("result on fold %d is %f\n", fold_index, result)
+
+	/* evtl. update xvalidation output class */
+	fold->set_test_indices(test_indices);
+	fold->set_test_result(result_labels);
+	CLabels* true_labels = (CLabels*)labels->clone();
+	fold->set_test_true_result(true_labels);
+	SG_UNREF(true_labels)
+	fold->post_update_results();
+	fold->set_evaluation_result(result);
+
+	/* clean up, remove subsets */
+	labels->remove_subset();
+	SG_UNREF(machine);
+	SG_UNREF(features);
+	SG_UNREF(labels);
+	SG_UNREF(evaluation_criterion);
+	SG_UNREF(result_labels);
 
-	SG_DEBUG("leaving %s::evaluate_one_run()\n", get_name())
-	return mean;
+	return result;
 }
@@ -14,12 +14,15 @@
 #include <shogun/evaluation/EvaluationResult.h>
 #include <shogun/evaluation/MachineEvaluation.h>
 
+#include <vector>
+
 namespace shogun
 {
 
 	class CMachineEvaluation;
 	class CCrossValidationOutput;
 	class CrossValidationStorage;
+	class CrossValidationFoldStorage;
 	class CList;
 
 	/** @brief type to encapsulate the results of an evaluation run.
@@ -160,6 +163,15 @@ namespace shogun
 	 * all
 	 * objects (might be changed later).
 	 *
+	 * With set_parallel_evaluation(), the folds of unlocked machines are
+	 * evaluated in parallel on the thread pool, as are the runs. Every fold
+	 * trains its own clone of the machine on a duplicate of the features,
+	 * which shares the feature data and only adds its own subsets. The
+	 * splits of all runs are drawn up front in run order and folds are
+	 * stored in fold order, so the stored results do not depend on the
+	 * scheduling. Machines which draw random numbers during training should
+	 * not be evaluated in parallel, since the global random generator is not
+	 * thread safe. Locked machines are always evaluated serially.
 	 */
 	class CCrossValidation : public CMachineEvaluation
 	{
@@ -199,6 +211,38 @@ namespace shogun
 		/** setter for the number of runs to use for evaluation */
 		void set_num_runs(int32_t num_runs);
 
+		/** set whether folds and runs of unlocked machines are evaluated in
+		 * parallel
+		 *
+		 * @param parallel_evaluation whether to evaluate in parallel
+		 */
+		void set_parallel_evaluation(bool parallel_evaluation);
+
+		/** @return whether folds and runs are evaluated in parallel */
+		bool get_parallel_evaluation() const;
+
+		/** set the number of folds evaluated in each run. Evaluating only
+		 * the first folds gives a cheaper but noisier estimate, which is
+		 * used to discard poor parameter combinations early in model
+		 * selection.
+		 *
+		 * @param num_folds number of folds to evaluate, 0 evaluates all
+		 */
+		void set_num_evaluated_folds(index_t num_folds);
+
+		/** @return number of folds evaluated in each run, 0 if all */
+		index_t get_num_evaluated_folds() const;
+
+		/** @return number of folds of the splitting strategy */
+		index_t get_num_folds() const;
+
+		/** draw the index sets of all runs of the next evaluation now, in
+		 * run order. Evaluations which run concurrently draw them one at a
+		 * time, since splitting strategies share the global random
+		 * generator.
+		 */
+		void build_run_subsets();
+
 		/** @return name of the SGSerializable */
 		virtual const char* get_name() const
 		{
@@ -229,8 +273,50 @@ namespace shogun
 		virtual float64_t
 		evaluate_one_run(int64_t index, CrossValidationStorage* storage);
 
+		/** Trains a clone of the unlocked machine on the training indices
+		 * and evaluates it on the test indices. Only reads shared members, so
+		 * folds may be evaluated concurrently.
+		 *
+		 * @param run_index index of the run
+		 * @param fold_index index of the fold
+		 * @param train_indices indices of the training vectors
+		 * @param test_indices indices of the test vectors
+		 * @param fold storage for the results of the fold
+		 * @return evaluation result of the fold
+		 */
+		float64_t evaluate_fold(
+		    int64_t run_index, index_t fold_index,
+		    SGVector<index_t> train_indices, SGVector<index_t> test_indices,
+		    CrossValidationFoldStorage* fold);
+
+		/** @return new storage for the results of one run */
+		CrossValidationStorage* create_run_storage();
+
+		/** emit the results of one run to the observers
+		 *
+		 * @param index index of the run
+		 * @param storage results of the run
+		 */
+		void observe_run(int64_t index, CrossValidationStorage* storage);
+
 		/** number of evaluation runs for one fold */
 		int32_t m_num_runs;
+
+		/** whether folds and runs are evaluated in parallel */
+		bool m_parallel_evaluation;
+
+		/** number of folds evaluated in each run, 0 if all */
+		index_t m_num_evaluated_folds;
+
+		/** training indices of each fold of each run, drawn up front for
+		 * parallel evaluation of runs or by build_run_subsets()
+		 */
+		std::vector<std::vector<SGVector<index_t> > > m_run_train_indices;
+
+		/** test indices of each fold of each run, drawn up front for
+		 * parallel evaluation of runs or by build_run_subsets()
+		 */
+		std::vector<std::vector<SGVector<index_t> > > m_run_test_indices;
 	};
 }
 
@@ -63,13 +63,16 @@ template<class T> void CStreamingDenseFeatures<T>::reset_stream()
 {
 	if (seekable)
 	{
-		((CStreamingFileFromDenseFeatures<T>*)working_file)->reset_stream();
-		if (parser.is_running())
-			parser.end_parser();
+		/* stop the parser before the file moves under it */
 		parser.exit_parser();
-		parser.init(working_file, has_labels, 1);
+		working_file->reset_stream();
+		/* keep the ring size, a single slot makes the parser thread wait
+		 * for every example */
+		int32_t ring_size=parser.get_ring_size();
+		bool free_vectors=parser.get_free_vectors_on_destruct();
+		parser.init(working_file, has_labels, ring_size);
 		parser.set_free_vector_after_release(false);
-		parser.set_free_vectors_on_destruct(false);
+		parser.set_free_vectors_on_destruct(free_vectors);
 		parser.start_parser();
 	}
 }
@@ -146,12 +149,14 @@ template<class T>
 void CStreamingDenseFeatures<T>::set_vector_reader()
 {
 	parser.set_read_vector(&CStreamingFile::get_vector);
+	parser.set_parse_vector(&CStreamingFile::parse_vector);
 }
 
 template<class T>
 void CStreamingDenseFeatures<T>::set_vector_and_label_reader()
 {
 	parser.set_read_vector_and_label(&CStreamingFile::get_vector_and_label);
+	parser.set_parse_vector_and_label(&CStreamingFile::parse_vector_and_label);
 }
 
 #define GET_FEATURE_TYPE(f_type, sg_type)				\
@@ -197,7 +202,8 @@ void CStreamingDenseFeatures<T>::init(CStreamingFile* file, bool is_labelled,
 	working_file=file;
 	SG_REF(working_file);
 	parser.init(file, is_labelled, size);
-	seekable=false;
+	/* files can be read again, pipes cannot */
+	seekable=file && file->is_seekable();
 }
 
 template<class T>
@@ -207,6 +213,12 @@ void CStreamingDenseFeatures<T>::start_parser()
 		parser.start_parser();
 }
 
+template<class T>
+void CStreamingDenseFeatures<T>::set_num_parsers(int32_t num)
+{
+	parser.set_num_parsers(num);
+}
+
 template<class T>
 void CStreamingDenseFeatures<T>::end_parser()
 {
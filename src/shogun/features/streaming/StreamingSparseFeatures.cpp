@@ -226,12 +226,16 @@ int32_t CStreamingSparseFeatures<T>::get_num_vectors() const
 template <class T> void CStreamingSparseFeatures<T>::set_vector_reader()
 {
 	parser.set_read_vector(&CStreamingFile::get_sparse_vector);
+	/* get_sparse_vector stops at lines of less than two characters */
+	parser.set_parse_vector(&CStreamingFile::parse_sparse_vector, 2);
 }
 
 template <class T> void CStreamingSparseFeatures<T>::set_vector_and_label_reader()
 {
 	parser.set_read_vector_and_label
 		(&CStreamingFile::get_sparse_vector_and_label);
+	parser.set_parse_vector_and_label
+		(&CStreamingFile::parse_sparse_vector_and_label, 2);
 }
 
 #define GET_FEATURE_TYPE(f_type, sg_type)				\
@@ -286,6 +290,12 @@ void CStreamingSparseFeatures<T>::start_parser()
 		parser.start_parser();
 }
 
+template <class T>
+void CStreamingSparseFeatures<T>::set_num_parsers(int32_t num)
+{
+	parser.set_num_parsers(num);
+}
+
 template <class T>
 void CStreamingSparseFeatures<T>::end_parser()
 {
@@ -102,6 +102,15 @@ public:
 	 */
 	virtual void start_parser();
 
+	/**
+	 * Sets the number of threads parsing the input, see
+	 * CInputParser::set_num_parsers(). Must be called before
+	 * start_parser().
+	 *
+	 * @param num number of parser threads
+	 */
+	void set_num_parsers(int32_t num);
+
 	/**
 	 * Ends the parsing thread.
 	 *
@@ -234,7 +234,7 @@ void SGIO::print_substring(substring s)
 float32_t SGIO::float_of_substring(substring s)
 {
 	char* endptr = s.end;
-	float32_t f = strtof(s.start,&endptr);
+	float32_t f = parse_double(s.start,&endptr);
 	if (endptr == s.start && s.start != s.end)
 		SG_SERROR("error: %s is not a float!\n", c_string_of_substring(s))
 
@@ -244,7 +244,7 @@ float32_t SGIO::float_of_substring(substring s)
 float64_t SGIO::double_of_substring(substring s)
 {
 	char* endptr = s.end;
-	float64_t f = strtod(s.start,&endptr);
+	float64_t f = parse_double(s.start,&endptr);
 	if (endptr == s.start && s.start != s.end)
 		SG_SERROR("Error!:%s is not a double!\n", c_string_of_substring(s))
 
@@ -270,6 +270,92 @@ uint32_t SGIO::ss_length(substring s)
 	return (s.end - s.start);
 }
 
+float64_t SGIO::parse_double(const char* str, char** endptr)
+{
+	static const float64_t powers_of_ten[]=
+	{
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	const char* p=str;
+	while (isspace(*p))
+		p++;
+
+	bool negative=false;
+	if (*p=='-' || *p=='+')
+		negative=*p++=='-';
+
+	uint64_t mantissa=0;
+	int32_t num_digits=0;
+	int32_t exponent=0;
+	bool has_digits=false;
+	for (; *p>='0' && *p<='9'; p++)
+	{
+		has_digits=true;
+		if (num_digits<19)
+			mantissa=mantissa*10+(*p-'0');
+		else
+			exponent++;
+		if (mantissa)
+			num_digits++;
+	}
+	if (*p=='.')
+	{
+		for (p++; *p>='0' && *p<='9'; p++)
+		{
+			has_digits=true;
+			if (num_digits<19)
+			{
+				mantissa=mantissa*10+(*p-'0');
+				exponent--;
+			}
+			if (mantissa)
+				num_digits++;
+		}
+	}
+
+	/* inf, nan, hex floats and malformed input */
+	if (!has_digits || *p=='x' || *p=='X')
+		return strtod(str, endptr);
+
+	if (*p=='e' || *p=='E')
+	{
+		const char* e=p+1;
+		bool negative_exponent=false;
+		if (*e=='-' || *e=='+')
+			negative_exponent=*e++=='-';
+
+		if (*e>='0' && *e<='9')
+		{
+			int32_t value=0;
+			for (; *e>='0' && *e<='9'; e++)
+			{
+				if (value<100000)
+					value=value*10+(*e-'0');
+			}
+			exponent+=negative_exponent ? -value : value;
+			p=e;
+		}
+	}
+
+	if (!mantissa)
+		exponent=0;
+	else if (num_digits>15 || exponent<-22 || exponent>22)
+		return strtod(str, endptr);
+
+	if (endptr)
+		*endptr=const_cast<char*>(p);
+
+	float64_t value=(float64_t) mantissa;
+	if (exponent<0)
+		value/=powers_of_ten[-exponent];
+	else
+		value*=powers_of_ten[exponent];
+
+	return negative ? -value : value;
+}
+
 char* SGIO::concat_filename(const char* filename)
 {
 #ifdef WIN32
@@ -530,6 +530,23 @@ class SGIO
 		 */
 		static uint32_t ss_length(substring s);
 
+		/**
+		 * Parse a floating point number like strtod, but without
+		 * going through the locale for the plain decimal notation
+		 * of data files.
+		 *
+		 * Numbers with at most 15 significant digits and a decimal
+		 * exponent of at most 22 are converted exactly with a single
+		 * multiplication or division, anything else is handed to
+		 * strtod.
+		 *
+		 * @param str string to parse, leading whitespace is skipped
+		 * @param endptr set to the first character after the number
+		 * if not NULL
+		 * @return parsed value
+		 */
+		static float64_t parse_double(const char* str, char** endptr=NULL);
+
 		/** increase reference counter
 		 *
 		 * @return reference count
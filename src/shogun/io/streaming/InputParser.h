@@ -14,10 +14,13 @@
 #include <shogun/io/SGIO.h>
 #include <shogun/io/streaming/StreamingFile.h>
 #include <shogun/io/streaming/ParseBuffer.h>
+#include <algorithm>
 #include <condition_variable>
+#include <locale.h>
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 #define PARSER_DEFAULT_BUFFSIZE 100
 
@@ -68,8 +71,18 @@ namespace shogun
  * the example, finalize_example() should be called, leaving the
  * spot free for a new example to be loaded.
  *
- * The parsing thread should be joined with a call to end_parser().
- * exit_parser() may be used to cancel the parse thread if needed.
+ * If the file can parse lines on their own (see
+ * CStreamingFile::has_line_parser()) and the parse_vector* functions
+ * are set, set_num_parsers() allows several threads to parse at once.
+ * They take turns reading chunks of raw lines from the file, claiming
+ * the ring positions for them at the same time, and then convert the
+ * lines to examples independently. Examples are still returned in the
+ * order of the file.
+ *
+ * The parsing thread should be joined with a call to end_parser(), also
+ * when the reader stops before the end of the input. The parser is then
+ * cancelled, as it may be waiting for free positions in the ring. The
+ * destructor cancels and joins a parser that is still running.
  *
  * Options are provided for automatic SG_FREEing of example objects
  * after each finalize_example() and also on CInputParser destruction.
@@ -149,6 +162,49 @@ public:
      */
     void set_read_vector_and_label(void (CStreamingFile::*func_ptr)(T* &vec, int32_t &len, float64_t &label));
 
+    /**
+     * Sets the function used for parsing a vector from a line
+     * of the file, when more than one parser thread is used.
+     *
+     * The function must be a member of CStreamingFile,
+     * taking the line and its number of characters, and
+     * setting the vector and its length by reference.
+     *
+     * The argument is a function pointer to that function.
+     * Lines with fewer than min_chars characters end the input,
+     * min_chars has to match the read function, see
+     * CStreamingFile::read_lines().
+     */
+    void set_parse_vector(void (CStreamingFile::*func_ptr)(char* line, int32_t num_chars, T* &vec, int32_t &len),
+        int32_t min_chars=1);
+
+    /**
+     * Sets the function used for parsing a vector and label
+     * from a line of the file, when more than one parser thread
+     * is used.
+     *
+     * The argument is a function pointer to that function.
+     * Lines with fewer than min_chars characters end the input,
+     * as for set_parse_vector().
+     */
+    void set_parse_vector_and_label(void (CStreamingFile::*func_ptr)(char* line, int32_t num_chars, T* &vec, int32_t &len, float64_t &label),
+        int32_t min_chars=1);
+
+    /**
+     * Sets the number of threads parsing the input.
+     *
+     * More than one thread is only used if the input file
+     * supports parsing lines on their own and the matching
+     * parse function is set, otherwise a single thread reads
+     * the examples. Takes effect on the next start_parser().
+     *
+     * @param num number of parser threads
+     */
+    void set_num_parsers(int32_t num);
+
+    /** @return number of parser threads */
+    int32_t get_num_parsers() { return num_parsers; }
+
     /**
      * Gets feature vector, length and label.
      * Sets their values by reference.
@@ -209,6 +265,13 @@ public:
      */
     void* main_parse_loop(void* params);
 
+    /**
+     * Parsing loop of each thread when more than one parser
+     * is used. Reads chunks of lines and the ring positions
+     * for them under a lock, and parses them outside of it.
+     */
+    void parallel_parse_loop();
+
 
     /**
      * Copy example into the buffer.
@@ -262,7 +325,8 @@ public:
     void finalize_example();
 
     /**
-     * End the parser, waiting for the parse thread to complete.
+     * End the parser, waiting for the parse thread to complete. A
+     * parser that has not reached the end of the input is cancelled.
      *
      */
     void end_parser();
@@ -271,6 +335,12 @@ public:
      */
     void exit_parser();
 
+    /**
+     * @return whether the vectors of the ring are freed on its
+     * destruction
+     */
+    bool get_free_vectors_on_destruct();
+
     /**
      * Returns the size of the examples ring
      *
@@ -311,12 +381,36 @@ protected:
      */
     void (CStreamingFile::*read_vector_and_label) (T* &vec, int32_t &len, float64_t &label);
 
+    /// Function parsing a vector from a line, for parallel parsing
+    void (CStreamingFile::*parse_vector) (char* line, int32_t num_chars, T* &vec, int32_t &len);
+
+    /// Function parsing a vector and label from a line, for parallel parsing
+    void (CStreamingFile::*parse_vector_and_label) (char* line, int32_t num_chars, T* &vec, int32_t &len, float64_t &label);
+
     /// Input source, CStreamingFile object
     CStreamingFile* input_source;
 
     /// Thread in which the parser runs
 	std::thread parse_thread;
 
+    /// Threads in which the parsers run, when there are several
+	std::vector<std::thread> parse_threads;
+
+    /// Number of parser threads
+    int32_t num_parsers;
+
+    /// Number of parser threads which have not reached the end of input
+    int32_t num_running_parsers;
+
+    /// Lines with fewer characters end the input, for parallel parsing
+    int32_t min_line_length;
+
+    /// Whether a parser thread has read the end of the input
+    bool input_ended;
+
+    /// Mutex taken while reading lines and claiming ring positions
+	std::mutex input_lock;
+
     /// The ring of examples, stored as they are parsed
     CParseBuffer<T>* examples_ring;
 
@@ -372,10 +466,39 @@ template <class T>
     read_vector_and_label=func_ptr;
 }
 
+template <class T>
+    void CInputParser<T>::set_parse_vector(void (CStreamingFile::*func_ptr)(char* line, int32_t num_chars, T* &vec, int32_t &len),
+        int32_t min_chars)
+{
+    parse_vector=func_ptr;
+    min_line_length=min_chars;
+}
+
+template <class T>
+    void CInputParser<T>::set_parse_vector_and_label(void (CStreamingFile::*func_ptr)(char* line, int32_t num_chars, T* &vec, int32_t &len, float64_t &label),
+        int32_t min_chars)
+{
+    parse_vector_and_label=func_ptr;
+    min_line_length=min_chars;
+}
+
+template <class T>
+    void CInputParser<T>::set_num_parsers(int32_t num)
+{
+    REQUIRE(num>0, "Number of parsers (%d) must be positive\n", num)
+    num_parsers=num;
+}
+
 template <class T>
     CInputParser<T>::CInputParser()
 {
 	examples_ring = nullptr;
+	parse_vector = nullptr;
+	parse_vector_and_label = nullptr;
+	num_parsers = 1;
+	num_running_parsers = 0;
+	min_line_length = 1;
+	input_ended = false;
 	parsing_done=true;
 	reading_done=true;
 	keep_running.store(false, std::memory_order_release);
@@ -384,6 +507,7 @@ template <class T>
 template <class T>
     CInputParser<T>::~CInputParser()
 {
+	exit_parser();
 	SG_UNREF(examples_ring);
 }
 
@@ -426,20 +550,38 @@ template <class T>
 	examples_ring->set_free_vectors_on_destruct(destroy);
 }
 
+template <class T>
+    bool CInputParser<T>::get_free_vectors_on_destruct()
+{
+	return examples_ring->get_free_vectors_on_destruct();
+}
+
 template <class T>
     void CInputParser<T>::start_parser()
 {
 	SG_SDEBUG("entering CInputParser::start_parser()\n")
     if (is_running())
     {
-        SG_SERROR("Parser thread is already running! Multiple parse threads not supported.\n")
+        SG_SERROR("Parser thread is already running!\n")
     }
 
     SG_SDEBUG("creating parse thread\n")
     if (examples_ring)
 		examples_ring->init_vector();
 	keep_running.store(true, std::memory_order_release);
-	parse_thread = std::thread(&parse_loop_entry_point, this);
+
+	bool can_parse_lines = example_type == E_LABELLED ?
+		parse_vector_and_label != nullptr : parse_vector != nullptr;
+	if (num_parsers > 1 && can_parse_lines && input_source->has_line_parser())
+	{
+		SG_SDEBUG("creating %d parse threads\n", num_parsers)
+		num_running_parsers = num_parsers;
+		input_ended = false;
+		for (int32_t i=0; i<num_parsers; i++)
+			parse_threads.emplace_back(&CInputParser::parallel_parse_loop, this);
+	}
+	else
+		parse_thread = std::thread(&parse_loop_entry_point, this);
 
     SG_SDEBUG("leaving CInputParser::start_parser()\n")
 }
@@ -526,6 +668,14 @@ template <class T> void* CInputParser<T>::main_parse_loop(void* params)
 		lock.unlock();
 
 		current_example = examples_ring->get_free_example();
+		if (!current_example)
+		{
+			/* cancelled, the reader gets the examples parsed so far */
+			lock.lock();
+			parsing_done = true;
+			examples_state_changed.notify_one();
+			return NULL;
+		}
 		current_feature_vector = current_example->fv;
 		current_len = current_example->length;
 		current_label = current_example->label;
@@ -547,14 +697,100 @@ template <class T> void* CInputParser<T>::main_parse_loop(void* params)
 		current_example->fv = current_feature_vector;
 		current_example->length = current_len;
 
-		examples_ring->copy_example(current_example);
+		bool copied = examples_ring->copy_example(current_example);
 		lock.lock();
+		if (!copied)
+		{
+			parsing_done = true;
+			examples_state_changed.notify_one();
+			return NULL;
+		}
 		number_of_vectors_parsed++;
 		examples_state_changed.notify_one();
 	}
     return NULL;
 }
 
+template <class T> void CInputParser<T>::parallel_parse_loop()
+{
+    // chunks small enough for all parsers to have one in the ring
+    int32_t chunk_size = std::max(1, ring_size/(2*num_parsers));
+    std::vector<char> lines;
+    std::vector<int64_t> starts;
+    std::vector<int32_t> lengths;
+    std::vector<Example<T>*> examples;
+
+    // numbers are parsed in the C locale, as by the read functions, but
+    // only for this thread
+#ifdef _WIN32
+    _configthreadlocale(_ENABLE_PER_THREAD_LOCALE);
+    SG_SET_LOCALE_C;
+#else
+    locale_t c_locale = newlocale(LC_ALL_MASK, "C", (locale_t) 0);
+    locale_t old_locale = uselocale(c_locale);
+#endif
+
+    while (keep_running.load(std::memory_order_acquire))
+    {
+        std::unique_lock<std::mutex> input_lk(input_lock);
+        if (input_ended)
+            break;
+        int32_t num_lines = input_source->read_lines(chunk_size, lines,
+                starts, lengths, min_line_length);
+        if (num_lines < chunk_size)
+            input_ended = true;
+        examples.resize(num_lines);
+        int32_t num_claimed = 0;
+        for (; num_claimed<num_lines; num_claimed++)
+        {
+            examples[num_claimed] = examples_ring->claim_free_example();
+            if (!examples[num_claimed])
+                break;
+        }
+        input_lk.unlock();
+
+        for (int32_t i=0; i<num_claimed; i++)
+        {
+            Example<T>* ex = examples[i];
+            T* feature_vector = ex->fv;
+            int32_t length = ex->length;
+            float64_t label = ex->label;
+
+            char* line = &lines[starts[i]];
+            if (example_type == E_LABELLED)
+                (input_source->*parse_vector_and_label)(line, lengths[i],
+                        feature_vector, length, label);
+            else
+                (input_source->*parse_vector)(line, lengths[i],
+                        feature_vector, length);
+
+            ex->fv = feature_vector;
+            ex->length = std::max(length, 0);
+            ex->label = label;
+            examples_ring->publish_example(ex);
+
+            std::lock_guard<std::mutex> lock(examples_state_lock);
+            number_of_vectors_parsed++;
+            examples_state_changed.notify_one();
+        }
+
+        if (num_claimed < chunk_size)
+            break;
+    }
+
+#ifndef _WIN32
+    uselocale(old_locale);
+    freelocale(c_locale);
+#endif
+
+    std::lock_guard<std::mutex> lock(examples_state_lock);
+    if (--num_running_parsers == 0)
+    {
+        parsing_done = true;
+        examples_state_changed.notify_one();
+    }
+}
+
 template <class T> Example<T>* CInputParser<T>::retrieve_example()
 {
     /* This function should be guarded by mutexes while calling  */
@@ -580,7 +816,9 @@ template <class T> Example<T>* CInputParser<T>::retrieve_example()
     }
 
     ex = examples_ring->get_unused_example();
-    number_of_vectors_read++;
+    /* with several parsers, the next example may still be parsed */
+    if (ex != NULL)
+        number_of_vectors_read++;
 
     return ex;
 }
@@ -649,8 +887,15 @@ template <class T> void CInputParser<T>::end_parser()
 {
 	SG_SDEBUG("entering CInputParser::end_parser\n")
 	SG_SDEBUG("joining parse thread\n")
+	/* a parser that has not read the whole input may be waiting for
+	 * the reader to free positions in the ring */
+	if (examples_ring)
+		examples_ring->cancel();
 	if (parse_thread.joinable())
 		parse_thread.join();
+	for (auto& thread : parse_threads)
+		thread.join();
+	parse_threads.clear();
     SG_SDEBUG("leaving CInputParser::end_parser\n")
 }
 
@@ -658,9 +903,14 @@ template <class T> void CInputParser<T>::exit_parser()
 {
 	SG_SDEBUG("cancelling parse thread\n")
 	keep_running.store(false, std::memory_order_release);
+	if (examples_ring)
+		examples_ring->cancel();
 	examples_state_changed.notify_one();
 	if (parse_thread.joinable())
 		parse_thread.join();
+	for (auto& thread : parse_threads)
+		thread.join();
+	parse_threads.clear();
 }
 }
 
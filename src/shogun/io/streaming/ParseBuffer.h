@@ -12,6 +12,7 @@
 #include <shogun/lib/common.h>
 #include <shogun/base/SGObject.h>
 #include <shogun/lib/DataType.h>
+#include <atomic>
 #include <condition_variable>
 #include <memory>
 #include <mutex>
@@ -21,12 +22,14 @@ namespace shogun
 {
 
 /// Specifies whether location is empty,
-/// contains an unused example or a used example.
+/// contains an unused example or a used example,
+/// or is being written by a parsing thread.
 enum E_IS_EXAMPLE_USED
 {
 	E_EMPTY = 1,
 	E_NOT_USED = 2,
-	E_USED = 3
+	E_USED = 3,
+	E_PARSING = 4
 };
 
 /** @brief Class Example is the container type for
@@ -85,19 +88,44 @@ public:
 	 * Return the next position to write the example
 	 * into the ring.
 	 *
-	 * @return pointer to example
+	 * @return pointer to example, NULL if the ring was cancelled
 	 */
 	Example<T>* get_free_example()
 	{
 		std::unique_lock<std::mutex> write_lk(*write_mutex, std::defer_lock);
 		std::unique_lock<std::mutex> current_ex_lock(*ex_in_use_mutex[ex_write_index], std::defer_lock);
 		std::lock(write_lk, current_ex_lock);
-		while (ex_used[ex_write_index] == E_NOT_USED)
+		while (ex_used[ex_write_index] == E_NOT_USED && !cancelled.load())
 			ex_in_use_cond[ex_write_index]->wait(current_ex_lock);
+		if (cancelled.load())
+			return NULL;
 		Example<T>* ex=&ex_ring[ex_write_index];
 		return ex;
 	}
 
+	/**
+	 * Claim the next position of the ring for an example that is
+	 * parsed outside of the buffer, waiting for it to be used if
+	 * necessary.
+	 *
+	 * Positions are claimed in ring order, so the examples are
+	 * read in the order they were claimed in, no matter in which
+	 * order they are published. The example is not visible to the
+	 * reader until publish_example() is called on it.
+	 *
+	 * @return pointer to the claimed example, NULL if the ring was
+	 * cancelled
+	 */
+	Example<T>* claim_free_example();
+
+	/**
+	 * Mark an example returned by claim_free_example() as ready
+	 * to be read.
+	 *
+	 * @param ex claimed example, filled in by the caller
+	 */
+	void publish_example(Example<T>* ex);
+
 	/**
 	 * Writes the given example into the appropriate buffer space.
 	 * Feature vector is copied into a separate block.
@@ -128,10 +156,18 @@ public:
 	 *
 	 * @param ex Example to copy into buffer
 	 *
-	 * @return 1 on success, 0 on memory errors
+	 * @return 1 on success, 0 on memory errors or if the ring was
+	 * cancelled
 	 */
 	int32_t copy_example(Example<T>* ex);
 
+	/**
+	 * Wake up and stop all writers waiting for a free position,
+	 * e.g. when the reader stops before the end of the input.
+	 * Writing after the cancellation fails.
+	 */
+	void cancel();
+
 	/**
 	 * Mark the example in 'read' position as 'used'.
 	 *
@@ -220,6 +256,9 @@ protected:
 
 	/// Whether examples on the ring will be freed on destruction
 	bool free_vectors_on_destruct;
+
+	/// Whether writers were stopped by cancel()
+	std::atomic<bool> cancelled;
 };
 
 
@@ -258,6 +297,7 @@ template <class T> CParseBuffer<T>::CParseBuffer(int32_t size)
 		ex_in_use_cond.push_back(std::make_shared<std::condition_variable>());
 	}
 	free_vectors_on_destruct = true;
+	cancelled.store(false);
 }
 
 template <class T> CParseBuffer<T>::~CParseBuffer()
@@ -328,16 +368,61 @@ int32_t CParseBuffer<T>::copy_example(Example<T> *ex)
 	int32_t current_index = ex_write_index;
 
 	std::unique_lock<std::mutex> current_ex_lock(*ex_in_use_mutex[current_index]);
-	while (ex_used[ex_write_index] == E_NOT_USED)
+	while (ex_used[ex_write_index] == E_NOT_USED && !cancelled.load())
 	{
 		ex_in_use_cond[ex_write_index]->wait(current_ex_lock);
 	}
+	if (cancelled.load())
+		return 0;
 
 	ret = write_example(ex);
 
 	return ret;
 }
 
+template <class T>
+Example<T>* CParseBuffer<T>::claim_free_example()
+{
+	std::lock_guard<std::mutex> write_lk(*write_mutex);
+	int32_t current_index = ex_write_index;
+
+	std::unique_lock<std::mutex> current_ex_lock(*ex_in_use_mutex[current_index]);
+	while ((ex_used[current_index] == E_NOT_USED ||
+		ex_used[current_index] == E_PARSING) && !cancelled.load())
+	{
+		ex_in_use_cond[current_index]->wait(current_ex_lock);
+	}
+	if (cancelled.load())
+		return NULL;
+
+	ex_used[current_index] = E_PARSING;
+	inc_write_index();
+
+	return &ex_ring[current_index];
+}
+
+template <class T>
+void CParseBuffer<T>::publish_example(Example<T>* ex)
+{
+	int32_t index = ex - ex_ring;
+
+	std::lock_guard<std::mutex> current_ex_lk(*ex_in_use_mutex[index]);
+	ex_used[index] = E_NOT_USED;
+	ex_in_use_cond[index]->notify_all();
+}
+
+template <class T>
+void CParseBuffer<T>::cancel()
+{
+	cancelled.store(true);
+	/* a writer either sees the flag before it waits or is notified */
+	for (int32_t i=0; i<ring_size; i++)
+	{
+		std::lock_guard<std::mutex> current_ex_lk(*ex_in_use_mutex[i]);
+		ex_in_use_cond[i]->notify_all();
+	}
+}
+
 template <class T>
 void CParseBuffer<T>::finalize_example(bool free_after_release)
 {
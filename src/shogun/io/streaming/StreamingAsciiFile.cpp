@@ -14,6 +14,9 @@
 
 using namespace shogun;
 
+/* tokens of the line being parsed, one array per parsing thread */
+static thread_local v_array<substring> words;
+
 CStreamingAsciiFile::CStreamingAsciiFile()
 		: CStreamingFile()
 {
@@ -31,26 +34,14 @@ CStreamingAsciiFile::~CStreamingAsciiFile()
 {
 }
 
-/* Methods for reading dense vectors from an ascii file */
+/* Methods for parsing a line of an ascii file into a dense vector */
 
-#define GET_VECTOR(fname, conv, sg_type)									\
-void CStreamingAsciiFile::get_vector(sg_type*& vector, int32_t& num_feat)	\
+#define PARSE_VECTOR(fname, conv, sg_type)									\
+void CStreamingAsciiFile::parse_vector(char* buffer, int32_t bytes_read,	\
+		sg_type*& vector, int32_t& num_feat)								\
 {																			\
-		char* buffer = NULL;												\
-		ssize_t bytes_read;													\
 		int32_t old_len = num_feat;											\
 																			\
-		SG_SET_LOCALE_C;													\
-		bytes_read = buf->read_line(buffer);								\
-																			\
-		if (bytes_read<=0)													\
-		{																	\
-				vector=NULL;												\
-				num_feat=-1;												\
-				SG_RESET_LOCALE;											\
-				return;														\
-		}																	\
-																			\
 		/* determine num_feat, populate dynamic array */					\
 		int32_t nf=0;														\
 		num_feat=0;															\
@@ -101,37 +92,27 @@ void CStreamingAsciiFile::get_vector(sg_type*& vector, int32_t& num_feat)	\
 				SG_FREE(item);												\
 		}																	\
 		delete items;														\
-		SG_RESET_LOCALE;													\
 }
 
-GET_VECTOR(get_bool_vector, str_to_bool, bool)
-GET_VECTOR(get_byte_vector, atoi, uint8_t)
-GET_VECTOR(get_char_vector, atoi, char)
-GET_VECTOR(get_int_vector, atoi, int32_t)
-GET_VECTOR(get_short_vector, atoi, int16_t)
-GET_VECTOR(get_word_vector, atoi, uint16_t)
-GET_VECTOR(get_int8_vector, atoi, int8_t)
-GET_VECTOR(get_uint_vector, atoi, uint32_t)
-GET_VECTOR(get_long_vector, atoi, int64_t)
-GET_VECTOR(get_ulong_vector, atoi, uint64_t)
-GET_VECTOR(get_longreal_vector, atoi, floatmax_t)
-#undef GET_VECTOR
-
-#define GET_FLOAT_VECTOR(sg_type)											\
-		void CStreamingAsciiFile::get_vector(sg_type*& vector, int32_t& len)\
+PARSE_VECTOR(parse_bool_vector, str_to_bool, bool)
+PARSE_VECTOR(parse_byte_vector, atoi, uint8_t)
+PARSE_VECTOR(parse_char_vector, atoi, char)
+PARSE_VECTOR(parse_int_vector, atoi, int32_t)
+PARSE_VECTOR(parse_short_vector, atoi, int16_t)
+PARSE_VECTOR(parse_word_vector, atoi, uint16_t)
+PARSE_VECTOR(parse_int8_vector, atoi, int8_t)
+PARSE_VECTOR(parse_uint_vector, atoi, uint32_t)
+PARSE_VECTOR(parse_long_vector, atoi, int64_t)
+PARSE_VECTOR(parse_ulong_vector, atoi, uint64_t)
+PARSE_VECTOR(parse_longreal_vector, atoi, floatmax_t)
+#undef PARSE_VECTOR
+
+#define PARSE_FLOAT_VECTOR(sg_type)										\
+		void CStreamingAsciiFile::parse_vector(char* line, int32_t num_chars,	\
+				sg_type*& vector, int32_t& len)								\
 		{																	\
-				char *line=NULL;											\
-				SG_SET_LOCALE_C;											\
-				int32_t num_chars = buf->read_line(line);					\
 				int32_t old_len = len;										\
 																			\
-				if (num_chars == 0)											\
-				{															\
-						len = -1;											\
-						SG_RESET_LOCALE;									\
-						return;												\
-				}															\
-																			\
 				substring example_string = {line, line + num_chars};		\
 																			\
 				tokenize(m_delimiter, example_string, words);				\
@@ -147,32 +128,19 @@ GET_VECTOR(get_longreal_vector, atoi, floatmax_t)
 				{															\
 						vector[j++] = SGIO::float_of_substring(*i);			\
 				}															\
-				SG_RESET_LOCALE;											\
 		}
 
-GET_FLOAT_VECTOR(float32_t)
-GET_FLOAT_VECTOR(float64_t)
-#undef GET_FLOAT_VECTOR
+PARSE_FLOAT_VECTOR(float32_t)
+PARSE_FLOAT_VECTOR(float64_t)
+#undef PARSE_FLOAT_VECTOR
 
-/* Methods for reading a dense vector and a label from an ascii file */
+/* Methods for parsing a line of an ascii file into a dense vector and a label */
 
-#define GET_VECTOR_AND_LABEL(fname, conv, sg_type)						\
-		void CStreamingAsciiFile::get_vector_and_label(sg_type*& vector, int32_t& num_feat, float64_t& label) \
+#define PARSE_VECTOR_AND_LABEL(fname, conv, sg_type)					\
+		void CStreamingAsciiFile::parse_vector_and_label(char* buffer, int32_t bytes_read, \
+				sg_type*& vector, int32_t& num_feat, float64_t& label)	\
 		{																\
-				char* buffer = NULL;									\
-				ssize_t bytes_read;										\
 				int32_t old_len = num_feat;								\
-				SG_SET_LOCALE_C;										\
-																		\
-				bytes_read = buf->read_line(buffer);					\
-																		\
-				if (bytes_read<=0)										\
-				{														\
-						vector=NULL;									\
-						num_feat=-1;									\
-						SG_RESET_LOCALE;								\
-						return;											\
-				}														\
 																		\
 				/* determine num_feat, populate dynamic array */		\
 				int32_t nf=0;											\
@@ -213,7 +181,7 @@ GET_FLOAT_VECTOR(float64_t)
 																		\
 				SG_DEBUG("num_feat %d\n", num_feat)					\
 				/* The first element is the label */					\
-				label=atof(items->get_element(0));						\
+				label=SGIO::parse_double(items->get_element(0));		\
 				/* now copy rest of the data into vector */				\
 				if (old_len < num_feat - 1)								\
 						vector=SG_REALLOC(sg_type, vector, old_len, num_feat-1);	\
@@ -226,37 +194,27 @@ GET_FLOAT_VECTOR(float64_t)
 				}														\
 				delete items;											\
 				num_feat--;												\
-				SG_RESET_LOCALE;										\
 		}
 
-GET_VECTOR_AND_LABEL(get_bool_vector_and_label, str_to_bool, bool)
-GET_VECTOR_AND_LABEL(get_byte_vector_and_label, atoi, uint8_t)
-GET_VECTOR_AND_LABEL(get_char_vector_and_label, atoi, char)
-GET_VECTOR_AND_LABEL(get_int_vector_and_label, atoi, int32_t)
-GET_VECTOR_AND_LABEL(get_short_vector_and_label, atoi, int16_t)
-GET_VECTOR_AND_LABEL(get_word_vector_and_label, atoi, uint16_t)
-GET_VECTOR_AND_LABEL(get_int8_vector_and_label, atoi, int8_t)
-GET_VECTOR_AND_LABEL(get_uint_vector_and_label, atoi, uint32_t)
-GET_VECTOR_AND_LABEL(get_long_vector_and_label, atoi, int64_t)
-GET_VECTOR_AND_LABEL(get_ulong_vector_and_label, atoi, uint64_t)
-GET_VECTOR_AND_LABEL(get_longreal_vector_and_label, atoi, floatmax_t)
-#undef GET_VECTOR_AND_LABEL
-
-#define GET_FLOAT_VECTOR_AND_LABEL(sg_type)								\
-		void CStreamingAsciiFile::get_vector_and_label(sg_type*& vector, int32_t& len, float64_t& label) \
+PARSE_VECTOR_AND_LABEL(parse_bool_vector_and_label, str_to_bool, bool)
+PARSE_VECTOR_AND_LABEL(parse_byte_vector_and_label, atoi, uint8_t)
+PARSE_VECTOR_AND_LABEL(parse_char_vector_and_label, atoi, char)
+PARSE_VECTOR_AND_LABEL(parse_int_vector_and_label, atoi, int32_t)
+PARSE_VECTOR_AND_LABEL(parse_short_vector_and_label, atoi, int16_t)
+PARSE_VECTOR_AND_LABEL(parse_word_vector_and_label, atoi, uint16_t)
+PARSE_VECTOR_AND_LABEL(parse_int8_vector_and_label, atoi, int8_t)
+PARSE_VECTOR_AND_LABEL(parse_uint_vector_and_label, atoi, uint32_t)
+PARSE_VECTOR_AND_LABEL(parse_long_vector_and_label, atoi, int64_t)
+PARSE_VECTOR_AND_LABEL(parse_ulong_vector_and_label, atoi, uint64_t)
+PARSE_VECTOR_AND_LABEL(parse_longreal_vector_and_label, atoi, floatmax_t)
+#undef PARSE_VECTOR_AND_LABEL
+
+#define PARSE_FLOAT_VECTOR_AND_LABEL(sg_type)							\
+		void CStreamingAsciiFile::parse_vector_and_label(char* line, int32_t num_chars, \
+				sg_type*& vector, int32_t& len, float64_t& label)		\
 		{																\
-				char *line=NULL;										\
-				SG_SET_LOCALE_C;										\
-				int32_t num_chars = buf->read_line(line);				\
 				int32_t old_len = len;									\
 																		\
-				if (num_chars == 0)										\
-				{														\
-						len = -1;										\
-						SG_RESET_LOCALE;								\
-						return;											\
-				}														\
-																		\
 				substring example_string = {line, line + num_chars};	\
 																		\
 				tokenize(m_delimiter, example_string, words);			\
@@ -274,12 +232,83 @@ GET_VECTOR_AND_LABEL(get_longreal_vector_and_label, atoi, floatmax_t)
 				{														\
 						vector[j++] = SGIO::float_of_substring(*i);		\
 				}														\
-				SG_RESET_LOCALE;										\
 		}
 
-GET_FLOAT_VECTOR_AND_LABEL(float32_t)
-GET_FLOAT_VECTOR_AND_LABEL(float64_t)
-#undef GET_FLOAT_VECTOR_AND_LABEL
+PARSE_FLOAT_VECTOR_AND_LABEL(float32_t)
+PARSE_FLOAT_VECTOR_AND_LABEL(float64_t)
+#undef PARSE_FLOAT_VECTOR_AND_LABEL
+
+/* Methods for reading dense vectors from an ascii file */
+
+#define GET_VECTOR(sg_type)						\
+void CStreamingAsciiFile::get_vector(sg_type*& vector, int32_t& len) \
+{																		\
+		char* buffer = NULL;											\
+		SG_SET_LOCALE_C;												\
+		ssize_t bytes_read = buf->read_line(buffer);					\
+																		\
+		if (bytes_read<=0)												\
+		{																\
+				vector=NULL;											\
+				len=-1;													\
+				SG_RESET_LOCALE;										\
+				return;													\
+		}																\
+																		\
+		parse_vector(buffer, bytes_read, vector, len);		\
+		SG_RESET_LOCALE;												\
+}
+
+GET_VECTOR(bool)
+GET_VECTOR(uint8_t)
+GET_VECTOR(char)
+GET_VECTOR(int32_t)
+GET_VECTOR(float32_t)
+GET_VECTOR(float64_t)
+GET_VECTOR(int16_t)
+GET_VECTOR(uint16_t)
+GET_VECTOR(int8_t)
+GET_VECTOR(uint32_t)
+GET_VECTOR(int64_t)
+GET_VECTOR(uint64_t)
+GET_VECTOR(floatmax_t)
+#undef GET_VECTOR
+
+/* Methods for reading a dense vector and a label from an ascii file */
+
+#define GET_VECTOR_AND_LABEL(sg_type)						\
+void CStreamingAsciiFile::get_vector_and_label(sg_type*& vector, int32_t& len, float64_t& label) \
+{																		\
+		char* buffer = NULL;											\
+		SG_SET_LOCALE_C;												\
+		ssize_t bytes_read = buf->read_line(buffer);					\
+																		\
+		if (bytes_read<=0)												\
+		{																\
+				vector=NULL;											\
+				len=-1;													\
+				SG_RESET_LOCALE;										\
+				return;													\
+		}																\
+																		\
+		parse_vector_and_label(buffer, bytes_read, vector, len, label);		\
+		SG_RESET_LOCALE;												\
+}
+
+GET_VECTOR_AND_LABEL(bool)
+GET_VECTOR_AND_LABEL(uint8_t)
+GET_VECTOR_AND_LABEL(char)
+GET_VECTOR_AND_LABEL(int32_t)
+GET_VECTOR_AND_LABEL(float32_t)
+GET_VECTOR_AND_LABEL(float64_t)
+GET_VECTOR_AND_LABEL(int16_t)
+GET_VECTOR_AND_LABEL(uint16_t)
+GET_VECTOR_AND_LABEL(int8_t)
+GET_VECTOR_AND_LABEL(uint32_t)
+GET_VECTOR_AND_LABEL(int64_t)
+GET_VECTOR_AND_LABEL(uint64_t)
+GET_VECTOR_AND_LABEL(floatmax_t)
+#undef GET_VECTOR_AND_LABEL
 
 /* Methods for reading a string vector from an ascii file (see StringFeatures) */
 
@@ -395,25 +424,12 @@ GET_STRING_AND_LABEL(get_ulong_string_and_label, atoi, uint64_t)
 GET_STRING_AND_LABEL(get_longreal_string_and_label, atoi, floatmax_t)
 #undef GET_STRING_AND_LABEL
 
-/* Methods for reading a sparse vector from an ascii file */
+/* Methods for parsing a line of an ascii file into a sparse vector */
 
-#define GET_SPARSE_VECTOR(fname, conv, sg_type)							\
-void CStreamingAsciiFile::get_sparse_vector(SGSparseVectorEntry<sg_type>*& vector, int32_t& len) \
+#define PARSE_SPARSE_VECTOR(fname, conv, sg_type)						\
+void CStreamingAsciiFile::parse_sparse_vector(char* buffer, int32_t bytes_read, \
+		SGSparseVectorEntry<sg_type>*& vector, int32_t& len)			\
 {																		\
-		char* buffer = NULL;											\
-		ssize_t bytes_read;												\
-		SG_SET_LOCALE_C;												\
-																		\
-		bytes_read = buf->read_line(buffer);							\
-																		\
-		if (bytes_read<=1)												\
-		{																\
-				vector=NULL;											\
-				len=-1;													\
-				SG_RESET_LOCALE;										\
-				return;													\
-		}																\
-																		\
 		/* Remove terminating \n */										\
 		int32_t num_chars;												\
 		if (buffer[bytes_read-1]=='\n')									\
@@ -471,43 +487,29 @@ void CStreamingAsciiFile::get_sparse_vector(SGSparseVectorEntry<sg_type>*& vecto
 		}																\
 																		\
 		len=current_feat;												\
-		SG_RESET_LOCALE;												\
 }
 
-GET_SPARSE_VECTOR(get_bool_sparse_vector, str_to_bool, bool)
-GET_SPARSE_VECTOR(get_byte_sparse_vector, atoi, uint8_t)
-GET_SPARSE_VECTOR(get_char_sparse_vector, atoi, char)
-GET_SPARSE_VECTOR(get_int_sparse_vector, atoi, int32_t)
-GET_SPARSE_VECTOR(get_shortreal_sparse_vector, atof, float32_t)
-GET_SPARSE_VECTOR(get_real_sparse_vector, atof, float64_t)
-GET_SPARSE_VECTOR(get_short_sparse_vector, atoi, int16_t)
-GET_SPARSE_VECTOR(get_word_sparse_vector, atoi, uint16_t)
-GET_SPARSE_VECTOR(get_int8_sparse_vector, atoi, int8_t)
-GET_SPARSE_VECTOR(get_uint_sparse_vector, atoi, uint32_t)
-GET_SPARSE_VECTOR(get_long_sparse_vector, atoi, int64_t)
-GET_SPARSE_VECTOR(get_ulong_sparse_vector, atoi, uint64_t)
-GET_SPARSE_VECTOR(get_longreal_sparse_vector, atoi, floatmax_t)
-#undef GET_SPARSE_VECTOR
-
-/* Methods for reading a sparse vector and a label from an ascii file */
-
-#define GET_SPARSE_VECTOR_AND_LABEL(fname, conv, sg_type)				\
-void CStreamingAsciiFile::get_sparse_vector_and_label(SGSparseVectorEntry<sg_type>*& vector, int32_t& len, float64_t& label) \
+PARSE_SPARSE_VECTOR(parse_bool_sparse_vector, str_to_bool, bool)
+PARSE_SPARSE_VECTOR(parse_byte_sparse_vector, atoi, uint8_t)
+PARSE_SPARSE_VECTOR(parse_char_sparse_vector, atoi, char)
+PARSE_SPARSE_VECTOR(parse_int_sparse_vector, atoi, int32_t)
+PARSE_SPARSE_VECTOR(parse_shortreal_sparse_vector, SGIO::parse_double, float32_t)
+PARSE_SPARSE_VECTOR(parse_real_sparse_vector, SGIO::parse_double, float64_t)
+PARSE_SPARSE_VECTOR(parse_short_sparse_vector, atoi, int16_t)
+PARSE_SPARSE_VECTOR(parse_word_sparse_vector, atoi, uint16_t)
+PARSE_SPARSE_VECTOR(parse_int8_sparse_vector, atoi, int8_t)
+PARSE_SPARSE_VECTOR(parse_uint_sparse_vector, atoi, uint32_t)
+PARSE_SPARSE_VECTOR(parse_long_sparse_vector, atoi, int64_t)
+PARSE_SPARSE_VECTOR(parse_ulong_sparse_vector, atoi, uint64_t)
+PARSE_SPARSE_VECTOR(parse_longreal_sparse_vector, atoi, floatmax_t)
+#undef PARSE_SPARSE_VECTOR
+
+/* Methods for parsing a line of an ascii file into a sparse vector and a label */
+
+#define PARSE_SPARSE_VECTOR_AND_LABEL(fname, conv, sg_type)			\
+void CStreamingAsciiFile::parse_sparse_vector_and_label(char* buffer, int32_t bytes_read, \
+		SGSparseVectorEntry<sg_type>*& vector, int32_t& len, float64_t& label) \
 {																		\
-		char* buffer = NULL;											\
-		ssize_t bytes_read;												\
-		SG_SET_LOCALE_C;												\
-																		\
-		bytes_read = buf->read_line(buffer);							\
-																		\
-		if (bytes_read<=1)												\
-		{																\
-				vector=NULL;											\
-				len=-1;													\
-				SG_RESET_LOCALE;										\
-				return;													\
-		}																\
-																		\
 		/* Remove terminating \n */										\
 		int32_t num_chars;												\
 		if (buffer[bytes_read-1]=='\n')									\
@@ -544,7 +546,7 @@ void CStreamingAsciiFile::get_sparse_vector_and_label(SGSparseVectorEntry<sg_typ
 				{														\
 						buffer[i]='\0';									\
 						label_pos=i;									\
-						label=atof(buffer);								\
+						label=SGIO::parse_double(buffer);				\
 						break;											\
 				}														\
 		}																\
@@ -587,22 +589,93 @@ void CStreamingAsciiFile::get_sparse_vector_and_label(SGSparseVectorEntry<sg_typ
 		}																\
 																		\
 		len=current_feat;												\
+}
+
+PARSE_SPARSE_VECTOR_AND_LABEL(parse_bool_sparse_vector_and_label, str_to_bool, bool)
+PARSE_SPARSE_VECTOR_AND_LABEL(parse_byte_sparse_vector_and_label, atoi, uint8_t)
+PARSE_SPARSE_VECTOR_AND_LABEL(parse_char_sparse_vector_and_label, atoi, char)
+PARSE_SPARSE_VECTOR_AND_LABEL(parse_int_sparse_vector_and_label, atoi, int32_t)
+PARSE_SPARSE_VECTOR_AND_LABEL(parse_shortreal_sparse_vector_and_label, SGIO::parse_double, float32_t)
+PARSE_SPARSE_VECTOR_AND_LABEL(parse_real_sparse_vector_and_label, SGIO::parse_double, float64_t)
+PARSE_SPARSE_VECTOR_AND_LABEL(parse_short_sparse_vector_and_label, atoi, int16_t)
+PARSE_SPARSE_VECTOR_AND_LABEL(parse_word_sparse_vector_and_label, atoi, uint16_t)
+PARSE_SPARSE_VECTOR_AND_LABEL(parse_int8_sparse_vector_and_label, atoi, int8_t)
+PARSE_SPARSE_VECTOR_AND_LABEL(parse_uint_sparse_vector_and_label, atoi, uint32_t)
+PARSE_SPARSE_VECTOR_AND_LABEL(parse_long_sparse_vector_and_label, atoi, int64_t)
+PARSE_SPARSE_VECTOR_AND_LABEL(parse_ulong_sparse_vector_and_label, atoi, uint64_t)
+PARSE_SPARSE_VECTOR_AND_LABEL(parse_longreal_sparse_vector_and_label, atoi, floatmax_t)
+#undef PARSE_SPARSE_VECTOR_AND_LABEL
+
+/* Methods for reading a sparse vector from an ascii file */
+
+#define GET_SPARSE_VECTOR(sg_type)						\
+void CStreamingAsciiFile::get_sparse_vector(SGSparseVectorEntry<sg_type>*& vector, int32_t& len) \
+{																		\
+		char* buffer = NULL;											\
+		SG_SET_LOCALE_C;												\
+		ssize_t bytes_read = buf->read_line(buffer);					\
+																		\
+		if (bytes_read<=1)												\
+		{																\
+				vector=NULL;											\
+				len=-1;													\
+				SG_RESET_LOCALE;										\
+				return;													\
+		}																\
+																		\
+		parse_sparse_vector(buffer, bytes_read, vector, len);		\
+		SG_RESET_LOCALE;												\
+}
+
+GET_SPARSE_VECTOR(bool)
+GET_SPARSE_VECTOR(uint8_t)
+GET_SPARSE_VECTOR(char)
+GET_SPARSE_VECTOR(int32_t)
+GET_SPARSE_VECTOR(float32_t)
+GET_SPARSE_VECTOR(float64_t)
+GET_SPARSE_VECTOR(int16_t)
+GET_SPARSE_VECTOR(uint16_t)
+GET_SPARSE_VECTOR(int8_t)
+GET_SPARSE_VECTOR(uint32_t)
+GET_SPARSE_VECTOR(int64_t)
+GET_SPARSE_VECTOR(uint64_t)
+GET_SPARSE_VECTOR(floatmax_t)
+#undef GET_SPARSE_VECTOR
+
+/* Methods for reading a sparse vector and a label from an ascii file */
+
+#define GET_SPARSE_VECTOR_AND_LABEL(sg_type)						\
+void CStreamingAsciiFile::get_sparse_vector_and_label(SGSparseVectorEntry<sg_type>*& vector, int32_t& len, float64_t& label) \
+{																		\
+		char* buffer = NULL;											\
+		SG_SET_LOCALE_C;												\
+		ssize_t bytes_read = buf->read_line(buffer);					\
+																		\
+		if (bytes_read<=1)												\
+		{																\
+				vector=NULL;											\
+				len=-1;													\
+				SG_RESET_LOCALE;										\
+				return;													\
+		}																\
+																		\
+		parse_sparse_vector_and_label(buffer, bytes_read, vector, len, label);		\
 		SG_RESET_LOCALE;												\
 }
 
-GET_SPARSE_VECTOR_AND_LABEL(get_bool_sparse_vector_and_label, str_to_bool, bool)
-GET_SPARSE_VECTOR_AND_LABEL(get_byte_sparse_vector_and_label, atoi, uint8_t)
-GET_SPARSE_VECTOR_AND_LABEL(get_char_sparse_vector_and_label, atoi, char)
-GET_SPARSE_VECTOR_AND_LABEL(get_int_sparse_vector_and_label, atoi, int32_t)
-GET_SPARSE_VECTOR_AND_LABEL(get_shortreal_sparse_vector_and_label, atof, float32_t)
-GET_SPARSE_VECTOR_AND_LABEL(get_real_sparse_vector_and_label, atof, float64_t)
-GET_SPARSE_VECTOR_AND_LABEL(get_short_sparse_vector_and_label, atoi, int16_t)
-GET_SPARSE_VECTOR_AND_LABEL(get_word_sparse_vector_and_label, atoi, uint16_t)
-GET_SPARSE_VECTOR_AND_LABEL(get_int8_sparse_vector_and_label, atoi, int8_t)
-GET_SPARSE_VECTOR_AND_LABEL(get_uint_sparse_vector_and_label, atoi, uint32_t)
-GET_SPARSE_VECTOR_AND_LABEL(get_long_sparse_vector_and_label, atoi, int64_t)
-GET_SPARSE_VECTOR_AND_LABEL(get_ulong_sparse_vector_and_label, atoi, uint64_t)
-GET_SPARSE_VECTOR_AND_LABEL(get_longreal_sparse_vector_and_label, atoi, floatmax_t)
+GET_SPARSE_VECTOR_AND_LABEL(bool)
+GET_SPARSE_VECTOR_AND_LABEL(uint8_t)
+GET_SPARSE_VECTOR_AND_LABEL(char)
+GET_SPARSE_VECTOR_AND_LABEL(int32_t)
+GET_SPARSE_VECTOR_AND_LABEL(float32_t)
+GET_SPARSE_VECTOR_AND_LABEL(float64_t)
+GET_SPARSE_VECTOR_AND_LABEL(int16_t)
+GET_SPARSE_VECTOR_AND_LABEL(uint16_t)
+GET_SPARSE_VECTOR_AND_LABEL(int8_t)
+GET_SPARSE_VECTOR_AND_LABEL(uint32_t)
+GET_SPARSE_VECTOR_AND_LABEL(int64_t)
+GET_SPARSE_VECTOR_AND_LABEL(uint64_t)
+GET_SPARSE_VECTOR_AND_LABEL(floatmax_t)
 #undef GET_SPARSE_VECTOR_AND_LABEL
 
 template <class T>
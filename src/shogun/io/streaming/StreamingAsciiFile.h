@@ -82,7 +82,19 @@ public:
 		(SGSparseVectorEntry<sg_type>*& vector, int32_t& len);	\
 									\
 	virtual void get_sparse_vector_and_label			\
-		(SGSparseVectorEntry<sg_type>*& vector, int32_t& len, float64_t& label);
+		(SGSparseVectorEntry<sg_type>*& vector, int32_t& len, float64_t& label); \
+									\
+	virtual void parse_vector					\
+		(char* line, int32_t num_chars, sg_type*& vector, int32_t& len); \
+									\
+	virtual void parse_vector_and_label				\
+		(char* line, int32_t num_chars, sg_type*& vector, int32_t& len, float64_t& label); \
+									\
+	virtual void parse_sparse_vector				\
+		(char* line, int32_t num_chars, SGSparseVectorEntry<sg_type>*& vector, int32_t& len); \
+									\
+	virtual void parse_sparse_vector_and_label			\
+		(char* line, int32_t num_chars, SGSparseVectorEntry<sg_type>*& vector, int32_t& len, float64_t& label);
 
 	GET_VECTOR_DECL(bool)
 	GET_VECTOR_DECL(uint8_t)
@@ -99,6 +111,14 @@ public:
 	GET_VECTOR_DECL(floatmax_t)
 #undef GET_VECTOR_DECL
 
+	/**
+	 * Dense and sparse vectors can be parsed from lines in
+	 * several threads.
+	 *
+	 * @return true
+	 */
+	virtual bool has_line_parser() { return true; }
+
 #endif // #ifndef SWIG // SWIG should skip this
 
 	/** @return object name */
@@ -128,9 +148,6 @@ private:
 	void tokenize(char delim, substring s, v_array<substring> &ret);
 
 private:
-	/// Helper for parsing
-	v_array<substring> words;
-
 	/** delimiter */
 	char m_delimiter;
 };
@@ -10,6 +10,8 @@
 #include <fcntl.h>
 #ifdef _WIN32
 #include <io.h>
+#else
+#include <unistd.h>
 #endif
 
 namespace shogun
@@ -178,6 +180,110 @@ GET_SPARSE_VECTOR_AND_LABEL(get_long_sparse_vector_and_label, atoi, int64_t)
 GET_SPARSE_VECTOR_AND_LABEL(get_ulong_sparse_vector_and_label, atoi, uint64_t)
 GET_SPARSE_VECTOR_AND_LABEL(get_longreal_sparse_vector_and_label, atoi, floatmax_t)
 #undef GET_SPARSE_VECTOR_AND_LABEL
+
+/* For parsing dense vectors from a line */
+#define PARSE_VECTOR(sg_type)						\
+	void CStreamingFile::parse_vector					\
+	(char* line, int32_t num_chars, sg_type*& vector,		\
+	 int32_t& num_feat)						\
+	{								\
+		vector=NULL;						\
+		num_feat=-1;						\
+		SG_ERROR("Parse function not supported by the file type!") \
+	}
+
+PARSE_VECTOR(bool)
+PARSE_VECTOR(uint8_t)
+PARSE_VECTOR(char)
+PARSE_VECTOR(int32_t)
+PARSE_VECTOR(float32_t)
+PARSE_VECTOR(float64_t)
+PARSE_VECTOR(int16_t)
+PARSE_VECTOR(uint16_t)
+PARSE_VECTOR(int8_t)
+PARSE_VECTOR(uint32_t)
+PARSE_VECTOR(int64_t)
+PARSE_VECTOR(uint64_t)
+PARSE_VECTOR(floatmax_t)
+#undef PARSE_VECTOR
+
+/* For parsing dense vectors with labels from a line */
+#define PARSE_VECTOR_AND_LABEL(sg_type)						\
+	void CStreamingFile::parse_vector_and_label					\
+	(char* line, int32_t num_chars, sg_type*& vector,		\
+	 int32_t& num_feat, float64_t& label)						\
+	{								\
+		vector=NULL;						\
+		num_feat=-1;						\
+		SG_ERROR("Parse function not supported by the file type!") \
+	}
+
+PARSE_VECTOR_AND_LABEL(bool)
+PARSE_VECTOR_AND_LABEL(uint8_t)
+PARSE_VECTOR_AND_LABEL(char)
+PARSE_VECTOR_AND_LABEL(int32_t)
+PARSE_VECTOR_AND_LABEL(float32_t)
+PARSE_VECTOR_AND_LABEL(float64_t)
+PARSE_VECTOR_AND_LABEL(int16_t)
+PARSE_VECTOR_AND_LABEL(uint16_t)
+PARSE_VECTOR_AND_LABEL(int8_t)
+PARSE_VECTOR_AND_LABEL(uint32_t)
+PARSE_VECTOR_AND_LABEL(int64_t)
+PARSE_VECTOR_AND_LABEL(uint64_t)
+PARSE_VECTOR_AND_LABEL(floatmax_t)
+#undef PARSE_VECTOR_AND_LABEL
+
+/* For parsing sparse vectors from a line */
+#define PARSE_SPARSE_VECTOR(sg_type)						\
+	void CStreamingFile::parse_sparse_vector					\
+	(char* line, int32_t num_chars, SGSparseVectorEntry<sg_type>*& vector,		\
+	 int32_t& num_feat)						\
+	{								\
+		vector=NULL;						\
+		num_feat=-1;						\
+		SG_ERROR("Parse function not supported by the file type!") \
+	}
+
+PARSE_SPARSE_VECTOR(bool)
+PARSE_SPARSE_VECTOR(uint8_t)
+PARSE_SPARSE_VECTOR(char)
+PARSE_SPARSE_VECTOR(int32_t)
+PARSE_SPARSE_VECTOR(float32_t)
+PARSE_SPARSE_VECTOR(float64_t)
+PARSE_SPARSE_VECTOR(int16_t)
+PARSE_SPARSE_VECTOR(uint16_t)
+PARSE_SPARSE_VECTOR(int8_t)
+PARSE_SPARSE_VECTOR(uint32_t)
+PARSE_SPARSE_VECTOR(int64_t)
+PARSE_SPARSE_VECTOR(uint64_t)
+PARSE_SPARSE_VECTOR(floatmax_t)
+#undef PARSE_SPARSE_VECTOR
+
+/* For parsing sparse vectors with labels from a line */
+#define PARSE_SPARSE_VECTOR_AND_LABEL(sg_type)						\
+	void CStreamingFile::parse_sparse_vector_and_label					\
+	(char* line, int32_t num_chars, SGSparseVectorEntry<sg_type>*& vector,		\
+	 int32_t& num_feat, float64_t& label)						\
+	{								\
+		vector=NULL;						\
+		num_feat=-1;						\
+		SG_ERROR("Parse function not supported by the file type!") \
+	}
+
+PARSE_SPARSE_VECTOR_AND_LABEL(bool)
+PARSE_SPARSE_VECTOR_AND_LABEL(uint8_t)
+PARSE_SPARSE_VECTOR_AND_LABEL(char)
+PARSE_SPARSE_VECTOR_AND_LABEL(int32_t)
+PARSE_SPARSE_VECTOR_AND_LABEL(float32_t)
+PARSE_SPARSE_VECTOR_AND_LABEL(float64_t)
+PARSE_SPARSE_VECTOR_AND_LABEL(int16_t)
+PARSE_SPARSE_VECTOR_AND_LABEL(uint16_t)
+PARSE_SPARSE_VECTOR_AND_LABEL(int8_t)
+PARSE_SPARSE_VECTOR_AND_LABEL(uint32_t)
+PARSE_SPARSE_VECTOR_AND_LABEL(int64_t)
+PARSE_SPARSE_VECTOR_AND_LABEL(uint64_t)
+PARSE_SPARSE_VECTOR_AND_LABEL(floatmax_t)
+#undef PARSE_SPARSE_VECTOR_AND_LABEL
 	
 }
 
@@ -185,6 +291,7 @@ using namespace shogun;
 
 CStreamingFile::CStreamingFile() : CSGObject()
 {
+	task='r';
 	buf=NULL;
 	filename=NULL;
 }
@@ -225,3 +332,40 @@ CStreamingFile::~CStreamingFile()
 	SG_FREE(filename);
 	SG_UNREF(buf);
 }
+
+bool CStreamingFile::is_seekable()
+{
+	return buf && task=='r' && lseek(buf->working_file, 0, SEEK_CUR)>=0;
+}
+
+void CStreamingFile::reset_stream()
+{
+	REQUIRE(is_seekable(), "Unable to reset the input stream!\n")
+	buf->reset_file();
+}
+
+int32_t CStreamingFile::read_lines(int32_t max_lines, std::vector<char>& lines,
+	std::vector<int64_t>& starts, std::vector<int32_t>& lengths,
+	int32_t min_chars)
+{
+	lines.clear();
+	starts.clear();
+	lengths.clear();
+
+	int32_t num_lines=0;
+	for (; num_lines<max_lines; num_lines++)
+	{
+		char* line=NULL;
+		ssize_t num_chars=buf->read_line(line);
+		if (num_chars<min_chars)
+			break;
+
+		starts.push_back(lines.size());
+		lengths.push_back(num_chars);
+		lines.insert(lines.end(), line, line+num_chars);
+		lines.push_back('\n');
+		lines.push_back('\0');
+	}
+
+	return num_lines;
+}
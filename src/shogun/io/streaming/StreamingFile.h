@@ -13,6 +13,8 @@
 #include <shogun/base/SGObject.h>
 #include <shogun/io/IOBuffer.h>
 
+#include <vector>
+
 namespace shogun
 {
 template <class ST> struct SGSparseVectorEntry;
@@ -56,14 +58,16 @@ template <class ST> struct SGSparseVectorEntry;
 		/**
 		 * Whether the stream is seekable/resettable
 		 *
-		 * @return false by default, unless overloaded
+		 * @return true for files opened for reading that support
+		 * seeking, false e.g. for pipes, unless overloaded
 		 */
-		virtual bool is_seekable() { return false; }
+		virtual bool is_seekable();
 
 		/**
-		 * Reset the stream, should be overloaded if possible
+		 * Reset the stream, seeks a file back to its start, should
+		 * be overloaded for other sources
 		 */
-		virtual void reset_stream() { SG_ERROR("Unable to reset the input stream!\n") }
+		virtual void reset_stream();
 
 		/** @name Dense Vector Access Functions
 		 *
@@ -262,6 +266,153 @@ template <class ST> struct SGSparseVectorEntry;
 
 		//@}
 
+		/**
+		 * Whether the parse_* functions below are implemented, in
+		 * which case the lines of the file can be parsed in several
+		 * threads (see CInputParser::set_num_parsers).
+		 *
+		 * @return false by default, unless overloaded
+		 */
+		virtual bool has_line_parser() { return false; }
+
+		/**
+		 * Copy the next lines of the file into a buffer owned by
+		 * the caller, so that they can be parsed after the next
+		 * read.
+		 *
+		 * Each line is stored with its terminating newline followed
+		 * by a '\0', as seen by the get_* functions. Like them, a
+		 * line with fewer than min_chars characters ends the input,
+		 * e.g. 2 for sparse vectors.
+		 *
+		 * @param max_lines maximum number of lines to read
+		 * @param lines buffer the lines are copied into
+		 * @param starts offset of each line in lines
+		 * @param lengths number of characters of each line,
+		 * without the newline
+		 * @param min_chars minimum number of characters of a line
+		 * @return number of lines read, less than max_lines at the
+		 * end of the input
+		 */
+		int32_t read_lines(int32_t max_lines, std::vector<char>& lines,
+			std::vector<int64_t>& starts, std::vector<int32_t>& lengths,
+			int32_t min_chars=1);
+
+		/** @name Line Parsing Functions
+		 *
+		 * Counterparts of the get_* functions which parse a line
+		 * returned by read_lines instead of reading from the file.
+		 * They do not touch the state of the file object, so that
+		 * several threads may call them at once. The line may be
+		 * modified in the process.
+		 */
+		//@{
+		virtual void parse_vector
+			(char* line, int32_t num_chars, bool*& vector, int32_t& len);
+		virtual void parse_vector
+			(char* line, int32_t num_chars, uint8_t*& vector, int32_t& len);
+		virtual void parse_vector
+			(char* line, int32_t num_chars, char*& vector, int32_t& len);
+		virtual void parse_vector
+			(char* line, int32_t num_chars, int32_t*& vector, int32_t& len);
+		virtual void parse_vector
+			(char* line, int32_t num_chars, float32_t*& vector, int32_t& len);
+		virtual void parse_vector
+			(char* line, int32_t num_chars, float64_t*& vector, int32_t& len);
+		virtual void parse_vector
+			(char* line, int32_t num_chars, int16_t*& vector, int32_t& len);
+		virtual void parse_vector
+			(char* line, int32_t num_chars, uint16_t*& vector, int32_t& len);
+		virtual void parse_vector
+			(char* line, int32_t num_chars, int8_t*& vector, int32_t& len);
+		virtual void parse_vector
+			(char* line, int32_t num_chars, uint32_t*& vector, int32_t& len);
+		virtual void parse_vector
+			(char* line, int32_t num_chars, int64_t*& vector, int32_t& len);
+		virtual void parse_vector
+			(char* line, int32_t num_chars, uint64_t*& vector, int32_t& len);
+		virtual void parse_vector
+			(char* line, int32_t num_chars, floatmax_t*& vector, int32_t& len);
+		virtual void parse_vector_and_label
+			(char* line, int32_t num_chars, bool*& vector, int32_t& len, float64_t& label);
+		virtual void parse_vector_and_label
+			(char* line, int32_t num_chars, uint8_t*& vector, int32_t& len, float64_t& label);
+		virtual void parse_vector_and_label
+			(char* line, int32_t num_chars, char*& vector, int32_t& len, float64_t& label);
+		virtual void parse_vector_and_label
+			(char* line, int32_t num_chars, int32_t*& vector, int32_t& len, float64_t& label);
+		virtual void parse_vector_and_label
+			(char* line, int32_t num_chars, float32_t*& vector, int32_t& len, float64_t& label);
+		virtual void parse_vector_and_label
+			(char* line, int32_t num_chars, float64_t*& vector, int32_t& len, float64_t& label);
+		virtual void parse_vector_and_label
+			(char* line, int32_t num_chars, int16_t*& vector, int32_t& len, float64_t& label);
+		virtual void parse_vector_and_label
+			(char* line, int32_t num_chars, uint16_t*& vector, int32_t& len, float64_t& label);
+		virtual void parse_vector_and_label
+			(char* line, int32_t num_chars, int8_t*& vector, int32_t& len, float64_t& label);
+		virtual void parse_vector_and_label
+			(char* line, int32_t num_chars, uint32_t*& vector, int32_t& len, float64_t& label);
+		virtual void parse_vector_and_label
+			(char* line, int32_t num_chars, int64_t*& vector, int32_t& len, float64_t& label);
+		virtual void parse_vector_and_label
+			(char* line, int32_t num_chars, uint64_t*& vector, int32_t& len, float64_t& label);
+		virtual void parse_vector_and_label
+			(char* line, int32_t num_chars, floatmax_t*& vector, int32_t& len, float64_t& label);
+		virtual void parse_sparse_vector
+			(char* line, int32_t num_chars, SGSparseVectorEntry<bool>*& vector, int32_t& len);
+		virtual void parse_sparse_vector
+			(char* line, int32_t num_chars, SGSparseVectorEntry<uint8_t>*& vector, int32_t& len);
+		virtual void parse_sparse_vector
+			(char* line, int32_t num_chars, SGSparseVectorEntry<char>*& vector, int32_t& len);
+		virtual void parse_sparse_vector
+			(char* line, int32_t num_chars, SGSparseVectorEntry<int32_t>*& vector, int32_t& len);
+		virtual void parse_sparse_vector
+			(char* line, int32_t num_chars, SGSparseVectorEntry<float32_t>*& vector, int32_t& len);
+		virtual void parse_sparse_vector
+			(char* line, int32_t num_chars, SGSparseVectorEntry<float64_t>*& vector, int32_t& len);
+		virtual void parse_sparse_vector
+			(char* line, int32_t num_chars, SGSparseVectorEntry<int16_t>*& vector, int32_t& len);
+		virtual void parse_sparse_vector
+			(char* line, int32_t num_chars, SGSparseVectorEntry<uint16_t>*& vector, int32_t& len);
+		virtual void parse_sparse_vector
+			(char* line, int32_t num_chars, SGSparseVectorEntry<int8_t>*& vector, int32_t& len);
+		virtual void parse_sparse_vector
+			(char* line, int32_t num_chars, SGSparseVectorEntry<uint32_t>*& vector, int32_t& len);
+		virtual void parse_sparse_vector
+			(char* line, int32_t num_chars, SGSparseVectorEntry<int64_t>*& vector, int32_t& len);
+		virtual void parse_sparse_vector
+			(char* line, int32_t num_chars, SGSparseVectorEntry<uint64_t>*& vector, int32_t& len);
+		virtual void parse_sparse_vector
+			(char* line, int32_t num_chars, SGSparseVectorEntry<floatmax_t>*& vector, int32_t& len);
+		virtual void parse_sparse_vector_and_label
+			(char* line, int32_t num_chars, SGSparseVectorEntry<bool>*& vector, int32_t& len, float64_t& label);
+		virtual void parse_sparse_vector_and_label
+			(char* line, int32_t num_chars, SGSparseVectorEntry<uint8_t>*& vector, int32_t& len, float64_t& label);
+		virtual void parse_sparse_vector_and_label
+			(char* line, int32_t num_chars, SGSparseVectorEntry<char>*& vector, int32_t& len, float64_t& label);
+		virtual void parse_sparse_vector_and_label
+			(char* line, int32_t num_chars, SGSparseVectorEntry<int32_t>*& vector, int32_t& len, float64_t& label);
+		virtual void parse_sparse_vector_and_label
+			(char* line, int32_t num_chars, SGSparseVectorEntry<float32_t>*& vector, int32_t& len, float64_t& label);
+		virtual void parse_sparse_vector_and_label
+			(char* line, int32_t num_chars, SGSparseVectorEntry<float64_t>*& vector, int32_t& len, float64_t& label);
+		virtual void parse_sparse_vector_and_label
+			(char* line, int32_t num_chars, SGSparseVectorEntry<int16_t>*& vector, int32_t& len, float64_t& label);
+		virtual void parse_sparse_vector_and_label
+			(char* line, int32_t num_chars, SGSparseVectorEntry<uint16_t>*& vector, int32_t& len, float64_t& label);
+		virtual void parse_sparse_vector_and_label
+			(char* line, int32_t num_chars, SGSparseVectorEntry<int8_t>*& vector, int32_t& len, float64_t& label);
+		virtual void parse_sparse_vector_and_label
+			(char* line, int32_t num_chars, SGSparseVectorEntry<uint32_t>*& vector, int32_t& len, float64_t& label);
+		virtual void parse_sparse_vector_and_label
+			(char* line, int32_t num_chars, SGSparseVectorEntry<int64_t>*& vector, int32_t& len, float64_t& label);
+		virtual void parse_sparse_vector_and_label
+			(char* line, int32_t num_chars, SGSparseVectorEntry<uint64_t>*& vector, int32_t& len, float64_t& label);
+		virtual void parse_sparse_vector_and_label
+			(char* line, int32_t num_chars, SGSparseVectorEntry<floatmax_t>*& vector, int32_t& len, float64_t& label);
+		//@}
+
 #endif // #ifndef SWIG // SWIG should skip this
 
 
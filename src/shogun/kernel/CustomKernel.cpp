@@ -12,11 +12,28 @@
 #include <shogun/features/DummyFeatures.h>
 #include <shogun/features/IndexFeatures.h>
 #include <shogun/io/SGIO.h>
+#include <shogun/io/MemoryMappedFile.h>
 #include <shogun/mathematics/linalg/LinalgNamespace.h>
 
 using namespace shogun;
 using namespace linalg;
 
+/** header of a kernel matrix file, followed by the kernel matrix as
+ * float32_t, either column-major or as concatenated upper triangle rows */
+struct KernelMatrixFileHeader
+{
+	/** file format identifier */
+	char magic[8];
+	/** number of rows */
+	int64_t num_rows;
+	/** number of columns */
+	int64_t num_cols;
+	/** whether only the upper triangle is stored */
+	int64_t upper_triangle;
+};
+
+static const char kernel_matrix_file_magic[8]="SGKMAT1";
+
 void CCustomKernel::init()
 {
 	m_row_subset_stack=new CSubsetStack();
@@ -25,6 +42,7 @@ void CCustomKernel::init()
 	SG_REF(m_col_subset_stack)
 	m_is_symmetric=false;
 	m_free_km=true;
+	m_mapped_file=NULL;
 
 	SG_ADD((CSGObject**)&m_row_subset_stack, "row_subset_stack",
 			"Subset stack of rows", MS_NOT_AVAILABLE);
@@ -58,6 +76,14 @@ CCustomKernel::CCustomKernel(CKernel* k)
 		m_is_symmetric=casted->m_is_symmetric;
 		set_full_kernel_matrix_from_full(casted->get_float32_kernel_matrix());
 		m_free_km=false;
+
+		/* a mapped kernel matrix has to stay mapped as long as it is used */
+		if (casted->m_mapped_file)
+		{
+			m_mapped_file=casted->m_mapped_file;
+			SG_REF(m_mapped_file);
+			upper_diagonal=casted->upper_diagonal;
+		}
 	}
 	else
 	{
@@ -84,6 +110,19 @@ CCustomKernel::CCustomKernel(SGMatrix<float32_t> km)
 	SG_DEBUG("Leaving\n")
 }
 
+CCustomKernel::CCustomKernel(CKernel* k, const char* fname,
+		bool upper_triangle)
+: CKernel(10), upper_diagonal(false)
+{
+	SG_DEBUG("Entering\n")
+	init();
+	compute_kernel_matrix_file(k, fname, upper_triangle);
+	set_kernel_matrix_from_file(fname);
+	m_is_symmetric=upper_triangle || k->get_lhs_equals_rhs();
+	lhs_equals_rhs=m_is_symmetric;
+	SG_DEBUG("Leaving\n")
+}
+
 CCustomKernel::~CCustomKernel()
 {
 	SG_DEBUG("Entering\n")
@@ -153,6 +192,114 @@ bool CCustomKernel::init(CFeatures* l, CFeatures* r)
 	return init_normalizer();
 }
 
+bool CCustomKernel::compute_kernel_matrix_file(CKernel* kernel,
+		const char* fname, bool upper_triangle)
+{
+	REQUIRE(kernel, "Kernel must not be NULL\n")
+	REQUIRE(kernel->has_features(), "Kernel must be initialized with features\n")
+	REQUIRE(fname, "File name must not be NULL\n")
+
+	int64_t num_rows=kernel->get_num_vec_lhs();
+	int64_t num_cols=kernel->get_num_vec_rhs();
+	REQUIRE(!upper_triangle || num_rows==num_cols, "Only square kernel "
+			"matrices can be stored as upper triangle, got %ldx%ld\n",
+			num_rows, num_cols)
+
+	int64_t num_elements=upper_triangle ?
+		num_rows*(num_rows+1)/2 : num_rows*num_cols;
+	int64_t size=sizeof(KernelMatrixFileHeader)+num_elements*sizeof(float32_t);
+
+	SG_SDEBUG("writing kernel matrix of size %ldx%ld to %s (%ld bytes)\n",
+			num_rows, num_cols, fname, size)
+
+	CMemoryMappedFile<char>* file=new CMemoryMappedFile<char>(fname, 'w', size);
+	SG_REF(file);
+	file->set_truncate_size(size);
+
+	KernelMatrixFileHeader header;
+	memcpy(header.magic, kernel_matrix_file_magic, sizeof(header.magic));
+	header.num_rows=num_rows;
+	header.num_cols=num_cols;
+	header.upper_triangle=upper_triangle;
+	memcpy(file->get_map(), &header, sizeof(header));
+
+	float32_t* km=(float32_t*) (file->get_map()+sizeof(header));
+
+	/* every thread writes its own rows/columns of the mapping, the
+	 * operating system writes the dirty pages back in the background */
+	if (upper_triangle)
+	{
+		#pragma omp parallel for schedule(dynamic)
+		for (int64_t row=0; row<num_rows; row++)
+		{
+			float32_t* tri_row=km+row*num_rows-row*(row+1)/2;
+			for (int64_t col=row; col<num_cols; col++)
+				tri_row[col]=kernel->kernel(row, col);
+		}
+	}
+	else
+	{
+		#pragma omp parallel for schedule(dynamic)
+		for (int64_t col=0; col<num_cols; col++)
+		{
+			float32_t* column=km+col*num_rows;
+			for (int64_t row=0; row<num_rows; row++)
+				column[row]=kernel->kernel(row, col);
+		}
+	}
+
+	SG_UNREF(file);
+	return true;
+}
+
+bool CCustomKernel::set_kernel_matrix_from_file(const char* fname)
+{
+	if (m_row_subset_stack->has_subsets() || m_col_subset_stack->has_subsets())
+	{
+		SG_ERROR("%s::set_kernel_matrix_from_file not possible with subset. "
+				"Remove first\n", get_name());
+	}
+	REQUIRE(fname, "File name must not be NULL\n")
+
+	CMemoryMappedFile<char>* file=new CMemoryMappedFile<char>(fname, 'r');
+	SG_REF(file);
+
+	KernelMatrixFileHeader header;
+	if (file->get_size()<sizeof(header))
+	{
+		SG_UNREF(file);
+		SG_ERROR("%s is not a kernel matrix file\n", fname)
+	}
+	memcpy(&header, file->get_map(), sizeof(header));
+
+	if (memcmp(header.magic, kernel_matrix_file_magic, sizeof(header.magic)))
+	{
+		SG_UNREF(file);
+		SG_ERROR("%s is not a kernel matrix file\n", fname)
+	}
+
+	int64_t num_elements=header.upper_triangle ?
+		header.num_rows*(header.num_rows+1)/2 : header.num_rows*header.num_cols;
+	if (file->get_size()<sizeof(header)+num_elements*sizeof(float32_t))
+	{
+		SG_UNREF(file);
+		SG_ERROR("Kernel matrix file %s is truncated\n", fname)
+	}
+
+	cleanup_custom();
+	SG_DEBUG("using memory mapped custom kernel of size %ldx%ld\n",
+			header.num_rows, header.num_cols)
+
+	m_mapped_file=file;
+	kmatrix=SGMatrix<float32_t>((float32_t*) (file->get_map()+sizeof(header)),
+			header.num_rows, header.num_cols, false);
+	upper_diagonal=header.upper_triangle;
+	m_is_symmetric=header.upper_triangle;
+
+	dummy_init(kmatrix.num_rows, kmatrix.num_cols);
+	return true;
+}
+
 float64_t CCustomKernel::sum_symmetric_block(index_t block_begin,
 		index_t block_size, bool no_diag)
 {
@@ -366,6 +513,7 @@ void CCustomKernel::cleanup_custom()
 
 	kmatrix=SGMatrix<float32_t>();
 	upper_diagonal=false;
+	SG_UNREF(m_mapped_file);
 
 	SG_DEBUG("Leaving\n")
 }
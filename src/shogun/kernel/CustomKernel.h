@@ -17,6 +17,8 @@
 
 namespace shogun
 {
+template <class T> class CMemoryMappedFile;
+
 /** @brief The Custom Kernel allows for custom user provided kernel matrices.
  *
  * For squared training matrices it allows to store only the upper triangle of
@@ -62,6 +64,16 @@ class CCustomKernel: public CKernel
 		 */
 		CCustomKernel(SGMatrix<float32_t> km);
 
+		/** constructor
+		 * computes the kernel matrix of the given kernel into a file and
+		 * memory maps it, see compute_kernel_matrix_file()
+		 *
+		 * @param k initialized kernel
+		 * @param fname name of the kernel matrix file
+		 * @param upper_triangle whether to store only the upper triangle
+		 */
+		CCustomKernel(CKernel* k, const char* fname, bool upper_triangle=false);
+
 		/**
 		 *
 		 */
@@ -316,6 +328,33 @@ class CCustomKernel: public CKernel
 			return true;
 		}
 
+		/** compute the kernel matrix of a kernel in parallel and write it
+		 * to a kernel matrix file in single precision. The file is written
+		 * through a memory mapping, so the matrix never has to fit into
+		 * memory.
+		 *
+		 * @param kernel initialized kernel
+		 * @param fname name of the kernel matrix file
+		 * @param upper_triangle whether to store only the upper triangle,
+		 * requires a square kernel matrix which is assumed to be symmetric
+		 * @return if writing was successful
+		 */
+		static bool compute_kernel_matrix_file(CKernel* kernel,
+				const char* fname, bool upper_triangle=false);
+
+		/** set kernel matrix from a kernel matrix file written by
+		 * compute_kernel_matrix_file(). The file is memory mapped read-only,
+		 * so the kernel matrix is paged in lazily as it is accessed.
+		 * works NOT with subset
+		 *
+		 * @param fname name of the kernel matrix file
+		 * @return if setting was successful
+		 */
+		bool set_kernel_matrix_from_file(const char* fname);
+
+		/** @return if the kernel matrix is memory mapped from a file */
+		bool is_memory_mapped() const { return m_mapped_file!=NULL; }
+
 		/**
 		 * Overrides the sum_symmetric_block method of CKernel to compute the
 		 * sum directly from the precomputed kernel matrix.
@@ -614,6 +653,9 @@ class CCustomKernel: public CKernel
 
 		/** indicates whether kernel matrix is to be freed in destructor */
 		bool m_free_km;
+
+		/** file the kernel matrix is mapped from, if any */
+		CMemoryMappedFile<char>* m_mapped_file;
 };
 
 }
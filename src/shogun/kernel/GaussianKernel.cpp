@@ -126,6 +126,23 @@ float64_t CGaussianKernel::compute(int32_t idx_a, int32_t idx_b)
 	return std::exp(-result);
 }
 
+bool CGaussianKernel::supports_block_computation()
+{
+	// subclasses compute different functions of the distance
+	return typeid(*this)==typeid(CGaussianKernel) &&
+		!has_precomputed_distance() && has_dense_real_features();
+}
+
+void CGaussianKernel::compute_block(SGVector<index_t> lhs_idx,
+	index_t rhs_begin, SGMatrix<float64_t>& block)
+{
+	compute_dense_squared_distance_block(lhs_idx, rhs_begin, block);
+
+	const float64_t inv_width=1.0/get_width();
+	for (index_t i=0; i<block.num_rows*block.num_cols; ++i)
+		block.matrix[i]=std::exp(-block.matrix[i]*inv_width);
+}
+
 void CGaussianKernel::load_serializable_post() throw (ShogunException)
 {
 	CKernel::load_serializable_post();
@@ -140,6 +140,20 @@ protected:
 	 */
 	virtual float64_t compute(int32_t idx_a, int32_t idx_b);
 
+	/** @return if the kernel matrix can be computed in blocks, i.e. for
+	 * dense real valued features without precomputed distances
+	 */
+	virtual bool supports_block_computation();
+
+	/** compute a block of kernel values from a single matrix product
+	 *
+	 * @param lhs_idx indices of the left hand side vectors, one per row
+	 * @param rhs_begin index of the first right hand side vector
+	 * @param block preallocated block to write the kernel values to
+	 */
+	virtual void compute_block(SGVector<index_t> lhs_idx,
+		index_t rhs_begin, SGMatrix<float64_t>& block);
+
 	/** Can (optionally) be overridden to post-initialize some member
 	 * variables which are not PARAMETER::ADD'ed. Make sure that at first
 	 * the overridden method BASE_CLASS::LOAD_SERIALIZABLE_POST is called.
@@ -12,6 +12,7 @@
 #include <shogun/io/File.h>
 #include <shogun/io/SGIO.h>
 #include <shogun/lib/Signal.h>
+#include <shogun/lib/StoppableSGObject.h>
 #include <shogun/lib/Time.h>
 #include <shogun/lib/common.h>
 #include <shogun/lib/config.h>
@@ -20,8 +21,11 @@
 
 #include <shogun/kernel/Kernel.h>
 #include <shogun/kernel/normalizer/IdentityKernelNormalizer.h>
+#include <shogun/kernel/normalizer/SqrtDiagKernelNormalizer.h>
 #include <shogun/features/Features.h>
+#include <shogun/features/DenseFeatures.h>
 #include <shogun/base/Parameter.h>
+#include <shogun/mathematics/linalg/LinalgNamespace.h>
 
 #include <shogun/classifier/svm/SVM.h>
 
@@ -231,13 +235,25 @@ void CKernel::kernel_cache_init(int32_t buffsize, bool regression_hack)
 void CKernel::get_kernel_row(
 	int32_t docnum, int32_t *active2dnum, float64_t *buffer, bool full_line)
 {
-	int32_t i,j;
+	int32_t j;
 	KERNELCACHE_IDX start;
 
 	int32_t num_vectors = get_num_vec_lhs();
 	if (docnum>=num_vectors)
 		docnum=2*num_vectors-1-docnum;
 
+	// entries are independent, long rows are filled in chunks on the
+	// thread pool; uncached entries are computed like in
+	// cache_multiple_kernel_rows
+	int32_t num_active=0;
+	if (!full_line)
+	{
+		while (active2dnum[num_active]>=0)
+			num_active++;
+	}
+	int64_t grain=CMath::max(int64_t(8192),
+		int64_t(num_active/parallel->get_num_threads()+1));
+
 	/* is cached? */
 	if(kernel_cache.index[docnum] != -1)
 	{
@@ -256,18 +272,18 @@ void CKernel::get_kernel_row(
 		}
 		else
 		{
-			for(i=0;(j=active2dnum[i])>=0;i++)
+			parallel->parallel_for(0, num_active, [&](int64_t first, int64_t last)
 			{
-				if(kernel_cache.totdoc2active[j] >= 0)
-					buffer[j]=kernel_cache.buffer[start+kernel_cache.totdoc2active[j]];
-				else
+				for(int64_t i=first;i<last;i++)
 				{
-					int32_t k=j;
-					if (k>=num_vectors)
-						k=2*num_vectors-1-k;
-					buffer[j]=(float64_t) kernel(docnum, k);
+					int32_t k=active2dnum[i];
+					if(kernel_cache.totdoc2active[k] >= 0)
+						buffer[k]=kernel_cache.buffer[start+kernel_cache.totdoc2active[k]];
+					else
+						buffer[k]=(float64_t) kernel(docnum,
+							k>=num_vectors ? 2*num_vectors-1-k : k);
 				}
-			}
+			}, grain);
 		}
 	}
 	else
@@ -279,13 +295,15 @@ void CKernel::get_kernel_row(
 		}
 		else
 		{
-			for(i=0;(j=active2dnum[i])>=0;i++)
+			parallel->parallel_for(0, num_active, [&](int64_t first, int64_t last)
 			{
-				int32_t k=j;
-				if (k>=num_vectors)
-					k=2*num_vectors-1-k;
-				buffer[j]=(KERNELCACHE_ELEM) kernel(docnum, k);
-			}
+				for(int64_t i=first;i<last;i++)
+				{
+					int32_t k=active2dnum[i];
+					buffer[k]=(KERNELCACHE_ELEM) kernel(docnum,
+						k>=num_vectors ? 2*num_vectors-1-k : k);
+				}
+			}, grain);
 		}
 	}
 }
@@ -380,15 +398,11 @@ void CKernel::cache_multiple_kernel_rows(int32_t* rows, int32_t num_rows)
 		// fill up kernel cache
 		int32_t* uncached_rows = SG_MALLOC(int32_t, num_rows);
 		KERNELCACHE_ELEM** cache = SG_MALLOC(KERNELCACHE_ELEM*, num_rows);
-		S_KTHREAD_PARAM params;
-		int32_t num_threads=nthreads-1;
 		int32_t num_vec=get_num_vec_lhs();
 		ASSERT(num_vec>0)
 		uint8_t* needs_computation=SG_CALLOC(uint8_t, num_vec);
 
-		int32_t step=0;
 		int32_t num=0;
-		int32_t end=0;
 
 		// allocate cachelines if necessary
 		for (int32_t i=0; i<num_rows; i++)
@@ -410,49 +424,22 @@ void CKernel::cache_multiple_kernel_rows(int32_t* rows, int32_t num_rows)
 			num++;
 		}
 
-		if (num>0)
+		// rows are independent, chunks of them are computed on the thread pool
+		parallel->parallel_for(0, num, [&](int64_t start, int64_t end)
 		{
-			step = num/nthreads;
-
-			if (step<1)
-			{
-				num_threads=num-1;
-				step=1;
-			}
-
-			#pragma omp parallel for private(params)
-			for (int32_t t=0; t<num_threads; t++)
-			{
-				params.kernel = this;
-				params.kernel_cache = &kernel_cache;
-				params.cache = cache;
-				params.uncached_rows = uncached_rows;
-				params.needs_computation = needs_computation;
-				params.num_uncached = num;
-				params.start = t*step;
-				params.end = (t+1)*step;
-				params.num_vectors = get_num_vec_lhs();
-				end=params.end;
-
-				cache_multiple_kernel_row_helper(&params);
-			}
-		}
-		else
-			num_threads=-1;
-
-
-		S_KTHREAD_PARAM last_param;
-		last_param.kernel = this;
-		last_param.kernel_cache = &kernel_cache;
-		last_param.cache = cache;
-		last_param.uncached_rows = uncached_rows;
-		last_param.needs_computation = needs_computation;
-		last_param.start = end;
-		last_param.num_uncached = num;
-		last_param.end = num;
-		last_param.num_vectors = get_num_vec_lhs();
-
-		cache_multiple_kernel_row_helper(&last_param);
+			S_KTHREAD_PARAM params;
+			params.kernel = this;
+			params.kernel_cache = &kernel_cache;
+			params.cache = cache;
+			params.uncached_rows = uncached_rows;
+			params.needs_computation = needs_computation;
+			params.num_uncached = num;
+			params.start = start;
+			params.end = end;
+			params.num_vectors = num_vec;
+
+			cache_multiple_kernel_row_helper(&params);
+		});
 
 		SG_FREE(needs_computation);
 		SG_FREE(cache);
@@ -1314,6 +1301,9 @@ SGMatrix<T> CKernel::get_kernel_matrix()
 
 	REQUIRE(has_features(), "no features assigned to kernel\n")
 
+	if (supports_block_computation())
+		return get_kernel_matrix_blocked<T>();
+
 	int32_t m=get_num_vec_lhs();
 	int32_t n=get_num_vec_rhs();
 
@@ -1367,9 +1357,352 @@ SGMatrix<T> CKernel::get_kernel_matrix()
 	return SGMatrix<T>(result,m,n,true);
 }
 
+template <class T>
+SGMatrix<T> CKernel::get_kernel_matrix_blocked()
+{
+	/* tiles of this many vectors keep both operands of a tile's matrix
+	 * product and the tile itself in cache for typical dimensions */
+	const index_t block_size=256;
+
+	int32_t m=get_num_vec_lhs();
+	int32_t n=get_num_vec_rhs();
+
+	// if lhs == rhs and sizes match assume k(i,j)=k(j,i)
+	bool symmetric= (lhs && lhs==rhs && m==n);
+
+	SG_DEBUG("returning kernel matrix of size %dx%d computed in blocks of "
+			"%d vectors\n", m, n, block_size)
+
+	SGMatrix<T> result(m, n);
+
+	bool normalize=normalizer &&
+		dynamic_cast<CIdentityKernelNormalizer*>(normalizer)==NULL;
+
+	int64_t num_row_blocks=(m+block_size-1)/block_size;
+	int64_t num_col_blocks=(n+block_size-1)/block_size;
+	int64_t num_blocks=num_row_blocks*num_col_blocks;
+
+	auto pb = SG_PROGRESS(range(num_blocks));
+#pragma omp parallel for schedule(dynamic)
+	for (int64_t b=0; b<num_blocks; ++b)
+	{
+		index_t block_row=b/num_col_blocks;
+		index_t block_col=b%num_col_blocks;
+
+		// the lower triangle is filled by mirroring the upper one
+		if (symmetric && block_col<block_row)
+		{
+			pb.print_progress();
+			continue;
+		}
+
+		index_t i_start=block_row*block_size;
+		index_t j_start=block_col*block_size;
+		SGVector<index_t> rows(CMath::min(block_size, m-i_start));
+		rows.range_fill(i_start);
+		SGMatrix<float64_t> block(rows.vlen, CMath::min(block_size, n-j_start));
+		compute_block(rows, j_start, block);
+
+		for (index_t j=0; j<block.num_cols; ++j)
+		{
+			for (index_t i=0; i<block.num_rows; ++i)
+			{
+				float64_t v=block(i, j);
+				if (normalize)
+					v=normalizer->normalize(v, i_start+i, j_start+j);
+
+				result(i_start+i, j_start+j)=v;
+				if (symmetric)
+					result(j_start+j, i_start+i)=v;
+			}
+		}
+
+		pb.print_progress();
+	}
+	pb.complete();
+
+	return result;
+}
+
+void CKernel::compute_block(SGVector<index_t> lhs_idx,
+	index_t rhs_begin, SGMatrix<float64_t>& block)
+{
+	for (index_t j=0; j<block.num_cols; ++j)
+	{
+		for (index_t i=0; i<block.num_rows; ++i)
+			block(i, j)=compute(lhs_idx[i], rhs_begin+j);
+	}
+}
+
+SGVector<float64_t> CKernel::compute_expansion(
+	SGVector<index_t> lhs_idx, SGVector<float64_t> weights,
+	CStoppableSGObject* controller)
+{
+	REQUIRE(has_features(), "no features assigned to kernel\n")
+	REQUIRE(lhs_idx.vlen==weights.vlen, "Number of indices (%d) and weights "
+			"(%d) of the expansion differ\n", lhs_idx.vlen, weights.vlen)
+
+	int32_t n=get_num_vec_rhs();
+	SGVector<float64_t> outputs(n);
+	outputs.zero();
+	if (!lhs_idx.vlen || !n)
+		return outputs;
+
+	if (compute_explicit_expansion(lhs_idx, weights, outputs))
+		return outputs;
+
+	/* expansion vectors are tiled like in get_kernel_matrix_blocked(), the
+	 * right hand side is cut in smaller tiles for small batches so that
+	 * every thread gets a few of them */
+	const index_t block_size=256;
+	int64_t num_tiles=4*int64_t(parallel->get_num_threads());
+	index_t tile_size=CMath::clamp(index_t((n+num_tiles-1)/num_tiles),
+			index_t(32), block_size);
+	num_tiles=(n+tile_size-1)/tile_size;
+
+	bool normalize=normalizer &&
+		dynamic_cast<CIdentityKernelNormalizer*>(normalizer)==NULL;
+
+	SG_DEBUG("computing expansion of %d vectors for %d vectors in tiles of "
+			"%dx%d\n", lhs_idx.vlen, n, block_size, tile_size)
+
+	auto pb = SG_PROGRESS(range(num_tiles));
+	parallel->parallel_for(0, num_tiles, [&](int64_t first, int64_t last)
+	{
+		for (int64_t t=first; t<last; ++t)
+		{
+			if (controller)
+			{
+				if (controller->cancel_computation())
+					break;
+				controller->pause_computation();
+			}
+
+			index_t j_start=t*tile_size;
+			index_t num_cols=CMath::min(tile_size, n-j_start);
+			for (index_t i_start=0; i_start<lhs_idx.vlen; i_start+=block_size)
+			{
+				SGVector<index_t> rows(lhs_idx.vector+i_start,
+						CMath::min(block_size, lhs_idx.vlen-i_start), false);
+				SGMatrix<float64_t> block(rows.vlen, num_cols);
+				compute_block(rows, j_start, block);
+
+				for (index_t j=0; j<num_cols; ++j)
+				{
+					float64_t sum=0;
+					for (index_t i=0; i<rows.vlen; ++i)
+					{
+						float64_t v=block(i, j);
+						if (normalize)
+							v=normalizer->normalize(v, rows[i], j_start+j);
+						sum+=weights[i_start+i]*v;
+					}
+					outputs[j_start+j]+=sum;
+				}
+			}
+			pb.print_progress();
+		}
+	}, 1);
+	pb.complete();
+
+	return outputs;
+}
+
+bool CKernel::has_separable_normalizer()
+{
+	return normalizer && (dynamic_cast<CIdentityKernelNormalizer*>(normalizer) ||
+		dynamic_cast<CSqrtDiagKernelNormalizer*>(normalizer));
+}
+
+/** @return if both features hold their feature matrix in memory and have
+ * the same dimension */
+template <class ST>
+static bool has_dense_feature_matrices(CFeatures* l, CFeatures* r)
+{
+	CDenseFeatures<ST>* dense_l=(CDenseFeatures<ST>*) l;
+	CDenseFeatures<ST>* dense_r=(CDenseFeatures<ST>*) r;
+
+	int32_t num_feat;
+	int32_t num_vec;
+	if (!dense_l->get_feature_matrix(num_feat, num_vec) ||
+			!dense_r->get_feature_matrix(num_feat, num_vec))
+		return false;
+
+	return dense_l->get_num_features()==dense_r->get_num_features();
+}
+
+bool CKernel::has_dense_real_features()
+{
+	if (!lhs || !rhs)
+		return false;
+
+	if (lhs->get_feature_class()!=C_DENSE || rhs->get_feature_class()!=C_DENSE ||
+			lhs->get_feature_type()!=rhs->get_feature_type())
+		return false;
+
+	switch (lhs->get_feature_type())
+	{
+		case F_DREAL:
+			return has_dense_feature_matrices<float64_t>(lhs, rhs);
+		case F_SHORTREAL:
+			return has_dense_feature_matrices<float32_t>(lhs, rhs);
+		default:
+			return false;
+	}
+}
+
+/** @return matrix whose columns are the given vectors of dense features, a
+ * view if they are a range of vectors without subset and a copy otherwise */
+template <class ST>
+static SGMatrix<ST> get_dense_vectors(CFeatures* features,
+		const index_t* idx, index_t size)
+{
+	CDenseFeatures<ST>* dense=(CDenseFeatures<ST>*) features;
+	int32_t num_feat;
+	int32_t num_vec;
+	ST* fm=dense->get_feature_matrix(num_feat, num_vec);
+
+	CSubsetStack* subsets=dense->get_subset_stack();
+	bool is_range=!subsets->has_subsets();
+	for (index_t i=1; i<size && is_range; ++i)
+		is_range=idx[i]==idx[0]+i;
+
+	SGMatrix<ST> vectors;
+	if (is_range && size)
+		vectors=SGMatrix<ST>(fm+int64_t(idx[0])*num_feat, num_feat, size, false);
+	else
+	{
+		vectors=SGMatrix<ST>(num_feat, size);
+		for (index_t i=0; i<size; ++i)
+		{
+			index_t real_idx=subsets->subset_idx_conversion(idx[i]);
+			sg_memcpy(vectors.get_column_vector(i), fm+int64_t(real_idx)*num_feat,
+					sizeof(ST)*num_feat);
+		}
+	}
+	SG_UNREF(subsets);
+
+	return vectors;
+}
+
+/** @return matrix whose columns are the given range of vectors of dense
+ * features */
+template <class ST>
+static SGMatrix<ST> get_dense_vectors(CFeatures* features,
+		index_t begin, index_t size)
+{
+	SGVector<index_t> idx(size);
+	idx.range_fill(begin);
+	return get_dense_vectors<ST>(features, idx.vector, size);
+}
+
+/** block=x'*y, computed in double precision */
+static void dot_block(const SGMatrix<float64_t>& x, const SGMatrix<float64_t>& y,
+		SGMatrix<float64_t>& block)
+{
+	linalg::matrix_prod(x, y, block, true, false);
+}
+
+/** block=x'*y, computed in single precision to process twice as many
+ * elements per vector instruction */
+static void dot_block(const SGMatrix<float32_t>& x, const SGMatrix<float32_t>& y,
+		SGMatrix<float64_t>& block)
+{
+	SGMatrix<float32_t> dots(block.num_rows, block.num_cols);
+	linalg::matrix_prod(x, y, dots, true, false);
+
+	for (int64_t i=0; i<int64_t(block.num_rows)*block.num_cols; ++i)
+		block.matrix[i]=dots.matrix[i];
+}
+
+template <class ST>
+static void dense_dot_block(CFeatures* l, CFeatures* r,
+		SGVector<index_t> lhs_idx, index_t rhs_begin, SGMatrix<float64_t>& block)
+{
+	SGMatrix<ST> x=get_dense_vectors<ST>(l, lhs_idx.vector, block.num_rows);
+	SGMatrix<ST> y=get_dense_vectors<ST>(r, rhs_begin, block.num_cols);
+
+	dot_block(x, y, block);
+}
+
+template <class ST>
+static void dense_squared_distance_block(CFeatures* l, CFeatures* r,
+		SGVector<index_t> lhs_idx, index_t rhs_begin, SGMatrix<float64_t>& block)
+{
+	SGMatrix<ST> x=get_dense_vectors<ST>(l, lhs_idx.vector, block.num_rows);
+	SGMatrix<ST> y=get_dense_vectors<ST>(r, rhs_begin, block.num_cols);
+
+	dot_block(x, y, block);
+
+	SGVector<ST> x_sq=linalg::colwise_sum(linalg::element_prod(x, x));
+	SGVector<ST> y_sq=linalg::colwise_sum(linalg::element_prod(y, y));
+
+	for (index_t j=0; j<block.num_cols; ++j)
+	{
+		for (index_t i=0; i<block.num_rows; ++i)
+		{
+			// clamp tiny negative values caused by cancellation
+			block(i, j)=CMath::max(0.0,
+					float64_t(x_sq[i])+float64_t(y_sq[j])-2*block(i, j));
+		}
+	}
+
+	// distances of vectors to themselves are exactly zero
+	if (l==r)
+	{
+		for (index_t i=0; i<block.num_rows; ++i)
+		{
+			index_t j=lhs_idx[i]-rhs_begin;
+			if (j>=0 && j<block.num_cols)
+				block(i, j)=0;
+		}
+	}
+}
+
+void CKernel::compute_dense_dot_block(SGVector<index_t> lhs_idx,
+	index_t rhs_begin, SGMatrix<float64_t>& block)
+{
+	if (lhs->get_feature_type()==F_SHORTREAL)
+		dense_dot_block<float32_t>(lhs, rhs, lhs_idx, rhs_begin, block);
+	else
+		dense_dot_block<float64_t>(lhs, rhs, lhs_idx, rhs_begin, block);
+}
+
+void CKernel::compute_dense_squared_distance_block(SGVector<index_t> lhs_idx,
+	index_t rhs_begin, SGMatrix<float64_t>& block)
+{
+	if (lhs->get_feature_type()==F_SHORTREAL)
+		dense_squared_distance_block<float32_t>(lhs, rhs, lhs_idx, rhs_begin, block);
+	else
+		dense_squared_distance_block<float64_t>(lhs, rhs, lhs_idx, rhs_begin, block);
+}
+
+template <class ST>
+static SGMatrix<float64_t> dense_real_vectors(CFeatures* features,
+		SGVector<index_t> idx)
+{
+	SGMatrix<ST> vectors=get_dense_vectors<ST>(features, idx.vector, idx.vlen);
+	SGMatrix<float64_t> result(vectors.num_rows, vectors.num_cols);
+	for (int64_t i=0; i<int64_t(vectors.num_rows)*vectors.num_cols; ++i)
+		result.matrix[i]=vectors.matrix[i];
+
+	return result;
+}
+
+SGMatrix<float64_t> CKernel::get_dense_real_vectors(
+	CFeatures* features, SGVector<index_t> idx)
+{
+	if (features->get_feature_type()==F_SHORTREAL)
+		return dense_real_vectors<float32_t>(features, idx);
+	else
+		return dense_real_vectors<float64_t>(features, idx);
+}
 
 template SGMatrix<float64_t> CKernel::get_kernel_matrix<float64_t>();
 template SGMatrix<float32_t> CKernel::get_kernel_matrix<float32_t>();
 
+template SGMatrix<float64_t> CKernel::get_kernel_matrix_blocked<float64_t>();
+template SGMatrix<float32_t> CKernel::get_kernel_matrix_blocked<float32_t>();
+
 template void* CKernel::get_kernel_matrix_helper<float64_t>(void* p);
 template void* CKernel::get_kernel_matrix_helper<float32_t>(void* p);
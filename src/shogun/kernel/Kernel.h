@@ -28,6 +28,7 @@ namespace shogun
 	class CFile;
 	class CFeatures;
 	class CKernelNormalizer;
+	class CStoppableSGObject;
 
 #ifdef USE_SHORTREAL_KERNELCACHE
 	/** kernel cache element */
@@ -794,6 +795,29 @@ class CKernel : public CSGObject
 			int32_t num_suppvec, int32_t* IDX, float64_t* alphas,
 			float64_t factor=1.0);
 
+		/** compute the outputs \f$f(y_j)=\sum_i w_i k(x_{lhs\_idx_i}, y_j)\f$
+		 * of a kernel expansion for all right hand side vectors.
+		 *
+		 * Kernels that can collapse the expansion into an explicit weight
+		 * representation (see compute_explicit_expansion()) evaluate that.
+		 * Otherwise expansion and right hand side vectors are processed in
+		 * tiles computed by compute_block(), tiles of right hand side
+		 * vectors in parallel.
+		 *
+		 * A controller, e.g. the machine the expansion belongs to, is asked
+		 * once per tile whether to cancel or pause the computation. The
+		 * outputs of the remaining tiles are zero after a cancellation.
+		 *
+		 * @param lhs_idx indices of the left hand side vectors of the expansion
+		 * @param weights weights of the expansion
+		 * @param controller object whose computation controllers are
+		 * respected, may be NULL
+		 * @return outputs, one per right hand side vector
+		 */
+		SGVector<float64_t> compute_expansion(
+			SGVector<index_t> lhs_idx, SGVector<float64_t> weights,
+			CStoppableSGObject* controller=NULL);
+
 		/** get combined kernel weight
 		 *
 		 * @return combined kernel weight
@@ -909,6 +933,96 @@ class CKernel : public CSGObject
 		 */
 		virtual float64_t compute(int32_t x, int32_t y)=0;
 
+		/** check whether the kernel can compute whole blocks of the kernel
+		 * matrix at once via compute_block(). If so, get_kernel_matrix()
+		 * computes the matrix tile by tile instead of element by element.
+		 *
+		 * Kernels on dense real valued features whose values are functions
+		 * of inner products or squared distances override this, as their
+		 * blocks reduce to one matrix product.
+		 *
+		 * @return if block computation is supported for the current features
+		 */
+		virtual bool supports_block_computation() { return false; }
+
+		/** compute a block of (unnormalized) kernel values
+		 * \f$block(i,j)=k(x_{lhs\_idx_i}, y_{rhs\_begin+j})\f$, where the
+		 * block size is given by the dimensions of the passed matrix.
+		 *
+		 * Base method calls compute() for every element.
+		 *
+		 * @param lhs_idx indices of the left hand side vectors, one per row
+		 * @param rhs_begin index of the first right hand side vector
+		 * @param block preallocated block to write the kernel values to
+		 */
+		virtual void compute_block(SGVector<index_t> lhs_idx,
+			index_t rhs_begin, SGMatrix<float64_t>& block);
+
+		/** evaluate a kernel expansion through an explicit representation
+		 * of its weights, e.g. a single weight vector for linear kernels.
+		 * Called by compute_expansion() before falling back to blocks.
+		 *
+		 * Base method does nothing and returns false.
+		 *
+		 * @param lhs_idx indices of the left hand side vectors of the expansion
+		 * @param weights weights of the expansion
+		 * @param outputs preallocated outputs, one per right hand side vector
+		 * @return if the outputs were computed
+		 */
+		virtual bool compute_explicit_expansion(SGVector<index_t> lhs_idx,
+			SGVector<float64_t> weights, SGVector<float64_t>& outputs)
+		{
+			return false;
+		}
+
+		/** @return if the normalizer is the identity or scales by one factor
+		 * per left and one per right hand side vector, i.e. if
+		 * normalize(v,i,j)=normalize_rhs(normalize_lhs(v,i),j)
+		 */
+		bool has_separable_normalizer();
+
+		/** @return if lhs and rhs are dense float64_t or float32_t features
+		 * of the same type whose feature matrix is held in memory. Products
+		 * of float32_t features are computed in single precision.
+		 */
+		bool has_dense_real_features();
+
+		/** compute a block of inner products \f$x_i^\top y_j\f$ of dense
+		 * real valued features by a single matrix product
+		 *
+		 * @param lhs_idx indices of the left hand side vectors, one per row
+		 * @param rhs_begin index of the first right hand side vector
+		 * @param block preallocated block to write the inner products to
+		 */
+		void compute_dense_dot_block(SGVector<index_t> lhs_idx,
+			index_t rhs_begin, SGMatrix<float64_t>& block);
+
+		/** compute a block of squared euclidean distances
+		 * \f$\|x_i-y_j\|^2=\|x_i\|^2+\|y_j\|^2-2x_i^\top y_j\f$ of dense
+		 * real valued features by a single matrix product
+		 *
+		 * @param lhs_idx indices of the left hand side vectors, one per row
+		 * @param rhs_begin index of the first right hand side vector
+		 * @param block preallocated block to write the distances to
+		 */
+		void compute_dense_squared_distance_block(SGVector<index_t> lhs_idx,
+			index_t rhs_begin, SGMatrix<float64_t>& block);
+
+		/** get dense real valued vectors in double precision
+		 *
+		 * @param features dense float64_t or float32_t features
+		 * @param idx indices of the vectors
+		 * @return matrix whose columns are the vectors
+		 */
+		static SGMatrix<float64_t> get_dense_real_vectors(
+			CFeatures* features, SGVector<index_t> idx);
+
+		/** compute the kernel matrix tile by tile using compute_block()
+		 *
+		 * @return the kernel matrix
+		 */
+		template <class T> SGMatrix<T> get_kernel_matrix_blocked();
+
 		/** compute row start offset for parallel kernel matrix computation
 		 *
 		 * @param offs offset
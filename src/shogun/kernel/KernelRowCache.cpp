@@ -0,0 +1,342 @@
+/*
+ * This software is distributed under BSD 3-clause license (see LICENSE file).
+ */
+
+#include <shogun/base/Parallel.h>
+#include <shogun/kernel/KernelRowCache.h>
+
+#include <algorithm>
+
+using namespace shogun;
+
+template <>
+SGVector<float32_t>& CKernelRowCache::CachedRow::values<float32_t>()
+{
+	return single;
+}
+
+template <>
+SGVector<float64_t>& CKernelRowCache::CachedRow::values<float64_t>()
+{
+	return full;
+}
+
+/** @return primitive type of the given precision */
+template <class T>
+static EPrimitiveType precision_of();
+
+template <>
+EPrimitiveType precision_of<float32_t>()
+{
+	return PT_FLOAT32;
+}
+
+template <>
+EPrimitiveType precision_of<float64_t>()
+{
+	return PT_FLOAT64;
+}
+
+CKernelRowCache::CKernelRowCache() : CSGObject()
+{
+	init();
+}
+
+CKernelRowCache::CKernelRowCache(CKernel* kernel, int32_t cache_size,
+		int32_t num_shards, EPrimitiveType precision) : CSGObject()
+{
+	init();
+
+	REQUIRE(num_shards>=0, "Number of shards (%d) must be non-negative\n",
+			num_shards);
+	REQUIRE(precision==PT_FLOAT32 || precision==PT_FLOAT64,
+			"Rows can only be cached as float32_t or float64_t\n");
+	m_num_shards=num_shards;
+	m_cache_size=cache_size;
+	m_precision=precision;
+	set_kernel(kernel);
+}
+
+CKernelRowCache::~CKernelRowCache()
+{
+	m_shards.clear();
+	SG_UNREF(m_kernel);
+}
+
+void CKernelRowCache::init()
+{
+	m_kernel=NULL;
+	m_cache_size=10;
+	m_max_rows=0;
+	m_explicit_max_rows=false;
+	m_num_shards=0;
+	m_precision=PT_FLOAT64;
+	m_num_hits=0;
+	m_num_misses=0;
+	m_num_evictions=0;
+
+	SG_ADD((CSGObject**) &m_kernel, "kernel", "Kernel whose rows are cached",
+			MS_NOT_AVAILABLE);
+	SG_ADD(&m_cache_size, "cache_size", "Cache size in megabytes",
+			MS_NOT_AVAILABLE);
+	SG_ADD(&m_max_rows, "max_rows", "Maximum number of cached rows",
+			MS_NOT_AVAILABLE);
+	SG_ADD(&m_explicit_max_rows, "explicit_max_rows",
+			"Whether the maximum number of rows was set explicitly",
+			MS_NOT_AVAILABLE);
+	SG_ADD(&m_num_shards, "num_shards", "Number of shards", MS_NOT_AVAILABLE);
+	SG_ADD((machine_int_t*) &m_precision, "precision",
+			"Element type of cached rows", MS_NOT_AVAILABLE);
+}
+
+void CKernelRowCache::set_kernel(CKernel* kernel)
+{
+	REQUIRE(kernel, "Kernel must not be NULL\n");
+	REQUIRE(kernel->has_features(), "Kernel must be initialized with features\n");
+
+	SG_REF(kernel);
+	SG_UNREF(m_kernel);
+	m_kernel=kernel;
+
+	reset_shards();
+}
+
+CKernel* CKernelRowCache::get_kernel()
+{
+	SG_REF(m_kernel);
+	return m_kernel;
+}
+
+void CKernelRowCache::set_cache_size(int32_t cache_size)
+{
+	REQUIRE(cache_size>0, "Cache size (%d MB) must be positive\n", cache_size);
+	m_cache_size=cache_size;
+	m_explicit_max_rows=false;
+	reset_shards();
+}
+
+void CKernelRowCache::set_max_rows(int64_t max_rows)
+{
+	REQUIRE(max_rows>0, "Maximum number of rows (%ld) must be positive\n",
+			max_rows);
+	m_max_rows=max_rows;
+	m_explicit_max_rows=true;
+	reset_shards();
+}
+
+void CKernelRowCache::set_precision(EPrimitiveType precision)
+{
+	REQUIRE(precision==PT_FLOAT32 || precision==PT_FLOAT64,
+			"Rows can only be cached as float32_t or float64_t\n");
+	m_precision=precision;
+	reset_shards();
+}
+
+void CKernelRowCache::reset_shards()
+{
+	m_shards.clear();
+
+	if (!m_kernel)
+		return;
+
+	int32_t num_rhs=m_kernel->get_num_vec_rhs();
+	REQUIRE(num_rhs>0, "Kernel has no right hand side vectors\n");
+
+	if (!m_explicit_max_rows)
+	{
+		int64_t elem_size=m_precision==PT_FLOAT32 ?
+			sizeof(float32_t) : sizeof(float64_t);
+		int64_t row_size=int64_t(num_rhs)*elem_size;
+		m_max_rows=CMath::max(int64_t(1),
+				(int64_t(m_cache_size)*1024*1024)/row_size);
+	}
+
+	int32_t num_shards=m_num_shards;
+	if (num_shards==0)
+		num_shards=4*CMath::max(1, parallel->get_num_threads());
+	num_shards=CMath::max(int64_t(1), CMath::min(int64_t(num_shards), m_max_rows));
+
+	// spread the capacity evenly, the first shards take the remainder
+	for (int32_t i=0; i<num_shards; i++)
+	{
+		std::unique_ptr<Shard> shard(new Shard());
+		shard->capacity=m_max_rows/num_shards+(i<m_max_rows%num_shards ? 1 : 0);
+		m_shards.push_back(std::move(shard));
+	}
+
+	SG_DEBUG("Kernel row cache holds %ld rows of %d %s elements in %d shards\n",
+			m_max_rows, num_rhs, ptype_name(m_precision).c_str(), num_shards);
+}
+
+template <class T>
+SGVector<T> CKernelRowCache::compute_row(int32_t row)
+{
+	int32_t num_rhs=m_kernel->get_num_vec_rhs();
+	SGVector<T> values(num_rhs);
+
+	// a miss stalls the solver that asked for the row, so long rows are
+	// filled in chunks on the thread pool
+	int64_t grain=CMath::max(int64_t(1024),
+		int64_t(num_rhs/parallel->get_num_threads()+1));
+	parallel->parallel_for(0, num_rhs, [&](int64_t first, int64_t last)
+	{
+		for (int64_t j=first; j<last; j++)
+			values[j]=(T) m_kernel->kernel(row, j);
+	}, grain);
+
+	return values;
+}
+
+template <class T>
+SGVector<T> CKernelRowCache::compute_and_insert(int32_t row)
+{
+	CachedRow computed;
+	computed.values<T>()=compute_row<T>(row);
+	CachedRow stored=insert(shard_of(row), row, computed);
+	return stored.values<T>();
+}
+
+bool CKernelRowCache::lookup(Shard& shard, int32_t row, CachedRow& result)
+{
+	std::lock_guard<std::mutex> guard(shard.lock);
+	auto it=shard.rows.find(row);
+	if (it==shard.rows.end())
+		return false;
+
+	shard.lru.splice(shard.lru.begin(), shard.lru, it->second.second);
+	result=it->second.first;
+	return true;
+}
+
+CKernelRowCache::CachedRow CKernelRowCache::insert(Shard& shard, int32_t row,
+		const CachedRow& values)
+{
+	std::lock_guard<std::mutex> guard(shard.lock);
+
+	auto it=shard.rows.find(row);
+	if (it!=shard.rows.end())
+		return it->second.first;
+
+	while (int64_t(shard.rows.size())>=shard.capacity)
+	{
+		shard.rows.erase(shard.lru.back());
+		shard.lru.pop_back();
+		m_num_evictions++;
+	}
+
+	shard.lru.push_front(row);
+	shard.rows.emplace(row, std::make_pair(values, shard.lru.begin()));
+	return values;
+}
+
+template <class T>
+SGVector<T> CKernelRowCache::get_row(int32_t row)
+{
+	REQUIRE(m_kernel, "No kernel set\n");
+	REQUIRE(row>=0 && row<m_kernel->get_num_vec_lhs(),
+			"Row index (%d) out of bounds [0, %d)\n",
+			row, m_kernel->get_num_vec_lhs());
+	REQUIRE(m_precision==precision_of<T>(),
+			"Rows are cached as %s, cannot be accessed as %s\n",
+			ptype_name(m_precision).c_str(),
+			ptype_name(precision_of<T>()).c_str());
+
+	CachedRow cached;
+	if (lookup(shard_of(row), row, cached))
+	{
+		m_num_hits++;
+		return cached.values<T>();
+	}
+
+	m_num_misses++;
+	return compute_and_insert<T>(row);
+}
+
+void CKernelRowCache::prefetch_rows(SGVector<int32_t> rows)
+{
+	REQUIRE(m_kernel, "No kernel set\n");
+
+	for (index_t i=0; i<rows.vlen; i++)
+	{
+		REQUIRE(rows[i]>=0 && rows[i]<m_kernel->get_num_vec_lhs(),
+				"Row index (%d) out of bounds [0, %d)\n",
+				rows[i], m_kernel->get_num_vec_lhs());
+	}
+
+	// every row is computed and counted at most once
+	SGVector<int32_t> unique_rows=rows.clone();
+	std::sort(unique_rows.vector, unique_rows.vector+unique_rows.vlen);
+	int32_t num_rows=std::unique(unique_rows.vector,
+			unique_rows.vector+unique_rows.vlen)-unique_rows.vector;
+
+	#pragma omp parallel for
+	for (int32_t i=0; i<num_rows; i++)
+	{
+		// another solver thread may have inserted the row meanwhile
+		if (is_cached(unique_rows[i]))
+			continue;
+
+		m_num_misses++;
+		if (m_precision==PT_FLOAT32)
+			compute_and_insert<float32_t>(unique_rows[i]);
+		else
+			compute_and_insert<float64_t>(unique_rows[i]);
+	}
+}
+
+bool CKernelRowCache::is_cached(int32_t row)
+{
+	if (m_shards.empty())
+		return false;
+
+	Shard& shard=shard_of(row);
+	std::lock_guard<std::mutex> guard(shard.lock);
+	return shard.rows.find(row)!=shard.rows.end();
+}
+
+int64_t CKernelRowCache::get_num_cached_rows()
+{
+	int64_t num_rows=0;
+	for (auto& shard : m_shards)
+	{
+		std::lock_guard<std::mutex> guard(shard->lock);
+		num_rows+=shard->rows.size();
+	}
+	return num_rows;
+}
+
+void CKernelRowCache::clear()
+{
+	for (auto& shard : m_shards)
+	{
+		std::lock_guard<std::mutex> guard(shard->lock);
+		shard->rows.clear();
+		shard->lru.clear();
+	}
+}
+
+float64_t CKernelRowCache::get_hit_rate() const
+{
+	int64_t num_hits=m_num_hits.load();
+	int64_t num_requests=num_hits+m_num_misses.load();
+	if (num_requests==0)
+		return 0.0;
+
+	return float64_t(num_hits)/num_requests;
+}
+
+void CKernelRowCache::reset_statistics()
+{
+	m_num_hits=0;
+	m_num_misses=0;
+	m_num_evictions=0;
+}
+
+void CKernelRowCache::load_serializable_post() throw (ShogunException)
+{
+	CSGObject::load_serializable_post();
+	reset_shards();
+}
+
+template SGVector<float32_t> CKernelRowCache::get_row<float32_t>(int32_t row);
+template SGVector<float64_t> CKernelRowCache::get_row<float64_t>(int32_t row);
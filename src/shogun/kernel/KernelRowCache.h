@@ -0,0 +1,272 @@
+/*
+ * This software is distributed under BSD 3-clause license (see LICENSE file).
+ */
+
+#ifndef _KERNEL_ROW_CACHE_H__
+#define _KERNEL_ROW_CACHE_H__
+
+#include <shogun/lib/config.h>
+
+#include <shogun/base/SGObject.h>
+#include <shogun/kernel/Kernel.h>
+#include <shogun/lib/SGVector.h>
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace shogun
+{
+
+/** @brief Thread-safe, sharded least-recently-used cache of kernel rows.
+ *
+ * Row \f$i\f$ holds \f$k(x_i, y_j)\f$ for all right hand side vectors
+ * \f$y_j\f$ of the underlying kernel. Rows are distributed over a number of
+ * independently locked shards (row \f$i\f$ lives in shard
+ * \f$i \bmod \text{num\_shards}\f$), each of which maintains its own LRU
+ * order. Kernel rows are computed outside of any lock, so that concurrent
+ * misses on different rows are computed in parallel and threads hitting
+ * other shards are never blocked by a computation.
+ *
+ * Rows are handed out as reference counted SGVector instances. Evicting a
+ * row from the cache therefore never invalidates a row that some solver
+ * thread still holds, which makes it safe to share a single cache between
+ * any number of solvers training on the same kernel concurrently.
+ *
+ * Rows are stored either in single or in double precision, which is chosen
+ * at runtime (see set_precision()). Single precision halves the memory per
+ * row and thus doubles the number of rows that fit into the cache.
+ *
+ * The cache keeps hit, miss and eviction counters which can be used to
+ * size it.
+ *
+ * Solvers use the cache when it is passed to them, see
+ * CSVM::set_row_cache(), and accept rows in either precision.
+ */
+class CKernelRowCache : public CSGObject
+{
+public:
+	/** default constructor */
+	CKernelRowCache();
+
+	/** constructor
+	 *
+	 * @param kernel initialized kernel whose rows are cached
+	 * @param cache_size size of the cache in megabytes
+	 * @param num_shards number of independently locked shards, 0 chooses
+	 * four shards per thread
+	 * @param precision element type of cached rows, PT_FLOAT32 or PT_FLOAT64
+	 */
+	CKernelRowCache(CKernel* kernel, int32_t cache_size=10,
+			int32_t num_shards=0, EPrimitiveType precision=PT_FLOAT64);
+
+	/** destructor */
+	virtual ~CKernelRowCache();
+
+	/** set the kernel whose rows are cached, drops all cached rows
+	 *
+	 * @param kernel initialized kernel
+	 */
+	void set_kernel(CKernel* kernel);
+
+	/** @return kernel whose rows are cached */
+	CKernel* get_kernel();
+
+	/** set the size of the cache in megabytes, drops all cached rows
+	 *
+	 * @param cache_size size of the cache in megabytes
+	 */
+	void set_cache_size(int32_t cache_size);
+
+	/** @return size of the cache in megabytes */
+	int32_t get_cache_size() const { return m_cache_size; }
+
+	/** limit the number of cached rows directly, overriding the size
+	 * computed from the cache size in megabytes; drops all cached rows
+	 *
+	 * @param max_rows maximum number of rows held in the cache
+	 */
+	void set_max_rows(int64_t max_rows);
+
+	/** @return maximum number of rows held in the cache */
+	int64_t get_max_rows() const { return m_max_rows; }
+
+	/** @return number of shards the rows are distributed over, also when
+	 * the number was chosen automatically, 0 if no kernel is set yet
+	 */
+	int32_t get_num_shards() const { return m_shards.size(); }
+
+	/** set the element type of cached rows, drops all cached rows
+	 *
+	 * @param precision PT_FLOAT32 or PT_FLOAT64
+	 */
+	void set_precision(EPrimitiveType precision);
+
+	/** @return element type of cached rows */
+	EPrimitiveType get_precision() const { return m_precision; }
+
+	/** get a kernel row, computing and caching it if it is not cached yet
+	 *
+	 * @param row index of the left hand side vector
+	 * @return kernel row of length num_rhs, T has to match the precision
+	 * of the cache
+	 */
+	template <class T=float64_t>
+	SGVector<T> get_row(int32_t row);
+
+	/** compute all rows that are not cached yet in parallel and add them
+	 * to the cache, e.g. for the rows of a working set. Each computed row
+	 * counts as one miss, also if it is requested several times.
+	 *
+	 * @param rows indices of the left hand side vectors
+	 */
+	void prefetch_rows(SGVector<int32_t> rows);
+
+	/** check whether a row is cached, does not touch the row
+	 *
+	 * @param row index of the left hand side vector
+	 * @return if the row is cached
+	 */
+	bool is_cached(int32_t row);
+
+	/** @return number of rows that are currently cached */
+	int64_t get_num_cached_rows();
+
+	/** drop all cached rows, statistics are kept */
+	void clear();
+
+	/** @return number of get_row calls served from the cache */
+	int64_t get_num_hits() const { return m_num_hits.load(); }
+
+	/** @return number of rows that had to be computed */
+	int64_t get_num_misses() const { return m_num_misses.load(); }
+
+	/** @return number of rows dropped to make room for new ones */
+	int64_t get_num_evictions() const { return m_num_evictions.load(); }
+
+	/** @return fraction of row requests served from the cache */
+	float64_t get_hit_rate() const;
+
+	/** reset hit, miss and eviction counters */
+	void reset_statistics();
+
+	/** @return object name */
+	virtual const char* get_name() const { return "KernelRowCache"; }
+
+protected:
+	/** rebuilds the shards after loading */
+	virtual void load_serializable_post() throw (ShogunException);
+
+private:
+	/** init and register parameters */
+	void init();
+
+	/** (re)create empty shards for the current kernel and size */
+	void reset_shards();
+
+	/** compute a kernel row
+	 *
+	 * @param row index of the left hand side vector
+	 * @return kernel row of length num_rhs
+	 */
+	template <class T>
+	SGVector<T> compute_row(int32_t row);
+
+	/** compute a row that is not cached yet and insert it
+	 *
+	 * @param row index of the left hand side vector
+	 */
+	template <class T>
+	SGVector<T> compute_and_insert(int32_t row);
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+	/** a cached row in the precision of the cache */
+	struct CachedRow
+	{
+		/** row in single precision */
+		SGVector<float32_t> single;
+		/** row in double precision */
+		SGVector<float64_t> full;
+
+		/** @return row in the given precision */
+		template <class T>
+		SGVector<T>& values();
+	};
+
+	/** one independently locked part of the cache */
+	struct Shard
+	{
+		/** guards all members */
+		std::mutex lock;
+		/** row indices, most recently used first */
+		std::list<int32_t> lru;
+		/** cached rows along with their position in the lru list */
+		std::unordered_map<int32_t,
+			std::pair<CachedRow, std::list<int32_t>::iterator> > rows;
+		/** maximum number of rows in this shard */
+		int64_t capacity;
+	};
+#endif // DOXYGEN_SHOULD_SKIP_THIS
+
+	/** @return shard holding the given row */
+	Shard& shard_of(int32_t row)
+	{
+		return *m_shards[row % m_shards.size()];
+	}
+
+	/** look up a row and mark it most recently used
+	 *
+	 * @param shard shard holding the row
+	 * @param row row index
+	 * @param result set to the row if found
+	 * @return if the row was found
+	 */
+	bool lookup(Shard& shard, int32_t row, CachedRow& result);
+
+	/** insert a computed row, evicting least recently used rows of the
+	 * shard as needed. If another thread inserted the same row in the
+	 * meantime, its row is returned and the given one is dropped.
+	 *
+	 * @param shard shard holding the row
+	 * @param row row index
+	 * @param values computed row
+	 * @return row as stored in the cache
+	 */
+	CachedRow insert(Shard& shard, int32_t row, const CachedRow& values);
+
+private:
+	/** kernel whose rows are cached */
+	CKernel* m_kernel;
+
+	/** cache size in megabytes */
+	int32_t m_cache_size;
+
+	/** maximum number of cached rows */
+	int64_t m_max_rows;
+
+	/** if m_max_rows was set explicitly */
+	bool m_explicit_max_rows;
+
+	/** number of shards */
+	int32_t m_num_shards;
+
+	/** element type of cached rows */
+	EPrimitiveType m_precision;
+
+	/** the shards */
+	std::vector<std::unique_ptr<Shard> > m_shards;
+
+	/** number of cache hits */
+	std::atomic<int64_t> m_num_hits;
+
+	/** number of cache misses */
+	std::atomic<int64_t> m_num_misses;
+
+	/** number of evicted rows */
+	std::atomic<int64_t> m_num_evictions;
+};
+}
+#endif // _KERNEL_ROW_CACHE_H__
@@ -5,6 +5,7 @@
  */
 
 #include <shogun/lib/common.h>
+#include <shogun/base/Parallel.h>
 #include <shogun/io/SGIO.h>
 #include <shogun/features/Features.h>
 #include <shogun/features/DotFeatures.h>
@@ -91,3 +92,40 @@ float64_t CLinearKernel::compute_optimized(int32_t idx)
 		dense_dot(idx, normal.vector, normal.size());
 	return normalizer->normalize_rhs(result, idx);
 }
+
+bool CLinearKernel::supports_block_computation()
+{
+	return has_dense_real_features();
+}
+
+void CLinearKernel::compute_block(SGVector<index_t> lhs_idx,
+	index_t rhs_begin, SGMatrix<float64_t>& block)
+{
+	compute_dense_dot_block(lhs_idx, rhs_begin, block);
+}
+
+bool CLinearKernel::compute_explicit_expansion(SGVector<index_t> lhs_idx,
+	SGVector<float64_t> weights, SGVector<float64_t>& outputs)
+{
+	if (!has_separable_normalizer())
+		return false;
+
+	// same as the normal built by add_to_normal(), which is left alone
+	CDotFeatures* l=(CDotFeatures*) lhs;
+	CDotFeatures* r=(CDotFeatures*) rhs;
+	SGVector<float64_t> w(l->get_dim_feature_space());
+	w.zero();
+	for (index_t i=0; i<lhs_idx.vlen; ++i)
+	{
+		l->add_to_dense_vec(normalizer->normalize_lhs(weights[i], lhs_idx[i]),
+				lhs_idx[i], w.vector, w.vlen);
+	}
+
+	parallel->parallel_for(0, outputs.vlen, [&](int64_t first, int64_t last)
+	{
+		for (int64_t j=first; j<last; ++j)
+			outputs[j]=normalizer->normalize_rhs(r->dense_dot(j, w.vector, w.vlen), j);
+	});
+
+	return true;
+}
@@ -130,6 +130,31 @@ class CLinearKernel: public CDotKernel
 		}
 
 	protected:
+		/** @return if the kernel matrix can be computed in blocks, i.e. for
+		 * dense real valued features
+		 */
+		virtual bool supports_block_computation();
+
+		/** compute a block of kernel values from a single matrix product
+		 *
+		 * @param lhs_idx indices of the left hand side vectors, one per row
+		 * @param rhs_begin index of the first right hand side vector
+		 * @param block preallocated block to write the kernel values to
+		 */
+		virtual void compute_block(SGVector<index_t> lhs_idx,
+			index_t rhs_begin, SGMatrix<float64_t>& block);
+
+		/** collapse a kernel expansion into a single weight vector like init_optimization() and evaluate it
+		 *
+		 * @param lhs_idx indices of the left hand side vectors of the expansion
+		 * @param weights weights of the expansion
+		 * @param outputs preallocated outputs, one per right hand side vector
+		 * @return if the outputs were computed, i.e. if the normalizer
+		 * is separable
+		 */
+		virtual bool compute_explicit_expansion(SGVector<index_t> lhs_idx,
+			SGVector<float64_t> weights, SGVector<float64_t>& outputs);
+
 		/** normal vector (used in case of optimized kernel) */
 		SGVector<float64_t> normal;
 };
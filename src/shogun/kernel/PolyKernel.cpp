@@ -6,10 +6,12 @@
 
 #include <shogun/lib/config.h>
 #include <shogun/lib/common.h>
+#include <shogun/base/Parallel.h>
 #include <shogun/io/SGIO.h>
 #include <shogun/kernel/PolyKernel.h>
 #include <shogun/kernel/normalizer/SqrtDiagKernelNormalizer.h>
 #include <shogun/features/DotFeatures.h>
+#include <shogun/mathematics/linalg/LinalgNamespace.h>
 
 using namespace shogun;
 
@@ -64,6 +66,90 @@ float64_t CPolyKernel::compute(int32_t idx_a, int32_t idx_b)
 	return CMath::pow(result, degree);
 }
 
+bool CPolyKernel::supports_block_computation()
+{
+	return has_dense_real_features();
+}
+
+void CPolyKernel::compute_block(SGVector<index_t> lhs_idx,
+	index_t rhs_begin, SGMatrix<float64_t>& block)
+{
+	compute_dense_dot_block(lhs_idx, rhs_begin, block);
+
+	float64_t offset=inhomogene ? 1.0 : 0.0;
+	for (index_t i=0; i<block.num_rows*block.num_cols; ++i)
+		block.matrix[i]=CMath::pow(block.matrix[i]+offset, degree);
+}
+
+bool CPolyKernel::compute_explicit_expansion(SGVector<index_t> lhs_idx,
+	SGVector<float64_t> weights, SGVector<float64_t>& outputs)
+{
+	if (degree<1 || degree>2 || !has_dense_real_features() ||
+			!has_separable_normalizer())
+		return false;
+
+	// the weight matrix has dim^2 entries, it only pays off when it replaces
+	// more than dim expansion vectors
+	int32_t dim=((CDotFeatures*) lhs)->get_dim_feature_space();
+	if (degree==2 && dim>lhs_idx.vlen)
+		return false;
+
+	SGVector<float64_t> a(lhs_idx.vlen);
+	for (index_t i=0; i<lhs_idx.vlen; ++i)
+		a[i]=normalizer->normalize_lhs(weights[i], lhs_idx[i]);
+
+	/* with w=\sum_i a_i x_i, M=\sum_i a_i x_i x_i^T and s=\sum_i a_i
+	 * \sum_i a_i (x_i^T y+c)^2 = y^T M y + 2c w^T y + c^2 s */
+	SGMatrix<float64_t> x=get_dense_real_vectors(lhs, lhs_idx);
+	SGVector<float64_t> w=linalg::matrix_prod(x, a);
+	float64_t s=linalg::sum(a);
+	float64_t c=inhomogene ? 1.0 : 0.0;
+
+	SGMatrix<float64_t> m;
+	if (degree==2)
+	{
+		SGMatrix<float64_t> xa(x.num_rows, x.num_cols);
+		for (index_t i=0; i<x.num_cols; ++i)
+		{
+			for (index_t k=0; k<x.num_rows; ++k)
+				xa(k, i)=a[i]*x(k, i);
+		}
+		m=linalg::matrix_prod(xa, x, false, true);
+	}
+
+	const index_t tile_size=256;
+	int64_t num_tiles=(outputs.vlen+tile_size-1)/tile_size;
+	parallel->parallel_for(0, num_tiles, [&](int64_t first, int64_t last)
+	{
+		for (int64_t t=first; t<last; ++t)
+		{
+			SGVector<index_t> cols(CMath::min(tile_size,
+					index_t(outputs.vlen-t*tile_size)));
+			cols.range_fill(t*tile_size);
+			SGMatrix<float64_t> y=get_dense_real_vectors(rhs, cols);
+			SGVector<float64_t> wy=linalg::matrix_prod(y, w, true);
+			SGMatrix<float64_t> my;
+			if (degree==2)
+				my=linalg::matrix_prod(m, y);
+
+			for (index_t j=0; j<cols.vlen; ++j)
+			{
+				float64_t f=wy[j]+c*s;
+				if (degree==2)
+				{
+					float64_t q=0;
+					for (index_t k=0; k<y.num_rows; ++k)
+						q+=y(k, j)*my(k, j);
+					f=q+2*c*wy[j]+c*c*s;
+				}
+				outputs[cols[j]]=normalizer->normalize_rhs(f, cols[j]);
+			}
+		}
+	}, 1);
+
+	return true;
+}
+
 void CPolyKernel::init()
 {
 	degree = 0;
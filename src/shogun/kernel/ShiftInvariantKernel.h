@@ -131,6 +131,12 @@ protected:
 	 */
 	virtual float64_t distance(int32_t idx_a, int32_t idx_b) const;
 
+	/** @return whether distances are taken from a precomputed distance */
+	bool has_precomputed_distance() const
+	{
+		return m_precomputed_distance!=NULL;
+	}
+
 	/** Distance instance for the kernel. MUST be initialized by the subclasses */
 	CDistance* m_distance;
 
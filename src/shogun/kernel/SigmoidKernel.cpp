@@ -58,3 +58,17 @@ void CSigmoidKernel::init()
 	SG_ADD(&gamma, "gamma", "Gamma.", MS_AVAILABLE);
 	SG_ADD(&coef0, "coef0", "Coefficient 0.", MS_AVAILABLE);
 }
+
+bool CSigmoidKernel::supports_block_computation()
+{
+	return has_dense_real_features();
+}
+
+void CSigmoidKernel::compute_block(SGVector<index_t> lhs_idx,
+	index_t rhs_begin, SGMatrix<float64_t>& block)
+{
+	compute_dense_dot_block(lhs_idx, rhs_begin, block);
+
+	for (index_t i=0; i<block.num_rows*block.num_cols; ++i)
+		block.matrix[i]=tanh(gamma*block.matrix[i]+coef0);
+}
@@ -87,6 +87,20 @@ class CSigmoidKernel: public CDotKernel
 			return tanh(gamma*CDotKernel::compute(idx_a,idx_b)+coef0);
 		}
 
+		/** @return if the kernel matrix can be computed in blocks, i.e. for
+		 * dense real valued features
+		 */
+		virtual bool supports_block_computation();
+
+		/** compute a block of kernel values from a single matrix product
+		 *
+		 * @param lhs_idx indices of the left hand side vectors, one per row
+		 * @param rhs_begin index of the first right hand side vector
+		 * @param block preallocated block to write the kernel values to
+		 */
+		virtual void compute_block(SGVector<index_t> lhs_idx,
+			index_t rhs_begin, SGMatrix<float64_t>& block);
+
 	private:
 		void init();
 
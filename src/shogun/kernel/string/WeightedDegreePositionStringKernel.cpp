@@ -19,10 +19,6 @@
 
 #include <shogun/classifier/svm/SVM.h>
 
-#ifdef HAVE_PTHREAD
-#include <pthread.h>
-
-#endif
 
 using namespace shogun;
 
@@ -1238,95 +1234,36 @@ void CWeightedDegreePositionStringKernel::compute_batch(
 
 	int32_t num_feat=((CStringFeatures<char>*) rhs)->get_max_vector_length();
 	ASSERT(num_feat>0)
-	// TODO: port to use OpenMP backend instead of pthread
-#ifdef HAVE_PTHREAD
 	int32_t num_threads=parallel->get_num_threads();
-#else
-	int32_t num_threads=1;
-#endif
 	ASSERT(num_threads>0)
-	int32_t* vec=SG_MALLOC(int32_t, num_threads*num_feat);
 
-	if (num_threads < 2)
+	// TODO: replace with the new signal
+	// for (int32_t j=0; j<num_feat && !CSignal::cancel_computations(); j++)
+	for (auto j : SG_PROGRESS(range(num_feat)))
 	{
-		// TODO: replace with the new signal
-		// for (int32_t j=0; j<num_feat && !CSignal::cancel_computations(); j++)
-		for (auto j : SG_PROGRESS(range(num_feat)))
+		init_optimization(num_suppvec, IDX, alphas, j);
+
+		// one chunk of vectors per thread, each remaps into its own buffer
+		parallel->parallel_for(0, num_vec, [&](int64_t start, int64_t end)
 		{
-			init_optimization(num_suppvec, IDX, alphas, j);
+			SGVector<int32_t> vec(num_feat);
 			S_THREAD_PARAM_WDS<DNATrie> params;
-			params.vec = vec;
+			params.vec = vec.vector;
 			params.result = result;
 			params.weights = weights;
 			params.kernel = this;
 			params.tries = &tries;
 			params.factor = factor;
 			params.j = j;
-			params.start = 0;
-			params.end = num_vec;
+			params.start = start;
+			params.end = end;
 			params.length = length;
 			params.max_shift = max_shift;
 			params.shift = shift;
 			params.vec_idx = vec_idx;
 			compute_batch_helper((void*)&params);
-		    }
+		}, (num_vec+num_threads-1)/num_threads);
 	}
-#ifdef HAVE_PTHREAD
-	else
-	{
-		// TODO: replace with the new signal
-		// for (int32_t j=0; j<num_feat && !CSignal::cancel_computations(); j++)
-		for (auto j : SG_PROGRESS(range(num_feat)))
-		{
-			init_optimization(num_suppvec, IDX, alphas, j);
-			pthread_t* threads = SG_MALLOC(pthread_t, num_threads-1);
-			S_THREAD_PARAM_WDS<DNATrie>* params = SG_MALLOC(S_THREAD_PARAM_WDS<DNATrie>, num_threads);
-			int32_t step= num_vec/num_threads;
-			int32_t t;
-
-			for (t=0; t<num_threads-1; t++)
-			{
-				params[t].vec=&vec[num_feat*t];
-				params[t].result=result;
-				params[t].weights=weights;
-				params[t].kernel=this;
-				params[t].tries=&tries;
-				params[t].factor=factor;
-				params[t].j=j;
-				params[t].start = t*step;
-				params[t].end = (t+1)*step;
-				params[t].length=length;
-				params[t].max_shift=max_shift;
-				params[t].shift=shift;
-				params[t].vec_idx=vec_idx;
-				pthread_create(&threads[t], NULL, CWeightedDegreePositionStringKernel::compute_batch_helper, (void*)&params[t]);
-			}
-
-			params[t].vec=&vec[num_feat*t];
-			params[t].result=result;
-			params[t].weights=weights;
-			params[t].kernel=this;
-			params[t].tries=&tries;
-			params[t].factor=factor;
-			params[t].j=j;
-			params[t].start=t*step;
-			params[t].end=num_vec;
-			params[t].length=length;
-			params[t].max_shift=max_shift;
-			params[t].shift=shift;
-			params[t].vec_idx=vec_idx;
-			compute_batch_helper((void*) &params[t]);
-
-			for (t=0; t<num_threads-1; t++)
-				pthread_join(threads[t], NULL);
-
-			SG_FREE(params);
-			SG_FREE(threads);
-		}
-	}
-#endif
-
-	SG_FREE(vec);
 
 	//really also free memory as this can be huge on testing especially when
 	//using the combined kernel
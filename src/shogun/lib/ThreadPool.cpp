@@ -0,0 +1,285 @@
+/*
+ * This software is distributed under BSD 3-clause license (see LICENSE file).
+ */
+
+#include <shogun/lib/ThreadPool.h>
+#include <shogun/mathematics/Math.h>
+
+#ifdef HAVE_OPENMP
+#include <omp.h>
+#endif
+
+using namespace shogun;
+
+/** pool the calling thread is a worker of */
+static thread_local ThreadPool* worker_pool=NULL;
+
+/** index of the calling worker in its pool */
+static thread_local int32_t worker_index=-1;
+
+/** runs OpenMP regions of the calling thread on a single thread while
+ * alive, so that a thread working on tasks does not start a team
+ */
+class SerialOpenMPGuard
+{
+public:
+	SerialOpenMPGuard()
+	{
+#ifdef HAVE_OPENMP
+		m_num_threads=omp_get_max_threads();
+		omp_set_num_threads(1);
+#endif
+	}
+
+	~SerialOpenMPGuard()
+	{
+#ifdef HAVE_OPENMP
+		omp_set_num_threads(m_num_threads);
+#endif
+	}
+
+private:
+	int32_t m_num_threads;
+};
+
+ThreadPool::TaskGroup::TaskGroup(ThreadPool* pool)
+	: m_pool(pool), m_num_pending(0)
+{
+	REQUIRE(pool, "Thread pool must not be NULL\n");
+}
+
+ThreadPool::TaskGroup::~TaskGroup()
+{
+	finish();
+}
+
+void ThreadPool::TaskGroup::run(task_t task)
+{
+	Task t;
+	t.function=std::move(task);
+	t.group=this;
+	m_num_pending++;
+
+	if (m_pool->m_workers.empty())
+		execute(t);
+	else
+		m_pool->push(std::move(t));
+}
+
+void ThreadPool::TaskGroup::finish()
+{
+	if (m_num_pending.load(std::memory_order_acquire)==0)
+		return;
+
+	SerialOpenMPGuard guard;
+	while (m_num_pending.load(std::memory_order_acquire)>0)
+	{
+		Task task;
+		if (m_pool->try_pop(task))
+		{
+			execute(task);
+			continue;
+		}
+
+		// sleep until a task is queued or the last task of the group is done
+		std::unique_lock<std::mutex> lock(m_pool->m_sleep_lock);
+		m_pool->m_wakeup.wait(lock, [this]()
+		{
+			return m_num_pending.load()==0 || m_pool->m_num_queued.load()>0;
+		});
+	}
+}
+
+void ThreadPool::TaskGroup::wait()
+{
+	finish();
+
+	std::exception_ptr error;
+	{
+		std::lock_guard<std::mutex> guard(m_error_lock);
+		std::swap(error, m_error);
+	}
+
+	if (error)
+		std::rethrow_exception(error);
+}
+
+ThreadPool::ThreadPool(int32_t num_threads)
+	: m_num_queued(0), m_stop(false)
+{
+	REQUIRE(num_threads>0, "Number of threads (%d) must be positive\n",
+			num_threads);
+	m_num_threads=num_threads;
+
+	// one queue per worker and the shared queue
+	for (int32_t i=0; i<num_threads; i++)
+		m_queues.push_back(std::unique_ptr<TaskQueue>(new TaskQueue()));
+
+	for (int32_t i=0; i<num_threads-1; i++)
+		m_workers.push_back(std::thread(&ThreadPool::worker_loop, this, i));
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> guard(m_sleep_lock);
+		m_stop=true;
+	}
+	m_wakeup.notify_all();
+
+	for (auto& worker : m_workers)
+		worker.join();
+}
+
+bool ThreadPool::in_worker()
+{
+	return worker_pool!=NULL;
+}
+
+void ThreadPool::push(Task task)
+{
+	int32_t index=worker_pool==this ? worker_index : m_workers.size();
+	{
+		std::lock_guard<std::mutex> guard(m_queues[index]->lock);
+		m_queues[index]->tasks.push_back(std::move(task));
+	}
+	{
+		std::lock_guard<std::mutex> guard(m_sleep_lock);
+		m_num_queued++;
+	}
+	m_wakeup.notify_one();
+}
+
+bool ThreadPool::try_pop(Task& task)
+{
+	if (m_num_queued.load(std::memory_order_acquire)==0)
+		return false;
+
+	int32_t num_queues=m_queues.size();
+	int32_t own=worker_pool==this ? worker_index : num_queues-1;
+
+	// newest task of the own queue, its data is most likely still cached
+	if (worker_pool==this)
+	{
+		TaskQueue& queue=*m_queues[own];
+		std::lock_guard<std::mutex> guard(queue.lock);
+		if (!queue.tasks.empty())
+		{
+			task=std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+			m_num_queued--;
+			return true;
+		}
+	}
+
+	// oldest task of the shared queue or of another worker
+	for (int32_t i=0; i<num_queues; i++)
+	{
+		int32_t index=(own+1+i)%num_queues;
+		if (worker_pool==this && index==own)
+			continue;
+
+		TaskQueue& queue=*m_queues[index];
+		std::lock_guard<std::mutex> guard(queue.lock);
+		if (!queue.tasks.empty())
+		{
+			task=std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+			m_num_queued--;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void ThreadPool::execute(Task& task)
+{
+	TaskGroup* group=task.group;
+	try
+	{
+		task.function();
+	}
+	catch (...)
+	{
+		std::lock_guard<std::mutex> guard(group->m_error_lock);
+		if (!group->m_error)
+			group->m_error=std::current_exception();
+	}
+
+	// the group may be gone as soon as the last task is marked done, the
+	// pool outlives it
+	ThreadPool* pool=group->m_pool;
+	if (group->m_num_pending.fetch_sub(1, std::memory_order_acq_rel)==1)
+	{
+		std::lock_guard<std::mutex> guard(pool->m_sleep_lock);
+		pool->m_wakeup.notify_all();
+	}
+}
+
+void ThreadPool::worker_loop(int32_t index)
+{
+	worker_pool=this;
+	worker_index=index;
+#ifdef HAVE_OPENMP
+	omp_set_num_threads(1);
+#endif
+
+	while (true)
+	{
+		Task task;
+		if (try_pop(task))
+		{
+			execute(task);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_sleep_lock);
+		m_wakeup.wait(lock, [this]() { return m_stop || m_num_queued.load()>0; });
+		if (m_stop && m_num_queued.load()==0)
+			break;
+	}
+
+	worker_pool=NULL;
+	worker_index=-1;
+}
+
+void ThreadPool::parallel_for(int64_t begin, int64_t end,
+		const std::function<void(int64_t, int64_t)>& body, int64_t grain)
+{
+	int64_t n=end-begin;
+	if (n<=0)
+		return;
+
+	if (grain<=0)
+	{
+		int64_t num_chunks=4*int64_t(m_num_threads);
+		grain=(n+num_chunks-1)/num_chunks;
+	}
+
+	if (m_workers.empty() || grain>=n)
+	{
+		body(begin, end);
+		return;
+	}
+
+	TaskGroup group(this);
+	for (int64_t start=begin+grain; start<end; start+=grain)
+	{
+		int64_t stop=CMath::min(start+grain, end);
+		group.run([&body, start, stop]() { body(start, stop); });
+	}
+
+	// the calling thread takes the first chunk and then helps with the rest
+	try
+	{
+		SerialOpenMPGuard guard;
+		body(begin, begin+grain);
+	}
+	catch (...)
+	{
+		group.finish();
+		throw;
+	}
+	group.wait();
+}
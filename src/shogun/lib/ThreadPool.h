@@ -0,0 +1,196 @@
+/*
+ * This software is distributed under BSD 3-clause license (see LICENSE file).
+ */
+
+#ifndef _THREAD_POOL_H__
+#define _THREAD_POOL_H__
+
+#include <shogun/lib/config.h>
+#include <shogun/lib/common.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace shogun
+{
+
+/** @brief Work-stealing pool of worker threads.
+ *
+ * A pool for num_threads threads starts num_threads-1 workers, the thread
+ * waiting for a group of tasks is the last one: it executes pending tasks
+ * of the pool until its group is finished, and sleeps while there are
+ * none. Waiting therefore never blocks
+ * a thread of the pool, which makes nested parallelism safe, e.g. a
+ * parallel_for inside a task of another parallel_for. Nested work is
+ * distributed among the existing threads instead of starting new ones, so
+ * the number of busy threads never exceeds num_threads.
+ *
+ * Every worker owns a task queue. Tasks submitted from a worker go to its
+ * own queue, which it processes newest first, while idle workers steal the
+ * oldest tasks of other queues. Tasks submitted from other threads go to a
+ * shared queue.
+ *
+ * OpenMP regions inside tasks run on a single thread, so that loops which
+ * are parallelized with OpenMP do not oversubscribe the cores when they
+ * are called from within the pool.
+ *
+ * Exceptions thrown by a task are caught and the first one is rethrown by
+ * TaskGroup::wait().
+ */
+class ThreadPool
+{
+public:
+	/** task type */
+	typedef std::function<void()> task_t;
+
+	/** @brief A group of tasks which can be waited for. */
+	class TaskGroup
+	{
+	public:
+		/** constructor
+		 *
+		 * @param pool pool to run the tasks on
+		 */
+		TaskGroup(ThreadPool* pool);
+
+		/** destructor, waits for all tasks of the group */
+		~TaskGroup();
+
+		/** submit a task
+		 *
+		 * @param task task to run
+		 */
+		void run(task_t task);
+
+		/** execute tasks of the pool until all tasks of this group are
+		 * finished, rethrows the first exception thrown by a task
+		 */
+		void wait();
+
+	private:
+		friend class ThreadPool;
+
+		/** execute tasks of the pool until all tasks of this group are
+		 * finished
+		 */
+		void finish();
+
+		/** pool the tasks run on */
+		ThreadPool* m_pool;
+
+		/** number of unfinished tasks */
+		std::atomic<int64_t> m_num_pending;
+
+		/** first exception thrown by a task */
+		std::exception_ptr m_error;
+
+		/** guards m_error */
+		std::mutex m_error_lock;
+	};
+
+	/** constructor
+	 *
+	 * @param num_threads number of threads working on tasks, including the
+	 * waiting thread
+	 */
+	ThreadPool(int32_t num_threads);
+
+	/** destructor, must not be called while tasks are pending */
+	~ThreadPool();
+
+	/** @return number of threads working on tasks */
+	int32_t get_num_threads() const { return m_num_threads; }
+
+	/** split the range [begin, end) into chunks and call body(chunk_begin,
+	 * chunk_end) for each chunk in parallel. The calling thread works on
+	 * chunks, too, and returns once all chunks are done.
+	 *
+	 * @param begin start of the range
+	 * @param end end of the range
+	 * @param body function called for each chunk
+	 * @param grain size of the chunks, 0 chooses four chunks per thread
+	 */
+	void parallel_for(int64_t begin, int64_t end,
+			const std::function<void(int64_t, int64_t)>& body, int64_t grain=0);
+
+	/** @return whether the calling thread is a worker of any pool */
+	static bool in_worker();
+
+private:
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+	/** a submitted task */
+	struct Task
+	{
+		/** function to call */
+		task_t function;
+		/** group the task belongs to */
+		TaskGroup* group;
+	};
+
+	/** queue of tasks */
+	struct TaskQueue
+	{
+		/** guards tasks */
+		std::mutex lock;
+		/** tasks, oldest first */
+		std::deque<Task> tasks;
+	};
+#endif // DOXYGEN_SHOULD_SKIP_THIS
+
+	/** add a task to the queue of the calling worker or the shared queue
+	 *
+	 * @param task task to add
+	 */
+	void push(Task task);
+
+	/** take a task, from the own queue first, then the shared queue, then
+	 * from the other workers
+	 *
+	 * @param task set to the task taken
+	 * @return whether a task was taken
+	 */
+	bool try_pop(Task& task);
+
+	/** run a task and mark it done in its group
+	 *
+	 * @param task task to run
+	 */
+	static void execute(Task& task);
+
+	/** main loop of a worker
+	 *
+	 * @param index index of the worker
+	 */
+	void worker_loop(int32_t index);
+
+private:
+	/** number of threads working on tasks */
+	int32_t m_num_threads;
+
+	/** worker threads */
+	std::vector<std::thread> m_workers;
+
+	/** queues of the workers, followed by the shared queue */
+	std::vector<std::unique_ptr<TaskQueue> > m_queues;
+
+	/** number of tasks in all queues */
+	std::atomic<int64_t> m_num_queued;
+
+	/** whether the workers shall stop */
+	bool m_stop;
+
+	/** guards sleeping of workers and of threads waiting for a group */
+	std::mutex m_sleep_lock;
+
+	/** wakes up sleeping threads when a task is queued or a group is done */
+	std::condition_variable m_wakeup;
+};
+}
+#endif // _THREAD_POOL_H__
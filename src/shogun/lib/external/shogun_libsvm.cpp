@@ -35,6 +35,7 @@
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 
+#include <shogun/base/Parallel.h>
 #include <shogun/base/init.h>
 #include <shogun/base/progress.h>
 #include <shogun/io/SGIO.h>
@@ -53,6 +54,7 @@
 #include <stdarg.h>
 
 #include <rxcpp/rx.hpp>
+#include <vector>
 
 namespace shogun
 {
@@ -67,6 +69,8 @@ template <class S, class T> inline void clone(T*& dst, S* src, int32_t n)
 }
 #define INF HUGE_VAL
 #define TAU 1e-12
+// O(l) loops over the gradient are split in chunks of at least this many entries
+#define PARALLEL_GRAIN 8192
 
 class QMatrix;
 class SVC_QMC;
@@ -212,7 +216,17 @@ public:
 	virtual void swap_index(int32_t i, int32_t j) const = 0;
 	virtual ~QMatrix() {}
 
+	// get the columns i and j of a working set, both stay valid until the
+	// next call; formulations with a batched kernel computation override this
+	virtual void get_Q_pair(int32_t i, int32_t j, int32_t len,
+		const Qfloat *&Q_i, const Qfloat *&Q_j) const
+	{
+		Q_i = get_Q(i,len);
+		Q_j = get_Q(j,len);
+	}
+
 	float64_t max_train_time;
+	Parallel* parallel;
 };
 
 class LibSVMKernel;
@@ -234,6 +248,12 @@ public:
 
 	void compute_Q_parallel(Qfloat* data, float64_t* lab, int32_t i, int32_t start, int32_t len) const
 	{
+		if (row_cache)
+		{
+			fill_Q_from_row_cache(data, lab, i, start, len);
+			return;
+		}
+
 		if (lab) // two class
 		{
 			#pragma omp parallel for
@@ -248,6 +268,59 @@ public:
 		}
 	}
 
+	// fill data_i[start_i,len) and data_j[start_j,len) in a single pass on
+	// the thread pool instead of one parallel region per column
+	void compute_Q_pair_parallel(Qfloat* data_i, Qfloat* data_j, float64_t* lab,
+		int32_t i, int32_t j, int32_t start_i, int32_t start_j, int32_t len) const
+	{
+		if (row_cache)
+		{
+			fill_Q_from_row_cache(data_i, lab, i, start_i, len);
+			fill_Q_from_row_cache(data_j, lab, j, start_j, len);
+			return;
+		}
+
+		int64_t n_i = CMath::max(len-start_i, 0);
+		int64_t n_j = CMath::max(len-start_j, 0);
+		parallel->parallel_for(0, n_i+n_j, [&](int64_t begin, int64_t end)
+		{
+			for (int64_t t=begin; t<end; t++)
+			{
+				int32_t row = t<n_i ? i : j;
+				int32_t col = t<n_i ? start_i+t : start_j+t-n_i;
+				Qfloat* data = t<n_i ? data_i : data_j;
+				if (lab)
+					data[col] = (Qfloat) lab[row]*lab[col]*this->kernel_function(row,col);
+				else
+					data[col] = (Qfloat) this->kernel_function(row,col);
+			}
+		});
+	}
+
+	// fill data[start,len) from the row of x[i] in the shared row cache,
+	// which holds the kernel values of x[i] with all training vectors
+	void fill_Q_from_row_cache(Qfloat* data, float64_t* lab, int32_t i, int32_t start, int32_t len) const
+	{
+		if (start>=len)
+			return;
+
+		if (row_cache->get_precision()==PT_FLOAT32)
+			fill_Q_from_row(data, lab, i, start, len, row_cache->get_row<float32_t>(x[i]->index));
+		else
+			fill_Q_from_row(data, lab, i, start, len, row_cache->get_row<float64_t>(x[i]->index));
+	}
+
+	template <class T>
+	void fill_Q_from_row(Qfloat* data, float64_t* lab, int32_t i, int32_t start, int32_t len,
+		const SGVector<T>& row) const
+	{
+		for(int32_t j=start;j<len;j++)
+		{
+			float64_t k=row[x[j]->index];
+			data[j] = (Qfloat) (lab ? lab[i]*lab[j]*k : k);
+		}
+	}
+
 	inline float64_t kernel_function(int32_t i, int32_t j) const
 	{
 		return kernel->kernel(x[i]->index,x[j]->index);
@@ -255,6 +328,7 @@ public:
 
 private:
 	CKernel* kernel;
+	CKernelRowCache* row_cache;
 	const svm_node **x;
 	float64_t *x_square;
 };
@@ -264,7 +338,17 @@ LibSVMKernel::LibSVMKernel(int32_t l, svm_node * const * x_, const svm_parameter
 	clone(x,x_,l);
 	x_square = 0;
 	kernel=param.kernel;
+	row_cache=param.row_cache;
 	max_train_time=param.max_train_time;
+	parallel=kernel->parallel;
+
+	if (row_cache)
+	{
+		CKernel* cached_kernel=row_cache->get_kernel();
+		SG_UNREF(cached_kernel);
+		REQUIRE(cached_kernel==kernel,
+			"Row cache holds the rows of a different kernel than the one trained on\n");
+	}
 }
 
 LibSVMKernel::~LibSVMKernel()
@@ -348,6 +432,51 @@ protected:
 	virtual float64_t calculate_rho();
 	virtual void do_shrinking();
 
+	// number of chunks an O(n) loop is split into, at most one per thread
+	int32_t num_chunks(int32_t n) const
+	{
+		int32_t num_threads = Q->parallel ? Q->parallel->get_num_threads() : 1;
+		return CMath::max(1, CMath::min(num_threads, n/PARALLEL_GRAIN));
+	}
+
+	// call body(chunk, chunk_begin, chunk_end) for the num_chunks(end-begin)
+	// consecutive chunks of [begin,end), in parallel if there is more than one
+	template <class F> void for_each_chunk(int32_t begin, int32_t end, F body) const
+	{
+		int64_t n = end-begin;
+		int32_t chunks = num_chunks(n);
+		if (chunks == 1)
+		{
+			body(0, begin, end);
+			return;
+		}
+
+		Q->parallel->parallel_for(0, chunks, [&](int64_t first, int64_t last)
+		{
+			for (int64_t c=first; c<last; c++)
+				body(c, begin+n*c/chunks, begin+n*(c+1)/chunks);
+		}, 1);
+	}
+
+	// G[k] += d_i*Q_i[k] + d_j*Q_j[k] on [begin,end), Q_j may be NULL
+	void update_gradient(float64_t* g, int32_t begin, int32_t end,
+		const Qfloat* Q_i, float64_t d_i, const Qfloat* Q_j, float64_t d_j) const
+	{
+		for_each_chunk(begin, end, [&](int32_t, int32_t b, int32_t e)
+		{
+			if (Q_j)
+			{
+				for(int32_t k=b;k<e;k++)
+					g[k] += Q_i[k]*d_i + Q_j[k]*d_j;
+			}
+			else
+			{
+				for(int32_t k=b;k<e;k++)
+					g[k] += d_i*Q_i[k];
+			}
+		});
+	}
+
 	/* Custom implementation of signal handling */
 	rxcpp::subscription connect_to_signal_handler();
 	void reset_computation_variables();
@@ -422,13 +551,21 @@ void Solver::reconstruct_gradient()
 
 	if (nr_free*l > 2*active_size*(l-active_size))
 	{
+		// alpha of the free variables and zero elsewhere, so that the
+		// inner loop has no branch
+		float64_t* alpha_free = SG_MALLOC(float64_t, active_size);
+		for(j=0;j<active_size;j++)
+			alpha_free[j] = is_free(j) ? alpha[j] : 0;
+
 		for(i=active_size;i<l;i++)
 		{
 			const Qfloat *Q_i = Q->get_Q(i,active_size);
+			float64_t G_i = G[i];
 			for(j=0;j<active_size;j++)
-				if(is_free(j))
-					G[i] += alpha[j] * Q_i[j];
+				G_i += alpha_free[j] * Q_i[j];
+			G[i] = G_i;
 		}
+		SG_FREE(alpha_free);
 	}
 	else
 	{
@@ -436,9 +573,7 @@ void Solver::reconstruct_gradient()
 			if(is_free(i))
 			{
 				const Qfloat *Q_i = Q->get_Q(i,l);
-				float64_t alpha_i = alpha[i];
-				for(j=active_size;j<l;j++)
-					G[j] += alpha_i * Q_i[j];
+				update_gradient(G, active_size, l, Q_i, alpha[i], NULL, 0);
 			}
 	}
 }
@@ -495,13 +630,9 @@ void Solver::Solve(
 			if(!is_lower_bound(i))
 			{
 				const Qfloat *Q_i = Q->get_Q(i,l);
-				float64_t alpha_i = alpha[i];
-				int32_t j;
-				for(j=0;j<l;j++)
-					G[j] += alpha_i*Q_i[j];
+				update_gradient(G, 0, l, Q_i, alpha[i], NULL, 0);
 				if(is_upper_bound(i))
-					for(j=0;j<l;j++)
-						G_bar[j] += get_C(i) * Q_i[j];
+					update_gradient(G_bar, 0, l, Q_i, get_C(i), NULL, 0);
 			}
 			pb.print_progress();
 		}
@@ -549,8 +680,8 @@ void Solver::Solve(
 
 		// update alpha[i] and alpha[j], handle bounds carefully
 
-		const Qfloat *Q_i = Q->get_Q(i,active_size);
-		const Qfloat *Q_j = Q->get_Q(j,active_size);
+		const Qfloat *Q_i, *Q_j;
+		Q->get_Q_pair(i,j,active_size,Q_i,Q_j);
 
 		float64_t C_i = get_C(i);
 		float64_t C_j = get_C(j);
@@ -670,10 +801,7 @@ void Solver::Solve(
 		float64_t delta_alpha_i = alpha[i] - old_alpha_i;
 		float64_t delta_alpha_j = alpha[j] - old_alpha_j;
 
-		for(int32_t k=0;k<active_size;k++)
-		{
-			G[k] += Q_i[k]*delta_alpha_i + Q_j[k]*delta_alpha_j;
-		}
+		update_gradient(G, 0, active_size, Q_i, delta_alpha_i, Q_j, delta_alpha_j);
 
 		// update alpha_status and G_bar
 
@@ -682,28 +810,21 @@ void Solver::Solve(
 			bool uj = is_upper_bound(j);
 			update_alpha_status(i);
 			update_alpha_status(j);
-			int32_t k;
-			if(ui != is_upper_bound(i))
-			{
-				Q_i = Q->get_Q(i,l);
-				if(ui)
-					for(k=0;k<l;k++)
-						G_bar[k] -= C_i * Q_i[k];
-				else
-					for(k=0;k<l;k++)
-						G_bar[k] += C_i * Q_i[k];
-			}
-
-			if(uj != is_upper_bound(j))
+			bool ci = ui != is_upper_bound(i);
+			bool cj = uj != is_upper_bound(j);
+			float64_t d_i = ui ? -C_i : C_i;
+			float64_t d_j = uj ? -C_j : C_j;
+			if(ci && cj)
 			{
-				Q_j = Q->get_Q(j,l);
-				if(uj)
-					for(k=0;k<l;k++)
-						G_bar[k] -= C_j * Q_j[k];
-				else
-					for(k=0;k<l;k++)
-						G_bar[k] += C_j * Q_j[k];
+				// both columns are needed in full length, compute them in one batch
+				Q->get_Q_pair(i,j,l,Q_i,Q_j);
+				update_gradient(G_bar, 0, l, Q_i, d_i, NULL, 0);
+				update_gradient(G_bar, 0, l, Q_j, d_j, NULL, 0);
 			}
+			else if(ci)
+				update_gradient(G_bar, 0, l, Q->get_Q(i,l), d_i, NULL, 0);
+			else if(cj)
+				update_gradient(G_bar, 0, l, Q->get_Q(j,l), d_j, NULL, 0);
 		}
 
 #ifdef MCSVM_DEBUG
@@ -772,31 +893,49 @@ int32_t Solver::select_working_set(
 	// j: minimizes the decrease of obj value
 	//    (if quadratic coefficient <= 0, replace it with tau)
 	//    -y_j*grad(f)_j < -y_i*grad(f)_i, j in I_low(\alpha)
+	//
+	// both scans are split in chunks, the per chunk optima are merged in
+	// chunk order with the same comparisons, so that the selected pair is
+	// the one of a serial scan
+
+	int32_t chunks = num_chunks(active_size);
+	std::vector<float64_t> chunk_Gmax(chunks, -INF);
+	std::vector<int32_t> chunk_Gmax_idx(chunks, -1);
+
+	for_each_chunk(0, active_size, [&](int32_t c, int32_t begin, int32_t end)
+	{
+		float64_t Gmax = -INF;
+		int32_t Gmax_idx = -1;
+		for(int32_t t=begin;t<end;t++)
+			if(y[t]==+1)
+			{
+				if(!is_upper_bound(t))
+					if(-G[t] >= Gmax)
+					{
+						Gmax = -G[t];
+						Gmax_idx = t;
+					}
+			}
+			else
+			{
+				if(!is_lower_bound(t))
+					if(G[t] >= Gmax)
+					{
+						Gmax = G[t];
+						Gmax_idx = t;
+					}
+			}
+		chunk_Gmax[c] = Gmax;
+		chunk_Gmax_idx[c] = Gmax_idx;
+	});
 
 	float64_t Gmax = -INF;
-	float64_t Gmax2 = -INF;
 	int32_t Gmax_idx = -1;
-	int32_t Gmin_idx = -1;
-	float64_t obj_diff_min = INF;
-
-	for(int32_t t=0;t<active_size;t++)
-		if(y[t]==+1)
+	for(int32_t c=0;c<chunks;c++)
+		if(chunk_Gmax_idx[c] != -1 && chunk_Gmax[c] >= Gmax)
 		{
-			if(!is_upper_bound(t))
-				if(-G[t] >= Gmax)
-				{
-					Gmax = -G[t];
-					Gmax_idx = t;
-				}
-		}
-		else
-		{
-			if(!is_lower_bound(t))
-				if(G[t] >= Gmax)
-				{
-					Gmax = G[t];
-					Gmax_idx = t;
-				}
+			Gmax = chunk_Gmax[c];
+			Gmax_idx = chunk_Gmax_idx[c];
 		}
 
 	int32_t i = Gmax_idx;
@@ -804,56 +943,82 @@ int32_t Solver::select_working_set(
 	if(i != -1) // NULL Q_i not accessed: Gmax=-INF if i=-1
 		Q_i = Q->get_Q(i,active_size);
 
-	for(int32_t j=0;j<active_size;j++)
+	std::vector<float64_t> chunk_Gmax2(chunks, -INF);
+	std::vector<float64_t> chunk_obj_diff_min(chunks, INF);
+	std::vector<int32_t> chunk_Gmin_idx(chunks, -1);
+
+	for_each_chunk(0, active_size, [&](int32_t c, int32_t begin, int32_t end)
 	{
-		if(y[j]==+1)
+		float64_t Gmax2 = -INF;
+		int32_t Gmin_idx = -1;
+		float64_t obj_diff_min = INF;
+		for(int32_t j=begin;j<end;j++)
 		{
-			if (!is_lower_bound(j))
+			if(y[j]==+1)
 			{
-				float64_t grad_diff=Gmax+G[j];
-				if (G[j] >= Gmax2)
-					Gmax2 = G[j];
-				if (grad_diff > 0)
+				if (!is_lower_bound(j))
 				{
-					float64_t obj_diff;
-					float64_t quad_coef=Q_i[i]+QD[j]-2.0*y[i]*Q_i[j];
-					if (quad_coef > 0)
-						obj_diff = -(grad_diff*grad_diff)/quad_coef;
-					else
-						obj_diff = -(grad_diff*grad_diff)/TAU;
-
-					if (obj_diff <= obj_diff_min)
+					float64_t grad_diff=Gmax+G[j];
+					if (G[j] >= Gmax2)
+						Gmax2 = G[j];
+					if (grad_diff > 0)
 					{
-						Gmin_idx=j;
-						obj_diff_min = obj_diff;
+						float64_t obj_diff;
+						float64_t quad_coef=Q_i[i]+QD[j]-2.0*y[i]*Q_i[j];
+						if (quad_coef > 0)
+							obj_diff = -(grad_diff*grad_diff)/quad_coef;
+						else
+							obj_diff = -(grad_diff*grad_diff)/TAU;
+
+						if (obj_diff <= obj_diff_min)
+						{
+							Gmin_idx=j;
+							obj_diff_min = obj_diff;
+						}
 					}
 				}
 			}
-		}
-		else
-		{
-			if (!is_upper_bound(j))
+			else
 			{
-				float64_t grad_diff= Gmax-G[j];
-				if (-G[j] >= Gmax2)
-					Gmax2 = -G[j];
-				if (grad_diff > 0)
+				if (!is_upper_bound(j))
 				{
-					float64_t obj_diff;
-					float64_t quad_coef=Q_i[i]+QD[j]+2.0*y[i]*Q_i[j];
-					if (quad_coef > 0)
-						obj_diff = -(grad_diff*grad_diff)/quad_coef;
-					else
-						obj_diff = -(grad_diff*grad_diff)/TAU;
-
-					if (obj_diff <= obj_diff_min)
+					float64_t grad_diff= Gmax-G[j];
+					if (-G[j] >= Gmax2)
+						Gmax2 = -G[j];
+					if (grad_diff > 0)
 					{
-						Gmin_idx=j;
-						obj_diff_min = obj_diff;
+						float64_t obj_diff;
+						float64_t quad_coef=Q_i[i]+QD[j]+2.0*y[i]*Q_i[j];
+						if (quad_coef > 0)
+							obj_diff = -(grad_diff*grad_diff)/quad_coef;
+						else
+							obj_diff = -(grad_diff*grad_diff)/TAU;
+
+						if (obj_diff <= obj_diff_min)
+						{
+							Gmin_idx=j;
+							obj_diff_min = obj_diff;
+						}
 					}
 				}
 			}
 		}
+		chunk_Gmax2[c] = Gmax2;
+		chunk_obj_diff_min[c] = obj_diff_min;
+		chunk_Gmin_idx[c] = Gmin_idx;
+	});
+
+	float64_t Gmax2 = -INF;
+	int32_t Gmin_idx = -1;
+	float64_t obj_diff_min = INF;
+	for(int32_t c=0;c<chunks;c++)
+	{
+		Gmax2 = CMath::max(Gmax2, chunk_Gmax2[c]);
+		if(chunk_Gmin_idx[c] != -1 && chunk_obj_diff_min[c] <= obj_diff_min)
+		{
+			Gmin_idx = chunk_Gmin_idx[c];
+			obj_diff_min = chunk_obj_diff_min[c];
+		}
 	}
 
 	gap=Gmax+Gmax2;
@@ -1685,6 +1850,18 @@ public:
 		return data;
 	}
 
+	void get_Q_pair(int32_t i, int32_t j, int32_t len,
+		const Qfloat *&Q_i, const Qfloat *&Q_j) const
+	{
+		// the cache holds at least two columns, getting j does not evict i
+		Qfloat *data_i, *data_j;
+		int32_t start_i = cache->get_data(i,&data_i,len);
+		int32_t start_j = cache->get_data(j,&data_j,len);
+		compute_Q_pair_parallel(data_i, data_j, y, i, j, start_i, start_j, len);
+		Q_i = data_i;
+		Q_j = data_j;
+	}
+
 	Qfloat *get_QD() const
 	{
 		return QD;
@@ -1733,6 +1910,17 @@ public:
 		return data;
 	}
 
+	void get_Q_pair(int32_t i, int32_t j, int32_t len,
+		const Qfloat *&Q_i, const Qfloat *&Q_j) const
+	{
+		Qfloat *data_i, *data_j;
+		int32_t start_i = cache->get_data(i,&data_i,len);
+		int32_t start_j = cache->get_data(j,&data_j,len);
+		compute_Q_pair_parallel(data_i, data_j, NULL, i, j, start_i, start_j, len);
+		Q_i = data_i;
+		Q_j = data_j;
+	}
+
 	Qfloat *get_QD() const
 	{
 		return QD;
@@ -1803,6 +1991,30 @@ public:
 		return buf;
 	}
 
+	void get_Q_pair(int32_t i, int32_t j, int32_t len,
+		const Qfloat *&Q_i, const Qfloat *&Q_j) const
+	{
+		Qfloat *data_i, *data_j;
+		int32_t real_i = index[i];
+		int32_t real_j = index[j];
+		int32_t start_i = cache->get_data(real_i,&data_i,l);
+		int32_t start_j = cache->get_data(real_j,&data_j,l);
+		compute_Q_pair_parallel(data_i, data_j, NULL, real_i, real_j, start_i, start_j, l);
+
+		// reorder and copy into both buffers
+		Qfloat *buf_i = buffer[next_buffer];
+		Qfloat *buf_j = buffer[1-next_buffer];
+		schar si = sign[i];
+		schar sj = sign[j];
+		for(int32_t k=0;k<len;k++)
+		{
+			buf_i[k] = si * sign[k] * data_i[index[k]];
+			buf_j[k] = sj * sign[k] * data_j[index[k]];
+		}
+		Q_i = buf_i;
+		Q_j = buf_j;
+	}
+
 	Qfloat *get_QD() const
 	{
 		return QD;
@@ -41,6 +41,7 @@
 #include <shogun/lib/config.h>
 
 #include <shogun/kernel/Kernel.h>
+#include <shogun/kernel/KernelRowCache.h>
 
 namespace shogun
 {
@@ -86,6 +87,11 @@ enum { LINEAR, POLY, RBF, SIGMOID, PRECOMPUTED }; /* kernel_type */
 /** SVM parameter */
 struct svm_parameter
 {
+	/** default constructor */
+	svm_parameter() {
+		row_cache = NULL;
+	}
+
 	/** SVM type */
 	int32_t svm_type;
 	/** kernel type */
@@ -124,6 +130,9 @@ struct svm_parameter
 	int32_t shrinking;
 	/** compute bias */
 	bool use_bias;
+	/** kernel row cache shared with other solvers, NULL to compute the
+	 * kernel entries of the solver's own cache */
+	shogun::CKernelRowCache* row_cache;
 };
 
 /** svm_model */
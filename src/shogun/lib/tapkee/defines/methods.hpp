@@ -102,7 +102,11 @@ namespace tapkee
 		//! \f$ O(N N \log k) \f$ time complexity.
 		//! Recommended to be used only in debug purposes.
 		Brute,
-		VpTree
+		VpTree,
+		//! Approximate search in a hierarchical navigable small world graph,
+		//! built in parallel with roughly \f$ O(N \log N) \f$ time complexity.
+		//! Recommended for large and high-dimensional data.
+		Hnsw
 #ifdef TAPKEE_USE_LGPL_COVERTREE
 		//! Covertree-based method with approximate \f$ O(\log N) \f$ time complexity.
 		//! Recommended to be used as a default method.
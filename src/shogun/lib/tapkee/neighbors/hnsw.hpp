@@ -0,0 +1,88 @@
+/* This software is distributed under BSD 3-clause license (see LICENSE file).
+ */
+
+#ifndef TAPKEE_HNSW_H_
+#define TAPKEE_HNSW_H_
+
+/* Tapkee includes */
+#include <shogun/lib/tapkee/defines.hpp>
+/* End of Tapkee includes */
+
+#include <shogun/base/Parallel.h>
+#include <shogun/base/init.h>
+#include <shogun/multiclass/HNSWIndex.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace tapkee
+{
+namespace tapkee_internal
+{
+
+template <class RandomAccessIterator, class Callback>
+Neighbors find_neighbors_hnsw_impl(const RandomAccessIterator& begin, const RandomAccessIterator& end,
+                                   Callback callback, IndexType k)
+{
+	timed_context context("HNSW graph based neighbors search");
+
+	shogun::CHNSWIndex* index = new shogun::CHNSWIndex();
+	SG_REF(index);
+	// one more neighbor as the query point itself is found, too
+	index->set_ef_search(std::max(50, 2*(k+1)));
+	index->insert(end-begin, [&callback,&begin](::index_t a, ::index_t b)
+	{
+		return callback.distance(begin+a, begin+b);
+	});
+
+	Neighbors neighbors(end-begin);
+	shogun::Parallel* parallel = shogun::get_global_parallel();
+	parallel->parallel_for(0, end-begin, [&](int64_t first, int64_t last)
+	{
+		std::vector<::index_t> indices(k+1);
+		std::vector<::float64_t> distances(k+1);
+		std::vector<std::pair<ScalarType, ::index_t> > candidates;
+		for (int64_t i=first; i<last; ++i)
+		{
+			RandomAccessIterator query = begin+i;
+			::index_t n_found = index->search([&callback,&begin,&query](::index_t p)
+			{
+				return callback.distance(begin+p, query);
+			}, k+1, indices.data(), distances.data());
+
+			LocalNeighbors local_neighbors;
+			local_neighbors.reserve(k);
+			for (::index_t j=0; j<n_found && static_cast<IndexType>(local_neighbors.size())<k; ++j)
+			{
+				if (indices[j] != i)
+					local_neighbors.push_back(indices[j]);
+			}
+			// the graph search may reach too few points, callers read
+			// exactly k neighbors so such points are searched exhaustively
+			if (static_cast<IndexType>(local_neighbors.size()) < k)
+			{
+				candidates.clear();
+				for (::index_t j=0; j<end-begin; ++j)
+				{
+					if (j != i)
+						candidates.push_back(std::make_pair(callback.distance(begin+j, query), j));
+				}
+				std::partial_sort(candidates.begin(), candidates.begin()+k, candidates.end());
+				local_neighbors.clear();
+				for (IndexType j=0; j<k; ++j)
+					local_neighbors.push_back(candidates[j].second);
+			}
+			neighbors[i] = local_neighbors;
+		}
+	});
+	SG_UNREF(parallel);
+	SG_UNREF(index);
+
+	return neighbors;
+}
+
+} // End of namespace tapkee_internal
+} // End of namespace tapkee
+
+#endif
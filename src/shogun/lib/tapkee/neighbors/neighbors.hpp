@@ -13,6 +13,7 @@
 #endif
 #include <shogun/lib/tapkee/neighbors/connected.hpp>
 #include <shogun/lib/tapkee/neighbors/vptree.hpp>
+#include <shogun/lib/tapkee/neighbors/hnsw.hpp>
 /* End of Tapkee includes */
 
 #include <vector>
@@ -186,6 +187,7 @@ Neighbors find_neighbors(NeighborsMethod method, const RandomAccessIterator& beg
 	{
 		case Brute: neighbors = find_neighbors_bruteforce_impl(begin,end,callback,k); break;
 		case VpTree: neighbors = find_neighbors_vptree_impl(begin,end,callback,k); break;
+		case Hnsw: neighbors = find_neighbors_hnsw_impl(begin,end,callback,k); break;
 #ifdef USE_GPL_SHOGUN
 		case CoverTree: neighbors = find_neighbors_covertree_impl(begin,end,callback,k); break;
 #endif
@@ -81,6 +81,21 @@ CDenseFeatures<float64_t>* shogun::tapkee_embed(const shogun::TAPKEE_PARAMETERS_
 	tapkee::EigenMethod eigen_method = tapkee::Dense;
 #endif
 	tapkee::NeighborsMethod neighbors_method = tapkee::CoverTree;
+	switch (parameters.neighbors_method)
+	{
+		case NEIGHBORS_BRUTE:
+			neighbors_method = tapkee::Brute;
+			break;
+		case NEIGHBORS_VP_TREE:
+			neighbors_method = tapkee::VpTree;
+			break;
+		case NEIGHBORS_COVER_TREE:
+			neighbors_method = tapkee::CoverTree;
+			break;
+		case NEIGHBORS_HNSW:
+			neighbors_method = tapkee::Hnsw;
+			break;
+	}
 	size_t N = 0;
 
 	switch (parameters.method)
@@ -10,6 +10,7 @@
 
 
 #include <shogun/io/SGIO.h>
+#include <shogun/converter/EmbeddingConverter.h>
 #include <shogun/kernel/Kernel.h>
 #include <shogun/distance/Distance.h>
 #include <shogun/features/DenseFeatures.h>
@@ -44,7 +45,8 @@ struct TAPKEE_PARAMETERS_FOR_SHOGUN
 {
 	TAPKEE_PARAMETERS_FOR_SHOGUN() :
 		method(SHOGUN_KERNEL_LOCALLY_LINEAR_EMBEDDING),
-		n_neighbors(10), n_timesteps(3),
+		n_neighbors(10), neighbors_method(NEIGHBORS_COVER_TREE),
+		n_timesteps(3),
 		target_dimension(2), spe_num_updates(100),
 		eigenshift(1e-9), landmark_ratio(0.5),
 		gaussian_kernel_width(1.0), spe_tolerance(1e-5),
@@ -56,6 +58,7 @@ struct TAPKEE_PARAMETERS_FOR_SHOGUN
 	}
 	TAPKEE_METHODS_FOR_SHOGUN method;
 	uint32_t n_neighbors;
+	ENeighborsMethod neighbors_method;
 	uint32_t n_timesteps;
 	uint32_t target_dimension;
 	uint32_t spe_num_updates;
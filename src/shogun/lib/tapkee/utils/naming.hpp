@@ -45,6 +45,7 @@ std::string get_neighbors_method_name(NeighborsMethod m)
 	{
 		case Brute: return "Brute-force";
 		case VpTree: return "VP-tree";
+		case Hnsw: return "HNSW graph";
 #ifdef TAPKEE_USE_LGPL_COVERTREE
 		case CoverTree: return "Cover Tree";
 #endif
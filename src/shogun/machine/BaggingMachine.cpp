@@ -5,11 +5,14 @@
  *          Olivier NGuyen, Bjoern Esser, Weijie Lin
  */
 
+#include <shogun/base/Parallel.h>
 #include <shogun/base/progress.h>
 #include <shogun/ensemble/CombinationRule.h>
 #include <shogun/ensemble/MeanRule.h>
 #include <shogun/machine/BaggingMachine.h>
 #include <shogun/mathematics/linalg/LinalgNamespace.h>
+#include <shogun/multiclass/tree/CARTree.h>
+#include <shogun/multiclass/tree/FlatTreeEnsemble.h>
 
 #include <shogun/evaluation/Evaluation.h>
 
@@ -41,6 +44,7 @@ CBaggingMachine::~CBaggingMachine()
 	SG_UNREF(m_combination_rule);
 	SG_UNREF(m_bags);
 	SG_UNREF(m_oob_indices);
+	SG_UNREF(m_flat_trees);
 }
 
 CBinaryLabels* CBaggingMachine::apply_binary(CFeatures* data)
@@ -122,26 +126,32 @@ CBaggingMachine::apply_outputs_without_combination(CFeatures* data)
 {
 	ASSERT(m_num_bags == m_bags->get_num_elements());
 
+	if (m_flat_trees)
+		return m_flat_trees->apply_trees(data->as<CDenseFeatures<float64_t>>());
+
 	SGMatrix<float64_t> output(data->get_num_vectors(), m_num_bags);
 	output.zero();
 
-	#pragma omp parallel for
-	for (int32_t i = 0; i < m_num_bags; ++i)
+	// one task per bag, parallel loops inside the bags share the same threads
+	parallel->parallel_for(0, m_num_bags, [&](int64_t begin, int64_t end)
 	{
-		CMachine* m = dynamic_cast<CMachine*>(m_bags->get_element(i));
-		CLabels* l = m->apply(data);
-		SGVector<float64_t> lv;
-		if (l!=NULL)
-			lv = dynamic_cast<CDenseLabels*>(l)->get_labels();
-		else
-			SG_ERROR("NULL returned by apply method\n");
-
-		float64_t* bag_results = output.get_column_vector(i);
-		sg_memcpy(bag_results, lv.vector, lv.vlen*sizeof(float64_t));
-
-		SG_UNREF(l);
-		SG_UNREF(m);
-	}
+		for (int64_t i = begin; i < end; ++i)
+		{
+			CMachine* m = dynamic_cast<CMachine*>(m_bags->get_element(i));
+			CLabels* l = m->apply(data);
+			SGVector<float64_t> lv;
+			if (l!=NULL)
+				lv = dynamic_cast<CDenseLabels*>(l)->get_labels();
+			else
+				SG_ERROR("NULL returned by apply method\n");
+
+			float64_t* bag_results = output.get_column_vector(i);
+			sg_memcpy(bag_results, lv.vector, lv.vlen*sizeof(float64_t));
+
+			SG_UNREF(l);
+			SG_UNREF(m);
+		}
+	}, 1);
 
 	return output;
 }
@@ -151,6 +161,9 @@ bool CBaggingMachine::train_machine(CFeatures* data)
 	REQUIRE(m_machine != NULL, "Machine is not set!");
 	REQUIRE(m_num_bags > 0, "Number of bag is not set!");
 
+	SG_UNREF(m_flat_trees);
+	m_flat_trees = NULL;
+
 	if (data)
 	{
 		SG_REF(data);
@@ -268,6 +281,9 @@ void CBaggingMachine::register_parameters()
 	SG_ADD(
 	    &m_oob_indices, "oob_indices", "OOB indices for each machine",
 	    MS_NOT_AVAILABLE);
+	SG_ADD(
+	    (CSGObject**)&m_flat_trees, "flat_trees",
+	    "Bags compiled for prediction", MS_NOT_AVAILABLE);
 }
 
 void CBaggingMachine::set_num_bags(int32_t num_bags)
@@ -314,6 +330,7 @@ void CBaggingMachine::init()
 	m_bag_size = 0;
 	m_all_oob_idx = SGVector<bool>();
 	m_oob_indices = NULL;
+	m_flat_trees = NULL;
 }
 
 void CBaggingMachine::set_combination_rule(CCombinationRule* rule)
@@ -329,6 +346,41 @@ CCombinationRule* CBaggingMachine::get_combination_rule() const
 	return m_combination_rule;
 }
 
+void CBaggingMachine::compile_trees()
+{
+	REQUIRE(m_bags->get_num_elements() > 0, "BaggingMachine is not trained!\n");
+
+	CFlatTreeEnsemble* flat_trees = new CFlatTreeEnsemble();
+	SG_REF(flat_trees);
+	for (int32_t i = 0; i < m_bags->get_num_elements(); ++i)
+	{
+		CSGObject* bag = m_bags->get_element(i);
+		CCARTree* tree = dynamic_cast<CCARTree*>(bag);
+		if (!tree)
+		{
+			const char* name = bag->get_name();
+			SG_UNREF(bag);
+			SG_UNREF(flat_trees);
+			SG_ERROR("Bag %d is a %s, only CARTree bags can be compiled\n",
+				i, name);
+		}
+
+		flat_trees->add_tree(tree);
+		SG_UNREF(bag);
+	}
+
+	SG_UNREF(m_flat_trees);
+	m_flat_trees = flat_trees;
+
+	SG_DEBUG("Compiled %d trees into %d nodes\n",
+		m_flat_trees->get_num_trees(), m_flat_trees->get_num_nodes());
+}
+
+bool CBaggingMachine::is_compiled() const
+{
+	return m_flat_trees != NULL;
+}
+
 float64_t CBaggingMachine::get_oob_error(CEvaluation* eval) const
 {
 	REQUIRE(m_combination_rule != NULL, "Combination rule is not set!");
@@ -17,6 +17,7 @@ namespace shogun
 {
 	class CCombinationRule;
 	class CEvaluation;
+	class CFlatTreeEnsemble;
 
 	/**
 	 * @brief: Bagging algorithm
@@ -115,6 +116,16 @@ namespace shogun
 			 */
 			float64_t get_oob_error(CEvaluation* eval) const;
 
+			/** convert the trained bags into a flat node table, which is
+			 * used by all subsequent apply calls instead of the bags.
+			 * All bags have to be CCARTree instances. Training again
+			 * drops the table.
+			 */
+			void compile_trees();
+
+			/** @return whether the bags were compiled into a flat node table */
+			bool is_compiled() const;
+
 			/** name **/
 			virtual const char* get_name() const { return "BaggingMachine"; }
 
@@ -186,6 +197,9 @@ namespace shogun
 
 			/** array of oob indices */
 			CDynamicObjectArray* m_oob_indices;
+
+			/** bags compiled for prediction */
+			CFlatTreeEnsemble* m_flat_trees;
 	};
 }
 
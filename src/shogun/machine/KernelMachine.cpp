@@ -7,6 +7,7 @@
  */
 
 #include <rxcpp/rx-lite.hpp>
+#include <shogun/base/Parallel.h>
 #include <shogun/base/progress.h>
 #include <shogun/io/SGIO.h>
 #include <shogun/kernel/CustomKernel.h>
@@ -14,12 +15,15 @@
 #include <shogun/labels/Labels.h>
 #include <shogun/labels/RegressionLabels.h>
 #include <shogun/machine/KernelMachine.h>
+#include <shogun/mathematics/linalg/LinalgNamespace.h>
 
 #ifdef HAVE_OPENMP
 #include <omp.h>
 
 #endif
 
+#include <vector>
+
 using namespace shogun;
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
@@ -78,6 +82,7 @@ CKernelMachine::~CKernelMachine()
 	SG_UNREF(kernel);
 	SG_UNREF(m_custom_kernel);
 	SG_UNREF(m_kernel_backup);
+	SG_UNREF(m_locked_kernel);
 }
 
 void CKernelMachine::set_kernel(CKernel* k)
@@ -113,6 +118,25 @@ bool CKernelMachine::get_linadd_enabled()
     return use_linadd;
 }
 
+void CKernelMachine::set_reuse_locked_kernel(bool reuse)
+{
+	m_reuse_locked_kernel=reuse;
+
+	/* drop a kept kernel matrix */
+	if (!reuse && !is_data_locked())
+	{
+		SG_UNREF(m_custom_kernel);
+		m_custom_kernel=NULL;
+		SG_UNREF(m_locked_kernel);
+		m_locked_kernel=NULL;
+	}
+}
+
+bool CKernelMachine::get_reuse_locked_kernel() const
+{
+	return m_reuse_locked_kernel;
+}
+
 void CKernelMachine::set_bias_enabled(bool enable_bias)
 {
     use_bias=enable_bias;
@@ -241,6 +265,154 @@ bool CKernelMachine::init_kernel_optimization()
 	return false;
 }
 
+float64_t CKernelMachine::reduce_support_vectors(int32_t budget)
+{
+	REQUIRE(kernel, "%s::reduce_support_vectors(): No kernel assigned!\n",
+			get_name())
+	REQUIRE(budget>0, "%s::reduce_support_vectors(): Budget (%d) must be "
+			"positive\n", get_name(), budget)
+
+	int32_t num_sv=get_num_support_vectors();
+	if (num_sv<=budget)
+		return 0;
+
+	CFeatures* lhs=kernel->get_lhs();
+	REQUIRE(lhs, "%s::reduce_support_vectors(): No left hand side specified\n",
+			get_name())
+	CFeatures* rhs=kernel->get_rhs();
+
+	/* the kernel is evaluated between support vectors, i.e. between left
+	 * hand side vectors. A custom kernel cannot be re-initialized with other
+	 * features, so it has to hold the kernel matrix of the training data */
+	bool custom=kernel->get_kernel_type()==K_CUSTOM;
+	if (custom && kernel->get_num_vec_lhs()!=kernel->get_num_vec_rhs())
+	{
+		SG_UNREF(lhs);
+		SG_UNREF(rhs);
+		SG_ERROR("%s::reduce_support_vectors(): The custom kernel has to "
+				"hold the kernel matrix of the training data, not a %dx%d "
+				"matrix\n", get_name(), kernel->get_num_vec_lhs(),
+				kernel->get_num_vec_rhs())
+	}
+	bool reinit=!custom && rhs!=lhs;
+	/* a linadd optimization holds the old expansion and is rebuilt */
+	bool optimized=kernel->get_is_initialized();
+	if (optimized)
+		kernel->delete_optimization();
+	if (reinit)
+		kernel->init(lhs, lhs);
+
+	SGVector<float64_t> alpha(num_sv);
+	for (int32_t i=0; i<num_sv; i++)
+		alpha[i]=get_alpha(i);
+
+	// c_i=<w,phi(x_i)>, later the correlation of x_i with the residual of w,
+	// and the squared distance d_i of phi(x_i) to the span of the selected
+	// vectors
+	SGVector<float64_t> c(num_sv);
+	SGVector<float64_t> d(num_sv);
+	parallel->parallel_for(0, num_sv, [&](int64_t first, int64_t last)
+	{
+		for (int64_t i=first; i<last; i++)
+		{
+			float64_t sum=0;
+			for (int32_t j=0; j<num_sv; j++)
+				sum+=alpha[j]*kernel->kernel(m_svs[j], m_svs[i]);
+			c[i]=sum;
+			d[i]=kernel->kernel(m_svs[i], m_svs[i]);
+		}
+	});
+	float64_t norm2=linalg::dot(alpha, c);
+	float64_t min_diag=1e-12*CMath::max(d.vector, d.vlen);
+
+	SGMatrix<float64_t> G(num_sv, budget);
+	SGVector<index_t> selected(budget);
+	SGVector<float64_t> z(budget);
+	std::vector<bool> is_selected(num_sv, false);
+	float64_t captured=0;
+	int32_t num_selected=0;
+	for (; num_selected<budget; num_selected++)
+	{
+		// adding x_p reduces ||w-w'||^2 by c_p^2/d_p
+		index_t p=-1;
+		float64_t best_gain=0;
+		for (index_t i=0; i<num_sv; i++)
+		{
+			if (!is_selected[i] && d[i]>min_diag && c[i]*c[i]/d[i]>best_gain)
+			{
+				best_gain=c[i]*c[i]/d[i];
+				p=i;
+			}
+		}
+		if (p==-1)
+			break;
+
+		// next column of the pivoted Cholesky factor, all columns so far are
+		// subtracted chunk by chunk
+		int32_t t=num_selected;
+		float64_t sqrt_d=std::sqrt(d[p]);
+		float64_t* g=G.get_column_vector(t);
+		parallel->parallel_for(0, num_sv, [&](int64_t first, int64_t last)
+		{
+			for (int64_t i=first; i<last; i++)
+				g[i]=kernel->kernel(m_svs[i], m_svs[p]);
+
+			for (int32_t s=0; s<t; s++)
+			{
+				const float64_t* col=G.get_column_vector(s);
+				float64_t G_ps=G(p, s);
+				for (int64_t i=first; i<last; i++)
+					g[i]-=G_ps*col[i];
+			}
+
+			for (int64_t i=first; i<last; i++)
+				g[i]/=sqrt_d;
+		});
+
+		z[t]=c[p]/sqrt_d;
+		for (index_t i=0; i<num_sv; i++)
+		{
+			c[i]-=z[t]*g[i];
+			d[i]-=g[i]*g[i];
+		}
+
+		captured+=z[t]*z[t];
+		selected[t]=p;
+		is_selected[p]=true;
+	}
+
+	/* K_SS=LL^T with L(s,u)=G(selected[s],u) and the correlations of the
+	 * selected vectors with w are Lz, the projection of w has the weights
+	 * beta=K_SS^{-1}Lz=L^{-T}z */
+	SGVector<float64_t> beta(num_selected);
+	SGVector<int32_t> svs(num_selected);
+	for (int32_t s=num_selected-1; s>=0; s--)
+	{
+		float64_t v=z[s];
+		for (int32_t u=s+1; u<num_selected; u++)
+			v-=G(selected[u], s)*beta[u];
+		beta[s]=v/G(selected[s], s);
+		svs[s]=get_support_vector(selected[s]);
+	}
+
+	if (reinit)
+		kernel->init(lhs, rhs ? rhs : lhs);
+	SG_UNREF(lhs);
+	SG_UNREF(rhs);
+
+	set_support_vectors(svs);
+	set_alphas(beta);
+	if (optimized)
+		init_kernel_optimization();
+
+	float64_t error=norm2>0 ?
+		std::sqrt(CMath::max(0.0, norm2-captured)/norm2) : 0;
+	SG_INFO("Reduced %d support vectors to %d, relative error %f\n", num_sv,
+			num_selected, error)
+
+	return error;
+}
+
 CRegressionLabels* CKernelMachine::apply_regression(CFeatures* data)
 {
 	SGVector<float64_t> outputs = apply_get_outputs(data);
@@ -331,7 +503,7 @@ SGVector<float64_t> CKernelMachine::apply_get_outputs(CFeatures* data)
 				output[i] = get_bias() + output[i];
 
 		}
-		else
+		else if (kernel->has_property(KP_LINADD) && kernel->get_is_initialized())
 		{
 			auto pb = SG_PROGRESS(range(num_vectors));
 			int32_t num_threads;
@@ -362,26 +534,28 @@ SGVector<float64_t> CKernelMachine::apply_get_outputs(CFeatures* data)
 					COMPUTATION_CONTROLLERS
 					pb.print_progress();
 
-					ASSERT(kernel)
-					if (kernel->has_property(KP_LINADD) &&
-					    (kernel->get_is_initialized()))
-					{
-						float64_t score = kernel->compute_optimized(vec);
-						output[vec] = score + get_bias();
-					}
-					else
-					{
-						float64_t score = 0;
-						for (int32_t i = 0; i < get_num_support_vectors(); i++)
-							score +=
-							    kernel->kernel(get_support_vector(i), vec) *
-							    get_alpha(i);
-						output[vec] = score + get_bias();
-					}
+					float64_t score = kernel->compute_optimized(vec);
+					output[vec] = score + get_bias();
 				}
 			}
 			pb.complete();
 		}
+		else
+		{
+			// support vectors and test vectors are processed in tiles
+			int32_t num_sv=get_num_support_vectors();
+			SGVector<index_t> sv_idx(num_sv);
+			SGVector<float64_t> sv_weight(num_sv);
+			for (int32_t i=0; i<num_sv; i++)
+			{
+				sv_idx[i]=get_support_vector(i);
+				sv_weight[i]=get_alpha(i);
+			}
+
+			output=kernel->compute_expansion(sv_idx, sv_weight, this);
+			for (int32_t i=0; i<output.vlen; i++)
+				output[i]+=get_bias();
+		}
 	}
 
 	SG_DEBUG("leaving %s::apply_get_outputs(%s at %p)\n",
@@ -559,17 +733,37 @@ void CKernelMachine::data_lock(CLabels* labs, CFeatures* features)
 	/* init kernel with data */
 	kernel->init(features, features);
 
+	/* the kept kernel matrix is still valid if neither the kernel nor its
+	 * parameters, which include the features, changed since it was computed */
+	bool reuse=m_reuse_locked_kernel && m_custom_kernel &&
+			m_locked_kernel==kernel && !kernel->parameter_hash_changed();
+
 	/* backup reference to old kernel */
 	SG_UNREF(m_kernel_backup)
 	m_kernel_backup=kernel;
 	SG_REF(m_kernel_backup);
 
-	/* unref possible old custom kernel */
-	SG_UNREF(m_custom_kernel);
-
-	/* create custom kernel matrix from current kernel */
-	m_custom_kernel=new CCustomKernel(kernel);
-	SG_REF(m_custom_kernel);
+	if (reuse)
+	{
+		SG_DEBUG("Reusing kernel matrix of previous data lock\n")
+		m_custom_kernel->remove_all_row_subsets();
+		m_custom_kernel->remove_all_col_subsets();
+	}
+	else
+	{
+		/* unref possible old custom kernel */
+		SG_UNREF(m_custom_kernel);
+
+		/* create custom kernel matrix from current kernel */
+		m_custom_kernel=new CCustomKernel(kernel);
+		SG_REF(m_custom_kernel);
+
+		SG_REF(kernel);
+		SG_UNREF(m_locked_kernel);
+		m_locked_kernel=kernel;
+		if (m_reuse_locked_kernel)
+			m_locked_kernel->update_parameter_hash();
+	}
 
 	/* replace kernel by custom kernel */
 	SG_UNREF(kernel);
@@ -582,8 +776,14 @@ void CKernelMachine::data_lock(CLabels* labs, CFeatures* features)
 
 void CKernelMachine::data_unlock()
 {
-	SG_UNREF(m_custom_kernel);
-	m_custom_kernel=NULL;
+	/* keep the kernel matrix for the next data lock if desired */
+	if (!m_reuse_locked_kernel)
+	{
+		SG_UNREF(m_custom_kernel);
+		m_custom_kernel=NULL;
+		SG_UNREF(m_locked_kernel);
+		m_locked_kernel=NULL;
+	}
 
 	/* restore original kernel, possibly delete created one */
 	if (m_kernel_backup)
@@ -606,6 +806,8 @@ void CKernelMachine::init()
 	kernel=NULL;
 	m_custom_kernel=NULL;
 	m_kernel_backup=NULL;
+	m_locked_kernel=NULL;
+	m_reuse_locked_kernel=false;
 	use_batch_computation=true;
 	use_linadd=true;
 	use_bias=true;
@@ -615,6 +817,10 @@ void CKernelMachine::init()
 			" data lock", MS_NOT_AVAILABLE);
 	SG_ADD((CSGObject**) &m_kernel_backup, "kernel_backup",
 			"Kernel backup for data lock", MS_NOT_AVAILABLE);
+	SG_ADD((CSGObject**) &m_locked_kernel, "locked_kernel",
+			"Kernel the custom kernel was computed from", MS_NOT_AVAILABLE);
+	SG_ADD(&m_reuse_locked_kernel, "reuse_locked_kernel",
+			"Whether the locked kernel matrix is reused", MS_NOT_AVAILABLE);
 	SG_ADD(&use_batch_computation, "use_batch_computation",
 			"Batch computation is enabled.", MS_NOT_AVAILABLE);
 	SG_ADD(&use_linadd, "use_linadd", "Linadd is enabled.", MS_NOT_AVAILABLE);
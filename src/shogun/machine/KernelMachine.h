@@ -113,6 +113,18 @@ class CKernelMachine : public CMachine
 		 */
 		bool get_linadd_enabled();
 
+		/** set whether the kernel matrix computed by data_lock() is kept
+		 * after data_unlock() and reused by the next data_lock() if the
+		 * kernel and its parameters did not change in between, e.g. when
+		 * only C is changed between evaluations during model selection
+		 *
+		 * @param reuse whether to reuse the locked kernel matrix
+		 */
+		void set_reuse_locked_kernel(bool reuse);
+
+		/** @return whether the locked kernel matrix is reused */
+		bool get_reuse_locked_kernel() const;
+
 		/** set state of bias
 		 *
 		 * @param enable_bias if bias shall be enabled
@@ -203,6 +215,30 @@ class CKernelMachine : public CMachine
 		 */
 		bool init_kernel_optimization();
 
+		/** compress the kernel expansion to a budget of support vectors
+		 *
+		 * Support vectors are selected greedily, each one the vector whose
+		 * span reduces the feature space distance \f$\|w-w'\|\f$ of the
+		 * original \f$w=\sum_i\alpha_i\phi(x_i)\f$ and the reduced
+		 * expansion \f$w'\f$ the most (a pivoted Cholesky factorization of
+		 * the kernel matrix of the support vectors). The weights of the kept
+		 * vectors are then refitted to the projection of \f$w\f$ onto
+		 * their span. The bias is kept.
+		 *
+		 * Outputs change by at most \f$\|w-w'\|\sqrt{k(x,x)}\f$, so that
+		 * e.g. the outputs of Gaussian kernel machines change by at most
+		 * \f$\|w-w'\|\f$.
+		 *
+		 * The kernel is evaluated between the support vectors on its left
+		 * hand side, which works for all features. A CCustomKernel has to
+		 * hold the square kernel matrix of the training data. An
+		 * initialized linadd optimization is rebuilt for the new expansion.
+		 *
+		 * @param budget maximal number of support vectors to keep
+		 * @return relative approximation error \f$\|w-w'\|/\|w\|\f$
+		 */
+		float64_t reduce_support_vectors(int32_t budget);
+
 		/** apply kernel machine to data
 		 * for regression task
 		 *
@@ -311,6 +347,12 @@ class CKernelMachine : public CMachine
 		/** old kernel is stored here on data lock */
 		CKernel* m_kernel_backup;
 
+		/** kernel m_custom_kernel was computed from */
+		CKernel* m_locked_kernel;
+
+		/** whether m_custom_kernel is kept for the next data lock */
+		bool m_reuse_locked_kernel;
+
 		/** if batch computation is enabled */
 		bool use_batch_computation;
 
@@ -7,22 +7,34 @@
  */
 
 #include <shogun/machine/OnlineLinearMachine.h>
+#include <shogun/base/Parallel.h>
 #include <shogun/base/Parameter.h>
+#include <shogun/features/streaming/StreamingDenseFeatures.h>
+#include <shogun/features/streaming/StreamingSparseFeatures.h>
 #include <shogun/labels/RegressionLabels.h>
 #include <shogun/mathematics/Math.h>
 #include <shogun/mathematics/linalg/LinalgNamespace.h>
 
+#include <algorithm>
 #include <vector>
 
 using namespace shogun;
 
+/** examples per learner and batch when training with several learners */
+static const int32_t LEARNER_BATCH_SIZE=256;
+
 COnlineLinearMachine::COnlineLinearMachine()
-: CMachine(), bias(0), features(NULL)
+: CMachine(), bias(0), features(NULL), m_num_learners(1),
+	m_average_learners(false)
 {
 	SG_ADD(&m_w, "m_w", "Parameter vector w.", MS_NOT_AVAILABLE);
 	SG_ADD(&bias, "bias", "Bias b.", MS_NOT_AVAILABLE);
 	SG_ADD((CSGObject**) &features, "features",
 	    "Feature object.", MS_NOT_AVAILABLE);
+	SG_ADD(&m_num_learners, "num_learners", "Number of learner threads.",
+	    MS_NOT_AVAILABLE);
+	SG_ADD(&m_average_learners, "average_learners",
+	    "Whether learners average private weights.", MS_NOT_AVAILABLE);
 }
 
 COnlineLinearMachine::~COnlineLinearMachine()
@@ -93,10 +105,15 @@ bool COnlineLinearMachine::train_machine(CFeatures *data)
 	}
 	start_train();
 	features->start_parser();
-	while (features->get_next_example())
+	if (m_num_learners>1)
+		train_learners();
+	else
 	{
-		train_example(features, features->get_label());
-		features->release_example();
+		while (features->get_next_example())
+		{
+			train_example(features, features->get_label());
+			features->release_example();
+		}
 	}
 
 	features->end_parser();
@@ -104,3 +121,141 @@ bool COnlineLinearMachine::train_machine(CFeatures *data)
 
 	return true;
 }
+
+void COnlineLinearMachine::set_num_learners(int32_t num_learners)
+{
+	REQUIRE(num_learners>0, "Number of learners (%d) must be positive\n",
+		num_learners)
+	m_num_learners=num_learners;
+}
+
+void COnlineLinearMachine::train_learners()
+{
+	int32_t num_learners=m_num_learners;
+	std::vector<std::vector<SGSparseVectorEntry<float32_t> > > examples(
+		int64_t(num_learners)*LEARNER_BATCH_SIZE);
+	std::vector<float64_t> labels(examples.size());
+	std::vector<SGVector<float32_t> > weights(m_average_learners ? num_learners : 0);
+	/* features each learner touched in the batch and its change of them */
+	std::vector<std::vector<int32_t> > touched(weights.size());
+	std::vector<std::vector<float32_t> > deltas(weights.size());
+	std::vector<float32_t> biases(num_learners);
+
+	int32_t num_examples;
+	while ((num_examples=read_examples(examples, labels))>0)
+	{
+		int32_t grain=(num_examples+num_learners-1)/num_learners;
+		int32_t num_active=(num_examples+grain-1)/grain;
+
+		// one task per learner, the pool may also run all of them in one call
+		parallel->parallel_for(0, num_active, [&](int64_t first, int64_t last)
+		{
+			for (int32_t learner=first; learner<last; learner++)
+			{
+				int64_t begin=int64_t(learner)*grain;
+				int64_t end=CMath::min(begin+grain, int64_t(num_examples));
+
+				float32_t* w=m_w.vector;
+				if (m_average_learners)
+				{
+					// learners only change the weights of the features of
+					// their examples, so only those are copied
+					std::vector<int32_t>& idx=touched[learner];
+					idx.clear();
+					for (int64_t i=begin; i<end; i++)
+					{
+						for (const auto& entry: examples[i])
+							idx.push_back(entry.feat_index);
+					}
+					std::sort(idx.begin(), idx.end());
+					idx.erase(std::unique(idx.begin(), idx.end()), idx.end());
+
+					if (weights[learner].vlen!=m_w.vlen)
+						weights[learner]=SGVector<float32_t>(m_w.vlen);
+					w=weights[learner].vector;
+					for (int32_t j: idx)
+						w[j]=m_w[j];
+				}
+
+				biases[learner]=bias;
+				for (int64_t i=begin; i<end; i++)
+				{
+					SGSparseVector<float32_t> example(examples[i].data(),
+						examples[i].size(), false);
+					train_learner_example(learner, example, labels[i], w,
+						biases[learner]);
+				}
+
+				if (m_average_learners)
+				{
+					const std::vector<int32_t>& idx=touched[learner];
+					deltas[learner].resize(idx.size());
+					for (size_t k=0; k<idx.size(); k++)
+						deltas[learner][k]=w[idx[k]]-m_w[idx[k]];
+				}
+			}
+		}, 1);
+
+		if (m_average_learners)
+		{
+			// the average of the private weights, learners that did not
+			// touch a feature kept its shared weight
+			for (int32_t k=0; k<num_active; k++)
+			{
+				const std::vector<int32_t>& idx=touched[k];
+				for (size_t i=0; i<idx.size(); i++)
+					m_w[idx[i]]+=deltas[k][i]/num_active;
+			}
+		}
+
+		// shared weights already hold the sum of all updates, the biases
+		// are combined the same way
+		float32_t bias_update=0;
+		for (int32_t k=0; k<num_active; k++)
+			bias_update+=biases[k]-bias;
+		bias+=m_average_learners ? bias_update/num_active : bias_update;
+
+		end_learner_batch(num_examples);
+	}
+}
+
+int32_t COnlineLinearMachine::read_examples(
+	std::vector<std::vector<SGSparseVectorEntry<float32_t> > >& examples,
+	std::vector<float64_t>& labels)
+{
+	EFeatureClass feature_class=features->get_feature_class();
+	REQUIRE(feature_class==C_STREAMING_DENSE || feature_class==C_STREAMING_SPARSE,
+		"Several learners require streaming dense or sparse features\n")
+	REQUIRE(features->get_feature_type()==F_SHORTREAL,
+		"Several learners require float32 features\n")
+
+	int32_t num=0;
+	while (num<int32_t(examples.size()) && features->get_next_example())
+	{
+		features->expand_if_required(m_w.vector, m_w.vlen);
+		labels[num]=features->get_label();
+
+		std::vector<SGSparseVectorEntry<float32_t> >& example=examples[num];
+		example.clear();
+		if (feature_class==C_STREAMING_DENSE)
+		{
+			SGVector<float32_t> vec=((CStreamingDenseFeatures<float32_t>*)
+				features)->get_vector();
+			for (int32_t j=0; j<vec.vlen; j++)
+			{
+				if (vec[j]!=0)
+					example.push_back({j, vec[j]});
+			}
+		}
+		else
+		{
+			SGSparseVector<float32_t> vec=((CStreamingSparseFeatures<float32_t>*)
+				features)->get_vector();
+			example.assign(vec.features, vec.features+vec.num_feat_entries);
+		}
+
+		features->release_example();
+		num++;
+	}
+	return num;
+}
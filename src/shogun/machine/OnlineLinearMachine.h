@@ -13,8 +13,11 @@
 
 #include <shogun/lib/common.h>
 #include <shogun/features/streaming/StreamingDotFeatures.h>
+#include <shogun/lib/SGSparseVector.h>
 #include <shogun/machine/Machine.h>
 
+#include <vector>
+
 
 namespace shogun
 {
@@ -47,6 +50,20 @@ class CRegressionLabels;
  *		f({\bf x})= {\bf w} \cdot \Phi({\bf x}) + b.
  *	\f]
  *
+ * Machines implementing train_learner_example() can train with several
+ * learner threads. The examples are then copied out of the stream in
+ * batches, which streaming dense and sparse float32 features support, and
+ * each learner trains on its share of a batch. By default the learners
+ * update the shared weights without locks (Hogwild), which works well when
+ * the examples are sparse, see
+ *
+ * Niu, F., Recht, B., Re, C. and Wright, S. J. (2011). Hogwild!: A
+ * lock-free approach to parallelizing stochastic gradient descent. NIPS.
+ *
+ * Alternatively the learners train private copies of the weights which are
+ * averaged after each batch. Only the weights of the features that occur in
+ * the batch are copied and averaged, so that a batch costs time in the
+ * number of its nonzero entries rather than in the dimension.
  * */
 class COnlineLinearMachine : public CMachine
 {
@@ -211,6 +228,30 @@ class COnlineLinearMachine : public CMachine
 			return false;
 		}
 
+		/** set the number of learner threads, more than one requires
+		 * train_learner_example() and streaming dense or sparse float32
+		 * features
+		 *
+		 * @param num_learners number of learners, 1 trains sequentially
+		 */
+		void set_num_learners(int32_t num_learners);
+
+		/** @return number of learner threads */
+		int32_t get_num_learners() const { return m_num_learners; }
+
+		/** set whether the learners average private copies of the
+		 * weights after each batch instead of sharing them
+		 *
+		 * @param average_learners whether to average
+		 */
+		void set_average_learners(bool average_learners)
+		{
+			m_average_learners=average_learners;
+		}
+
+		/** @return whether the learners average private weights */
+		bool get_average_learners() const { return m_average_learners; }
+
 	protected:
 		/**
 		 * Train classifier
@@ -229,6 +270,47 @@ class COnlineLinearMachine : public CMachine
 		 */
 		SGVector<float64_t> apply_get_outputs(CFeatures* data);
 
+		/** train the learners on all examples of the started stream, see
+		 * set_num_learners()
+		 */
+		void train_learners();
+
+		/** train a learner on one example. Called concurrently for
+		 * different learners, which may race on shared weights. Only the
+		 * weights of the features of the example may be changed, updates
+		 * of all weights belong into end_learner_batch().
+		 *
+		 * @param learner index of the learner
+		 * @param example example copied out of the stream
+		 * @param label label of the example
+		 * @param w weights the learner updates, of length m_w.vlen
+		 * @param b bias the learner updates
+		 */
+		virtual void train_learner_example(int32_t learner,
+				const SGSparseVector<float32_t>& example, float64_t label,
+				float32_t* w, float32_t& b)
+		{
+			SG_NOTIMPLEMENTED
+		}
+
+		/** called after the learners finished a batch and their weights
+		 * and biases were combined
+		 *
+		 * @param num_examples number of examples in the batch
+		 */
+		virtual void end_learner_batch(int32_t num_examples) { }
+
+	private:
+		/** copy the next examples of the stream, expanding w as needed
+		 *
+		 * @param examples written with the non-zero entries
+		 * @param labels written with the labels
+		 * @return number of examples read
+		 */
+		int32_t read_examples(
+				std::vector<std::vector<SGSparseVectorEntry<float32_t> > >& examples,
+				std::vector<float64_t>& labels);
+
 	protected:
 		/** w */
 		SGVector<float32_t> m_w;
@@ -236,6 +318,12 @@ class COnlineLinearMachine : public CMachine
 		float32_t bias;
 		/** features */
 		CStreamingDotFeatures* features;
+
+		/** number of learner threads */
+		int32_t m_num_learners;
+
+		/** whether the learners average private weights */
+		bool m_average_learners;
 };
 }
 #endif
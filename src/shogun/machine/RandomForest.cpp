@@ -139,6 +139,18 @@ int32_t CRandomForest::get_num_random_features() const
 	return dynamic_cast<CRandomCARTree*>(m_machine)->get_feature_subset_size();
 }
 
+void CRandomForest::set_num_bins(int32_t num_bins)
+{
+	REQUIRE(m_machine,"m_machine is NULL. It is expected to be RandomCARTree\n")
+	dynamic_cast<CRandomCARTree*>(m_machine)->set_num_bins(num_bins);
+}
+
+int32_t CRandomForest::get_num_bins() const
+{
+	REQUIRE(m_machine,"m_machine is NULL. It is expected to be RandomCARTree\n")
+	return dynamic_cast<CRandomCARTree*>(m_machine)->get_num_bins();
+}
+
 void CRandomForest::set_machine_parameters(CMachine* m, SGVector<index_t> idx)
 {
 	REQUIRE(m,"Machine supplied is NULL\n")
@@ -159,7 +171,10 @@ void CRandomForest::set_machine_parameters(CMachine* m, SGVector<index_t> idx)
 	}
 
 	tree->set_weights(weights);
-	tree->set_sorted_features(m_sorted_transposed_feats, m_sorted_indices);
+	if (tree->get_num_bins()>0)
+		tree->set_binned_features(m_binned_feats, m_bin_thresholds);
+	else
+		tree->set_sorted_features(m_sorted_transposed_feats, m_sorted_indices);
 	// equate the machine problem types - cloning does not do this
 	tree->set_machine_problem_type(dynamic_cast<CRandomCARTree*>(m_machine)->get_machine_problem_type());
 }
@@ -175,7 +190,11 @@ bool CRandomForest::train_machine(CFeatures* data)
 	
 	REQUIRE(m_features, "Training features not set!\n");
 	
-	dynamic_cast<CRandomCARTree*>(m_machine)->pre_sort_features(m_features, m_sorted_transposed_feats, m_sorted_indices);
+	CRandomCARTree* tree=dynamic_cast<CRandomCARTree*>(m_machine);
+	if (tree->get_num_bins()>0)
+		tree->pre_bin_features(m_features, m_binned_feats, m_bin_thresholds);
+	else
+		tree->pre_sort_features(m_features, m_sorted_transposed_feats, m_sorted_indices);
 
 	return CBaggingMachine::train_machine();
 }
@@ -138,6 +138,18 @@ public:
 	 */
 	int32_t get_num_random_features() const;
 
+	/** set number of bins features are quantized into for histogram based node splits
+	 *
+	 * @param num_bins number of bins (at most 255), 0 to search exact splits
+	 */
+	void set_num_bins(int32_t num_bins);
+
+	/** get number of bins features are quantized into for histogram based node splits
+	 *
+	 * @return number of bins, 0 if exact splits are searched
+	 */
+	int32_t get_num_bins() const;
+
 protected:
 
 	virtual bool train_machine(CFeatures* data=NULL);
@@ -161,6 +173,12 @@ private:
 
 	/** Indices of pre-sorted features */
 	SGMatrix<index_t> m_sorted_indices;
+
+	/** Quantized features shared by all trees */
+	SGMatrix<uint8_t> m_binned_feats;
+
+	/** Upper boundaries of the bins of quantized features */
+	SGMatrix<float64_t> m_bin_thresholds;
 };
 } /* namespace shogun */
 #endif /* _RANDOMFOREST_H__ */
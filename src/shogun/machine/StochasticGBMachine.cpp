@@ -33,6 +33,7 @@
 #include <shogun/lib/View.h>
 #include <shogun/machine/StochasticGBMachine.h>
 #include <shogun/mathematics/Math.h>
+#include <shogun/multiclass/tree/CARTree.h>
 #include <shogun/optimization/lbfgs/lbfgs.h>
 
 using namespace shogun;
@@ -66,6 +67,8 @@ CStochasticGBMachine::~CStochasticGBMachine()
 	SG_UNREF(m_loss);
 	SG_UNREF(m_weak_learners);
 	SG_UNREF(m_gamma);
+	SG_UNREF(m_validation_features);
+	SG_UNREF(m_validation_labels);
 }
 
 void CStochasticGBMachine::set_machine(CMachine* machine)
@@ -142,6 +145,48 @@ float64_t CStochasticGBMachine::get_learning_rate() const
 	return m_learning_rate;
 }
 
+void CStochasticGBMachine::set_second_order(bool second_order)
+{
+	m_second_order=second_order;
+}
+
+bool CStochasticGBMachine::get_second_order() const
+{
+	return m_second_order;
+}
+
+void CStochasticGBMachine::set_validation_data(CFeatures* data, CLabels* labels)
+{
+	REQUIRE(data,"Validation data is NULL\n")
+	REQUIRE(labels,"Validation labels are NULL\n")
+	REQUIRE(data->get_num_vectors()==labels->get_num_labels(),"Number of validation vectors (%d) does not match "
+		"number of validation labels (%d)\n",data->get_num_vectors(),labels->get_num_labels())
+
+	SG_REF(data);
+	SG_UNREF(m_validation_features);
+	m_validation_features=data;
+
+	SG_REF(labels);
+	SG_UNREF(m_validation_labels);
+	m_validation_labels=labels;
+}
+
+void CStochasticGBMachine::set_early_stopping_rounds(int32_t rounds)
+{
+	REQUIRE(rounds>=0,"Number of early stopping rounds should be non-negative. Supplied value is %d\n",rounds)
+	m_early_stopping_rounds=rounds;
+}
+
+int32_t CStochasticGBMachine::get_early_stopping_rounds() const
+{
+	return m_early_stopping_rounds;
+}
+
+int32_t CStochasticGBMachine::get_num_learners() const
+{
+	return m_weak_learners->get_num_elements();
+}
+
 CRegressionLabels* CStochasticGBMachine::apply_regression(CFeatures* data)
 {
 	REQUIRE(data,"test data supplied is NULL\n")
@@ -149,7 +194,7 @@ CRegressionLabels* CStochasticGBMachine::apply_regression(CFeatures* data)
 
 	SGVector<float64_t> retlabs(feats->get_num_vectors());
 	retlabs.fill_vector(retlabs.vector,retlabs.vlen,0);
-	for (int32_t i=0;i<m_num_iter;i++)
+	for (int32_t i=0;i<m_weak_learners->get_num_elements();i++)
 	{
 		float64_t gamma=m_gamma->get_element(i);
 
@@ -177,17 +222,37 @@ bool CStochasticGBMachine::train_machine(CFeatures* data)
 	REQUIRE(m_loss,"loss function not specified\n")
 	REQUIRE(m_labels, "labels not specified\n")
 
+	REQUIRE(!m_second_order || dynamic_cast<CCARTree*>(m_machine),"Second order boosting requires a CCARTree as machine\n")
+	REQUIRE(!m_early_stopping_rounds || m_validation_features,"Early stopping requires validation data\n")
+
 	CDenseFeatures<float64_t>* feats=data->as<CDenseFeatures<float64_t>>();
 
 	// initialize weak learners array and gamma array
 	initialize_learners();
 
+	// quantize the features once for the trees of all iterations
+	CCARTree* tree=dynamic_cast<CCARTree*>(m_machine);
+	if (tree && tree->get_num_bins()>0)
+		tree->pre_bin_features(feats, m_binned_feats, m_bin_thresholds);
+
 	// cache predicted labels for intermediate models
 	CRegressionLabels* interf=new CRegressionLabels(feats->get_num_vectors());
 	SG_REF(interf);
 	for (int32_t i=0;i<interf->get_num_labels();i++)
 		interf->set_label(i,0);
 
+	// cache predictions for validation data
+	SGVector<float64_t> valid_f;
+	SGVector<float64_t> valid_labels;
+	if (m_validation_features)
+	{
+		valid_f=SGVector<float64_t>(m_validation_features->get_num_vectors());
+		valid_f.zero();
+		valid_labels=m_validation_labels->as<CDenseLabels>()->get_labels();
+	}
+	float64_t best_loss=CMath::INFTY;
+	int32_t best_num_learners=0;
+
 	for (auto i : SG_PROGRESS(range(m_num_iter)))
 	{
 		const auto result = get_subset(feats, interf);
@@ -195,18 +260,30 @@ bool CStochasticGBMachine::train_machine(CFeatures* data)
 		const auto& interf_iter = std::get<1>(result);
 		const auto& labels_iter = std::get<2>(result);
 
-		// compute pseudo-residuals
-		CRegressionLabels* pres =
-		    compute_pseudo_residuals(interf_iter, labels_iter);
-
-		// fit learner
-		CMachine* wlearner = fit_model(feats_iter, pres);
-		m_weak_learners->push_back(wlearner);
-
-		// compute multiplier
-		CRegressionLabels* hm = wlearner->apply_regression(feats_iter);
-		SG_REF(hm);
-		float64_t gamma = compute_multiplier(interf_iter, hm, labels_iter);
+		CMachine* wlearner=NULL;
+		float64_t gamma=1.0;
+		if (m_second_order)
+		{
+			// newton steps need no line search
+			wlearner = fit_second_order_model(feats_iter, interf_iter, labels_iter);
+			m_weak_learners->push_back(wlearner);
+		}
+		else
+		{
+			// compute pseudo-residuals
+			CRegressionLabels* pres =
+			    compute_pseudo_residuals(interf_iter, labels_iter);
+
+			// fit learner
+			wlearner = fit_model(feats_iter, pres);
+			m_weak_learners->push_back(wlearner);
+
+			// compute multiplier
+			CRegressionLabels* hm = wlearner->apply_regression(feats_iter);
+			SG_REF(hm);
+			gamma = compute_multiplier(interf_iter, hm, labels_iter);
+			SG_UNREF(hm);
+		}
 		m_gamma->push_back(gamma);
 
 		// update intermediate function value
@@ -216,10 +293,52 @@ bool CStochasticGBMachine::train_machine(CFeatures* data)
 			interf->set_label(j,interf->get_label(j)+delta[j]*gamma*m_learning_rate);
 
 		SG_UNREF(dlabels);
-		SG_UNREF(hm);
+
+		if (m_validation_features)
+		{
+			CRegressionLabels* vlabels=wlearner->apply_regression(m_validation_features);
+			SGVector<float64_t> vdelta=vlabels->get_labels();
+
+			float64_t loss=0;
+			#pragma omp parallel for reduction(+:loss)
+			for (int32_t j=0;j<valid_f.vlen;j++)
+			{
+				valid_f[j]+=vdelta[j]*gamma*m_learning_rate;
+				loss+=m_loss->loss(valid_f[j],valid_labels[j]);
+			}
+			loss/=valid_f.vlen;
+			SG_UNREF(vlabels);
+
+			SG_DEBUG("validation loss after %d iterations: %f\n",i+1,loss)
+			if (loss<best_loss)
+			{
+				best_loss=loss;
+				best_num_learners=i+1;
+			}
+			else if (m_early_stopping_rounds && i+1-best_num_learners>=m_early_stopping_rounds)
+			{
+				SG_UNREF(wlearner);
+				SG_INFO("Validation loss has not improved for %d iterations, stopping early\n",m_early_stopping_rounds)
+				break;
+			}
+		}
+
 		SG_UNREF(wlearner);
 	}
 
+	// keep the model with the lowest validation loss
+	if (m_early_stopping_rounds)
+	{
+		while (m_weak_learners->get_num_elements()>best_num_learners)
+		{
+			m_weak_learners->pop_back();
+			m_gamma->pop_back();
+		}
+	}
+
+	m_binned_feats=SGMatrix<uint8_t>();
+	m_bin_thresholds=SGMatrix<float64_t>();
+
 	SG_UNREF(interf);
 	return true;
 }
@@ -251,6 +370,10 @@ CMachine* CStochasticGBMachine::fit_model(CDenseFeatures<float64_t>* feats, CReg
 	else
 		SG_ERROR("Machine could not be cloned!\n")
 
+	// share the quantized features
+	if (m_binned_feats.matrix)
+		dynamic_cast<CCARTree*>(c)->set_binned_features(m_binned_feats, m_bin_thresholds);
+
 	// train cloned machine
 	c->set_labels(labels);
 	c->train(feats);
@@ -258,6 +381,45 @@ CMachine* CStochasticGBMachine::fit_model(CDenseFeatures<float64_t>* feats, CReg
 	return c;
 }
 
+CMachine* CStochasticGBMachine::fit_second_order_model(CDenseFeatures<float64_t>* feats, CRegressionLabels* inter_f, CLabels* labs)
+{
+	auto labels = labs->as<CDenseLabels>()->get_labels();
+	SGVector<float64_t> f=inter_f->get_labels();
+
+	// a weighted least squares fit of -g/h with weights h minimizes the second order expansion of the loss
+	SGVector<float64_t> newton_steps(f.vlen);
+	SGVector<float64_t> hessians(f.vlen);
+	#pragma omp parallel for
+	for (int32_t i=0;i<f.vlen;i++)
+	{
+		float64_t g=m_loss->first_derivative(f[i],labels[i]);
+		float64_t h=m_loss->second_derivative(f[i],labels[i]);
+
+		// fall back to a gradient step where the loss has no curvature
+		if (h<=0)
+			h=1.0;
+
+		newton_steps[i]=-g/h;
+		hessians[i]=h;
+	}
+
+	CSGObject* obj=m_machine->clone();
+	CCARTree* c=NULL;
+	if (obj)
+		c=dynamic_cast<CCARTree*>(obj);
+	else
+		SG_ERROR("Machine could not be cloned!\n")
+
+	if (m_binned_feats.matrix)
+		c->set_binned_features(m_binned_feats, m_bin_thresholds);
+
+	c->set_weights(hessians);
+	c->set_labels(new CRegressionLabels(newton_steps));
+	c->train(feats);
+
+	return c;
+}
+
 CRegressionLabels* CStochasticGBMachine::compute_pseudo_residuals(
     CRegressionLabels* inter_f, CLabels* labs)
 {
@@ -394,6 +556,10 @@ void CStochasticGBMachine::init()
 	m_num_iter=0;
 	m_subset_frac=0;
 	m_learning_rate=0;
+	m_second_order=false;
+	m_validation_features=NULL;
+	m_validation_labels=NULL;
+	m_early_stopping_rounds=0;
 
 	m_weak_learners=new CDynamicObjectArray();
 	SG_REF(m_weak_learners);
@@ -408,4 +574,8 @@ void CStochasticGBMachine::init()
 	SG_ADD(&m_learning_rate,"m_learning_rate","learning rate",MS_NOT_AVAILABLE);
 	SG_ADD((CSGObject**)&m_weak_learners,"m_weak_learners","array of weak learners",MS_NOT_AVAILABLE);
 	SG_ADD((CSGObject**)&m_gamma,"m_gamma","array of learner weights",MS_NOT_AVAILABLE);
+	SG_ADD(&m_second_order,"m_second_order","whether trees are fit to newton steps",MS_NOT_AVAILABLE);
+	SG_ADD((CSGObject**)&m_validation_features,"m_validation_features","validation data",MS_NOT_AVAILABLE);
+	SG_ADD((CSGObject**)&m_validation_labels,"m_validation_labels","validation labels",MS_NOT_AVAILABLE);
+	SG_ADD(&m_early_stopping_rounds,"m_early_stopping_rounds","iterations without improvement before stopping",MS_NOT_AVAILABLE);
 }
@@ -51,6 +51,15 @@ namespace shogun
  * For one dimensional optimization, this class uses the backtracking linesearch accessed via Shogun's L-BFGS class.
  * A concise description of the algorithm implemented can be found in the following link :
  * http://en.wikipedia.org/wiki/Gradient_boosting#Algorithm
+ *
+ * In second order mode (see set_second_order()), which requires a CCARTree as base machine, every tree is fit to the Newton
+ * step \f$-g_i/h_i\f$ with weights \f$h_i\f$, where \f$g_i\f$ and \f$h_i\f$ are the first and second derivatives of the loss
+ * at the current prediction. The splits then maximize \f$G_L^2/H_L+G_R^2/H_R-G^2/H\f$ and the leaves predict \f$-G/H\f$, so that
+ * no line search is needed. If the base tree quantizes features (see CCARTree::set_num_bins()), the features are quantized only
+ * once and shared by the trees of all iterations.
+ *
+ * Training can be stopped early when the loss on a validation set (see set_validation_data()) has not improved for a number of
+ * iterations, in which case the model is truncated to the iteration with the lowest validation loss.
  */
 class CStochasticGBMachine : public CMachine
 {
@@ -135,6 +144,43 @@ public:
 	 */
 	float64_t get_learning_rate() const;
 
+	/** set whether trees are fit to Newton steps using second derivatives of the loss
+	 *
+	 * @param second_order whether to use second order boosting
+	 */
+	void set_second_order(bool second_order);
+
+	/** get whether trees are fit to Newton steps using second derivatives of the loss
+	 *
+	 * @return whether second order boosting is used
+	 */
+	bool get_second_order() const;
+
+	/** set validation data used to monitor the loss during training
+	 *
+	 * @param data validation data
+	 * @param labels validation labels
+	 */
+	void set_validation_data(CFeatures* data, CLabels* labels);
+
+	/** set number of iterations without improvement of the validation loss after which training stops
+	 *
+	 * @param rounds number of iterations, 0 to disable early stopping
+	 */
+	void set_early_stopping_rounds(int32_t rounds);
+
+	/** get number of iterations without improvement of the validation loss after which training stops
+	 *
+	 * @return number of iterations, 0 if early stopping is disabled
+	 */
+	int32_t get_early_stopping_rounds() const;
+
+	/** get number of weak learners in the trained model
+	 *
+	 * @return number of weak learners, less than the number of iterations if training was stopped early
+	 */
+	int32_t get_num_learners() const;
+
 	/** apply_regression
 	 *
 	 * @param data test data
@@ -169,6 +215,15 @@ protected:
 	 */
 	CMachine* fit_model(CDenseFeatures<float64_t>* feats, CRegressionLabels* labels);
 
+	/** train base tree on Newton steps
+	 *
+	 * @param feats training data
+	 * @param inter_f intermediate boosted model labels for training data
+	 * @param labs training labels
+	 * @return trained base model
+	 */
+	CMachine* fit_second_order_model(CDenseFeatures<float64_t>* feats, CRegressionLabels* inter_f, CLabels* labs);
+
 	/** compute pseudo_residuals
 	 *
 	 * @param inter_f intermediate boosted model labels for training data
@@ -231,6 +286,24 @@ protected:
 
 	/** gamma - weak learner weights */
 	CDynamicArray<float64_t>* m_gamma;
+
+	/** whether trees are fit to Newton steps */
+	bool m_second_order;
+
+	/** validation data */
+	CFeatures* m_validation_features;
+
+	/** validation labels */
+	CLabels* m_validation_labels;
+
+	/** iterations without improvement of the validation loss before stopping */
+	int32_t m_early_stopping_rounds;
+
+	/** quantized training features shared by the trees of all iterations */
+	SGMatrix<uint8_t> m_binned_feats;
+
+	/** upper boundaries of the bins of quantized features */
+	SGMatrix<float64_t> m_bin_thresholds;
 };
 }/* shogun */
 
@@ -34,14 +34,133 @@
 #include <shogun/machine/gp/ExactInferenceMethod.h>
 
 
+#include <shogun/base/Parallel.h>
+#include <shogun/distance/EuclideanDistance.h>
+#include <shogun/features/DenseFeatures.h>
+#include <shogun/kernel/GaussianKernel.h>
+#include <shogun/kernel/normalizer/IdentityKernelNormalizer.h>
+#include <shogun/kernel/normalizer/SqrtDiagKernelNormalizer.h>
 #include <shogun/machine/gp/GaussianLikelihood.h>
 #include <shogun/labels/RegressionLabels.h>
 #include <shogun/mathematics/Math.h>
 #include <shogun/mathematics/eigen3.h>
 
+#include <typeinfo>
+
+/** block size of the Cholesky factorization in update_chol() */
+#define CHOLESKY_BLOCK_SIZE 256
+
 using namespace shogun;
 using namespace Eigen;
 
+/** overwrites the symmetric positive definite matrix A with its upper
+ * triangular Cholesky factor U, A=U'*U. After a diagonal block is factored,
+ * the row panel to its right and the trailing matrix are updated in
+ * parallel, one block column per task.
+ */
+static void blocked_cholesky(SGMatrix<float64_t>& A, Parallel* parallel)
+{
+	Map<MatrixXd> U(A.matrix, A.num_rows, A.num_cols);
+	const index_t n=A.num_rows;
+	const index_t bs=CHOLESKY_BLOCK_SIZE;
+
+	for (index_t k=0; k<n; k+=bs)
+	{
+		const index_t kb=CMath::min(bs, n-k);
+		LLT<MatrixXd, Upper> llt(U.block(k, k, kb, kb));
+		U.block(k, k, kb, kb)=llt.matrixU();
+		U.block(k+kb, k, n-k-kb, kb).setZero();
+
+		const index_t num_blocks=(n-k-kb+bs-1)/bs;
+		if (!num_blocks)
+			break;
+
+		// U_kj=U_kk'\A_kj
+		parallel->parallel_for(0, num_blocks, [&](int64_t first, int64_t last)
+		{
+			for (int64_t b=first; b<last; b++)
+			{
+				index_t j=k+kb+b*bs;
+				Block<Map<MatrixXd> > panel=U.block(k, j, kb, CMath::min(bs, n-j));
+				U.block(k, k, kb, kb).triangularView<Upper>().adjoint().solveInPlace(panel);
+			}
+		}, 1);
+
+		// A_ij=A_ij-U_ki'*U_kj for the blocks on and above the diagonal
+		parallel->parallel_for(0, num_blocks, [&](int64_t first, int64_t last)
+		{
+			for (int64_t b=first; b<last; b++)
+			{
+				index_t j=k+kb+b*bs;
+				index_t jb=CMath::min(bs, n-j);
+				U.block(k+kb, j, j+jb-k-kb, jb).noalias()-=
+					U.block(k, k+kb, kb, j+jb-k-kb).adjoint()*U.block(k, j, kb, jb);
+			}
+		}, 1);
+	}
+}
+
+/** @return squared euclidean distances between the vectors of l and r */
+static SGMatrix<float64_t> squared_distances(CFeatures* l, CFeatures* r)
+{
+	CEuclideanDistance* distance=new CEuclideanDistance();
+	SG_REF(distance);
+	distance->set_disable_sqrt(true);
+	distance->init(l, r);
+	SGMatrix<float64_t> result=distance->get_distance_matrix<float64_t>();
+	SG_UNREF(distance);
+
+	// clamp tiny negative values caused by cancellation
+	for (int64_t i=0; i<result.size(); i++)
+		result.matrix[i]=CMath::max(0.0, result.matrix[i]);
+
+	return result;
+}
+
+/** @return Gaussian kernel matrix exp(-D/width) for squared distances D */
+static SGMatrix<float64_t> gaussian_kernel_matrix(SGMatrix<float64_t> sq_dist,
+		float64_t width, Parallel* parallel)
+{
+	SGMatrix<float64_t> result(sq_dist.num_rows, sq_dist.num_cols);
+	const int64_t num_rows=sq_dist.num_rows;
+	const float64_t inv_width=1.0/width;
+
+	parallel->parallel_for(0, sq_dist.num_cols, [&](int64_t first, int64_t last)
+	{
+		for (int64_t i=first*num_rows; i<last*num_rows; i++)
+			result.matrix[i]=std::exp(-sq_dist.matrix[i]*inv_width);
+	});
+
+	return result;
+}
+
+/** @return symmetric matrix whose upper left block is A and whose last
+ * columns, and by symmetry last rows, are the columns of cols
+ */
+static SGMatrix<float64_t> append_symmetric(SGMatrix<float64_t> A,
+		SGMatrix<float64_t> cols)
+{
+	const index_t n=A.num_rows;
+	const index_t size=cols.num_rows;
+	SGMatrix<float64_t> result(size, size);
+
+	for (index_t j=0; j<n; j++)
+	{
+		sg_memcpy(result.get_column_vector(j), A.get_column_vector(j),
+				sizeof(float64_t)*n);
+		for (index_t i=n; i<size; i++)
+			result(i, j)=cols(j, i-n);
+	}
+
+	for (index_t j=n; j<size; j++)
+	{
+		sg_memcpy(result.get_column_vector(j), cols.get_column_vector(j-n),
+				sizeof(float64_t)*size);
+	}
+
+	return result;
+}
+
 CExactInferenceMethod::CExactInferenceMethod() : CInference()
 {
 }
@@ -88,6 +207,153 @@ void CExactInferenceMethod::update()
 	SG_DEBUG("leaving\n");
 }
 
+void CExactInferenceMethod::append_observations(CFeatures* features,
+		CLabels* labels)
+{
+	REQUIRE(features, "Features of the new observations should not be NULL\n")
+	REQUIRE(labels, "Labels of the new observations should not be NULL\n")
+	REQUIRE(labels->get_label_type()==LT_REGRESSION,
+		"Labels must be type of CRegressionLabels\n")
+	REQUIRE(features->get_num_vectors()==labels->get_num_labels(),
+		"Number of new vectors (%d) must match number of new labels (%d)\n",
+		features->get_num_vectors(), labels->get_num_labels())
+	check_members();
+	SG_REF(features);
+	SG_REF(labels);
+
+	// the factor can only be extended if it belongs to the current parameters
+	bool extend=m_L.matrix && !parameter_hash_changed();
+
+	index_t n=m_labels->get_num_labels();
+	index_t m=labels->get_num_labels();
+
+	SGVector<float64_t> y=((CRegressionLabels*) m_labels)->get_labels();
+	SGVector<float64_t> y_new=((CRegressionLabels*) labels)->get_labels();
+	SGVector<float64_t> all_y(n+m);
+	sg_memcpy(all_y.vector, y.vector, sizeof(float64_t)*n);
+	sg_memcpy(all_y.vector+n, y_new.vector, sizeof(float64_t)*m);
+
+	CFeatures* all_features=m_features->create_merged_copy(features);
+	set_features(all_features);
+	set_labels(new CRegressionLabels(all_y));
+
+	if (!extend)
+	{
+		update();
+		SG_UNREF(labels);
+		SG_UNREF(features);
+		return;
+	}
+
+	SG_DEBUG("appending %d observations to %d\n", m, n)
+
+	// kernel between all and the new observations
+	SGMatrix<float64_t> k_new;
+	if (use_squared_distances() && m_sq_dist.num_rows==n)
+	{
+		SGMatrix<float64_t> d_new=squared_distances(all_features, features);
+		for (index_t i=0; i<m; i++)
+			d_new(n+i, i)=0;
+
+		m_sq_dist=append_symmetric(m_sq_dist, d_new);
+		m_sq_dist_features=
+			((CDenseFeatures<float64_t>*) all_features)->get_feature_matrix().clone();
+
+		CGaussianKernel* kernel=(CGaussianKernel*) m_kernel;
+		k_new=gaussian_kernel_matrix(d_new, kernel->get_width(), parallel);
+	}
+	else
+	{
+		m_kernel->init(all_features, features);
+		k_new=m_kernel->get_kernel_matrix();
+	}
+	m_kernel->init(all_features, all_features);
+
+	// get the sigma variable from the Gaussian likelihood model
+	CGaussianLikelihood* lik = m_model->as<CGaussianLikelihood>();
+	float64_t sigma=lik->get_sigma();
+	float64_t scale=std::exp(m_log_scale * 2.0) / CMath::sq(sigma);
+
+	SGMatrix<float64_t> L(n+m, n+m);
+	L.zero();
+	Map<MatrixXd> eigen_L(L.matrix, n+m, n+m);
+	Map<MatrixXd> eigen_old_L(m_L.matrix, n, n);
+	Map<MatrixXd> eigen_k(k_new.matrix, n+m, m);
+	eigen_L.topLeftCorner(n, n)=eigen_old_L;
+
+	// new columns of the factor: solve L' * B = K_12 * scale / sigma^2
+	Block<Map<MatrixXd> > B=eigen_L.topRightCorner(n, m);
+	B=eigen_k.topRows(n)*scale;
+	eigen_old_L.triangularView<Upper>().adjoint().solveInPlace(B);
+
+	// and the factor of the Schur complement as lower right block:
+	// S = K_22 * scale / sigma^2 + I - B' * B
+	MatrixXd S=eigen_k.bottomRows(m)*scale+MatrixXd::Identity(m, m);
+	S.noalias()-=B.adjoint()*B;
+	LLT<MatrixXd> llt(S);
+	eigen_L.bottomRightCorner(m, m)=llt.matrixU();
+
+	m_L=L;
+	m_ktrtr=append_symmetric(m_ktrtr, k_new);
+	update_alpha();
+	m_gradient_update=false;
+	update_parameter_hash();
+
+	SG_UNREF(labels);
+	SG_UNREF(features);
+}
+
+bool CExactInferenceMethod::use_squared_distances() const
+{
+	if (!m_kernel || typeid(*m_kernel)!=typeid(CGaussianKernel))
+		return false;
+
+	// both normalizers leave Gaussian kernels unchanged as k(x,x)=1
+	CKernelNormalizer* normalizer=m_kernel->get_normalizer();
+	bool unchanged=dynamic_cast<CIdentityKernelNormalizer*>(normalizer) ||
+		dynamic_cast<CSqrtDiagKernelNormalizer*>(normalizer);
+	SG_UNREF(normalizer);
+	if (!unchanged)
+		return false;
+
+	if (!m_features || m_features->get_feature_class()!=C_DENSE ||
+			m_features->get_feature_type()!=F_DREAL)
+		return false;
+
+	int32_t num_feat;
+	int32_t num_vec;
+	return ((CDenseFeatures<float64_t>*) m_features)->get_feature_matrix(
+			num_feat, num_vec)!=NULL;
+}
+
+void CExactInferenceMethod::update_train_kernel()
+{
+	if (!use_squared_distances())
+	{
+		m_sq_dist=SGMatrix<float64_t>();
+		m_sq_dist_features=SGMatrix<float64_t>();
+		CInference::update_train_kernel();
+		return;
+	}
+
+	m_kernel->init(m_features, m_features);
+
+	// squared distances only change with the features, not with the width
+	// of the kernel during model selection
+	SGMatrix<float64_t> feature_matrix=
+		((CDenseFeatures<float64_t>*) m_features)->get_feature_matrix();
+	if (!m_sq_dist.matrix || !m_sq_dist_features.equals(feature_matrix))
+	{
+		m_sq_dist=squared_distances(m_features, m_features);
+		for (index_t i=0; i<m_sq_dist.num_rows; i++)
+			m_sq_dist(i, i)=0;
+		m_sq_dist_features=feature_matrix.clone();
+	}
+
+	CGaussianKernel* kernel=(CGaussianKernel*) m_kernel;
+	m_ktrtr=gaussian_kernel_matrix(m_sq_dist, kernel->get_width(), parallel);
+}
+
 void CExactInferenceMethod::check_members() const
 {
 	CInference::check_members();
@@ -186,10 +452,9 @@ void CExactInferenceMethod::update_chol()
 	/* creates views on kernel and cholesky matrix and perform cholesky */
 	Map<MatrixXd> K(m_ktrtr.matrix, m_ktrtr.num_rows, m_ktrtr.num_cols);
 	Map<MatrixXd> L(m_L.matrix, m_ktrtr.num_rows, m_ktrtr.num_cols);
-	LLT<MatrixXd> llt(
-	    K * (std::exp(m_log_scale * 2.0) / CMath::sq(sigma)) +
-	    MatrixXd::Identity(m_ktrtr.num_rows, m_ktrtr.num_cols));
-	L=llt.matrixU();
+	L = K * (std::exp(m_log_scale * 2.0) / CMath::sq(sigma)) +
+	    MatrixXd::Identity(m_ktrtr.num_rows, m_ktrtr.num_cols);
+	blocked_cholesky(m_L, parallel);
 }
 
 void CExactInferenceMethod::update_alpha()
@@ -348,6 +613,22 @@ SGVector<float64_t> CExactInferenceMethod::get_derivative_wrt_kernel(
 	int64_t len=const_cast<TParameter *>(param)->m_datatype.get_num_elements();
 	result=SGVector<float64_t>(len);
 
+	if (!strcmp(param->m_name, "log_width") && use_squared_distances() &&
+			m_sq_dist.num_rows==m_ktrtr.num_rows)
+	{
+		Map<MatrixXd> eigen_K(m_ktrtr.matrix, m_ktrtr.num_rows, m_ktrtr.num_cols);
+		Map<MatrixXd> eigen_D(m_sq_dist.matrix, m_sq_dist.num_rows,
+				m_sq_dist.num_cols);
+		float64_t width=((CGaussianKernel*) m_kernel)->get_width();
+
+		// dK=K.*D/width*2 from the cached distances, so that dnlZ=
+		// sum(Q.*K.*D)*scale/width without evaluating the kernel again
+		result[0]=eigen_Q.cwiseProduct(eigen_K).cwiseProduct(eigen_D).sum();
+		result[0] *= std::exp(m_log_scale * 2.0) / width;
+
+		return result;
+	}
+
 	for (index_t i=0; i<result.vlen; i++)
 	{
 		SGMatrix<float64_t> dK;
@@ -187,6 +187,16 @@ public:
 	/** update matrices except gradients*/
 	virtual void update();
 
+	/** appends observations to the training data. If the posterior is up
+	 * to date, the Cholesky factor is extended by the rows of the new
+	 * observations in \f$O(n^{2}m)\f$ instead of being recomputed in
+	 * \f$O((n+m)^{3})\f$, otherwise everything is updated from scratch.
+	 *
+	 * @param features features of the new observations
+	 * @param labels regression labels of the new observations
+	 */
+	virtual void append_observations(CFeatures* features, CLabels* labels);
+
         /** Set a minimizer
          *
          * @param minimizer minimizer used in inference method
@@ -196,6 +206,11 @@ protected:
 	/** check if members of object are valid for inference */
 	virtual void check_members() const;
 
+	/** update train kernel matrix, Gaussian kernel matrices are computed
+	 * from cached squared distances which do not depend on the width
+	 */
+	virtual void update_train_kernel();
+
 	/** update alpha matrix */
 	virtual void update_alpha();
 
@@ -263,6 +278,18 @@ private:
 	SGVector<float64_t> m_mu;
 
 	SGMatrix<float64_t> m_Q;
+
+	/** @return whether the kernel matrix and its derivative wrt the width
+	 * are computed from cached squared distances, i.e. if the kernel is a
+	 * Gaussian kernel on dense real features held in memory
+	 */
+	bool use_squared_distances() const;
+
+	/** squared distances of the training features */
+	SGMatrix<float64_t> m_sq_dist;
+
+	/** copy of the features the squared distances were computed from */
+	SGMatrix<float64_t> m_sq_dist_features;
 };
 }
 #endif /* CEXACTINFERENCEMETHOD_H_ */
@@ -7,8 +7,16 @@
 
 #include <shogun/modelselection/ModelSelection.h>
 #include <shogun/modelselection/ModelSelectionParameters.h>
+#include <shogun/modelselection/ParameterCombination.h>
 #include <shogun/evaluation/CrossValidation.h>
+#include <shogun/machine/KernelMachine.h>
 #include <shogun/base/Parameter.h>
+#include <shogun/base/Parallel.h>
+#include <shogun/base/progress.h>
+#include <shogun/mathematics/Math.h>
+
+#include <algorithm>
+#include <mutex>
 
 using namespace shogun;
 
@@ -33,12 +41,21 @@ void CModelSelection::init()
 {
 	m_model_parameters=NULL;
 	m_machine_eval=NULL;
+	m_num_concurrent_evaluations=1;
+	m_halving_rate=0;
 
 	SG_ADD((CSGObject**)&m_model_parameters, "model_parameters",
 			"Parameter tree for model selection", MS_NOT_AVAILABLE);
 
 	SG_ADD((CSGObject**)&m_machine_eval, "machine_evaluation",
 			"Machine evaluation strategy", MS_NOT_AVAILABLE);
+
+	SG_ADD(&m_num_concurrent_evaluations, "num_concurrent_evaluations",
+			"Number of combinations evaluated at the same time",
+			MS_NOT_AVAILABLE);
+
+	SG_ADD(&m_halving_rate, "halving_rate",
+			"Rate of successive halving", MS_NOT_AVAILABLE);
 }
 
 CModelSelection::~CModelSelection()
@@ -46,3 +63,254 @@ CModelSelection::~CModelSelection()
 	SG_UNREF(m_model_parameters);
 	SG_UNREF(m_machine_eval);
 }
+
+void CModelSelection::set_num_concurrent_evaluations(int32_t num_evaluations)
+{
+	REQUIRE(num_evaluations>0, "Number of concurrent evaluations (%d) must "
+			"be positive\n", num_evaluations);
+	m_num_concurrent_evaluations=num_evaluations;
+}
+
+int32_t CModelSelection::get_num_concurrent_evaluations() const
+{
+	return m_num_concurrent_evaluations;
+}
+
+void CModelSelection::set_halving_rate(int32_t halving_rate)
+{
+	REQUIRE(halving_rate==0 || halving_rate>=2, "Halving rate (%d) must be "
+			"at least 2, or 0 to disable successive halving\n", halving_rate);
+	m_halving_rate=halving_rate;
+}
+
+int32_t CModelSelection::get_halving_rate() const
+{
+	return m_halving_rate;
+}
+
+bool CModelSelection::is_better(float64_t a, float64_t b) const
+{
+	if (m_machine_eval->get_evaluation_direction()==ED_MAXIMIZE)
+		return a>b;
+
+	return a<b;
+}
+
+CCrossValidationResult* CModelSelection::evaluate_machine(
+		CMachineEvaluation* machine_eval)
+{
+	/* note that this may implicitly lock and unlock the machine */
+	CEvaluationResult* result=machine_eval->evaluate();
+
+	if (result->get_result_type()!=CROSSVALIDATION_RESULT)
+		SG_SERROR("Evaluation result is not of type CCrossValidationResult!")
+
+	return (CCrossValidationResult*)result;
+}
+
+SGVector<float64_t> CModelSelection::evaluate_combinations(
+		CDynamicObjectArray* combinations, SGVector<index_t> indices,
+		bool print_state)
+{
+	SGVector<float64_t> means(indices.vlen);
+
+	/* underlying learning machine */
+	CMachine* machine=m_machine_eval->get_machine();
+
+	if (m_num_concurrent_evaluations==1 || indices.vlen<=1)
+	{
+		for (auto i : SG_PROGRESS(range(indices.vlen)))
+		{
+			CParameterCombination* combination=(CParameterCombination*)
+					combinations->get_element(indices[i]);
+
+			if (print_state)
+			{
+				SG_PRINT("trying combination:\n")
+				combination->print_tree();
+			}
+
+			combination->apply_to_machine(machine);
+			CCrossValidationResult* result=evaluate_machine(m_machine_eval);
+
+			if (print_state)
+				result->print_result();
+
+			means[i]=result->get_mean();
+			SG_UNREF(result);
+			SG_UNREF(combination);
+		}
+	}
+	else
+	{
+		/* the combinations share the objects of the parameter tree, so they
+		 * are applied to the machine one at a time and every evaluation
+		 * runs on a snapshot of the machine evaluation */
+		std::mutex apply_lock;
+		int64_t num_tasks=CMath::min(m_num_concurrent_evaluations,
+				indices.vlen);
+		int64_t grain=(indices.vlen+num_tasks-1)/num_tasks;
+
+		parallel->parallel_for(0, indices.vlen, [&](int64_t begin, int64_t end)
+		{
+			for (int64_t i=begin; i<end; i++)
+			{
+				CParameterCombination* combination=(CParameterCombination*)
+						combinations->get_element(indices[i]);
+
+				/* the folds are drawn under the lock as well, splitting
+				 * strategies share the global random generator */
+				CMachineEvaluation* machine_eval=NULL;
+				{
+					std::lock_guard<std::mutex> guard(apply_lock);
+					combination->apply_to_machine(machine);
+					machine_eval=(CMachineEvaluation*)m_machine_eval->clone();
+					CCrossValidation* cross_validation=
+						dynamic_cast<CCrossValidation*>(machine_eval);
+					if (cross_validation)
+						cross_validation->build_run_subsets();
+				}
+
+				CCrossValidationResult* result=NULL;
+				try
+				{
+					result=evaluate_machine(machine_eval);
+				}
+				catch (...)
+				{
+					SG_UNREF(machine_eval);
+					SG_UNREF(combination);
+					throw;
+				}
+
+				if (print_state)
+				{
+					std::lock_guard<std::mutex> guard(apply_lock);
+					SG_PRINT("tried combination:\n")
+					combination->print_tree();
+					result->print_result();
+				}
+
+				means[i]=result->get_mean();
+				SG_UNREF(result);
+				SG_UNREF(machine_eval);
+				SG_UNREF(combination);
+			}
+		}, grain);
+	}
+
+	SG_UNREF(machine);
+	return means;
+}
+
+CParameterCombination* CModelSelection::search_combinations(
+		CDynamicObjectArray* combinations, bool print_state)
+{
+	REQUIRE(combinations, "No parameter combinations given\n");
+	REQUIRE(m_machine_eval, "No machine evaluation set\n");
+
+	float64_t best_mean;
+	if (m_machine_eval->get_evaluation_direction()==ED_MAXIMIZE)
+	{
+		if (print_state) SG_PRINT("Direction is maximize\n")
+		best_mean=CMath::ALMOST_NEG_INFTY;
+	}
+	else
+	{
+		if (print_state) SG_PRINT("Direction is minimize\n")
+		best_mean=CMath::ALMOST_INFTY;
+	}
+
+	/* a kernel machine evaluated in place keeps its kernel matrix between
+	 * combinations, snapshots of concurrent evaluations would copy it */
+	CMachine* machine=m_machine_eval->get_machine();
+	CKernelMachine* kernel_machine=NULL;
+	bool reuse_locked_kernel=false;
+	if (m_num_concurrent_evaluations==1)
+		kernel_machine=dynamic_cast<CKernelMachine*>(machine);
+	if (kernel_machine)
+	{
+		reuse_locked_kernel=kernel_machine->get_reuse_locked_kernel();
+		kernel_machine->set_reuse_locked_kernel(true);
+	}
+
+	SGVector<index_t> candidates(combinations->get_num_elements());
+	candidates.range_fill();
+	SGVector<float64_t> means;
+
+	CCrossValidation* cross_validation=NULL;
+	if (m_halving_rate>0)
+	{
+		cross_validation=dynamic_cast<CCrossValidation*>(m_machine_eval);
+		if (!cross_validation)
+		{
+			SG_WARNING("Successive halving is only supported by "
+					"CCrossValidation, evaluating all combinations fully\n")
+		}
+	}
+
+	if (cross_validation)
+	{
+		/* number of folds of each rung, the last one evaluates all folds */
+		std::vector<index_t> rung_folds;
+		for (index_t folds=cross_validation->get_num_folds(); folds>=1;
+				folds/=m_halving_rate)
+		{
+			rung_folds.insert(rung_folds.begin(), folds);
+		}
+
+		index_t num_evaluated_folds=cross_validation->get_num_evaluated_folds();
+		for (size_t rung=0; rung<rung_folds.size(); rung++)
+		{
+			if (print_state)
+			{
+				SG_PRINT("Evaluating %d combinations on %d folds\n",
+						candidates.vlen, rung_folds[rung])
+			}
+
+			cross_validation->set_num_evaluated_folds(rung_folds[rung]);
+			means=evaluate_combinations(combinations, candidates, print_state);
+
+			if (rung+1==rung_folds.size() || candidates.vlen==1)
+				break;
+
+			/* keep the best 1/eta of the combinations in their order */
+			std::vector<index_t> order(candidates.vlen);
+			for (index_t i=0; i<candidates.vlen; i++)
+				order[i]=i;
+			std::stable_sort(order.begin(), order.end(),
+					[&](index_t a, index_t b) { return is_better(means[a], means[b]); });
+
+			index_t num_kept=(candidates.vlen+m_halving_rate-1)/m_halving_rate;
+			order.resize(num_kept);
+			std::sort(order.begin(), order.end());
+
+			SGVector<index_t> kept(num_kept);
+			for (index_t i=0; i<num_kept; i++)
+				kept[i]=candidates[order[i]];
+			candidates=kept;
+		}
+		cross_validation->set_num_evaluated_folds(num_evaluated_folds);
+	}
+	else
+		means=evaluate_combinations(combinations, candidates, print_state);
+
+	/* first of the best combinations */
+	CParameterCombination* best_combination=NULL;
+	for (index_t i=0; i<candidates.vlen; i++)
+	{
+		if (is_better(means[i], best_mean))
+		{
+			best_mean=means[i];
+			SG_UNREF(best_combination);
+			best_combination=(CParameterCombination*)
+					combinations->get_element(candidates[i]);
+		}
+	}
+
+	if (kernel_machine)
+		kernel_machine->set_reuse_locked_kernel(reuse_locked_kernel);
+	SG_UNREF(machine);
+
+	return best_combination;
+}
@@ -12,11 +12,14 @@
 
 #include <shogun/base/SGObject.h>
 #include <shogun/evaluation/MachineEvaluation.h>
+#include <shogun/lib/SGVector.h>
 
 namespace shogun
 {
 class CModelSelectionParameters;
 class CParameterCombination;
+class CDynamicObjectArray;
+class CCrossValidationResult;
 
 /** @brief Abstract base class for model selection.
  *
@@ -50,15 +53,86 @@ public:
 	 */
 	virtual CParameterCombination* select_model(bool print_state=false)=0;
 
+	/** set how many parameter combinations are evaluated at the same time.
+	 * Every concurrent evaluation works on its own clone of the machine
+	 * evaluation, which includes the machine and the features, so this
+	 * bounds the memory used besides the number of threads. The folds of
+	 * a CCrossValidation are drawn from the global random generator while
+	 * the combination is applied, one evaluation at a time, so which folds
+	 * a combination gets depends on the order the evaluations start in.
+	 *
+	 * @param num_evaluations number of concurrent evaluations, 1 evaluates
+	 * the combinations one after another on the machine itself
+	 */
+	void set_num_concurrent_evaluations(int32_t num_evaluations);
+
+	/** @return number of concurrent evaluations */
+	int32_t get_num_concurrent_evaluations() const;
+
+	/** set the rate of successive halving. With a rate eta, all
+	 * combinations are first evaluated on a fraction of the folds of the
+	 * cross-validation, then only the best 1/eta of them are evaluated on
+	 * eta times as many folds, and so on until the remaining ones are
+	 * evaluated on all folds. Only supported by CCrossValidation.
+	 *
+	 * @param halving_rate rate eta, at least 2, or 0 to evaluate all
+	 * combinations on all folds
+	 */
+	void set_halving_rate(int32_t halving_rate);
+
+	/** @return rate of successive halving, 0 if disabled */
+	int32_t get_halving_rate() const;
+
+protected:
+	/** search the best of the given combinations. Kernel machines keep the
+	 * kernel matrix computed when locking for the next combination, so
+	 * combinations which only change parameters of the machine, e.g. C,
+	 * share it.
+	 *
+	 * @param combinations parameter combinations to evaluate
+	 * @param print_state if true, the current combination is printed
+	 * @return best combination of model parameters
+	 */
+	CParameterCombination* search_combinations(
+			CDynamicObjectArray* combinations, bool print_state);
+
 private:
 	/** initializer */
 	void init();
 
+	/** evaluate some of the combinations, concurrently if desired
+	 *
+	 * @param combinations parameter combinations
+	 * @param indices indices of the combinations to evaluate
+	 * @param print_state if true, the current combination is printed
+	 * @return mean result of each evaluated combination
+	 */
+	SGVector<float64_t> evaluate_combinations(
+			CDynamicObjectArray* combinations, SGVector<index_t> indices,
+			bool print_state);
+
+	/** evaluate the machine with its current parameters
+	 *
+	 * @param machine_eval evaluation to run
+	 * @return cross-validation result
+	 */
+	static CCrossValidationResult* evaluate_machine(
+			CMachineEvaluation* machine_eval);
+
+	/** @return whether result a is better than result b */
+	bool is_better(float64_t a, float64_t b) const;
+
 protected:
 	/** model parameters */
 	CModelSelectionParameters* m_model_parameters;
 	/** cross validation */
 	CMachineEvaluation* m_machine_eval;
+
+	/** number of concurrent evaluations */
+	int32_t m_num_concurrent_evaluations;
+
+	/** rate of successive halving, 0 if disabled */
+	int32_t m_halving_rate;
 };
 }
 #endif /* __MODELSELECTION_H_ */
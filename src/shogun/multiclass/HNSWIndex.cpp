@@ -0,0 +1,470 @@
+/*
+ * This software is distributed under BSD 3-clause license (see LICENSE file).
+ */
+
+#include <shogun/base/Parallel.h>
+#include <shogun/mathematics/Math.h>
+#include <shogun/multiclass/HNSWIndex.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <queue>
+
+using namespace shogun;
+
+/** marks the points visited by a search, a new search only increments the
+ * tag instead of clearing the marks
+ */
+struct VisitedList
+{
+	VisitedList() : tag(0) {}
+
+	/** start a new search over num_points points */
+	void reset(index_t num_points)
+	{
+		if (tags.size()<size_t(num_points) || tag==UINT32_MAX)
+		{
+			tags.assign(num_points, 0);
+			tag=0;
+		}
+		tag++;
+	}
+
+	/** @return whether the point was visited before, marks it visited */
+	bool visit(index_t point)
+	{
+		if (tags[point]==tag)
+			return true;
+		tags[point]=tag;
+		return false;
+	}
+
+	std::vector<uint32_t> tags;
+	uint32_t tag;
+};
+
+/** one list per thread, searches of a thread never overlap */
+static thread_local VisitedList visited_list;
+
+CHNSWIndex::CHNSWIndex() : CSGObject()
+{
+	init();
+}
+
+CHNSWIndex::CHNSWIndex(int32_t max_connections, int32_t ef_construction)
+	: CSGObject()
+{
+	init();
+	set_max_connections(max_connections);
+	set_ef_construction(ef_construction);
+}
+
+CHNSWIndex::~CHNSWIndex()
+{
+}
+
+void CHNSWIndex::init()
+{
+	m_max_connections=16;
+	m_ef_construction=200;
+	m_ef_search=50;
+	m_num_points=0;
+	m_entry_point=-1;
+	m_max_level=-1;
+
+	SG_ADD(&m_max_connections, "max_connections",
+			"Links per node on the upper layers", MS_NOT_AVAILABLE);
+	SG_ADD(&m_ef_construction, "ef_construction",
+			"Beam width while inserting", MS_AVAILABLE);
+	SG_ADD(&m_ef_search, "ef_search", "Beam width while searching",
+			MS_AVAILABLE);
+	SG_ADD(&m_num_points, "num_points", "Number of indexed points",
+			MS_NOT_AVAILABLE);
+	SG_ADD(&m_entry_point, "entry_point", "Point the searches start at",
+			MS_NOT_AVAILABLE);
+	SG_ADD(&m_max_level, "max_level", "Level of the entry point",
+			MS_NOT_AVAILABLE);
+	SG_ADD(&m_levels, "levels", "Level of each point", MS_NOT_AVAILABLE);
+	SG_ADD(&m_offsets, "offsets", "Offset of the links of each point",
+			MS_NOT_AVAILABLE);
+	SG_ADD(&m_links, "links", "Link lists of all points and layers",
+			MS_NOT_AVAILABLE);
+}
+
+void CHNSWIndex::set_max_connections(int32_t max_connections)
+{
+	REQUIRE(max_connections>1, "Number of connections (%d) must be at least 2\n",
+			max_connections);
+	REQUIRE(m_num_points==0, "Number of connections can only be changed on "
+			"an empty index\n");
+	m_max_connections=max_connections;
+}
+
+void CHNSWIndex::set_ef_construction(int32_t ef_construction)
+{
+	REQUIRE(ef_construction>0, "Beam width (%d) must be positive\n",
+			ef_construction);
+	m_ef_construction=ef_construction;
+}
+
+void CHNSWIndex::set_ef_search(int32_t ef_search)
+{
+	REQUIRE(ef_search>0, "Beam width (%d) must be positive\n", ef_search);
+	m_ef_search=ef_search;
+}
+
+void CHNSWIndex::clear()
+{
+	m_num_points=0;
+	m_entry_point=-1;
+	m_max_level=-1;
+	m_levels=SGVector<int32_t>();
+	m_offsets=SGVector<int64_t>();
+	m_links=SGVector<index_t>();
+}
+
+index_t* CHNSWIndex::links(index_t node, int32_t level) const
+{
+	int64_t offset=m_offsets.vector[node];
+	if (level>0)
+		offset+=2*m_max_connections+1+int64_t(level-1)*(m_max_connections+1);
+
+	return m_links.vector+offset;
+}
+
+void CHNSWIndex::get_links(index_t node, int32_t level, std::mutex* locks,
+		std::vector<index_t>& result) const
+{
+	std::unique_lock<std::mutex> guard;
+	if (locks)
+		guard=std::unique_lock<std::mutex>(locks[node]);
+
+	const index_t* list=links(node, level);
+	result.assign(list+1, list+1+list[0]);
+}
+
+void CHNSWIndex::greedy_search(const query_distance_t& distance,
+		int32_t from_level, int32_t to_level, std::mutex* locks,
+		index_t& current, float64_t& current_dist) const
+{
+	std::vector<index_t> neighbors;
+	for (int32_t level=from_level; level>to_level; level--)
+	{
+		bool changed=true;
+		while (changed)
+		{
+			changed=false;
+			get_links(current, level, locks, neighbors);
+			for (auto neighbor : neighbors)
+			{
+				float64_t dist=distance(neighbor);
+				if (dist<current_dist)
+				{
+					current=neighbor;
+					current_dist=dist;
+					changed=true;
+				}
+			}
+		}
+	}
+}
+
+void CHNSWIndex::search_layer(const query_distance_t& distance, index_t entry,
+		float64_t entry_dist, int32_t level, int32_t ef, std::mutex* locks,
+		std::vector<candidate_t>& result) const
+{
+	VisitedList& visited=visited_list;
+	visited.reset(m_num_points);
+	visited.visit(entry);
+
+	// closest unexpanded candidate first, furthest found point first
+	std::priority_queue<candidate_t, std::vector<candidate_t>,
+			std::greater<candidate_t> > candidates;
+	std::priority_queue<candidate_t> found;
+	candidates.emplace(entry_dist, entry);
+	found.emplace(entry_dist, entry);
+
+	std::vector<index_t> neighbors;
+	while (!candidates.empty())
+	{
+		candidate_t closest=candidates.top();
+		if (closest.first>found.top().first)
+			break;
+		candidates.pop();
+
+		get_links(closest.second, level, locks, neighbors);
+		for (auto neighbor : neighbors)
+		{
+			if (visited.visit(neighbor))
+				continue;
+
+			float64_t dist=distance(neighbor);
+			if (int32_t(found.size())<ef || dist<found.top().first)
+			{
+				candidates.emplace(dist, neighbor);
+				found.emplace(dist, neighbor);
+				if (int32_t(found.size())>ef)
+					found.pop();
+			}
+		}
+	}
+
+	result.resize(found.size());
+	for (index_t i=found.size()-1; i>=0; i--)
+	{
+		result[i]=found.top();
+		found.pop();
+	}
+}
+
+void CHNSWIndex::select_neighbors(const point_distance_t& distance,
+		int32_t num, std::vector<candidate_t>& candidates) const
+{
+	if (int32_t(candidates.size())<=num)
+		return;
+
+	std::vector<candidate_t> selected;
+	for (const auto& candidate : candidates)
+	{
+		if (int32_t(selected.size())>=num)
+			break;
+
+		bool keep=true;
+		for (const auto& other : selected)
+		{
+			if (distance(candidate.second, other.second)<candidate.first)
+			{
+				keep=false;
+				break;
+			}
+		}
+
+		if (keep)
+			selected.push_back(candidate);
+	}
+
+	candidates.swap(selected);
+}
+
+void CHNSWIndex::connect(const point_distance_t& distance, index_t node,
+		index_t point, float64_t dist, int32_t level, std::mutex* locks)
+{
+	std::lock_guard<std::mutex> guard(locks[node]);
+	index_t* list=links(node, level);
+	index_t num_links=list[0];
+
+	if (num_links<capacity(level))
+	{
+		list[1+num_links]=point;
+		list[0]=num_links+1;
+		return;
+	}
+
+	// full, keep the best links including the new one
+	std::vector<candidate_t> candidates;
+	candidates.emplace_back(dist, point);
+	for (index_t i=0; i<num_links; i++)
+		candidates.emplace_back(distance(node, list[1+i]), list[1+i]);
+	std::sort(candidates.begin(), candidates.end());
+	select_neighbors(distance, capacity(level), candidates);
+
+	list[0]=candidates.size();
+	for (size_t i=0; i<candidates.size(); i++)
+		list[1+i]=candidates[i].second;
+}
+
+void CHNSWIndex::insert_point(const point_distance_t& distance, index_t point,
+		std::mutex* locks, std::mutex& entry_lock)
+{
+	int32_t level=m_levels.vector[point];
+
+	// a point above the entry point becomes the new entry point, other
+	// insertions wait until it is linked
+	std::unique_lock<std::mutex> entry_guard(entry_lock);
+	index_t current=m_entry_point;
+	int32_t max_level=m_max_level;
+	if (level<=max_level)
+		entry_guard.unlock();
+
+	// concurrent insertions may already have linked the point, it must not
+	// become its own neighbor
+	auto query_distance=[&](index_t other)
+	{
+		return other==point ? CMath::INFTY : distance(point, other);
+	};
+	float64_t current_dist=query_distance(current);
+	greedy_search(query_distance, max_level, level, locks, current, current_dist);
+
+	std::vector<candidate_t> candidates;
+	for (int32_t l=CMath::min(level, max_level); l>=0; l--)
+	{
+		search_layer(query_distance, current, current_dist, l,
+				m_ef_construction, locks, candidates);
+
+		candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+				[point](const candidate_t& c) { return c.second==point; }),
+				candidates.end());
+		if (candidates.empty())
+			continue;
+
+		current=candidates[0].second;
+		current_dist=candidates[0].first;
+
+		select_neighbors(distance, m_max_connections, candidates);
+		{
+			std::lock_guard<std::mutex> guard(locks[point]);
+			index_t* list=links(point, l);
+			list[0]=candidates.size();
+			for (size_t i=0; i<candidates.size(); i++)
+				list[1+i]=candidates[i].second;
+		}
+
+		for (const auto& candidate : candidates)
+			connect(distance, candidate.second, point, candidate.first, l, locks);
+	}
+
+	if (level>max_level)
+	{
+		m_entry_point=point;
+		m_max_level=level;
+	}
+}
+
+void CHNSWIndex::insert(index_t num_points, const point_distance_t& distance)
+{
+	REQUIRE(num_points>=0, "Number of points (%d) must not be negative\n",
+			num_points);
+	if (num_points==0)
+		return;
+
+	index_t first=m_num_points;
+	index_t num_total=first+num_points;
+
+	// draw the levels and allocate the links up front, so that the points
+	// can be linked in parallel
+	float64_t level_scale=1.0/std::log(float64_t(m_max_connections));
+	m_levels.resize_vector(num_total);
+	m_offsets.resize_vector(num_total);
+	int64_t num_links=m_links.vlen;
+	for (index_t i=first; i<num_total; i++)
+	{
+		float64_t u=CMath::random(0.0, 1.0);
+		m_levels[i]=u>0 ? int32_t(-std::log(u)*level_scale) : 0;
+		m_offsets[i]=num_links;
+		num_links+=2*m_max_connections+1+
+				int64_t(m_levels[i])*(m_max_connections+1);
+	}
+
+	index_t old_num_links=m_links.vlen;
+	m_links.resize_vector(num_links);
+	for (int64_t i=old_num_links; i<num_links; i++)
+		m_links[i]=0;
+	m_num_points=num_total;
+
+	if (m_entry_point<0)
+	{
+		m_entry_point=first;
+		m_max_level=m_levels[first];
+		first++;
+	}
+
+	std::vector<std::mutex> locks(num_total);
+	std::mutex entry_lock;
+
+	// small chunks are taken roughly in order, so that the early points
+	// are linked before most of the others search the graph
+	parallel->parallel_for(first, num_total, [&](int64_t begin, int64_t end)
+	{
+		for (int64_t i=begin; i<end; i++)
+			insert_point(distance, i, locks.data(), entry_lock);
+	}, 64);
+
+	SG_DEBUG("Indexed %d points, %d in total, top level %d\n", num_points,
+			m_num_points, m_max_level);
+}
+
+index_t CHNSWIndex::search(const query_distance_t& distance, int32_t k,
+		index_t* indices, float64_t* dists) const
+{
+	if (m_entry_point<0 || k<=0)
+		return 0;
+
+	index_t current=m_entry_point;
+	float64_t current_dist=distance(current);
+	greedy_search(distance, m_max_level, 0, NULL, current, current_dist);
+
+	std::vector<candidate_t> candidates;
+	search_layer(distance, current, current_dist, 0,
+			CMath::max(m_ef_search, k), NULL, candidates);
+
+	index_t num_found=CMath::min(index_t(k), index_t(candidates.size()));
+	for (index_t i=0; i<num_found; i++)
+	{
+		indices[i]=candidates[i].second;
+		dists[i]=candidates[i].first;
+	}
+
+	return num_found;
+}
+
+void CHNSWIndex::build(CDistance* distance)
+{
+	clear();
+	add_points(distance);
+}
+
+void CHNSWIndex::add_points(CDistance* distance)
+{
+	REQUIRE(distance, "Distance must not be NULL\n");
+	index_t num_lhs=distance->get_num_vec_lhs();
+	REQUIRE(num_lhs>=m_num_points, "Distance has %d lhs vectors, but %d "
+			"points are indexed\n", num_lhs, m_num_points);
+
+	// distances between the points, lhs to lhs
+	CFeatures* lhs=distance->get_lhs();
+	CFeatures* rhs=distance->replace_rhs(lhs);
+
+	insert(num_lhs-m_num_points, [distance](index_t a, index_t b)
+	{
+		return distance->distance(a, b);
+	});
+
+	distance->replace_rhs(rhs);
+	SG_UNREF(lhs);
+}
+
+void CHNSWIndex::query_knn(CDistance* distance, int32_t k)
+{
+	REQUIRE(distance, "Distance must not be NULL\n");
+	REQUIRE(m_num_points>0, "Index is empty\n");
+	REQUIRE(k>0 && k<=m_num_points, "Number of neighbors (%d) must be in "
+			"[1, %d]\n", k, m_num_points);
+	REQUIRE(distance->get_num_vec_lhs()>=m_num_points, "Distance has %d lhs "
+			"vectors, but %d points are indexed\n",
+			distance->get_num_vec_lhs(), m_num_points);
+
+	index_t num_queries=distance->get_num_vec_rhs();
+	m_knn_indices=SGMatrix<index_t>(k, num_queries);
+	m_knn_dists=SGMatrix<float64_t>(k, num_queries);
+
+	parallel->parallel_for(0, num_queries, [&](int64_t begin, int64_t end)
+	{
+		for (int64_t i=begin; i<end; i++)
+		{
+			index_t* indices=m_knn_indices.get_column_vector(i);
+			float64_t* dists=m_knn_dists.get_column_vector(i);
+			index_t num_found=search([distance, i](index_t point)
+			{
+				return distance->distance(point, i);
+			}, k, indices, dists);
+
+			for (index_t j=num_found; j<k; j++)
+			{
+				indices[j]=-1;
+				dists[j]=CMath::INFTY;
+			}
+		}
+	});
+}
@@ -0,0 +1,278 @@
+/*
+ * This software is distributed under BSD 3-clause license (see LICENSE file).
+ */
+
+#ifndef _HNSWINDEX_H__
+#define _HNSWINDEX_H__
+
+#include <shogun/lib/config.h>
+
+#include <shogun/base/SGObject.h>
+#include <shogun/distance/Distance.h>
+#include <shogun/lib/SGMatrix.h>
+#include <shogun/lib/SGVector.h>
+
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace shogun
+{
+
+/** @brief Approximate nearest neighbor index based on a hierarchical
+ * navigable small world (HNSW) graph, see
+ *
+ * Malkov, Y. A. and Yashunin, D. A. (2016). Efficient and robust
+ * approximate nearest neighbor search using Hierarchical Navigable Small
+ * World graphs. https://arxiv.org/abs/1603.09320
+ *
+ * Every indexed point is a node on the layers 0 to its level, levels are
+ * drawn from an exponentially decaying distribution so that the upper
+ * layers are sparse. A search greedily descends the upper layers and then
+ * explores layer 0 with a beam of ef candidates, larger ef trade speed for
+ * recall.
+ *
+ * Points are inserted in batches, which may be repeated to grow the index.
+ * The points of a batch are inserted in parallel, with one lock per node.
+ * The index only stores the graph: distances are computed by a CDistance
+ * whose lhs are the indexed points or by a callback. The graph is
+ * registered as parameters, so a built index can be serialized.
+ */
+class CHNSWIndex : public CSGObject
+{
+public:
+	/** distance between two indexed points */
+	typedef std::function<float64_t(index_t, index_t)> point_distance_t;
+
+	/** distance between an indexed point and the query */
+	typedef std::function<float64_t(index_t)> query_distance_t;
+
+	/** default constructor */
+	CHNSWIndex();
+
+	/** constructor
+	 *
+	 * @param max_connections number of links per node on the upper layers,
+	 * twice as many are kept on layer 0
+	 * @param ef_construction beam width while inserting points
+	 */
+	CHNSWIndex(int32_t max_connections, int32_t ef_construction=200);
+
+	/** destructor */
+	virtual ~CHNSWIndex();
+
+	/** set the number of links per node, the index must be empty
+	 *
+	 * @param max_connections links per node on the upper layers
+	 */
+	void set_max_connections(int32_t max_connections);
+
+	/** @return number of links per node on the upper layers */
+	int32_t get_max_connections() const { return m_max_connections; }
+
+	/** set the beam width while inserting points
+	 *
+	 * @param ef_construction beam width
+	 */
+	void set_ef_construction(int32_t ef_construction);
+
+	/** @return beam width while inserting points */
+	int32_t get_ef_construction() const { return m_ef_construction; }
+
+	/** set the beam width while searching, at least k candidates are
+	 * always kept
+	 *
+	 * @param ef_search beam width
+	 */
+	void set_ef_search(int32_t ef_search);
+
+	/** @return beam width while searching */
+	int32_t get_ef_search() const { return m_ef_search; }
+
+	/** @return number of indexed points */
+	index_t get_num_points() const { return m_num_points; }
+
+	/** remove all points */
+	void clear();
+
+	/** index all lhs vectors of a distance, replacing the current graph
+	 *
+	 * @param distance distance whose lhs are the points
+	 */
+	void build(CDistance* distance);
+
+	/** index the lhs vectors of a distance which are not indexed yet, i.e.
+	 * the vectors from get_num_points() on. The first vectors must be the
+	 * already indexed points.
+	 *
+	 * @param distance distance whose lhs are the points
+	 */
+	void add_points(CDistance* distance);
+
+	/** find the approximate k nearest indexed points of all rhs vectors of
+	 * a distance, the results are available through get_knn_indices() and
+	 * get_knn_dists()
+	 *
+	 * @param distance distance whose lhs are the indexed points and whose
+	 * rhs are the queries
+	 * @param k number of neighbors
+	 */
+	void query_knn(CDistance* distance, int32_t k);
+
+	/** @return k x n matrix of the neighbors of the last query, closest
+	 * first, -1 if fewer than k points were reached
+	 */
+	SGMatrix<index_t> get_knn_indices() const { return m_knn_indices; }
+
+	/** @return k x n matrix of the distances to the neighbors of the last
+	 * query
+	 */
+	SGMatrix<float64_t> get_knn_dists() const { return m_knn_dists; }
+
+	/** insert the points get_num_points() to get_num_points()+num_points-1
+	 *
+	 * @param num_points number of points to insert
+	 * @param distance distance between two points, must be thread safe
+	 */
+	void insert(index_t num_points, const point_distance_t& distance);
+
+	/** find the approximate k nearest indexed points of a query
+	 *
+	 * @param distance distance from a point to the query
+	 * @param k number of neighbors
+	 * @param indices written with the neighbors, closest first
+	 * @param dists written with the distances to the neighbors
+	 * @return number of neighbors found, less than k only if fewer points
+	 * were reached
+	 */
+	index_t search(const query_distance_t& distance, int32_t k,
+			index_t* indices, float64_t* dists) const;
+
+	/** @return object name */
+	virtual const char* get_name() const { return "HNSWIndex"; }
+
+private:
+	/** candidate, distance and point */
+	typedef std::pair<float64_t, index_t> candidate_t;
+
+	/** register parameters and set defaults */
+	void init();
+
+	/** @return link list of a node on a layer, the first element is the
+	 * number of links
+	 */
+	index_t* links(index_t node, int32_t level) const;
+
+	/** @return maximum number of links per node on a layer */
+	int32_t capacity(int32_t level) const
+	{
+		return level ? m_max_connections : 2*m_max_connections;
+	}
+
+	/** copy the links of a node on a layer
+	 *
+	 * @param node node
+	 * @param level layer
+	 * @param locks node locks while inserting, NULL when searching
+	 * @param result written with the links
+	 */
+	void get_links(index_t node, int32_t level, std::mutex* locks,
+			std::vector<index_t>& result) const;
+
+	/** greedily move to the closest point on the layers from_level down
+	 * to to_level+1
+	 *
+	 * @param distance distance to the query
+	 * @param from_level first layer
+	 * @param to_level layer below the last one
+	 * @param locks node locks while inserting, NULL when searching
+	 * @param current start point, set to the closest point
+	 * @param current_dist distance of the current point
+	 */
+	void greedy_search(const query_distance_t& distance, int32_t from_level,
+			int32_t to_level, std::mutex* locks, index_t& current,
+			float64_t& current_dist) const;
+
+	/** beam search on a layer
+	 *
+	 * @param distance distance to the query
+	 * @param entry start point
+	 * @param entry_dist distance of the start point
+	 * @param level layer
+	 * @param ef beam width
+	 * @param locks node locks while inserting, NULL when searching
+	 * @param result written with the closest points found, closest first
+	 */
+	void search_layer(const query_distance_t& distance, index_t entry,
+			float64_t entry_dist, int32_t level, int32_t ef, std::mutex* locks,
+			std::vector<candidate_t>& result) const;
+
+	/** keep at most num candidates which are closer to the query than to
+	 * any kept candidate, which keeps links in different directions
+	 *
+	 * @param distance distance between two points
+	 * @param num maximum number of candidates to keep
+	 * @param candidates candidates sorted by distance, filtered in place
+	 */
+	void select_neighbors(const point_distance_t& distance, int32_t num,
+			std::vector<candidate_t>& candidates) const;
+
+	/** link a node to a new point, pruning its links if they are full
+	 *
+	 * @param distance distance between two points
+	 * @param node node to link
+	 * @param point new point
+	 * @param dist distance between node and point
+	 * @param level layer
+	 * @param locks node locks
+	 */
+	void connect(const point_distance_t& distance, index_t node,
+			index_t point, float64_t dist, int32_t level, std::mutex* locks);
+
+	/** insert a point whose links are allocated
+	 *
+	 * @param distance distance between two points
+	 * @param point point to insert
+	 * @param locks node locks
+	 * @param entry_lock guards the entry point
+	 */
+	void insert_point(const point_distance_t& distance, index_t point,
+			std::mutex* locks, std::mutex& entry_lock);
+
+private:
+	/** links per node on the upper layers */
+	int32_t m_max_connections;
+
+	/** beam width while inserting */
+	int32_t m_ef_construction;
+
+	/** beam width while searching */
+	int32_t m_ef_search;
+
+	/** number of indexed points */
+	index_t m_num_points;
+
+	/** point the searches start at, -1 if the index is empty */
+	index_t m_entry_point;
+
+	/** level of the entry point */
+	int32_t m_max_level;
+
+	/** level of each point */
+	SGVector<int32_t> m_levels;
+
+	/** offset of the link lists of each point in m_links */
+	SGVector<int64_t> m_offsets;
+
+	/** link lists of all points and layers */
+	SGVector<index_t> m_links;
+
+	/** neighbors of the last query */
+	SGMatrix<index_t> m_knn_indices;
+
+	/** distances to the neighbors of the last query */
+	SGMatrix<float64_t> m_knn_dists;
+};
+}
+#endif /* _HNSWINDEX_H__ */
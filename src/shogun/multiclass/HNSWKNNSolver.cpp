@@ -0,0 +1,89 @@
+/*
+ * This software is distributed under BSD 3-clause license (see LICENSE file).
+ */
+
+#include <shogun/lib/Signal.h>
+#include <shogun/multiclass/HNSWIndex.h>
+#include <shogun/multiclass/HNSWKNNSolver.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+using namespace shogun;
+
+CHNSWKNNSolver::CHNSWKNNSolver(const int32_t k, const float64_t q, const int32_t num_classes, const int32_t min_label, const SGVector<int32_t> train_labels, const int32_t max_connections, const int32_t ef_construction, const int32_t ef_search):
+CKNNSolver(k, q, num_classes, min_label, train_labels)
+{
+	init();
+
+	m_max_connections=max_connections;
+	m_ef_construction=ef_construction;
+	m_ef_search=ef_search;
+}
+
+SGMatrix<index_t> CHNSWKNNSolver::nearest_neighbors(CDistance* knn_distance) const
+{
+	CHNSWIndex* index=new CHNSWIndex(m_max_connections, m_ef_construction);
+	SG_REF(index);
+	index->set_ef_search(m_ef_search);
+	index->build(knn_distance);
+	index->query_knn(knn_distance, m_k);
+	SGMatrix<index_t> NN=index->get_knn_indices();
+	SG_UNREF(index);
+
+	// the graph search may reach fewer than k points, which are marked by
+	// trailing -1 entries, such queries are answered exhaustively
+	index_t num_train=knn_distance->get_num_vec_lhs();
+	std::vector<std::pair<float64_t, index_t> > candidates(num_train);
+	for (index_t i=0; i<NN.num_cols; i++)
+	{
+		if (NN(m_k-1, i)>=0)
+			continue;
+
+		for (index_t j=0; j<num_train; j++)
+			candidates[j]=std::make_pair(knn_distance->distance(j, i), j);
+		std::partial_sort(candidates.begin(), candidates.begin()+m_k,
+				candidates.end());
+		for (index_t j=0; j<m_k; j++)
+			NN(j, i)=candidates[j].second;
+	}
+
+	return NN;
+}
+
+CMulticlassLabels* CHNSWKNNSolver::classify_objects(CDistance* knn_distance, const int32_t num_lab, SGVector<int32_t>& train_lab, SGVector<float64_t>& classes) const
+{
+	CMulticlassLabels* output=new CMulticlassLabels(num_lab);
+	SGMatrix<index_t> NN=nearest_neighbors(knn_distance);
+	for (int32_t i = 0; i < num_lab && (!cancel_computation()); i++)
+	{
+		//write the labels of the k nearest neighbors from theirs indices
+		for (int32_t j=0; j<m_k; j++)
+			train_lab[j] = m_train_labels[ NN(j,i) ];
+
+		//get the index of the 'nearest' class
+		int32_t out_idx = choose_class(classes.vector, train_lab.vector);
+		//write the label of 'nearest' in the output
+		output->set_label(i, out_idx + m_min_label);
+	}
+
+	return output;
+}
+
+SGVector<int32_t> CHNSWKNNSolver::classify_objects_k(CDistance* knn_distance, const int32_t num_lab, SGVector<int32_t>& train_lab, SGVector<int32_t>& classes) const
+{
+	SGVector<int32_t> output(m_k*num_lab);
+
+	//the neighbors are already sorted by distance
+	SGMatrix<index_t> NN=nearest_neighbors(knn_distance);
+	for (index_t i = 0; i < num_lab && (!cancel_computation()); i++)
+	{
+		for (index_t j=0; j<m_k; j++)
+			train_lab[j] = m_train_labels[ NN(j,i) ];
+
+		choose_class_for_multiple_k(output.vector+i, classes.vector, train_lab.vector, num_lab);
+	}
+
+	return output;
+}
@@ -0,0 +1,84 @@
+/*
+ * This software is distributed under BSD 3-clause license (see LICENSE file).
+ */
+
+#ifndef HNSWKNNSOLVER_H__
+#define HNSWKNNSOLVER_H__
+
+#include <shogun/lib/config.h>
+
+#include <shogun/lib/common.h>
+#include <shogun/distance/Distance.h>
+#include <shogun/multiclass/KNNSolver.h>
+
+namespace shogun
+{
+
+/**
+ * HNSW solver. It finds approximate nearest neighbours in a hierarchical
+ * navigable small world graph, see CHNSWIndex. The graph is built in
+ * parallel on the training vectors and queried in parallel, which works
+ * well for high-dimensional data and any distance.
+ */
+class CHNSWKNNSolver : public CKNNSolver
+{
+	public:
+		/** default constructor */
+		CHNSWKNNSolver() : CKNNSolver()
+		{
+			init();
+		}
+
+		/** deconstructor */
+		virtual ~CHNSWKNNSolver() { /* nothing to do */ }
+
+		/** constructor
+		 *
+		 * @param k k
+		 * @param q m_q
+		 * @param num_classes m_num_classes
+		 * @param min_label m_min_label
+		 * @param train_labels m_train_labels
+		 * @param max_connections m_max_connections
+		 * @param ef_construction m_ef_construction
+		 * @param ef_search m_ef_search
+		 */
+		CHNSWKNNSolver(const int32_t k, const float64_t q, const int32_t num_classes, const int32_t min_label, const SGVector<int32_t> train_labels, const int32_t max_connections, const int32_t ef_construction, const int32_t ef_search);
+
+		virtual CMulticlassLabels* classify_objects(CDistance* d, const int32_t num_lab, SGVector<int32_t>& train_lab, SGVector<float64_t>& classes) const;
+
+		virtual SGVector<int32_t> classify_objects_k(CDistance* d, const int32_t num_lab, SGVector<int32_t>& train_lab, SGVector<int32_t>& classes) const;
+
+		/** @return object name */
+		const char* get_name() const { return "HNSWKNNSolver"; }
+
+	private:
+		void init()
+		{
+			m_max_connections=16;
+			m_ef_construction=200;
+			m_ef_search=50;
+		}
+
+		/** build the graph on the lhs of the distance and query the rhs,
+		 * queries for which the graph search reaches fewer than k points
+		 * are answered by brute force
+		 *
+		 * @param d distance
+		 * @return k x n matrix of neighbor indices, closest first
+		 */
+		SGMatrix<index_t> nearest_neighbors(CDistance* d) const;
+
+	protected:
+		/* Number of links per node of the graph */
+		int32_t m_max_connections;
+
+		/* Beam width while building the graph */
+		int32_t m_ef_construction;
+
+		/* Beam width while querying the graph */
+		int32_t m_ef_search;
+};
+}
+
+#endif
@@ -6,8 +6,10 @@
  *          Evgeniy Andreev, Viktor Gal, Bjoern Esser
  */
 
+#include <shogun/base/Parallel.h>
 #include <shogun/base/Parameter.h>
 #include <shogun/base/progress.h>
+#include <shogun/features/DenseFeatures.h>
 #include <shogun/labels/Labels.h>
 #include <shogun/lib/Signal.h>
 #include <shogun/lib/Time.h>
@@ -16,6 +18,10 @@
 
 #include <shogun/mathematics/linalg/LinalgNamespace.h>
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 //#define DEBUG_KNN
 
 using namespace shogun;
@@ -52,10 +58,14 @@ void CKNN::init()
 	m_q=1.0;
 	m_num_classes=0;
 	m_leaf_size=1;
+	m_batch_size=512;
 	m_knn_solver=KNN_BRUTE;
 	solver=NULL;
 	m_lsh_l = 0;
 	m_lsh_t = 0;
+	m_hnsw_max_connections = 16;
+	m_hnsw_ef_construction = 200;
+	m_hnsw_ef_search = 50;
 
 	/* use the method classify_multiply_k to experiment with different values
 	 * of k */
@@ -63,7 +73,15 @@ void CKNN::init()
 	SG_ADD(&m_q, "q", "Parameter q", MS_AVAILABLE);
 	SG_ADD(&m_num_classes, "num_classes", "Number of classes", MS_NOT_AVAILABLE);
 	SG_ADD(&m_leaf_size, "leaf_size", "Leaf size for KDTree", MS_NOT_AVAILABLE);
+	SG_ADD(&m_batch_size, "batch_size", "Vectors per distance tile",
+			MS_NOT_AVAILABLE);
 	SG_ADD((machine_int_t*) &m_knn_solver, "knn_solver", "Algorithm to solve knn", MS_NOT_AVAILABLE);
+	SG_ADD(&m_hnsw_max_connections, "hnsw_max_connections",
+			"Links per node of the HNSW graph", MS_NOT_AVAILABLE);
+	SG_ADD(&m_hnsw_ef_construction, "hnsw_ef_construction",
+			"Beam width while building the HNSW graph", MS_NOT_AVAILABLE);
+	SG_ADD(&m_hnsw_ef_search, "hnsw_ef_search",
+			"Beam width while querying the HNSW graph", MS_NOT_AVAILABLE);
 }
 
 CKNN::~CKNN()
@@ -113,6 +131,9 @@ SGMatrix<index_t> CKNN::nearest_neighbors()
 	    n >= m_k,
 	    "K (%d) must not be larger than the number of examples (%d).\n", m_k, n)
 
+	if (use_batched_distances())
+		return nearest_neighbors_batched(m_k);
+
 	//distances to train data
 	SGVector<float64_t> dists(m_train_labels.vlen);
 	//indices to train data
@@ -200,6 +221,15 @@ CMulticlassLabels* CKNN::classify_NN()
 
 	SG_INFO("%d test examples\n", num_lab)
 
+	if (use_batched_distances())
+	{
+		SGMatrix<index_t> NN=nearest_neighbors_batched(1);
+		for (int32_t i=0; i<num_lab; i++)
+			output->set_label(i, m_train_labels.vector[NN(0, i)]+m_min_label);
+
+		return output;
+	}
+
 	distance->precompute_lhs();
 
 	// for each test example
@@ -233,6 +263,144 @@ CMulticlassLabels* CKNN::classify_NN()
 	return output;
 }
 
+void CKNN::set_batch_size(int32_t batch_size)
+{
+	REQUIRE(batch_size>=0, "Batch size (%d) must not be negative\n",
+			batch_size);
+	m_batch_size=batch_size;
+}
+
+void CKNN::set_hnsw_parameters(int32_t max_connections,
+		int32_t ef_construction, int32_t ef_search)
+{
+	REQUIRE(max_connections>1, "Number of connections (%d) must be at least "
+			"2\n", max_connections);
+	REQUIRE(ef_construction>0 && ef_search>0, "Beam widths (%d, %d) must be "
+			"positive\n", ef_construction, ef_search);
+	m_hnsw_max_connections=max_connections;
+	m_hnsw_ef_construction=ef_construction;
+	m_hnsw_ef_search=ef_search;
+}
+
+bool CKNN::use_batched_distances()
+{
+	if (m_batch_size==0 || distance->get_distance_type()!=D_EUCLIDEAN)
+		return false;
+
+	CFeatures* lhs=distance->get_lhs();
+	CFeatures* rhs=distance->get_rhs();
+	bool dense=lhs && rhs &&
+			lhs->get_feature_class()==C_DENSE && lhs->get_feature_type()==F_DREAL &&
+			rhs->get_feature_class()==C_DENSE && rhs->get_feature_type()==F_DREAL;
+	SG_UNREF(lhs);
+	SG_UNREF(rhs);
+
+	return dense;
+}
+
+/** squared norm of each column */
+static SGVector<float64_t> squared_norms(const SGMatrix<float64_t>& mat)
+{
+	SGVector<float64_t> norms(mat.num_cols);
+	for (index_t i=0; i<mat.num_cols; i++)
+	{
+		SGVector<float64_t> col(mat.get_column_vector(i), mat.num_rows, false);
+		norms[i]=linalg::dot(col, col);
+	}
+
+	return norms;
+}
+
+SGMatrix<index_t> CKNN::nearest_neighbors_batched(int32_t k)
+{
+	CDenseFeatures<float64_t>* lhs=(CDenseFeatures<float64_t>*) distance->get_lhs();
+	CDenseFeatures<float64_t>* rhs=(CDenseFeatures<float64_t>*) distance->get_rhs();
+	SGMatrix<float64_t> train=lhs->get_feature_matrix();
+	SGMatrix<float64_t> test=rhs->get_feature_matrix();
+	SG_UNREF(lhs);
+	SG_UNREF(rhs);
+
+	REQUIRE(train.num_rows==test.num_rows, "Dimension of training (%d) and "
+			"test vectors (%d) differ\n", train.num_rows, test.num_rows);
+	REQUIRE(k<=train.num_cols, "K (%d) must not be larger than the number of "
+			"training vectors (%d)\n", k, train.num_cols);
+
+	index_t dim=train.num_rows;
+	index_t num_train=train.num_cols;
+	index_t num_test=test.num_cols;
+	index_t block=m_batch_size;
+	SGVector<float64_t> train_norms=squared_norms(train);
+	SGVector<float64_t> test_norms=squared_norms(test);
+	SGMatrix<index_t> NN(k, num_test);
+
+	int64_t num_blocks=(num_test+block-1)/block;
+	parallel->parallel_for(0, num_blocks, [&](int64_t first_block, int64_t last_block)
+	{
+		SGMatrix<float64_t> tile(block, block);
+
+		// max-heaps of (squared distance, index) of the k best so far, ties
+		// are broken towards the smaller index
+		typedef std::pair<float64_t, index_t> neighbor_t;
+		std::vector<std::vector<neighbor_t> > heaps(block);
+
+		for (int64_t b=first_block; b<last_block; b++)
+		{
+			COMPUTATION_CONTROLLERS
+
+			index_t q0=b*block;
+			index_t qn=CMath::min(block, num_test-q0);
+			SGMatrix<float64_t> queries(test.get_column_vector(q0), dim, qn, false);
+			for (index_t j=0; j<qn; j++)
+			{
+				heaps[j].clear();
+				heaps[j].reserve(k);
+			}
+
+			for (index_t t0=0; t0<num_train; t0+=block)
+			{
+				index_t tn=CMath::min(block, num_train-t0);
+				SGMatrix<float64_t> train_block(train.get_column_vector(t0), dim, tn, false);
+				SGMatrix<float64_t> dots(tile.matrix, tn, qn, false);
+				linalg::matrix_prod(train_block, queries, dots, true, false);
+
+				for (index_t j=0; j<qn; j++)
+				{
+					std::vector<neighbor_t>& heap=heaps[j];
+					float64_t query_norm=test_norms[q0+j];
+					const float64_t* dot=dots.get_column_vector(j);
+
+					for (index_t i=0; i<tn; i++)
+					{
+						float64_t dist=CMath::max(0.0,
+								train_norms[t0+i]+query_norm-2*dot[i]);
+
+						if ((int32_t) heap.size()<k)
+						{
+							heap.push_back(neighbor_t(dist, t0+i));
+							std::push_heap(heap.begin(), heap.end());
+						}
+						else if (dist<heap.front().first)
+						{
+							std::pop_heap(heap.begin(), heap.end());
+							heap.back()=neighbor_t(dist, t0+i);
+							std::push_heap(heap.begin(), heap.end());
+						}
+					}
+				}
+			}
+
+			for (index_t j=0; j<qn; j++)
+			{
+				std::sort_heap(heaps[j].begin(), heaps[j].end());
+				for (int32_t l=0; l<k; l++)
+					NN(l, q0+j)=heaps[j][l].second;
+			}
+		}
+	}, 1);
+
+	return NN;
+}
+
 SGMatrix<int32_t> CKNN::classify_for_multiple_k()
 {
 	REQUIRE(distance, "Distance not set.\n");
@@ -334,5 +502,11 @@ void CKNN::init_solver(KNN_SOLVER knn_solver)
 		SG_REF(solver);
 		break;
 	}
+	case KNN_HNSW:
+	{
+		solver = new CHNSWKNNSolver(m_k, m_q, m_num_classes, m_min_label, m_train_labels, m_hnsw_max_connections, m_hnsw_ef_construction, m_hnsw_ef_search);
+		SG_REF(solver);
+		break;
+	}
 	}
 }
@@ -24,6 +24,7 @@
 #include <shogun/multiclass/CoverTreeKNNSolver.h>
 #endif
 #include <shogun/multiclass/LSHKNNSolver.h>
+#include <shogun/multiclass/HNSWKNNSolver.h>
 
 namespace shogun
 {
@@ -32,7 +33,8 @@ namespace shogun
 		KNN_BRUTE,
 		KNN_KDTREE,
 		KNN_COVER_TREE,
-		KNN_LSH
+		KNN_LSH,
+		KNN_HNSW
 	};
 
 class CDistanceMachine;
@@ -200,6 +202,22 @@ class CKNN : public CDistanceMachine
 			m_knn_solver = knn_solver;
 		}
 
+		/** set the number of query and training vectors per distance tile
+		 * of the brute force solver. For Euclidean distances on dense real
+		 * features, distances are computed tile by tile as
+		 * |x|^2+|y|^2-2x'y with one matrix product per tile, and the k
+		 * nearest neighbors of each query are selected with a bounded heap
+		 * instead of sorting all distances. Query tiles are processed in
+		 * parallel.
+		 *
+		 * @param batch_size vectors per tile, 0 computes the distances one
+		 * pair at a time
+		 */
+		void set_batch_size(int32_t batch_size);
+
+		/** @return number of vectors per distance tile */
+		int32_t get_batch_size() const { return m_batch_size; }
+
 		/** set parameters for LSH solver
 		  * @param l number of hash tables for LSH
 		  * @param t number of probes per query for LSH
@@ -210,6 +228,13 @@ class CKNN : public CDistanceMachine
 			m_lsh_t = t;
 		}
 
+		/** set parameters for HNSW solver
+		  * @param max_connections number of links per node of the graph
+		  * @param ef_construction beam width while building the graph
+		  * @param ef_search beam width while querying the graph, at least k
+		  */
+		void set_hnsw_parameters(int32_t max_connections, int32_t ef_construction, int32_t ef_search);
+
 	protected:
 		/** Stores feature data of underlying model.
 		 *
@@ -273,6 +298,19 @@ class CKNN : public CDistanceMachine
 		 */
 		void init_solver(KNN_SOLVER knn_solver);
 
+		/** @return whether the distances can be computed in tiles, i.e. the
+		 * distance is Euclidean on dense real features and tiles are enabled
+		 */
+		bool use_batched_distances();
+
+		/** find the nearest neighbors of all rhs vectors among the lhs
+		 * vectors of the Euclidean distance, tile by tile
+		 *
+		 * @param k number of neighbors
+		 * @return k x n matrix of neighbor indices, closest first
+		 */
+		SGMatrix<index_t> nearest_neighbors_batched(int32_t k);
+
 	protected:
 		/// the k parameter in KNN
 		int32_t m_k;
@@ -296,11 +334,23 @@ class CKNN : public CDistanceMachine
 
 		int32_t m_leaf_size;
 
+		/** number of query and training vectors per distance tile */
+		int32_t m_batch_size;
+
 		/* Number of hash tables for LSH */
 		int32_t m_lsh_l;
 
 		/* Number of probes per query for LSH */
 		int32_t m_lsh_t;
+
+		/* Number of links per node for HNSW */
+		int32_t m_hnsw_max_connections;
+
+		/* Beam width while building the HNSW graph */
+		int32_t m_hnsw_ef_construction;
+
+		/* Beam width while querying the HNSW graph */
+		int32_t m_hnsw_ef_search;
 };
 
 }
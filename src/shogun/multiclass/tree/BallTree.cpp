@@ -40,7 +40,7 @@ CBallTree::CBallTree(int32_t leaf_size, EDistanceType d)
 float64_t CBallTree::min_dist(bnode_t* node,float64_t* feat, int32_t dim)
 {
 	float64_t dist=0;
-	SGVector<float64_t> center=node->data.center;
+	const SGVector<float64_t>& center=node->data.center;
 	for (int32_t i=0;i<dim;i++)
 		dist+=add_dim_dist(center[i]-feat[i]);
 
@@ -51,8 +51,8 @@ float64_t CBallTree::min_dist(bnode_t* node,float64_t* feat, int32_t dim)
 float64_t CBallTree::min_dist_dual(bnode_t* nodeq, bnode_t* noder)
 {
 	float64_t dist=0;
-	SGVector<float64_t> center1=nodeq->data.center;
-	SGVector<float64_t> center2=noder->data.center;
+	const SGVector<float64_t>& center1=nodeq->data.center;
+	const SGVector<float64_t>& center2=noder->data.center;
 	for (int32_t i=0;i<center1.vlen;i++)
 		dist+=add_dim_dist(center1[i]-center2[i]);
 
@@ -63,8 +63,8 @@ float64_t CBallTree::min_dist_dual(bnode_t* nodeq, bnode_t* noder)
 float64_t CBallTree::max_dist_dual(bnode_t* nodeq, bnode_t* noder)
 {
 	float64_t dist=0;
-	SGVector<float64_t> center1=nodeq->data.center;
-	SGVector<float64_t> center2=noder->data.center;
+	const SGVector<float64_t>& center1=nodeq->data.center;
+	const SGVector<float64_t>& center2=noder->data.center;
 	for (int32_t i=0;i<center1.vlen;i++)
 		dist+=add_dim_dist(center1[i]-center2[i]);
 
@@ -75,7 +75,7 @@ float64_t CBallTree::max_dist_dual(bnode_t* nodeq, bnode_t* noder)
 void CBallTree::min_max_dist(float64_t* pt, bnode_t* node, float64_t &lower,float64_t &upper, int32_t dim)
 {
 	float64_t dist=0;
-	SGVector<float64_t> center=node->data.center;
+	const SGVector<float64_t>& center=node->data.center;
 	for (int32_t i=0;i<dim;i++)
 		dist+=add_dim_dist(center[i]-pt[i]);
 
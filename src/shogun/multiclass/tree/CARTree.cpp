@@ -28,6 +28,7 @@
  * either expressed or implied, of the Shogun Development Team.
  */
 
+#include <algorithm>
 #include <vector>
 
 #include <shogun/lib/View.h>
@@ -35,6 +36,7 @@
 #include <shogun/mathematics/eigen3.h>
 #include <shogun/mathematics/linalg/LinalgNamespace.h>
 #include <shogun/multiclass/tree/CARTree.h>
+#include <shogun/multiclass/tree/FlatTreeEnsemble.h>
 
 using namespace Eigen;
 using namespace shogun;
@@ -42,6 +44,7 @@ using namespace shogun;
 const float64_t CCARTree::MISSING=CMath::MAX_REAL_NUMBER;
 const float64_t CCARTree::EQ_DELTA=1e-7;
 const float64_t CCARTree::MIN_SPLIT_GAIN=1e-7;
+const int32_t CCARTree::MAX_ENUMERATED_CATEGORIES=12;
 
 CCARTree::CCARTree()
 : CTreeMachine<CARTreeNodeData>()
@@ -283,6 +286,19 @@ bool CCARTree::train_machine(CFeatures* data)
 	}
 
 	auto dense_labels = m_labels->as<CDenseLabels>();
+	if (m_num_bins>0)
+	{
+		if (!m_pre_bin)
+			pre_bin_features(dense_features, m_binned_features, m_bin_thresholds);
+
+		if (m_mode==PT_MULTICLASS)
+		{
+			m_label_values=dense_labels->get_labels().clone();
+			std::sort(m_label_values.begin(), m_label_values.end());
+			m_label_values.vlen=std::unique(m_label_values.begin(), m_label_values.end())-m_label_values.begin();
+		}
+	}
+
 	set_root(CARTtrain(dense_features,m_weights,dense_labels,0));
 
 	if (m_apply_cv_pruning)
@@ -290,6 +306,13 @@ bool CCARTree::train_machine(CFeatures* data)
 		prune_by_cross_validation(dense_features,m_folds);
 	}
 
+	// quantized features are only kept if they are shared with other trees
+	if (m_num_bins>0 && !m_pre_bin)
+	{
+		m_binned_features=SGMatrix<uint8_t>();
+		m_bin_thresholds=SGMatrix<float64_t>();
+	}
+
 	return true;
 }
 
@@ -320,16 +343,115 @@ void CCARTree::pre_sort_features(CFeatures* data, SGMatrix<float64_t>& sorted_fe
 
 }
 
-CBinaryTreeMachineNode<CARTreeNodeData>* CCARTree::CARTtrain(CDenseFeatures<float64_t>* data, const SGVector<float64_t>& weights, CDenseLabels* labels, int32_t level)
+int32_t CCARTree::get_num_bins() const
+{
+	return m_num_bins;
+}
+
+void CCARTree::set_num_bins(int32_t num_bins)
+{
+	REQUIRE(num_bins>=0 && num_bins<=255,"Number of bins should be between 0 and 255. Supplied value is %d\n",num_bins)
+	m_num_bins=num_bins;
+}
+
+void CCARTree::set_binned_features(SGMatrix<uint8_t>& binned_feats, SGMatrix<float64_t>& bin_thresholds)
+{
+	REQUIRE(bin_thresholds.num_rows==m_num_bins,"Features are quantized into %d bins, %d are used for training\n",
+		bin_thresholds.num_rows,m_num_bins)
+
+	m_pre_bin=true;
+	m_binned_features=binned_feats;
+	m_bin_thresholds=bin_thresholds;
+}
+
+void CCARTree::pre_bin_features(CFeatures* data, SGMatrix<uint8_t>& binned_feats, SGMatrix<float64_t>& bin_thresholds)
+{
+	REQUIRE(m_num_bins>0,"Number of bins has to be set before quantizing features\n")
+	REQUIRE(data,"Data required for quantization\n")
+
+	// quantize all vectors, nodes address them through the subset indices
+	int32_t num_feats=0;
+	int32_t num_vecs=0;
+	float64_t* mat=data->as<CDenseFeatures<float64_t>>()->get_feature_matrix(num_feats, num_vecs);
+
+	binned_feats=SGMatrix<uint8_t>(num_vecs, num_feats);
+	bin_thresholds=SGMatrix<float64_t>(m_num_bins, num_feats);
+	bin_thresholds.set_const(MISSING);
+
+	index_t num_failed=0;
+	#pragma omp parallel for reduction(+:num_failed)
+	for (index_t attr=0; attr<num_feats; ++attr)
+	{
+		std::vector<float64_t> values;
+		values.reserve(num_vecs);
+		for (index_t i=0; i<num_vecs; ++i)
+		{
+			float64_t v=mat[int64_t(i)*num_feats+attr];
+			if (v!=MISSING)
+				values.push_back(v);
+		}
+		std::sort(values.begin(), values.end());
+
+		index_t num_distinct=0;
+		for (index_t j=0; j<(index_t)values.size(); ++j)
+		{
+			if (j==0 || values[j]!=values[j-1])
+				num_distinct++;
+		}
+
+		// every distinct value gets its own bin if possible, otherwise bins hold equally many values
+		float64_t* thresholds=bin_thresholds.get_column_vector(attr);
+		index_t num_thresholds=0;
+		if (num_distinct<=m_num_bins)
+		{
+			for (index_t j=0; j<(index_t)values.size(); ++j)
+			{
+				if (j==0 || values[j]!=values[j-1])
+					thresholds[num_thresholds++]=values[j];
+			}
+		}
+		else
+		{
+			if (m_nominal.vlen>attr && m_nominal[attr])
+				num_failed++;
+
+			for (index_t b=0; b<m_num_bins; ++b)
+			{
+				float64_t t=values[(int64_t(b+1)*values.size())/m_num_bins-1];
+				if (num_thresholds==0 || t>thresholds[num_thresholds-1])
+					thresholds[num_thresholds++]=t;
+			}
+		}
+
+		uint8_t* bins=binned_feats.get_column_vector(attr);
+		for (index_t i=0; i<num_vecs; ++i)
+		{
+			float64_t v=mat[int64_t(i)*num_feats+attr];
+			if (v==MISSING)
+				bins[i]=m_num_bins;
+			else
+				bins[i]=std::lower_bound(thresholds, thresholds+num_thresholds, v)-thresholds;
+		}
+	}
+
+	REQUIRE(num_failed==0,"%d nominal attributes have more categories than bins (%d)\n",num_failed,m_num_bins)
+}
+
+CBinaryTreeMachineNode<CARTreeNodeData>* CCARTree::CARTtrain(CDenseFeatures<float64_t>* data, const SGVector<float64_t>& weights, CDenseLabels* labels,
+	int32_t level, SGVector<float64_t> histogram)
 {
 	REQUIRE(labels,"labels have to be supplied\n");
 	REQUIRE(data,"data matrix has to be supplied\n");
 
 	bnode_t* node=new bnode_t();
 	auto labels_vec = labels->get_labels();
-	auto mat = data->get_feature_matrix();
-	auto num_feats=mat.num_rows;
-	auto num_vecs=mat.num_cols;
+	auto num_feats=data->get_num_features();
+	auto num_vecs=data->get_num_vectors();
+
+	// the data matrix is not needed for histogram based splits unless values are missing
+	SGMatrix<float64_t> mat;
+	if (m_num_bins==0)
+		mat=data->get_feature_matrix();
 
 	// calculate node label
 	switch(m_mode)
@@ -419,7 +541,7 @@ CBinaryTreeMachineNode<CARTreeNodeData>* CCARTree::CARTtrain(CDenseFeatures<floa
 	int32_t best_attribute;
 
 	SGVector<index_t> indices(num_vecs);
-	if (m_pre_sort)
+	if (m_pre_sort || m_num_bins>0)
 	{
 		CSubsetStack* subset_stack = data->get_subset_stack();
 		if (subset_stack->has_subsets())
@@ -427,8 +549,17 @@ CBinaryTreeMachineNode<CARTreeNodeData>* CCARTree::CARTtrain(CDenseFeatures<floa
 		else
 			linalg::range_fill(indices);
 		SG_UNREF(subset_stack);
-		best_attribute=compute_best_attribute(m_sorted_features,weights,labels,left,right,left_final,num_missing_final,c_left,c_right,0,indices);
 	}
+
+	if (m_num_bins>0)
+	{
+		// only the root computes its histogram, the others are derived by the parent
+		if (histogram.vlen==0)
+			histogram=compute_histogram(indices, labels_vec, weights);
+		best_attribute=compute_best_attribute(mat,weights,labels,left,right,left_final,num_missing_final,c_left,c_right,0,indices,histogram);
+	}
+	else if (m_pre_sort)
+		best_attribute=compute_best_attribute(m_sorted_features,weights,labels,left,right,left_final,num_missing_final,c_left,c_right,0,indices);
 	else
 		best_attribute=compute_best_attribute(mat,weights,labels,left,right,left_final,num_missing_final,c_left,c_right);
 
@@ -446,6 +577,9 @@ CBinaryTreeMachineNode<CARTreeNodeData>* CCARTree::CARTtrain(CDenseFeatures<floa
 
 	if (num_missing_final>0)
 	{
+		if (!mat.matrix)
+			mat=data->get_feature_matrix();
+
 		SGVector<bool> is_left_final(num_vecs-num_missing_final);
 		int32_t ilf=0;
 		for (int32_t i=0;i<num_vecs;++i)
@@ -479,17 +613,41 @@ CBinaryTreeMachineNode<CARTreeNodeData>* CCARTree::CARTtrain(CDenseFeatures<floa
 		}
 	}
 
+	// only the histogram of the smaller child is computed, the other one is the difference to the parent
+	SGVector<float64_t> histogram_left;
+	SGVector<float64_t> histogram_right;
+	if (m_num_bins>0)
+	{
+		bool smaller_left=(count_left<=num_vecs-count_left);
+		const SGVector<index_t>& subset=smaller_left ? subsetl : subsetr;
+		SGVector<index_t> child_indices(subset.vlen);
+		SGVector<float64_t> child_labels(subset.vlen);
+		for (index_t i=0; i<subset.vlen; ++i)
+		{
+			child_indices[i]=indices[subset[i]];
+			child_labels[i]=labels_vec[subset[i]];
+		}
+
+		SGVector<float64_t> smaller=compute_histogram(child_indices, child_labels, smaller_left ? weightsl : weightsr);
+		SGVector<float64_t> larger=linalg::add(histogram, smaller, 1.0, -1.0);
+		histogram_left=smaller_left ? smaller : larger;
+		histogram_right=smaller_left ? larger : smaller;
+		histogram=SGVector<float64_t>();
+	}
+
 	// left child
 	auto feats_train = view(data, subsetl);
 	auto labels_train = view(labels, subsetl);
 	bnode_t* left_child =
-	    CARTtrain(feats_train, weightsl, labels_train, level + 1);
+	    CARTtrain(feats_train, weightsl, labels_train, level + 1, histogram_left);
+	histogram_left=SGVector<float64_t>();
 
 	// right child
 	feats_train = view(data, subsetr);
 	labels_train = view(labels, subsetr);
 	bnode_t* right_child =
-	    CARTtrain(feats_train, weightsr, labels_train, level + 1);
+	    CARTtrain(feats_train, weightsr, labels_train, level + 1, histogram_right);
+	histogram_right=SGVector<float64_t>();
 
 	// set node parameters
 	node->data.attribute_id=best_attribute;
@@ -529,8 +687,11 @@ SGVector<float64_t> CCARTree::get_unique_labels(const SGVector<float64_t>& label
 
 index_t CCARTree::compute_best_attribute(const SGMatrix<float64_t>& mat, const SGVector<float64_t>& weights, CDenseLabels* labels,
 	SGVector<float64_t>& left, SGVector<float64_t>& right, SGVector<bool>& is_left_final, index_t &num_missing_final, index_t &count_left,
-	index_t &count_right, index_t subset_size, const SGVector<index_t>& active_indices)
+	index_t &count_right, index_t subset_size, const SGVector<index_t>& active_indices, const SGVector<float64_t>& histogram)
 {
+	if (m_num_bins>0)
+		return compute_best_attribute_binned(weights,labels,left,right,is_left_final,num_missing_final,count_left,count_right,subset_size,active_indices,histogram);
+
 	auto labels_vec=labels->get_labels();
 	auto num_vecs=labels->get_num_labels();
 	auto num_feats = (m_pre_sort) ? mat.num_cols : mat.num_rows;
@@ -838,6 +999,331 @@ index_t CCARTree::compute_best_attribute(const SGMatrix<float64_t>& mat, const S
 	return best_attribute;
 }
 
+index_t CCARTree::compute_best_attribute_binned(const SGVector<float64_t>& weights, CDenseLabels* labels,
+	SGVector<float64_t>& left, SGVector<float64_t>& right, SGVector<bool>& is_left_final, index_t &num_missing_final,
+	index_t &count_left, index_t &count_right, index_t subset_size, const SGVector<index_t>& active_indices,
+	const SGVector<float64_t>& histogram)
+{
+	REQUIRE(histogram.vlen>0,"Histogram of the node has to be supplied\n")
+
+	auto labels_vec=labels->get_labels();
+	auto num_vecs=labels_vec.vlen;
+	auto num_feats=m_binned_features.num_cols;
+
+	// if all labels same early stop
+	float64_t delta=0;
+	if (m_mode==PT_REGRESSION)
+		delta=m_label_epsilon;
+
+	if (CMath::max(labels_vec.vector, num_vecs)<=CMath::min(labels_vec.vector, num_vecs)+delta)
+		return -1;
+
+	index_t num_stats=get_num_histogram_stats();
+	index_t attribute_size=(m_num_bins+1)*num_stats;
+
+	SGVector<index_t> idx(num_feats);
+	linalg::range_fill(idx);
+	if (subset_size)
+	{
+		num_feats=subset_size;
+		CMath::permute(idx);
+	}
+
+	SGVector<float64_t> gains(num_feats);
+	std::vector<SGVector<bool>> splits(num_feats);
+	#pragma omp parallel for
+	for (index_t i=0;i<num_feats;++i)
+	{
+		gains[i]=MIN_SPLIT_GAIN;
+		splits[i]=SGVector<bool>(m_num_bins);
+		find_best_binned_split(histogram.vector+idx[i]*attribute_size, m_nominal[idx[i]], gains[i], splits[i]);
+	}
+
+	float64_t max_gain=MIN_SPLIT_GAIN;
+	index_t best=-1;
+	for (index_t i=0;i<num_feats;++i)
+	{
+		if (gains[i]>max_gain)
+		{
+			max_gain=gains[i];
+			best=i;
+		}
+	}
+
+	if (best==-1)
+		return -1;
+
+	index_t best_attribute=idx[best];
+	const float64_t* attribute_histogram=histogram.vector+best_attribute*attribute_size;
+	const float64_t* thresholds=m_bin_thresholds.get_column_vector(best_attribute);
+	num_missing_final=(index_t) attribute_histogram[m_num_bins*num_stats];
+
+	const SGVector<bool>& bin_left=splits[best];
+	if (m_nominal[best_attribute])
+	{
+		std::vector<index_t> categories;
+		for (index_t b=0;b<m_num_bins;++b)
+		{
+			if (attribute_histogram[b*num_stats]>0)
+				categories.push_back(b);
+		}
+
+		if (left.vlen<(index_t)categories.size())
+			left.resize_vector(categories.size());
+		if (right.vlen<(index_t)categories.size())
+			right.resize_vector(categories.size());
+
+		count_left=0;
+		count_right=0;
+		for (index_t c=0;c<(index_t)categories.size();++c)
+		{
+			if (bin_left[categories[c]])
+				left[count_left++]=thresholds[categories[c]];
+			else
+				right[count_right++]=thresholds[categories[c]];
+		}
+	}
+	else
+	{
+		// the lower bins go left, the threshold is the upper boundary of the last one
+		index_t split=0;
+		while (split+1<m_num_bins && bin_left[split+1])
+			++split;
+
+		left[0]=thresholds[split];
+		right[0]=thresholds[split];
+		count_left=1;
+		count_right=1;
+	}
+
+	const uint8_t* bins=m_binned_features.get_column_vector(best_attribute);
+	for (index_t i=0;i<num_vecs;++i)
+	{
+		uint8_t b=bins[active_indices[i]];
+		is_left_final[i]=(b<m_num_bins) && bin_left[b];
+	}
+
+	return best_attribute;
+}
+
+SGVector<float64_t> CCARTree::compute_histogram(const SGVector<index_t>& indices, const SGVector<float64_t>& labels_vec,
+	const SGVector<float64_t>& weights) const
+{
+	auto num_feats=m_binned_features.num_cols;
+	index_t num_stats=get_num_histogram_stats();
+	index_t attribute_size=(m_num_bins+1)*num_stats;
+
+	SGVector<float64_t> histogram(num_feats*attribute_size);
+	linalg::zero(histogram);
+
+	// position of the class weight in the statistics of a bin
+	SGVector<index_t> stat_index(indices.vlen);
+	for (index_t i=0;i<indices.vlen;++i)
+	{
+		if (m_mode==PT_MULTICLASS)
+		{
+			const float64_t* values=m_label_values.vector;
+			stat_index[i]=1+(std::lower_bound(values, values+m_label_values.vlen, labels_vec[i])-values);
+		}
+		else
+			stat_index[i]=1;
+	}
+
+	#pragma omp parallel for
+	for (index_t attr=0;attr<num_feats;++attr)
+	{
+		float64_t* attribute_histogram=histogram.vector+attr*attribute_size;
+		const uint8_t* bins=m_binned_features.get_column_vector(attr);
+		for (index_t i=0;i<indices.vlen;++i)
+		{
+			float64_t* stats=attribute_histogram+bins[indices[i]]*num_stats;
+			stats[0]+=1;
+			stats[stat_index[i]]+=weights[i];
+			if (m_mode==PT_REGRESSION)
+				stats[2]+=weights[i]*labels_vec[i];
+		}
+	}
+
+	return histogram;
+}
+
+index_t CCARTree::get_num_histogram_stats() const
+{
+	if (m_mode==PT_REGRESSION)
+		return 3;
+
+	return 1+m_label_values.vlen;
+}
+
+void CCARTree::find_best_binned_split(const float64_t* histogram, bool nominal, float64_t& best_gain, SGVector<bool>& bin_left) const
+{
+	index_t num_stats=get_num_histogram_stats();
+
+	// statistics of all non-missing values
+	SGVector<float64_t> total(num_stats);
+	SGVector<float64_t> left(num_stats);
+	linalg::zero(total);
+	linalg::zero(left);
+	std::vector<index_t> nonempty;
+	for (index_t b=0;b<m_num_bins;++b)
+	{
+		const float64_t* stats=histogram+b*num_stats;
+		if (stats[0]<=0)
+			continue;
+
+		nonempty.push_back(b);
+		for (index_t s=0;s<num_stats;++s)
+			total[s]+=stats[s];
+	}
+
+	// if only one unique value - it cannot be used to split
+	if (nonempty.size()<2)
+		return;
+
+	bool two_class=(m_mode==PT_MULTICLASS && m_label_values.vlen==2);
+	if (nominal && m_mode==PT_MULTICLASS && !two_class && (index_t)nonempty.size()<=MAX_ENUMERATED_CATEGORIES)
+	{
+		// test all 2^(I-1)-1 possible divisions of the present categories, the last one always goes right
+		int64_t num_cases=int64_t(1)<<(nonempty.size()-1);
+		int64_t best_case=0;
+		for (int64_t k=1;k<num_cases;++k)
+		{
+			linalg::zero(left);
+			for (index_t c=0;c<(index_t)nonempty.size()-1;++c)
+			{
+				if ((k>>c)&1)
+				{
+					const float64_t* stats=histogram+nonempty[c]*num_stats;
+					for (index_t s=0;s<num_stats;++s)
+						left[s]+=stats[s];
+				}
+			}
+
+			float64_t g=binned_gain(left.vector, total.vector);
+			if (g>best_gain)
+			{
+				best_gain=g;
+				best_case=k;
+			}
+		}
+
+		if (best_case>0)
+		{
+			bin_left.zero();
+			for (index_t c=0;c<(index_t)nonempty.size()-1;++c)
+				bin_left[nonempty[c]]=(best_case>>c)&1;
+		}
+		return;
+	}
+
+	// continuous attributes are split between consecutive non-empty bins, the categories of nominal ones
+	// are ordered by their mean label or by their fraction of the most frequent class first
+	if (nominal)
+	{
+		index_t ref=m_mode==PT_REGRESSION ? 2 : 1;
+		if (m_mode==PT_MULTICLASS)
+		{
+			for (index_t s=2;s<num_stats;++s)
+			{
+				if (total[s]>total[ref])
+					ref=s;
+			}
+		}
+
+		SGVector<float64_t> score(m_num_bins);
+		for (index_t b : nonempty)
+		{
+			const float64_t* stats=histogram+b*num_stats;
+			float64_t weight=0;
+			if (m_mode==PT_REGRESSION)
+				weight=stats[1];
+			else
+			{
+				for (index_t s=1;s<num_stats;++s)
+					weight+=stats[s];
+			}
+			score[b]=weight>0 ? stats[ref]/weight : 0;
+		}
+
+		std::stable_sort(nonempty.begin(), nonempty.end(),
+			[&score](index_t a, index_t b) { return score[a]<score[b]; });
+	}
+
+	index_t best_prefix=-1;
+	for (index_t c=0;c<(index_t)nonempty.size()-1;++c)
+	{
+		const float64_t* stats=histogram+nonempty[c]*num_stats;
+		for (index_t s=0;s<num_stats;++s)
+			left[s]+=stats[s];
+
+		float64_t g=binned_gain(left.vector, total.vector);
+		if (g>best_gain)
+		{
+			best_gain=g;
+			best_prefix=c;
+		}
+	}
+
+	if (best_prefix<0)
+		return;
+
+	bin_left.zero();
+	if (nominal)
+	{
+		for (index_t c=0;c<=best_prefix;++c)
+			bin_left[nonempty[c]]=true;
+	}
+	else
+	{
+		for (index_t b=0;b<=nonempty[best_prefix];++b)
+			bin_left[b]=true;
+	}
+}
+
+float64_t CCARTree::binned_gain(const float64_t* left, const float64_t* total) const
+{
+	if (m_mode==PT_REGRESSION)
+	{
+		float64_t total_weight=total[1];
+		float64_t total_lweight=left[1];
+		float64_t total_rweight=total_weight-total_lweight;
+		if (total_lweight<=0 || total_rweight<=0)
+			return 0;
+
+		// least squares deviation gain, the sums of squared labels cancel out
+		float64_t sum=total[2];
+		float64_t lsum=left[2];
+		float64_t rsum=sum-lsum;
+		return (lsum*lsum/total_lweight+rsum*rsum/total_rweight-sum*sum/total_weight)/total_weight;
+	}
+
+	float64_t total_weight=0;
+	float64_t total_lweight=0;
+	float64_t total_rweight=0;
+	float64_t gini_n=0;
+	float64_t gini_l=0;
+	float64_t gini_r=0;
+	for (index_t s=1;s<get_num_histogram_stats();++s)
+	{
+		float64_t wl=left[s];
+		float64_t wr=total[s]-left[s];
+		total_weight+=total[s];
+		total_lweight+=wl;
+		total_rweight+=wr;
+		gini_n+=total[s]*total[s];
+		gini_l+=wl*wl;
+		gini_r+=wr*wr;
+	}
+
+	if (total_lweight<=0 || total_rweight<=0)
+		return 0;
+
+	gini_n=1.0-gini_n/(total_weight*total_weight);
+	gini_l=1.0-gini_l/(total_lweight*total_lweight);
+	gini_r=1.0-gini_r/(total_rweight*total_rweight);
+	return gini_n-(gini_l*(total_lweight/total_weight))-(gini_r*(total_rweight/total_weight));
+}
+
 SGVector<bool> CCARTree::surrogate_split(SGMatrix<float64_t> m,SGVector<float64_t> weights, SGVector<bool> nm_left, int32_t attr) const
 {
 	// return vector - left/right belongingness
@@ -1092,64 +1578,12 @@ CLabels* CCARTree::apply_from_current_node(CDenseFeatures<float64_t>* feats, bno
 	auto num_vecs=feats->get_num_vectors();
 	REQUIRE(num_vecs>0, "No data provided in apply\n");
 
-	SGVector<float64_t> labels(num_vecs);
-	for (index_t i=0;i<num_vecs;++i)
-	{
-		auto sample=feats->get_feature_vector(i);
-		bnode_t* node=current;
-		SG_REF(node);
-
-		// until leaf is reached
-		while(node->data.num_leaves!=1)
-		{
-			bnode_t* leftchild=node->left();
-
-			if (m_nominal[node->data.attribute_id])
-			{
-				SGVector<float64_t> comp=leftchild->data.transit_into_values;
-				bool flag=false;
-				for (index_t k=0;k<comp.vlen;++k)
-				{
-					if (comp[k]==sample[node->data.attribute_id])
-					{
-						flag=true;
-						break;
-					}
-				}
-
-				if (flag)
-				{
-					SG_UNREF(node);
-					node=leftchild;
-					SG_REF(leftchild);
-				}
-				else
-				{
-					SG_UNREF(node);
-					node=node->right();
-				}
-			}
-			else
-			{
-				if (sample[node->data.attribute_id]<=leftchild->data.transit_into_values[0])
-				{
-					SG_UNREF(node);
-					node=leftchild;
-					SG_REF(leftchild);
-				}
-				else
-				{
-					SG_UNREF(node);
-					node=node->right();
-				}
-			}
-
-			SG_UNREF(leftchild);
-		}
-
-		labels[i]=node->data.node_label;
-		SG_UNREF(node);
-	}
+	// walk a flat copy of the tree rather than the refcounted nodes
+	CFlatTreeEnsemble* flat=new CFlatTreeEnsemble();
+	SG_REF(flat);
+	flat->add_tree(current, m_nominal);
+	SGVector<float64_t> labels=flat->apply_tree(feats, 0);
+	SG_UNREF(flat);
 
 	switch(m_mode)
 	{
@@ -1488,10 +1922,16 @@ void CCARTree::init()
 	m_label_epsilon=1e-7;
 	m_sorted_features=SGMatrix<float64_t>();
 	m_sorted_indices=SGMatrix<index_t>();
+	m_num_bins=0;
+	m_pre_bin=false;
 
 	SG_ADD(&m_pre_sort, "pre_sort", "presort", MS_NOT_AVAILABLE);
 	SG_ADD(&m_sorted_features, "sorted_features", "sorted feats", MS_NOT_AVAILABLE);
 	SG_ADD(&m_sorted_indices, "sorted_indices", "sorted indices", MS_NOT_AVAILABLE);
+	SG_ADD(&m_num_bins, "num_bins", "number of bins for histogram based splits", MS_NOT_AVAILABLE);
+	SG_ADD(&m_pre_bin, "pre_bin", "prebinned", MS_NOT_AVAILABLE);
+	SG_ADD(&m_binned_features, "binned_features", "quantized feats", MS_NOT_AVAILABLE);
+	SG_ADD(&m_bin_thresholds, "bin_thresholds", "bin boundaries", MS_NOT_AVAILABLE);
 	SG_ADD(&m_nominal, "nominal", "feature types", MS_NOT_AVAILABLE);
 	SG_ADD(&m_weights, "weights", "weights", MS_NOT_AVAILABLE);
 	SG_ADD(&m_weights_set, "weights_set", "weights set", MS_NOT_AVAILABLE);
@@ -74,7 +74,13 @@ namespace shogun
  * have been sent to left/right child. If all possible surrogate splits are used up but some data points are still to be
  * assigned left/right child, majority rule is used, ie. the data points are assigned the child where majority of data points
  * have gone from the node. \n
- * cf. http://pic.dhe.ibm.com/infocenter/spssstat/v20r0m0/index.jsp?topic=%2Fcom.ibm.spss.statistics.help%2Falg_tree-cart.htm
+ * cf. http://pic.dhe.ibm.com/infocenter/spssstat/v20r0m0/index.jsp?topic=%2Fcom.ibm.spss.statistics.help%2Falg_tree-cart.htm \n \n
+ *
+ * HISTOGRAM BASED SPLITS : \n
+ * For large datasets, the features can be quantized into at most 255 bins per attribute once before training (see set_num_bins()).
+ * Splits are then searched over the bin boundaries using per-node histograms of label weights, which are built in parallel across
+ * attributes in a single pass over the data of the node. Only the histogram of the smaller child of a split is built, the other
+ * one is obtained by subtracting it from the histogram of the parent. Nominal attributes must not have more categories than bins.
  */
 class CCARTree : public CTreeMachine<CARTreeNodeData>
 {
@@ -232,6 +238,33 @@ public:
 
 	void set_sorted_features(SGMatrix<float64_t>& sorted_feats, SGMatrix<index_t>& sorted_indices);
 
+	/** get number of bins features are quantized into
+	 *
+	 * @return number of bins, 0 if exact splits are searched
+	 */
+	int32_t get_num_bins() const;
+
+	/** set number of bins features are quantized into for histogram based split search
+	 *
+	 * @param num_bins number of bins (at most 255), 0 to search exact splits
+	 */
+	void set_num_bins(int32_t num_bins);
+
+	/** quantize all vectors of the features into at most get_num_bins() bins per attribute, ignoring any subset
+	 *
+	 * @param data training data
+	 * @param binned_feats bin of every feature, one column per attribute - missing values are put into bin get_num_bins()
+	 * @param bin_thresholds upper boundary of every bin, one column per attribute
+	 */
+	void pre_bin_features(CFeatures* data, SGMatrix<uint8_t>& binned_feats, SGMatrix<float64_t>& bin_thresholds);
+
+	/** use quantized features computed by pre_bin_features() in training
+	 *
+	 * @param binned_feats bin of every feature
+	 * @param bin_thresholds upper boundary of every bin
+	 */
+	void set_binned_features(SGMatrix<uint8_t>& binned_feats, SGMatrix<float64_t>& bin_thresholds);
+
 protected:
 	/** train machine - build CART from training data
 	 * @param data training data
@@ -245,9 +278,11 @@ protected:
 	 * @param weights vector of weights of data points
 	 * @param labels labels of data points
 	 * @param level current tree depth
+	 * @param histogram histogram of the node derived by the parent for histogram based splits, empty to compute it
 	 * @return pointer to the root of the CART subtree
 	 */
-	virtual CBinaryTreeMachineNode<CARTreeNodeData>* CARTtrain(CDenseFeatures<float64_t>* data, const SGVector<float64_t>& weights, CDenseLabels* labels, int32_t level);
+	virtual CBinaryTreeMachineNode<CARTreeNodeData>* CARTtrain(CDenseFeatures<float64_t>* data, const SGVector<float64_t>& weights, CDenseLabels* labels,
+		int32_t level, SGVector<float64_t> histogram=SGVector<float64_t>());
 
 	/** modify labels for compute_best_attribute
 	 *
@@ -268,12 +303,72 @@ protected:
 	 * @param num_missing number of missing attributes
 	 * @param count_left stores number of feature values for left transition
 	 * @param count_right stores number of feature values for right transition
+	 * @param subset_size number of randomly chosen attributes to consider, 0 for all
+	 * @param active_indices indices of the data vectors of the node in the sorted or quantized features
+	 * @param histogram histogram of the node for histogram based splits
 	 * @return index to the best attribute
 	 */
 	virtual index_t compute_best_attribute(const SGMatrix<float64_t>& mat, const SGVector<float64_t>& weights, CDenseLabels* labels,
 		SGVector<float64_t>& left, SGVector<float64_t>& right, SGVector<bool>& is_left_final, index_t &num_missing,
-		index_t &count_left, index_t &count_right, index_t subset_size=0, const SGVector<index_t>& active_indices=SGVector<index_t>());
+		index_t &count_left, index_t &count_right, index_t subset_size=0, const SGVector<index_t>& active_indices=SGVector<index_t>(),
+		const SGVector<float64_t>& histogram=SGVector<float64_t>());
 
+	/** computes best attribute for CARTtrain from histograms of quantized features
+	 *
+	 * @param weights data weights
+	 * @param labels data labels
+	 * @param left stores feature values for left transition
+	 * @param right stores feature values for right transition
+	 * @param is_left_final stores which feature vectors go to the left child
+	 * @param num_missing number of missing attributes
+	 * @param count_left stores number of feature values for left transition
+	 * @param count_right stores number of feature values for right transition
+	 * @param subset_size number of randomly chosen attributes to consider, 0 for all
+	 * @param active_indices indices of the data vectors of the node in the quantized features
+	 * @param histogram histogram of the node, see compute_histogram()
+	 * @return index to the best attribute
+	 */
+	index_t compute_best_attribute_binned(const SGVector<float64_t>& weights, CDenseLabels* labels,
+		SGVector<float64_t>& left, SGVector<float64_t>& right, SGVector<bool>& is_left_final, index_t &num_missing,
+		index_t &count_left, index_t &count_right, index_t subset_size, const SGVector<index_t>& active_indices,
+		const SGVector<float64_t>& histogram);
+
+	/** computes histogram of label statistics over the bins of all attributes
+	 *
+	 * @param indices indices of the data vectors in the quantized features
+	 * @param labels_vec labels of the data vectors
+	 * @param weights weights of the data vectors
+	 * @return histogram of size num_attributes x (num_bins+1) x get_num_histogram_stats()
+	 */
+	SGVector<float64_t> compute_histogram(const SGVector<index_t>& indices, const SGVector<float64_t>& labels_vec,
+		const SGVector<float64_t>& weights) const;
+
+	/** @return number of statistics per histogram bin - count and weight per class for classification,
+	 * count, weight and weighted label sum for regression
+	 */
+	index_t get_num_histogram_stats() const;
+
+	/** finds best split of an attribute in its histogram
+	 *
+	 * The categories of a nominal attribute are divided in all possible ways if there are at most
+	 * MAX_ENUMERATED_CATEGORIES of them. Otherwise, and always for regression and two classes, only the
+	 * divisions into a prefix and a suffix of the categories ordered by their mean label or by their fraction
+	 * of the most frequent class are tested. For regression and two classes this ordering contains the best division.
+	 *
+	 * @param histogram histogram of the attribute
+	 * @param nominal whether the attribute is nominal
+	 * @param best_gain stores gain of the best split, if better than the initial value
+	 * @param bin_left stores which bins go left if a better split is found
+	 */
+	void find_best_binned_split(const float64_t* histogram, bool nominal, float64_t& best_gain, SGVector<bool>& bin_left) const;
+
+	/** returns gain of a split from histogram statistics
+	 *
+	 * @param left statistics of the left child
+	 * @param total statistics of the current node
+	 * @return Gini gain for classification, least squared deviation gain for regression
+	 */
+	float64_t binned_gain(const float64_t* left, const float64_t* total) const;
 
 	/** handles missing values through surrogate splits
 	 *
@@ -422,6 +517,9 @@ public:
 	/** equality epsilon */
 	static const float64_t EQ_DELTA;
 
+	/** maximum number of categories of a nominal attribute for which all divisions are tested in histogram based splits */
+	static const int32_t MAX_ENUMERATED_CATEGORIES;
+
 protected:
 	/** equality range for regression labels */
 	float64_t m_label_epsilon;
@@ -441,6 +539,21 @@ protected:
 	/** If pre sorted features are used in train */
 	bool m_pre_sort;
 
+	/** number of bins features are quantized into, 0 for exact splits */
+	int32_t m_num_bins;
+
+	/** If pre binned features are used in train */
+	bool m_pre_bin;
+
+	/** quantized features, one column per attribute */
+	SGMatrix<uint8_t> m_binned_features;
+
+	/** upper boundaries of bins, one column per attribute */
+	SGMatrix<float64_t> m_bin_thresholds;
+
+	/** distinct training labels in classification */
+	SGVector<float64_t> m_label_values;
+
 	/** flag storing whether the type of various feature dimensions are specified using is_nominal_feature **/
 	bool m_types_set;
 
@@ -0,0 +1,253 @@
+/*
+ * This software is distributed under BSD 3-clause license (see LICENSE file).
+ */
+
+#include <shogun/base/Parallel.h>
+#include <shogun/multiclass/tree/CARTree.h>
+#include <shogun/multiclass/tree/FlatTreeEnsemble.h>
+
+using namespace shogun;
+
+/** append src to dst */
+template <class T>
+static void append(SGVector<T>& dst, const std::vector<T>& src)
+{
+	index_t old_len=dst.vlen;
+	dst.resize_vector(old_len+src.size());
+	for (size_t i=0; i<src.size(); i++)
+		dst[old_len+i]=src[i];
+}
+
+CFlatTreeEnsemble::CFlatTreeEnsemble() : CSGObject()
+{
+	init();
+}
+
+CFlatTreeEnsemble::~CFlatTreeEnsemble()
+{
+}
+
+void CFlatTreeEnsemble::init()
+{
+	m_num_attributes=0;
+	m_block_size=256;
+
+	SG_ADD(&m_roots, "roots", "Root node of each tree", MS_NOT_AVAILABLE);
+	SG_ADD(&m_attribute, "attribute", "Splitting attribute of each node",
+			MS_NOT_AVAILABLE);
+	SG_ADD(&m_threshold, "threshold", "Threshold of numeric splits",
+			MS_NOT_AVAILABLE);
+	SG_ADD(&m_right, "right", "Right child of each node", MS_NOT_AVAILABLE);
+	SG_ADD(&m_value, "value", "Label of each node", MS_NOT_AVAILABLE);
+	SG_ADD(&m_nominal_begin, "nominal_begin",
+			"Start of the left values of nominal splits", MS_NOT_AVAILABLE);
+	SG_ADD(&m_nominal_end, "nominal_end",
+			"End of the left values of nominal splits", MS_NOT_AVAILABLE);
+	SG_ADD(&m_nominal_values, "nominal_values",
+			"Left values of nominal splits", MS_NOT_AVAILABLE);
+	SG_ADD(&m_num_attributes, "num_attributes",
+			"Number of attributes the trees need", MS_NOT_AVAILABLE);
+	SG_ADD(&m_block_size, "block_size", "Number of vectors per task",
+			MS_NOT_AVAILABLE);
+}
+
+void CFlatTreeEnsemble::add_tree(CCARTree* tree)
+{
+	REQUIRE(tree, "Tree must not be NULL\n");
+
+	bnode_t* root=dynamic_cast<bnode_t*>(tree->get_root());
+	REQUIRE(root, "Tree is not trained\n");
+
+	add_tree(root, tree->get_feature_types());
+	SG_UNREF(root);
+}
+
+void CFlatTreeEnsemble::add_tree(bnode_t* root, SGVector<bool> nominal)
+{
+	REQUIRE(root, "Root node must not be NULL\n");
+
+	FlatNodes nodes;
+	flatten(root, nominal, nodes);
+
+	int32_t root_index=m_attribute.vlen;
+	m_roots.resize_vector(m_roots.vlen+1);
+	m_roots[m_roots.vlen-1]=root_index;
+
+	// make indices absolute, leaves and numeric splits keep their -1
+	int32_t nominal_offset=m_nominal_values.vlen;
+	for (size_t i=0; i<nodes.attribute.size(); i++)
+	{
+		if (nodes.right[i]>=0)
+			nodes.right[i]+=root_index;
+
+		if (nodes.nominal_begin[i]>=0)
+		{
+			nodes.nominal_begin[i]+=nominal_offset;
+			nodes.nominal_end[i]+=nominal_offset;
+		}
+	}
+
+	append(m_attribute, nodes.attribute);
+	append(m_threshold, nodes.threshold);
+	append(m_right, nodes.right);
+	append(m_value, nodes.value);
+	append(m_nominal_begin, nodes.nominal_begin);
+	append(m_nominal_end, nodes.nominal_end);
+	append(m_nominal_values, nodes.nominal_values);
+
+	for (size_t i=0; i<nodes.attribute.size(); i++)
+		m_num_attributes=CMath::max(m_num_attributes, nodes.attribute[i]+1);
+
+	SG_DEBUG("Added tree with %d nodes, %d nodes in total\n",
+			(int32_t) nodes.attribute.size(), m_attribute.vlen);
+}
+
+int32_t CFlatTreeEnsemble::flatten(bnode_t* node, SGVector<bool> nominal, FlatNodes& nodes)
+{
+	int32_t index=nodes.attribute.size();
+	nodes.attribute.push_back(-1);
+	nodes.threshold.push_back(0);
+	nodes.right.push_back(-1);
+	nodes.value.push_back(node->data.node_label);
+	nodes.nominal_begin.push_back(-1);
+	nodes.nominal_end.push_back(-1);
+
+	if (node->data.num_leaves==1)
+		return index;
+
+	int32_t attribute=node->data.attribute_id;
+	REQUIRE(attribute>=0 && attribute<nominal.vlen,
+			"Attribute %d of node has no feature type\n", attribute);
+	nodes.attribute[index]=attribute;
+
+	bnode_t* left=node->left();
+	SGVector<float64_t> left_values=left->data.transit_into_values;
+	if (nominal[attribute])
+	{
+		nodes.nominal_begin[index]=nodes.nominal_values.size();
+		for (index_t k=0; k<left_values.vlen; k++)
+			nodes.nominal_values.push_back(left_values[k]);
+		nodes.nominal_end[index]=nodes.nominal_values.size();
+	}
+	else
+	{
+		nodes.threshold[index]=left_values[0];
+	}
+
+	// preorder, the left child directly follows its parent
+	flatten(left, nominal, nodes);
+	SG_UNREF(left);
+
+	bnode_t* right=node->right();
+	nodes.right[index]=flatten(right, nominal, nodes);
+	SG_UNREF(right);
+
+	return index;
+}
+
+void CFlatTreeEnsemble::clear()
+{
+	m_roots=SGVector<int32_t>();
+	m_attribute=SGVector<int32_t>();
+	m_threshold=SGVector<float64_t>();
+	m_right=SGVector<int32_t>();
+	m_value=SGVector<float64_t>();
+	m_nominal_begin=SGVector<int32_t>();
+	m_nominal_end=SGVector<int32_t>();
+	m_nominal_values=SGVector<float64_t>();
+	m_num_attributes=0;
+}
+
+void CFlatTreeEnsemble::set_block_size(int32_t block_size)
+{
+	REQUIRE(block_size>0, "Block size (%d) must be positive\n", block_size);
+	m_block_size=block_size;
+}
+
+float64_t CFlatTreeEnsemble::predict(int32_t node, const float64_t* x) const
+{
+	const int32_t* attribute=m_attribute.vector;
+	const int32_t* nominal_begin=m_nominal_begin.vector;
+
+	while (attribute[node]>=0)
+	{
+		float64_t value=x[attribute[node]];
+		bool go_left=false;
+
+		if (nominal_begin[node]>=0)
+		{
+			int32_t nominal_end=m_nominal_end.vector[node];
+			for (int32_t k=nominal_begin[node]; k<nominal_end; k++)
+			{
+				if (m_nominal_values.vector[k]==value)
+				{
+					go_left=true;
+					break;
+				}
+			}
+		}
+		else
+		{
+			go_left=value<=m_threshold.vector[node];
+		}
+
+		node=go_left ? node+1 : m_right.vector[node];
+	}
+
+	return m_value.vector[node];
+}
+
+void CFlatTreeEnsemble::apply_range(const SGMatrix<float64_t>& mat,
+		int32_t first_tree, int32_t num_trees, float64_t* output) const
+{
+	REQUIRE(mat.num_rows>=m_num_attributes,
+			"Trees need %d attributes, features have %d\n",
+			m_num_attributes, mat.num_rows);
+
+	int64_t num_vecs=mat.num_cols;
+	int64_t num_blocks=(num_vecs+m_block_size-1)/m_block_size;
+	int64_t num_tasks=num_blocks*num_trees;
+
+	// the trees of one block are adjacent so that a block of vectors stays
+	// in cache while different threads walk different trees over it
+	parallel->parallel_for(0, num_tasks, [&](int64_t first_task, int64_t last_task)
+	{
+		for (int64_t task=first_task; task<last_task; task++)
+		{
+			int64_t block=task/num_trees;
+			int32_t tree=task%num_trees;
+			int32_t root=m_roots.vector[first_tree+tree];
+
+			int64_t start=block*m_block_size;
+			int64_t end=CMath::min(start+m_block_size, num_vecs);
+			float64_t* out=output+tree*num_vecs;
+			for (int64_t i=start; i<end; i++)
+				out[i]=predict(root, mat.matrix+i*mat.num_rows);
+		}
+	}, 1);
+}
+
+SGMatrix<float64_t> CFlatTreeEnsemble::apply_trees(CDenseFeatures<float64_t>* feats) const
+{
+	REQUIRE(feats, "Features must not be NULL\n");
+	REQUIRE(m_roots.vlen>0, "No trees added\n");
+
+	SGMatrix<float64_t> mat=feats->get_feature_matrix();
+	SGMatrix<float64_t> output(mat.num_cols, m_roots.vlen);
+	apply_range(mat, 0, m_roots.vlen, output.matrix);
+
+	return output;
+}
+
+SGVector<float64_t> CFlatTreeEnsemble::apply_tree(CDenseFeatures<float64_t>* feats, int32_t tree) const
+{
+	REQUIRE(feats, "Features must not be NULL\n");
+	REQUIRE(tree>=0 && tree<m_roots.vlen, "Tree index (%d) out of bounds [0, %d)\n",
+			tree, m_roots.vlen);
+
+	SGMatrix<float64_t> mat=feats->get_feature_matrix();
+	SGVector<float64_t> output(mat.num_cols);
+	apply_range(mat, tree, 1, output.vector);
+
+	return output;
+}
@@ -0,0 +1,180 @@
+/*
+ * This software is distributed under BSD 3-clause license (see LICENSE file).
+ */
+
+#ifndef _FLAT_TREE_ENSEMBLE_H__
+#define _FLAT_TREE_ENSEMBLE_H__
+
+#include <shogun/lib/config.h>
+
+#include <shogun/base/SGObject.h>
+#include <shogun/features/DenseFeatures.h>
+#include <shogun/multiclass/tree/BinaryTreeMachineNode.h>
+#include <shogun/multiclass/tree/CARTreeNodeData.h>
+
+#include <vector>
+
+namespace shogun
+{
+class CCARTree;
+
+/** @brief Read-only, flattened representation of one or more CART trees
+ * for fast prediction.
+ *
+ * The nodes of all trees are stored in a single struct-of-arrays table:
+ * splitting attribute, threshold, index of the right child and leaf value
+ * are each kept in one contiguous array. Nodes are laid out in preorder so
+ * that the left child of a node always directly follows it and only the
+ * index of the right child has to be stored. The values a nominal split
+ * sends to the left are kept in a separate contiguous array.
+ *
+ * Prediction walks this table with plain index arithmetic instead of
+ * following reference counted CBinaryTreeMachineNode objects. apply_trees()
+ * splits the data into blocks of vectors and evaluates all (block, tree)
+ * pairs in parallel, so that the nodes of one tree are reused for a whole
+ * block of vectors while they are hot in the cache.
+ *
+ * The table is a snapshot: changing a tree after it was added does not
+ * change the table.
+ */
+class CFlatTreeEnsemble : public CSGObject
+{
+public:
+	/** binary tree node type of CART */
+	typedef CBinaryTreeMachineNode<CARTreeNodeData> bnode_t;
+
+	/** constructor */
+	CFlatTreeEnsemble();
+
+	/** destructor */
+	virtual ~CFlatTreeEnsemble();
+
+	/** append a trained tree
+	 *
+	 * @param tree trained CART tree
+	 */
+	void add_tree(CCARTree* tree);
+
+	/** append the subtree starting at a node
+	 *
+	 * @param root root of the subtree
+	 * @param nominal whether the attributes are nominal
+	 */
+	void add_tree(bnode_t* root, SGVector<bool> nominal);
+
+	/** drop all trees */
+	void clear();
+
+	/** @return number of trees */
+	int32_t get_num_trees() const { return m_roots.vlen; }
+
+	/** @return total number of nodes in all trees */
+	int32_t get_num_nodes() const { return m_attribute.vlen; }
+
+	/** set the number of vectors evaluated per task in apply_trees()
+	 *
+	 * @param block_size number of vectors per block
+	 */
+	void set_block_size(int32_t block_size);
+
+	/** @return number of vectors evaluated per task */
+	int32_t get_block_size() const { return m_block_size; }
+
+	/** predict the leaf values of all trees
+	 *
+	 * @param feats dense features to be classified
+	 * @return num_vectors x num_trees matrix, column i holds the leaf
+	 * values of tree i
+	 */
+	SGMatrix<float64_t> apply_trees(CDenseFeatures<float64_t>* feats) const;
+
+	/** predict the leaf values of a single tree
+	 *
+	 * @param feats dense features to be classified
+	 * @param tree index of the tree
+	 * @return leaf values of all vectors
+	 */
+	SGVector<float64_t> apply_tree(CDenseFeatures<float64_t>* feats, int32_t tree) const;
+
+	/** @return object name */
+	virtual const char* get_name() const { return "FlatTreeEnsemble"; }
+
+private:
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+	/** nodes of a tree being added */
+	struct FlatNodes
+	{
+		std::vector<int32_t> attribute;
+		std::vector<float64_t> threshold;
+		std::vector<int32_t> right;
+		std::vector<float64_t> value;
+		std::vector<int32_t> nominal_begin;
+		std::vector<int32_t> nominal_end;
+		std::vector<float64_t> nominal_values;
+	};
+#endif // DOXYGEN_SHOULD_SKIP_THIS
+
+	/** init and register parameters */
+	void init();
+
+	/** append a node and its subtree in preorder
+	 *
+	 * @param node node to append
+	 * @param nominal whether the attributes are nominal
+	 * @param nodes nodes of the tree so far
+	 * @return index of the node, relative to the root of its tree
+	 */
+	static int32_t flatten(bnode_t* node, SGVector<bool> nominal, FlatNodes& nodes);
+
+	/** evaluate the trees in [first_tree, first_tree+num_trees) on all
+	 * vectors
+	 *
+	 * @param mat feature matrix, one vector per column
+	 * @param first_tree index of the first tree
+	 * @param num_trees number of trees
+	 * @param output num_vectors x num_trees column-major output
+	 */
+	void apply_range(const SGMatrix<float64_t>& mat, int32_t first_tree,
+			int32_t num_trees, float64_t* output) const;
+
+	/** walk a tree down to its leaf
+	 *
+	 * @param node index of the root node
+	 * @param x feature vector
+	 * @return value of the leaf reached
+	 */
+	inline float64_t predict(int32_t node, const float64_t* x) const;
+
+private:
+	/** index of the root node of each tree */
+	SGVector<int32_t> m_roots;
+
+	/** splitting attribute of each node, -1 for leaves */
+	SGVector<int32_t> m_attribute;
+
+	/** threshold of numeric splits, values not larger go left */
+	SGVector<float64_t> m_threshold;
+
+	/** index of the right child of each node */
+	SGVector<int32_t> m_right;
+
+	/** label of each node */
+	SGVector<float64_t> m_value;
+
+	/** start of the left values of nominal splits, -1 for numeric splits */
+	SGVector<int32_t> m_nominal_begin;
+
+	/** end of the left values of nominal splits */
+	SGVector<int32_t> m_nominal_end;
+
+	/** values sending a vector to the left child in nominal splits */
+	SGVector<float64_t> m_nominal_values;
+
+	/** number of attributes the trees need */
+	int32_t m_num_attributes;
+
+	/** number of vectors per task */
+	int32_t m_block_size;
+};
+}
+#endif // _FLAT_TREE_ENSEMBLE_H__
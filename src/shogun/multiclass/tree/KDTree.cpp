@@ -56,10 +56,10 @@ float64_t CKDTree::min_dist(bnode_t* node,float64_t* feat, int32_t dim)
 
 float64_t CKDTree::min_dist_dual(bnode_t* nodeq, bnode_t* noder)
 {
-	SGVector<float64_t> nodeq_lower=nodeq->data.bbox_lower;
-	SGVector<float64_t> nodeq_upper=nodeq->data.bbox_upper;
-	SGVector<float64_t> noder_lower=noder->data.bbox_lower;
-	SGVector<float64_t> noder_upper=noder->data.bbox_upper;
+	const SGVector<float64_t>& nodeq_lower=nodeq->data.bbox_lower;
+	const SGVector<float64_t>& nodeq_upper=nodeq->data.bbox_upper;
+	const SGVector<float64_t>& noder_lower=noder->data.bbox_lower;
+	const SGVector<float64_t>& noder_upper=noder->data.bbox_upper;
 	float64_t dist=0;
 	for(int32_t i=0;i<noder_lower.vlen;i++)
 	{
@@ -73,10 +73,10 @@ float64_t CKDTree::min_dist_dual(bnode_t* nodeq, bnode_t* noder)
 
 float64_t CKDTree::max_dist_dual(bnode_t* nodeq, bnode_t* noder)
 {
-	SGVector<float64_t> nodeq_lower=nodeq->data.bbox_lower;
-	SGVector<float64_t> nodeq_upper=nodeq->data.bbox_upper;
-	SGVector<float64_t> noder_lower=noder->data.bbox_lower;
-	SGVector<float64_t> noder_upper=noder->data.bbox_upper;
+	const SGVector<float64_t>& nodeq_lower=nodeq->data.bbox_lower;
+	const SGVector<float64_t>& nodeq_upper=nodeq->data.bbox_upper;
+	const SGVector<float64_t>& noder_lower=noder->data.bbox_lower;
+	const SGVector<float64_t>& noder_upper=noder->data.bbox_upper;
 	float64_t dist=0;
 	for(int32_t i=0;i<noder_lower.vlen;i++)
 	{
@@ -28,6 +28,7 @@
  * either expressed or implied, of the Shogun Development Team.
  */
 
+#include <shogun/base/Parallel.h>
 #include <shogun/multiclass/tree/NbodyTree.h>
 #include <shogun/distributions/KernelDensity.h>
 
@@ -49,6 +50,21 @@ void CNbodyTree::build_tree(CDenseFeatures<float64_t>* data)
 
 	m_knn_done=false;
 	m_data=data->get_feature_matrix();
+	m_data32=SGMatrix<float32_t>();
+
+	if (m_single_precision)
+	{
+		// the nodes are built from the rounded vectors, so that their
+		// bounds hold for the vectors stored in single precision
+		SGMatrix<float64_t> rounded(m_data.num_rows, m_data.num_cols);
+		m_data32=SGMatrix<float32_t>(m_data.num_rows, m_data.num_cols);
+		for (int64_t i=0; i<int64_t(m_data.num_rows)*m_data.num_cols; i++)
+		{
+			m_data32.matrix[i]=(float32_t) m_data.matrix[i];
+			rounded.matrix[i]=m_data32.matrix[i];
+		}
+		m_data=rounded;
+	}
 
 	m_vec_id=SGVector<index_t>(m_data.num_cols);
 	m_vec_id.range_fill(0);
@@ -67,19 +83,92 @@ void CNbodyTree::query_knn(CDenseFeatures<float64_t>* data, int32_t k)
 	m_knn_indices=SGMatrix<index_t>(k,qfeats.num_cols);
 	int32_t dim=qfeats.num_rows;
 
-	for (int32_t i=0;i<qfeats.num_cols;i++)
+	bnode_t* root=NULL;
+	if (m_root)
+		root=dynamic_cast<bnode_t*>(m_root);
+	REQUIRE(root,"Tree has not been built\n")
+
+	// the tree is only read, so the queries are independent
+	parallel->parallel_for(0, qfeats.num_cols, [&](int64_t begin, int64_t end)
 	{
-		CKNNHeap* heap=new CKNNHeap(k);
-		bnode_t* root=NULL;
-		if (m_root)
-			root=dynamic_cast<bnode_t*>(m_root);
+		for (int64_t i=begin;i<end;i++)
+		{
+			CKNNHeap heap(k);
+			float64_t* query=qfeats.matrix+i*dim;
+			float64_t mdist=min_dist(root,query,dim);
+			query_knn_single(&heap,mdist,root,query,dim);
+
+			// get_dists() sorts the heap, the indices follow
+			SGVector<float64_t> dists=heap.get_dists();
+			SGVector<index_t> indices=heap.get_indices();
+			sg_memcpy(m_knn_dists.matrix+i*k,dists.vector,k*sizeof(float64_t));
+			sg_memcpy(m_knn_indices.matrix+i*k,indices.vector,k*sizeof(index_t));
+		}
+	});
+}
+
+void CNbodyTree::query_knn_dual(SGMatrix<float64_t> test, SGVector<index_t> qid, bnode_t* qroot, int32_t k)
+{
+	REQUIRE(test.num_rows==m_data.num_rows,"query data dimension should be same as training data dimension\n")
+	REQUIRE(qroot,"Query tree root not supplied\n")
+	REQUIRE(qid.vlen==test.num_cols,"Query tree has %d vectors, query data %d\n",qid.vlen,test.num_cols)
+
+	bnode_t* rroot=NULL;
+	if (m_root)
+		rroot=dynamic_cast<bnode_t*>(m_root);
+	REQUIRE(rroot,"Tree has not been built\n")
 
-		float64_t mdist=min_dist(root,qfeats.matrix+i*dim,dim);
-		query_knn_single(heap,mdist,root,qfeats.matrix+i*dim,dim);
-		sg_memcpy(m_knn_dists.matrix+i*k,heap->get_dists(),k*sizeof(float64_t));
-		sg_memcpy(m_knn_indices.matrix+i*k,heap->get_indices(),k*sizeof(index_t));
+	m_knn_done=true;
+	m_knn_dists=SGMatrix<float64_t>(k,test.num_cols);
+	m_knn_indices=SGMatrix<index_t>(k,test.num_cols);
 
-		delete(heap);
+	// heaps are not copied, copies would share their buffers
+	std::vector<CKNNHeap> heaps;
+	heaps.reserve(test.num_cols);
+	for (int32_t i=0;i<test.num_cols;i++)
+		heaps.emplace_back(k);
+
+	// split the query tree into subtrees with disjoint query vectors, which
+	// are traversed in parallel
+	std::vector<bnode_t*> subtrees(1,qroot);
+	SG_REF(qroot);
+	int32_t num_subtrees=4*parallel->get_num_threads();
+	bool split=true;
+	while (split && int32_t(subtrees.size())<num_subtrees)
+	{
+		split=false;
+		std::vector<bnode_t*> children;
+		for (auto node : subtrees)
+		{
+			if (node->data.is_leaf)
+			{
+				children.push_back(node);
+				continue;
+			}
+
+			children.push_back(node->left());
+			children.push_back(node->right());
+			SG_UNREF(node);
+			split=true;
+		}
+		subtrees=children;
+	}
+
+	parallel->parallel_for(0, subtrees.size(), [&](int64_t begin, int64_t end)
+	{
+		for (int64_t i=begin;i<end;i++)
+			knn_dual(heaps,subtrees[i],rroot,qid,test);
+	}, 1);
+
+	for (auto subtree : subtrees)
+		SG_UNREF(subtree);
+
+	for (int32_t i=0;i<test.num_cols;i++)
+	{
+		SGVector<float64_t> dists=heaps[i].get_dists();
+		SGVector<index_t> indices=heaps[i].get_indices();
+		sg_memcpy(m_knn_dists.matrix+i*k,dists.vector,k*sizeof(float64_t));
+		sg_memcpy(m_knn_indices.matrix+i*k,indices.vector,k*sizeof(index_t));
 	}
 }
 
@@ -92,26 +181,30 @@ SGVector<float64_t> CNbodyTree::log_kernel_density(SGMatrix<float64_t> test, EKe
 	float64_t log_rtol = std::log(rtol);
 	float64_t log_kernel_norm=CKernelDensity::log_norm(kernel,h,dim);
 	SGVector<float64_t> log_density(test.num_cols);
-	for (int32_t i=0;i<test.num_cols;i++)
+	bnode_t* root=NULL;
+	if (m_root)
+		root=dynamic_cast<bnode_t*>(m_root);
+
+	// the tree is only read, so the query points are independent
+	parallel->parallel_for(0, test.num_cols, [&](int64_t begin, int64_t end)
 	{
-		bnode_t* root=NULL;
-		if (m_root)
-			root=dynamic_cast<bnode_t*>(m_root);
-
-		float64_t lower_dist=0;
-		float64_t upper_dist=0;
-		min_max_dist(test.matrix+i*dim,root,lower_dist,upper_dist,dim);
-
-		float64_t min_bound = std::log(m_data.num_cols) +
-		                      CKernelDensity::log_kernel(kernel, upper_dist, h);
-		float64_t max_bound = std::log(m_data.num_cols) +
-		                      CKernelDensity::log_kernel(kernel, lower_dist, h);
-		float64_t spread=logdiffexp(max_bound,min_bound);
-
-		get_kde_single(root,test.matrix+i*dim,kernel,h,log_atol,log_rtol,log_kernel_norm,min_bound,spread,min_bound,spread);
-		log_density[i] = logsumexp(min_bound, spread - std::log(2)) +
-		                 log_kernel_norm - std::log(m_data.num_cols);
-	}
+		for (int64_t i=begin;i<end;i++)
+		{
+			float64_t lower_dist=0;
+			float64_t upper_dist=0;
+			min_max_dist(test.matrix+i*dim,root,lower_dist,upper_dist,dim);
+
+			float64_t min_bound = std::log(m_data.num_cols) +
+			                      CKernelDensity::log_kernel(kernel, upper_dist, h);
+			float64_t max_bound = std::log(m_data.num_cols) +
+			                      CKernelDensity::log_kernel(kernel, lower_dist, h);
+			float64_t spread=logdiffexp(max_bound,min_bound);
+
+			get_kde_single(root,test.matrix+i*dim,kernel,h,log_atol,log_rtol,log_kernel_norm,min_bound,spread,min_bound,spread);
+			log_density[i] = logsumexp(min_bound, spread - std::log(2)) +
+			                 log_kernel_norm - std::log(m_data.num_cols);
+		}
+	});
 
 	return log_density;
 }
@@ -203,8 +296,92 @@ void CNbodyTree::query_knn_single(CKNNHeap* heap, float64_t mdist, bnode_t* node
 	SG_UNREF(cright);
 }
 
+void CNbodyTree::knn_dual(std::vector<CKNNHeap>& heaps, bnode_t* querynode, bnode_t* refnode, SGVector<index_t> qid, SGMatrix<float64_t> qdata)
+{
+	if (min_dist_dual(querynode,refnode)>knn_dual_bound(heaps,querynode,qid))
+		return;
+
+	int32_t dim=m_data.num_rows;
+
+	// both are leaves
+	if (querynode->data.is_leaf && refnode->data.is_leaf)
+	{
+		for (int32_t i=querynode->data.start_idx;i<=querynode->data.end_idx;i++)
+		{
+			CKNNHeap& heap=heaps[qid[i]];
+			float64_t* query=qdata.matrix+int64_t(dim)*qid[i];
+			for (int32_t j=refnode->data.start_idx;j<=refnode->data.end_idx;j++)
+				heap.push(m_vec_id[j],distance(m_vec_id[j],query,dim));
+		}
+
+		return;
+	}
+
+	// descend the reference tree if the query node is a leaf or the larger
+	// one, closer reference child first
+	index_t queryn=querynode->data.end_idx-querynode->data.start_idx;
+	index_t refn=refnode->data.end_idx-refnode->data.start_idx;
+	if (querynode->data.is_leaf || (!refnode->data.is_leaf && refn>=queryn))
+	{
+		bnode_t* lchild=refnode->left();
+		bnode_t* rchild=refnode->right();
+
+		if (min_dist_dual(querynode,lchild)<=min_dist_dual(querynode,rchild))
+		{
+			knn_dual(heaps,querynode,lchild,qid,qdata);
+			knn_dual(heaps,querynode,rchild,qid,qdata);
+		}
+		else
+		{
+			knn_dual(heaps,querynode,rchild,qid,qdata);
+			knn_dual(heaps,querynode,lchild,qid,qdata);
+		}
+
+		SG_UNREF(lchild);
+		SG_UNREF(rchild);
+		return;
+	}
+
+	bnode_t* lchild=querynode->left();
+	bnode_t* rchild=querynode->right();
+	knn_dual(heaps,lchild,refnode,qid,qdata);
+	knn_dual(heaps,rchild,refnode,qid,qdata);
+	SG_UNREF(lchild);
+	SG_UNREF(rchild);
+}
+
+float64_t CNbodyTree::knn_dual_bound(std::vector<CKNNHeap>& heaps, bnode_t* querynode, SGVector<index_t> qid)
+{
+	float64_t bound=0;
+	for (int32_t i=querynode->data.start_idx;i<=querynode->data.end_idx;i++)
+		bound=CMath::max(bound,heaps[qid[i]].get_max_dist());
+
+	return bound;
+}
+
 float64_t CNbodyTree::distance(index_t vec, float64_t* arr, int32_t dim)
 {
+	if (m_data32.matrix)
+	{
+		const float32_t* vector=m_data32.matrix+int64_t(vec)*dim;
+		float32_t ret=0;
+		if (m_dist==D_EUCLIDEAN)
+		{
+			for (int32_t i=0;i<dim;i++)
+			{
+				float32_t d=vector[i]-(float32_t) arr[i];
+				ret+=d*d;
+			}
+		}
+		else
+		{
+			for (int32_t i=0;i<dim;i++)
+				ret+=add_dim_dist(vector[i]-(float32_t) arr[i]);
+		}
+
+		return actual_dists(ret);
+	}
+
 	float64_t ret=0;
 	for (int32_t i=0;i<dim;i++)
 		ret+=add_dim_dist(m_data(i,vec)-arr[i]);
@@ -579,6 +756,8 @@ void CNbodyTree::init()
 	m_data=SGMatrix<float64_t>();
 	m_leaf_size=1;
 	m_vec_id=SGVector<index_t>();
+	m_data32=SGMatrix<float32_t>();
+	m_single_precision=false;
 	m_dist=D_EUCLIDEAN;
 	m_knn_done=false;
 	m_knn_dists=SGMatrix<float64_t>();
@@ -587,6 +766,8 @@ void CNbodyTree::init()
 	SG_ADD(&m_data,"m_data","data matrix",MS_NOT_AVAILABLE);
 	SG_ADD(&m_leaf_size,"m_leaf_size","leaf size",MS_NOT_AVAILABLE);
 	SG_ADD(&m_vec_id,"m_vec_id","id of vectors",MS_NOT_AVAILABLE);
+	SG_ADD(&m_data32,"m_data32","data matrix in single precision",MS_NOT_AVAILABLE);
+	SG_ADD(&m_single_precision,"single_precision","whether data is stored in single precision",MS_NOT_AVAILABLE);
 	SG_ADD(&m_knn_done,"knn_done","knn done or not",MS_NOT_AVAILABLE);
 	SG_ADD(&m_knn_dists,"m_knn_dists","knn distances",MS_NOT_AVAILABLE);
 	SG_ADD(&m_knn_indices,"knn_indices","knn indices",MS_NOT_AVAILABLE);
@@ -41,6 +41,8 @@
 #include <shogun/multiclass/tree/KNNHeap.h>
 #include <shogun/features/DenseFeatures.h>
 
+#include <vector>
+
 namespace shogun
 {
 
@@ -84,6 +86,33 @@ public:
 	 */
 	void query_knn(CDenseFeatures<float64_t>* data, int32_t k);
 
+	/** apply knn with a dual-tree traversal, which prunes pairs of query
+	 * and reference nodes instead of single query vectors and pays off for
+	 * large query sets, e.g. the all-knn problem where the query vectors
+	 * are the training vectors. Independent query subtrees are processed
+	 * in parallel.
+	 *
+	 * @param test query vectors
+	 * @param qid id vector of the query tree
+	 * @param qroot root of the query tree, built from test with the same
+	 * tree type and distance as this tree
+	 * @param k K value in KNN
+	 */
+	void query_knn_dual(SGMatrix<float64_t> test, SGVector<index_t> qid, bnode_t* qroot, int32_t k);
+
+	/** set whether the vectors are stored in single precision. Distances
+	 * to the vectors in the leaves are then computed in single precision,
+	 * which halves the memory traffic of the leaf scans. The node bounds
+	 * are computed from the rounded vectors, so they stay valid. Takes
+	 * effect with the next build_tree().
+	 *
+	 * @param single_precision whether to store the vectors as float32
+	 */
+	void set_single_precision(bool single_precision) { m_single_precision=single_precision; }
+
+	/** @return whether the vectors are stored in single precision */
+	bool get_single_precision() const { return m_single_precision; }
+
 	/** get log of kernel density at query points
 	 *
 	 * @param test query points at which kernel density is to be calculated
@@ -215,6 +244,26 @@ private:
 	 */
 	void query_knn_single(CKNNHeap* heap, float64_t min_dist, bnode_t* node, float64_t* arr, int32_t dim);
 
+	/** depth-first traversal in dual trees for KNN
+	 *
+	 * @param heaps heap of each query vector
+	 * @param querynode current node from query tree
+	 * @param refnode current node from reference tree
+	 * @param qid id vector of query tree
+	 * @param qdata query data matrix
+	 */
+	void knn_dual(std::vector<CKNNHeap>& heaps, bnode_t* querynode, bnode_t* refnode, SGVector<index_t> qid, SGMatrix<float64_t> qdata);
+
+	/** largest k-th neighbor distance found so far of the query vectors of
+	 * a node, no closer reference node needs to be visited
+	 *
+	 * @param heaps heap of each query vector
+	 * @param querynode node from query tree
+	 * @param qid id vector of query tree
+	 * @return bound of the node
+	 */
+	float64_t knn_dual_bound(std::vector<CKNNHeap>& heaps, bnode_t* querynode, SGVector<index_t> qid);
+
 	/** find kde at each query point
 	 *
 	 * @param node current node
@@ -316,6 +365,9 @@ protected:
 	/** vector id */
 	SGVector<index_t> m_vec_id;
 
+	/** data matrix in single precision, empty if not used */
+	SGMatrix<float32_t> m_data32;
+
 private:
 	/** leaf size */
 	int32_t m_leaf_size;
@@ -323,6 +375,9 @@ private:
 	/** distance metric */
 	EDistanceType m_dist;
 
+	/** whether the vectors are stored in single precision */
+	bool m_single_precision;
+
 	/** knn query done or not */
 	bool m_knn_done;
 
@@ -51,10 +51,12 @@ void CRandomCARTree::set_feature_subset_size(index_t size)
 
 index_t CRandomCARTree::compute_best_attribute(const SGMatrix<float64_t>& mat, const SGVector<float64_t>& weights, CDenseLabels* labels,
 	SGVector<float64_t>& left, SGVector<float64_t>& right, SGVector<bool>& is_left_final, index_t &num_missing_final, index_t &count_left,
-	index_t &count_right, index_t subset_size, const SGVector<index_t>& active_indices)
+	index_t &count_right, index_t subset_size, const SGVector<index_t>& active_indices, const SGVector<float64_t>& histogram)
 
 {
 	auto num_feats = (m_pre_sort) ? mat.num_cols : mat.num_rows;
+	if (m_num_bins>0)
+		num_feats=m_binned_features.num_cols;
 
 	// if subset size is not set choose sqrt(num_feats) by default
 	if (m_randsubset_size==0)
@@ -64,7 +66,7 @@ index_t CRandomCARTree::compute_best_attribute(const SGMatrix<float64_t>& mat, c
 	REQUIRE(subset_size<=num_feats, "The Feature subset size(set %d) should be less than"
 	" or equal to the total number of features(%d here).\n",subset_size,num_feats)
 
-	return CCARTree::compute_best_attribute(mat,weights,labels,left,right,is_left_final,num_missing_final,count_left,count_right,subset_size, active_indices);
+	return CCARTree::compute_best_attribute(mat,weights,labels,left,right,is_left_final,num_missing_final,count_left,count_right,subset_size, active_indices, histogram);
 
 }
 
@@ -83,11 +83,15 @@ protected:
 	 * @param num_missing number of missing attributes
 	 * @param count_left stores number of feature values for left transition
 	 * @param count_right stores number of feature values for right transition
+	 * @param subset_size ignored, the feature subset size of the tree is used
+	 * @param active_indices indices of the data vectors of the node in the sorted or quantized features
+	 * @param histogram histogram of the node for histogram based splits
 	 * @return index to the best attribute
 	 */
 	virtual index_t compute_best_attribute(const SGMatrix<float64_t>& mat, const SGVector<float64_t>& weights, CDenseLabels* labels,
 		SGVector<float64_t>& left, SGVector<float64_t>& right, SGVector<bool>& is_left_final, index_t &num_missing,
-		index_t &count_left, index_t &count_right, index_t subset_size=0, const SGVector<index_t>& active_indices=SGVector<index_t>());
+		index_t &count_left, index_t &count_right, index_t subset_size=0, const SGVector<index_t>& active_indices=SGVector<index_t>(),
+		const SGVector<float64_t>& histogram=SGVector<float64_t>());
 
 private:
 	/** initialize parameters */
@@ -129,6 +129,7 @@ bool CLibSVR::train_machine(CFeatures* data)
 	param.weight_label = weights_label;
 	param.weight = weights;
 	param.use_bias = get_bias_enabled();
+	param.row_cache = m_row_cache;
 
 	const char* error_msg = svm_check_parameter(&problem,&param);
 
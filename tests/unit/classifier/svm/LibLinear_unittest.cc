@@ -442,3 +442,51 @@ TEST_F(LibLinear, simple_set_train_L2R_LR_DUAL_BIAS)
 	// bias, not l1
 	train_with_solver_simple(liblinear_solver_type, true, false, t_w);
 }
+
+TEST_F(LibLinear, parallel_dual_solvers)
+{
+	generate_data_l2();
+	LIBLINEAR_SOLVER_TYPE solver_types[] = {L2R_L1LOSS_SVC_DUAL,
+	                                        L2R_L2LOSS_SVC_DUAL};
+	LIBLINEAR_PARALLEL_MODE modes[] = {LL_ASYNCHRONOUS, LL_REPRODUCIBLE};
+
+	// the number of threads is global, it is restored in the end
+	int32_t old_num_threads = get_global_parallel()->get_num_threads();
+
+	auto eval = new CContingencyTableEvaluation();
+	SG_REF(eval);
+	for (auto solver_type : solver_types)
+	{
+		for (auto mode : modes)
+		{
+			SGVector<float64_t> first_w;
+			for (auto run : range(2))
+			{
+				sg_rand->set_seed(7);
+				auto ll = new CLibLinear(solver_type);
+				SG_REF(ll);
+				ll->parallel->set_num_threads(4);
+				ll->set_liblinear_parallel_mode(mode);
+				ll->set_features(train_feats);
+				ll->set_labels(ground_truth);
+				ll->train();
+
+				auto pred = ll->apply_binary(test_feats);
+				EXPECT_NEAR(eval->evaluate(pred, ground_truth), 1.0, 1e-6);
+
+				// same seed and number of threads, same solution
+				if (mode == LL_REPRODUCIBLE && run == 1)
+				{
+					for (auto i : range(first_w.vlen))
+						EXPECT_EQ(ll->get_w()[i], first_w[i]);
+				}
+				first_w = ll->get_w().clone();
+
+				SG_UNREF(pred);
+				SG_UNREF(ll);
+			}
+		}
+	}
+	SG_UNREF(eval);
+	get_global_parallel()->set_num_threads(old_num_threads);
+}
@@ -0,0 +1,61 @@
+/*
+ * This software is distributed under BSD 3-clause license (see LICENSE file).
+ */
+
+#include <gtest/gtest.h>
+
+#include <shogun/base/Parallel.h>
+#include <shogun/classifier/svm/LibSVM.h>
+#include <shogun/features/DenseFeatures.h>
+#include <shogun/kernel/LinearKernel.h>
+#include <shogun/labels/BinaryLabels.h>
+#include <shogun/mathematics/Math.h>
+
+using namespace shogun;
+
+TEST(LibSVM, parallel_solver_matches_serial)
+{
+	// large enough for the gradient loops to be split in several chunks
+	CMath::init_random(23);
+	int32_t num=20000;
+	SGMatrix<float64_t> data(2, num);
+	SGVector<float64_t> lab(num);
+	for (index_t i=0; i<num; i++)
+	{
+		lab[i]=i%2 ? 1 : -1;
+		data(0, i)=lab[i]+CMath::randn_double();
+		data(1, i)=0.5*lab[i]+CMath::randn_double();
+	}
+
+	CDenseFeatures<float64_t>* features=new CDenseFeatures<float64_t>(data);
+	CBinaryLabels* labels=new CBinaryLabels(lab);
+	CLinearKernel* kernel=new CLinearKernel(features, features);
+	SG_REF(kernel);
+
+	int32_t old_num_threads=kernel->parallel->get_num_threads();
+	int32_t num_threads[]={1, 4};
+	CLibSVM* svm[2];
+	for (int32_t t=0; t<2; t++)
+	{
+		kernel->parallel->set_num_threads(num_threads[t]);
+		svm[t]=new CLibSVM(1.0, kernel, labels);
+		SG_REF(svm[t]);
+		svm[t]->train();
+	}
+	kernel->parallel->set_num_threads(old_num_threads);
+
+	// chunks are merged in order, so the solver takes the same steps
+	EXPECT_EQ(svm[0]->get_bias(), svm[1]->get_bias());
+	SGVector<float64_t> alphas=svm[0]->get_alphas();
+	SGVector<int32_t> sv=svm[0]->get_support_vectors();
+	ASSERT_EQ(alphas.vlen, svm[1]->get_alphas().vlen);
+	for (index_t i=0; i<alphas.vlen; i++)
+	{
+		EXPECT_EQ(alphas[i], svm[1]->get_alphas()[i]);
+		EXPECT_EQ(sv[i], svm[1]->get_support_vectors()[i]);
+	}
+
+	SG_UNREF(svm[0]);
+	SG_UNREF(svm[1]);
+	SG_UNREF(kernel);
+}
@@ -0,0 +1,91 @@
+/*
+ * This software is distributed under BSD 3-clause license (see LICENSE file).
+ */
+
+#include <gtest/gtest.h>
+
+#include <shogun/clustering/GMM.h>
+#include <shogun/distributions/Gaussian.h>
+#include <shogun/features/DenseFeatures.h>
+#include <shogun/mathematics/Math.h>
+
+using namespace shogun;
+
+TEST(GMM, batched_log_PDF_matches_pointwise)
+{
+	CMath::init_random(3);
+	int32_t dim=4;
+	SGMatrix<float64_t> points(dim, 600);
+	for (index_t i=0; i<points.num_rows*points.num_cols; i++)
+		points.matrix[i]=CMath::randn_double();
+
+	SGVector<float64_t> mean(dim);
+	SGMatrix<float64_t> cov(dim, dim);
+	for (int32_t i=0; i<dim; i++)
+	{
+		mean[i]=0.5*i;
+		for (int32_t j=0; j<dim; j++)
+			cov(i, j)=i==j ? 1.0+i : 0.3;
+	}
+
+	ECovType cov_types[]={FULL, DIAG, SPHERICAL};
+	for (auto cov_type: cov_types)
+	{
+		CGaussian* gaussian=new CGaussian(mean, cov, cov_type);
+		SG_REF(gaussian);
+
+		SGVector<float64_t> result(points.num_cols);
+		gaussian->compute_log_PDF(points, result);
+		for (index_t i=0; i<points.num_cols; i++)
+		{
+			SGVector<float64_t> point(points.get_column_vector(i), dim, false);
+			EXPECT_NEAR(result[i], gaussian->compute_log_PDF(point), 1e-10);
+		}
+
+		SG_UNREF(gaussian);
+	}
+}
+
+TEST(GMM, train_em_separated_clusters)
+{
+	CMath::init_random(11);
+	int32_t num_per_cluster=300;
+	SGMatrix<float64_t> data(2, 2*num_per_cluster);
+	for (index_t i=0; i<data.num_cols; i++)
+	{
+		float64_t offset=i<num_per_cluster ? -10 : 10;
+		data(0, i)=offset+CMath::randn_double();
+		data(1, i)=offset+0.5*CMath::randn_double();
+	}
+
+	CDenseFeatures<float64_t>* features=new CDenseFeatures<float64_t>(data);
+	SG_REF(features);
+	ECovType cov_types[]={FULL, DIAG};
+	for (auto cov_type: cov_types)
+	{
+		CGMM* gmm=new CGMM(2, cov_type);
+		SG_REF(gmm);
+		gmm->train(features);
+		float64_t log_likelihood=gmm->train_em(1e-9, 100, 1e-9);
+		EXPECT_FALSE(CMath::is_nan(log_likelihood));
+
+		SGVector<float64_t> coef=gmm->get_coef();
+		for (int32_t i=0; i<2; i++)
+		{
+			EXPECT_NEAR(coef[i], 0.5, 1e-6);
+
+			SGVector<float64_t> mean=gmm->get_nth_mean(i);
+			float64_t offset=mean[0]<0 ? -10 : 10;
+			EXPECT_NEAR(mean[0], offset, 0.3);
+			EXPECT_NEAR(mean[1], offset, 0.3);
+
+			SGMatrix<float64_t> cov=gmm->get_nth_cov(i);
+			EXPECT_NEAR(cov(0, 0), 1.0, 0.3);
+			EXPECT_NEAR(cov(1, 1), 0.25, 0.1);
+		}
+
+		SG_UNREF(gmm);
+	}
+
+	SG_UNREF(features);
+}
@@ -0,0 +1,79 @@
+/*
+ * This software is distributed under BSD 3-clause license (see LICENSE file).
+ */
+
+#include <gtest/gtest.h>
+
+#include <shogun/clustering/Hierarchical.h>
+#include <shogun/distance/EuclideanDistance.h>
+#include <shogun/features/DenseFeatures.h>
+#include <shogun/mathematics/Math.h>
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+using namespace shogun;
+
+TEST(Hierarchical, matches_merging_all_pairs)
+{
+	CMath::init_random(17);
+	int32_t num=150;
+	int32_t merges=4;
+	SGMatrix<float64_t> data(3, num);
+	for (index_t i=0; i<data.num_rows*data.num_cols; i++)
+		data.matrix[i]=CMath::randn_double();
+
+	CDenseFeatures<float64_t>* features=new CDenseFeatures<float64_t>(data);
+	CEuclideanDistance* distance=new CEuclideanDistance(features, features);
+	CHierarchical* hierarchical=new CHierarchical(merges, distance);
+	SG_REF(hierarchical);
+	hierarchical->train();
+
+	// reference: merge the clusters of the closest pairs first
+	std::vector<std::tuple<float64_t, int32_t, int32_t>> all_pairs;
+	for (int32_t i=0; i<num; i++)
+	{
+		for (int32_t j=i+1; j<num; j++)
+			all_pairs.emplace_back(distance->distance(i, j), i, j);
+	}
+	std::sort(all_pairs.begin(), all_pairs.end());
+
+	std::vector<int32_t> assignment(num);
+	for (int32_t i=0; i<num; i++)
+		assignment[i]=i;
+
+	SGVector<float64_t> merge_distances=hierarchical->get_merge_distances();
+	SGMatrix<int32_t> cluster_pairs=hierarchical->get_cluster_pairs();
+	int32_t l=0;
+	for (const auto& p: all_pairs)
+	{
+		int32_t c1=assignment[std::get<1>(p)];
+		int32_t c2=assignment[std::get<2>(p)];
+		if (c1==c2)
+			continue;
+
+		if (l<merges)
+		{
+			EXPECT_EQ(merge_distances[l], std::get<0>(p));
+			EXPECT_EQ(cluster_pairs(0, l), CMath::min(c1, c2));
+			EXPECT_EQ(cluster_pairs(1, l), CMath::max(c1, c2));
+		}
+
+		for (int32_t m=0; m<num; m++)
+		{
+			if (assignment[m]==c1 || assignment[m]==c2)
+				assignment[m]=num+l;
+		}
+
+		if (num-(++l)<merges)
+			break;
+	}
+
+	SGVector<int32_t> result=hierarchical->get_assignment();
+	EXPECT_EQ(result.vlen, num-merges);
+	for (index_t i=0; i<result.vlen; i++)
+		EXPECT_EQ(result[i], assignment[i]);
+
+	SG_UNREF(hierarchical);
+}
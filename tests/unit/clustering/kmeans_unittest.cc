@@ -11,6 +11,11 @@
 #include <shogun/clustering/KMeans.h>
 #include <shogun/clustering/KMeansMiniBatch.h>
 #include <shogun/distance/EuclideanDistance.h>
+#include <shogun/features/DataGenerator.h>
+#include <shogun/features/streaming/StreamingDenseFeatures.h>
+#include <shogun/io/CSVFile.h>
+#include <shogun/io/streaming/StreamingAsciiFile.h>
+#include "../utils/Utils.h"
 
 using namespace shogun;
 
@@ -280,3 +285,158 @@ TEST(KMeans, random_centers_assign)
 	SG_UNREF(learnt_centers);
 }
 
+TEST(KMeans, hamerly_matches_lloyd)
+{
+	CMath::init_random(5);
+	int32_t num_clusters=8;
+	SGMatrix<float64_t> data=CDataGenerator::generate_gaussians(100, num_clusters, 5);
+
+	/* overlapping clusters need several iterations */
+	SGMatrix<float64_t> initial_centers(5, num_clusters);
+	for (int32_t i=0; i<num_clusters; i++)
+	{
+		for (int32_t j=0; j<5; j++)
+			initial_centers(j, i)=data(j, 37*i);
+	}
+
+	SGMatrix<float64_t> centers[2];
+	for (int32_t use_hamerly=0; use_hamerly<2; use_hamerly++)
+	{
+		CDenseFeatures<float64_t>* features=new CDenseFeatures<float64_t>(data);
+		SG_REF(features);
+		CEuclideanDistance* distance=new CEuclideanDistance(features, features);
+		CKMeans* clustering=new CKMeans(num_clusters, distance, initial_centers);
+		clustering->set_use_hamerly(use_hamerly);
+		clustering->train(features);
+
+		centers[use_hamerly]=clustering->get_cluster_centers();
+
+		SG_UNREF(clustering);
+		SG_UNREF(features);
+	}
+
+	for (int32_t i=0; i<num_clusters*5; i++)
+		EXPECT_NEAR(centers[0].matrix[i], centers[1].matrix[i], 1e-10);
+}
+
+TEST(KMeans, minibatch_streaming_kmeans_parallel)
+{
+	CMath::init_random(7);
+	/* four well separated blobs in the corners of a square */
+	int32_t num_clusters=4;
+	int32_t num_per_cluster=200;
+	SGMatrix<float64_t> true_centers(2, num_clusters);
+	SGMatrix<float64_t> data(2, num_clusters*num_per_cluster);
+	for (int32_t i=0; i<num_clusters; i++)
+	{
+		true_centers(0, i)=i%2 ? 100 : -100;
+		true_centers(1, i)=i/2 ? 100 : -100;
+	}
+	for (int32_t i=0; i<data.num_cols; i++)
+	{
+		for (int32_t j=0; j<2; j++)
+			data(j, i)=true_centers(j, i%num_clusters)+CMath::randn_double();
+	}
+
+	CDenseFeatures<float64_t>* features=new CDenseFeatures<float64_t>(data);
+	CStreamingDenseFeatures<float64_t>* stream=
+		new CStreamingDenseFeatures<float64_t>(features);
+	SG_REF(stream);
+
+	CEuclideanDistance* distance=new CEuclideanDistance();
+	CKMeansMiniBatch* clustering=new CKMeansMiniBatch(num_clusters, distance);
+	EXPECT_ANY_THROW(clustering->set_init_rounds(0));
+	EXPECT_ANY_THROW(clustering->set_oversampling(0));
+	clustering->set_init_rounds(3);
+	clustering->set_oversampling(2);
+
+	/* more batches than the stream holds, it is reset in between */
+	clustering->set_mb_params(64, 40);
+	clustering->train(stream);
+
+	SGMatrix<float64_t> centers=clustering->get_cluster_centers();
+	ASSERT_EQ(centers.num_rows, 2);
+	ASSERT_EQ(centers.num_cols, num_clusters);
+	for (int32_t i=0; i<num_clusters; i++)
+	{
+		float64_t closest=CMath::INFTY;
+		for (int32_t j=0; j<num_clusters; j++)
+		{
+			closest=CMath::min(closest,
+				CMath::sq(centers(0, j)-true_centers(0, i))+
+				CMath::sq(centers(1, j)-true_centers(1, i)));
+		}
+		EXPECT_LT(closest, 1.0);
+	}
+
+	/* the learnt centers are used to assign new vectors */
+	CMulticlassLabels* result=clustering->apply_multiclass(features);
+	for (int32_t i=num_clusters; i<data.num_cols; i++)
+		EXPECT_EQ(result->get_label(i), result->get_label(i-num_clusters));
+	SG_UNREF(result);
+
+	SG_UNREF(clustering);
+	SG_UNREF(stream);
+}
+
+TEST(KMeans, minibatch_streaming_file_kmeans_parallel)
+{
+	CMath::init_random(11);
+	int32_t num_clusters=4;
+	SGMatrix<float64_t> true_centers(2, num_clusters);
+	SGMatrix<float64_t> data(2, num_clusters*200);
+	for (int32_t i=0; i<num_clusters; i++)
+	{
+		true_centers(0, i)=i%2 ? 100 : -100;
+		true_centers(1, i)=i/2 ? 100 : -100;
+	}
+	for (int32_t i=0; i<data.num_cols; i++)
+	{
+		for (int32_t j=0; j<2; j++)
+			data(j, i)=true_centers(j, i%num_clusters)+CMath::randn_double();
+	}
+
+	char fname[]="KMeansMiniBatch_stream.XXXXXX";
+	generate_temp_filename(fname);
+	CDenseFeatures<float64_t>* features=new CDenseFeatures<float64_t>(data);
+	SG_REF(features);
+	CCSVFile* file=new CCSVFile(fname, 'w');
+	features->save(file);
+	file->close();
+	SG_UNREF(file);
+
+	CStreamingAsciiFile* input=new CStreamingAsciiFile(fname);
+	input->set_delimiter(',');
+	CStreamingDenseFeatures<float64_t>* stream=
+		new CStreamingDenseFeatures<float64_t>(input, false, 32);
+	SG_REF(stream);
+	EXPECT_TRUE(stream->is_seekable());
+
+	CEuclideanDistance* distance=new CEuclideanDistance();
+	CKMeansMiniBatch* clustering=new CKMeansMiniBatch(num_clusters, distance);
+	clustering->set_init_rounds(3);
+
+	/* fewer batches than the file holds, the parser is stopped early */
+	clustering->set_mb_params(64, 5);
+	clustering->train(stream);
+
+	SGMatrix<float64_t> centers=clustering->get_cluster_centers();
+	ASSERT_EQ(centers.num_rows, 2);
+	ASSERT_EQ(centers.num_cols, num_clusters);
+	for (int32_t i=0; i<num_clusters; i++)
+	{
+		float64_t closest=CMath::INFTY;
+		for (int32_t j=0; j<num_clusters; j++)
+		{
+			closest=CMath::min(closest,
+				CMath::sq(centers(0, j)-true_centers(0, i))+
+				CMath::sq(centers(1, j)-true_centers(1, i)));
+		}
+		EXPECT_LT(closest, 1.0);
+	}
+
+	SG_UNREF(clustering);
+	SG_UNREF(stream);
+	SG_UNREF(features);
+	std::remove(fname);
+}
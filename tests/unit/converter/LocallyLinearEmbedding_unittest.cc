@@ -0,0 +1,44 @@
+/*
+ * This software is distributed under BSD 3-clause license (see LICENSE file).
+ */
+#include <gtest/gtest.h>
+#include <shogun/converter/LocallyLinearEmbedding.h>
+#include <shogun/features/DenseFeatures.h>
+#include <shogun/features/DataGenerator.h>
+#include <shogun/mathematics/Math.h>
+
+using namespace shogun;
+
+/* all other points are neighbors, so that a graph search which misses any
+ * of them has to be completed exhaustively */
+TEST(LocallyLinearEmbeddingTest, hnsw_neighbors_max_k)
+{
+	CMath::init_random(17);
+	const index_t n_samples = 20;
+	const index_t n_dimensions = 3;
+	const index_t n_target_dimensions = 2;
+	CDenseFeatures<float64_t>* high_dimensional_features =
+		new CDenseFeatures<float64_t>(CDataGenerator::generate_gaussians(n_samples, 1, n_dimensions));
+	SG_REF(high_dimensional_features);
+
+	CLocallyLinearEmbedding* embedder = new CLocallyLinearEmbedding();
+	SG_REF(embedder);
+	embedder->set_target_dim(n_target_dimensions);
+	embedder->set_k(n_samples-1);
+	embedder->set_neighbors_method(NEIGHBORS_HNSW);
+	EXPECT_EQ(NEIGHBORS_HNSW, embedder->get_neighbors_method());
+
+	CDenseFeatures<float64_t>* low_dimensional_features =
+		embedder->transform(high_dimensional_features)->as<CDenseFeatures<float64_t>>();
+	SG_REF(low_dimensional_features);
+
+	EXPECT_EQ(n_target_dimensions, low_dimensional_features->get_dim_feature_space());
+	EXPECT_EQ(n_samples, low_dimensional_features->get_num_vectors());
+	SGMatrix<float64_t> embedding = low_dimensional_features->get_feature_matrix();
+	for (index_t i=0; i<embedding.num_rows*embedding.num_cols; i++)
+		EXPECT_TRUE(CMath::is_finite(embedding.matrix[i]));
+
+	SG_UNREF(low_dimensional_features);
+	SG_UNREF(embedder);
+	SG_UNREF(high_dimensional_features);
+}
@@ -0,0 +1,221 @@
+/*
+ * This software is distributed under BSD 3-clause license (see LICENSE file).
+ */
+
+#include <gtest/gtest.h>
+
+#include <shogun/distributions/HMM.h>
+#include <shogun/features/StringFeatures.h>
+#include <shogun/lib/SGString.h>
+#include <shogun/lib/SGStringList.h>
+#include <shogun/mathematics/Math.h>
+
+#include <vector>
+
+using namespace shogun;
+
+static CStringFeatures<uint16_t>* random_sequences(int32_t num, int32_t M)
+{
+	SGStringList<uint16_t> list(num, 0);
+	for (int32_t i=0; i<num; i++)
+	{
+		int32_t len=CMath::random(1, 60);
+		list.strings[i]=SGString<uint16_t>(len);
+		for (int32_t t=0; t<len; t++)
+		{
+			// a sticky source so that the sequences have some structure
+			uint16_t prev=t ? list.strings[i].string[t-1] : 0;
+			list.strings[i].string[t]=CMath::random(0, 2) ? prev :
+				CMath::random(0, M-1);
+		}
+		list.max_string_length=CMath::max(list.max_string_length, len);
+	}
+	return new CStringFeatures<uint16_t>(list, CUBE);
+}
+
+TEST(HMM, batched_probabilities_match_per_sequence)
+{
+	CMath::init_random(5);
+	CStringFeatures<uint16_t>* obs=random_sequences(40, 6);
+	CHMM* hmm=new CHMM(obs, 4, 6, 1e-10);
+	SG_REF(hmm);
+	hmm->init_model_random();
+
+	float64_t likelihood=0;
+	float64_t viterbi=0;
+	for (int32_t i=0; i<obs->get_num_vectors(); i++)
+	{
+		likelihood+=hmm->model_probability(i);
+		viterbi+=hmm->best_path(i);
+	}
+	likelihood/=obs->get_num_vectors();
+	viterbi/=obs->get_num_vectors();
+
+	hmm->invalidate_model();
+	EXPECT_NEAR(hmm->model_probability(), likelihood, 1e-9);
+	EXPECT_NEAR(hmm->best_path(-1), viterbi, 1e-9);
+
+	SG_UNREF(hmm);
+}
+
+#ifndef USE_HMMPARALLEL_STRUCTURES
+TEST(HMM, baum_welch_matches_reference)
+{
+	CMath::init_random(7);
+	CStringFeatures<uint16_t>* obs=random_sequences(30, 6);
+	CHMM* hmm=new CHMM(obs, 3, 6, 1e-10);
+	SG_REF(hmm);
+	hmm->init_model_random();
+
+	CHMM* batched=new CHMM(hmm);
+	CHMM* reference=new CHMM(hmm);
+	SG_REF(batched);
+	SG_REF(reference);
+	batched->estimate_model_baum_welch(hmm);
+	reference->estimate_model_baum_welch_old(hmm);
+
+	for (int32_t i=0; i<hmm->get_N(); i++)
+	{
+		EXPECT_NEAR(batched->get_p(i), reference->get_p(i), 1e-8);
+		EXPECT_NEAR(batched->get_q(i), reference->get_q(i), 1e-8);
+		for (int32_t j=0; j<hmm->get_N(); j++)
+			EXPECT_NEAR(batched->get_a(i, j), reference->get_a(i, j), 1e-8);
+		for (int32_t j=0; j<hmm->get_M(); j++)
+			EXPECT_NEAR(batched->get_b(i, j), reference->get_b(i, j), 1e-8);
+	}
+
+	SG_UNREF(reference);
+	SG_UNREF(batched);
+	SG_UNREF(hmm);
+}
+#endif
+
+TEST(HMM, viterbi_training_counts_best_paths)
+{
+	CMath::init_random(9);
+	int32_t N=3;
+	int32_t M=6;
+	CStringFeatures<uint16_t>* obs=random_sequences(30, M);
+	CHMM* hmm=new CHMM(obs, N, M, 1e-10);
+	SG_REF(hmm);
+	hmm->init_model_random();
+
+	std::vector<float64_t> a(N*N, hmm->get_pseudo());
+	std::vector<float64_t> b(N*M, hmm->get_pseudo());
+	for (int32_t i=0; i<obs->get_num_vectors(); i++)
+	{
+		hmm->best_path(i);
+		int32_t len=obs->get_vector_length(i);
+		for (int32_t t=0; t<len; t++)
+		{
+			int32_t state=hmm->get_best_path_state(i, t);
+			b[state*M+obs->get_feature(i, t)]++;
+			if (t<len-1)
+				a[state*N+hmm->get_best_path_state(i, t+1)]++;
+		}
+	}
+
+	CHMM* estimate=new CHMM(hmm);
+	SG_REF(estimate);
+	estimate->estimate_model_viterbi(hmm);
+
+	for (int32_t i=0; i<N; i++)
+	{
+		float64_t a_sum=0;
+		for (int32_t j=0; j<N; j++)
+			a_sum+=a[i*N+j];
+		for (int32_t j=0; j<N; j++)
+			EXPECT_NEAR(estimate->get_a(i, j), std::log(a[i*N+j]/a_sum), 1e-9);
+
+		float64_t b_sum=0;
+		for (int32_t j=0; j<M; j++)
+			b_sum+=b[i*M+j];
+		for (int32_t j=0; j<M; j++)
+			EXPECT_NEAR(estimate->get_b(i, j), std::log(b[i*M+j]/b_sum), 1e-9);
+	}
+
+	SG_UNREF(estimate);
+	SG_UNREF(hmm);
+}
+
+TEST(HMM, forward_does_not_underflow)
+{
+	// two separate chains, the one that ends falls 700 nats per symbol
+	// behind the other, so that its scaled forward variables underflow
+	const int32_t T=5;
+	SGStringList<uint16_t> list(1, T);
+	list.strings[0]=SGString<uint16_t>(T);
+	for (int32_t t=0; t<T; t++)
+		list.strings[0].string[t]=0;
+	CStringFeatures<uint16_t>* obs=new CStringFeatures<uint16_t>(list, CUBE);
+
+	CHMM* hmm=new CHMM(obs, 2, 2, 1e-10);
+	SG_REF(hmm);
+	for (int32_t i=0; i<2; i++)
+	{
+		hmm->set_p(i, std::log(0.5));
+		hmm->set_a(i, i, 0);
+		hmm->set_a(i, 1-i, -CMath::INFTY);
+	}
+	hmm->set_q(0, -CMath::INFTY);
+	hmm->set_q(1, 0);
+	hmm->set_b(0, 0, 0);
+	hmm->set_b(0, 1, -CMath::INFTY);
+	hmm->set_b(1, 0, -700);
+	hmm->set_b(1, 1, 0);
+	hmm->invalidate_model();
+
+	EXPECT_NEAR(hmm->model_probability(), std::log(0.5)-700*T, 1e-6);
+
+	SG_UNREF(hmm);
+}
+
+#ifndef USE_HMMPARALLEL_STRUCTURES
+TEST(HMM, backward_does_not_underflow)
+{
+	// two chains whose emissions are 800 nats apart in opposite order, so
+	// that the future of one chain lies too far below the other one for the
+	// scaled backward variables, although both chains are equally likely
+	SGStringList<uint16_t> list(1, 2);
+	list.strings[0]=SGString<uint16_t>(2);
+	list.strings[0].string[0]=0;
+	list.strings[0].string[1]=1;
+	CStringFeatures<uint16_t>* obs=new CStringFeatures<uint16_t>(list, CUBE);
+
+	CHMM* hmm=new CHMM(obs, 2, 2, 1e-10);
+	SG_REF(hmm);
+	for (int32_t i=0; i<2; i++)
+	{
+		hmm->set_p(i, std::log(0.5));
+		hmm->set_q(i, 0);
+		hmm->set_a(i, i, 0);
+		hmm->set_a(i, 1-i, -1000);
+		hmm->set_b(i, i, -800);
+		hmm->set_b(i, 1-i, 0);
+	}
+	hmm->invalidate_model();
+
+	CHMM* batched=new CHMM(hmm);
+	CHMM* reference=new CHMM(hmm);
+	SG_REF(batched);
+	SG_REF(reference);
+	batched->estimate_model_baum_welch(hmm);
+	reference->estimate_model_baum_welch_old(hmm);
+
+	for (int32_t i=0; i<2; i++)
+	{
+		EXPECT_NEAR(batched->get_p(i), std::log(0.5), 1e-8);
+		EXPECT_NEAR(batched->get_p(i), reference->get_p(i), 1e-8);
+		EXPECT_NEAR(batched->get_q(i), reference->get_q(i), 1e-8);
+		for (int32_t j=0; j<2; j++)
+		{
+			EXPECT_NEAR(batched->get_a(i, j), reference->get_a(i, j), 1e-8);
+			EXPECT_NEAR(batched->get_b(i, j), reference->get_b(i, j), 1e-8);
+		}
+	}
+
+	SG_UNREF(reference);
+	SG_UNREF(batched);
+	SG_UNREF(hmm);
+}
+#endif
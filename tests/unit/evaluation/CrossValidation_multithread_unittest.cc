@@ -168,3 +168,57 @@ TEST(CrossValidation_multithread, KNN)
 	SG_UNREF(cross);
 	SG_UNREF(features);
 }
+
+TEST(CrossValidation_multithread, KNN_parallel_evaluation)
+{
+	int32_t num=200;
+	SGMatrix<float64_t> mat(2, num);
+	SGVector<float64_t> lab(num);
+
+	/* overlapping clusters, so that folds differ in accuracy */
+	sg_rand->set_seed(3);
+	for (index_t i=0; i<num; i++)
+	{
+		lab[i]=i%2;
+		mat(0,i)=lab[i]*3+CMath::randn_double()*2;
+		mat(1,i)=CMath::randn_double()*2;
+	}
+	CMulticlassLabels* labels=new CMulticlassLabels(lab);
+
+	CDenseFeatures<float64_t>* features=
+			new CDenseFeatures<float64_t>(mat);
+	SG_REF(features);
+
+	CEuclideanDistance* distance = new CEuclideanDistance(features, features);
+	CKNN* knn=new CKNN (3, distance, labels);
+	CMulticlassAccuracy* eval_crit = new CMulticlassAccuracy ();
+
+	index_t n_folds=5;
+	CStratifiedCrossValidationSplitting* splitting=
+			new CStratifiedCrossValidationSplitting(labels, n_folds);
+
+	CCrossValidation* cross=new CCrossValidation(knn, features, labels,
+			splitting, eval_crit);
+
+	cross->set_autolock(false);
+	cross->set_num_runs(3);
+
+	sg_rand->set_seed(1);
+	CCrossValidationResult* result1=(CCrossValidationResult*)cross->evaluate();
+
+	cross->set_parallel_evaluation(true);
+	EXPECT_TRUE(cross->get_parallel_evaluation());
+	cross->parallel->set_num_threads(4);
+
+	/* same splits as the serial evaluation */
+	sg_rand->set_seed(1);
+	CCrossValidationResult* result2=(CCrossValidationResult*)cross->evaluate();
+
+	EXPECT_EQ(result1->get_mean(), result2->get_mean());
+	EXPECT_EQ(result1->get_std_dev(), result2->get_std_dev());
+
+	SG_UNREF(result1);
+	SG_UNREF(result2);
+	SG_UNREF(cross);
+	SG_UNREF(features);
+}
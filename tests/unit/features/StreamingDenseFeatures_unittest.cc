@@ -62,6 +62,112 @@ TEST(StreamingDenseFeaturesTest, example_reading_from_file)
 	std::remove(fname);
 }
 
+TEST(StreamingDenseFeaturesTest, parallel_parsing_from_file)
+{
+	index_t n=500;
+	index_t dim=3;
+	char fname[] = "StreamingDenseFeatures_parallel.XXXXXX";
+	generate_temp_filename(fname);
+
+	SGMatrix<float64_t> data(dim,n);
+	for (index_t i=0; i<dim*n; ++i)
+		data.matrix[i] = sg_rand->std_normal_distrib();
+
+	CDenseFeatures<float64_t>* orig_feats=new CDenseFeatures<float64_t>(data);
+	CCSVFile* saved_features = new CCSVFile(fname, 'w');
+	orig_feats->save(saved_features);
+	saved_features->close();
+	SG_UNREF(saved_features);
+
+	CStreamingAsciiFile* input = new CStreamingAsciiFile(fname);
+	input->set_delimiter(',');
+	CStreamingDenseFeatures<float64_t>* feats
+		= new CStreamingDenseFeatures<float64_t>(input, false, 16);
+	feats->set_num_parsers(4);
+
+	index_t i = 0;
+	feats->start_parser();
+	while (feats->get_next_example())
+	{
+		SGVector<float64_t> example = feats->get_vector();
+		SGVector<float64_t> expected = orig_feats->get_feature_vector(i);
+
+		ASSERT_EQ(dim, example.vlen);
+
+		// examples come back in the order of the file
+		for (index_t j = 0; j < dim; j++)
+			EXPECT_NEAR(expected.vector[j], example.vector[j], 1E-5);
+
+		feats->release_example();
+		i++;
+	}
+	feats->end_parser();
+	EXPECT_EQ(n, i);
+
+	SG_UNREF(orig_feats);
+	SG_UNREF(feats);
+
+	std::remove(fname);
+}
+
+TEST(StreamingDenseFeaturesTest, reset_file_stream)
+{
+	index_t n=50;
+	index_t dim=2;
+	char fname[] = "StreamingDenseFeatures_reset.XXXXXX";
+	generate_temp_filename(fname);
+
+	SGMatrix<float64_t> data(dim,n);
+	for (index_t i=0; i<dim*n; ++i)
+		data.matrix[i] = sg_rand->std_normal_distrib();
+
+	CDenseFeatures<float64_t>* orig_feats=new CDenseFeatures<float64_t>(data);
+	CCSVFile* saved_features = new CCSVFile(fname, 'w');
+	orig_feats->save(saved_features);
+	saved_features->close();
+	SG_UNREF(saved_features);
+
+	CStreamingAsciiFile* input = new CStreamingAsciiFile(fname);
+	input->set_delimiter(',');
+	// a ring smaller than the file, so that the parser waits for the reader
+	CStreamingDenseFeatures<float64_t>* feats
+		= new CStreamingDenseFeatures<float64_t>(input, false, 4);
+	EXPECT_TRUE(feats->is_seekable());
+
+	// stop in the middle of the file, then read it again from its start
+	feats->start_parser();
+	for (index_t i=0; i<10; i++)
+	{
+		ASSERT_TRUE(feats->get_next_example());
+		feats->release_example();
+	}
+	feats->reset_stream();
+
+	index_t i = 0;
+	while (feats->get_next_example())
+	{
+		SGVector<float64_t> example = feats->get_vector();
+		SGVector<float64_t> expected = orig_feats->get_feature_vector(i);
+
+		ASSERT_EQ(dim, example.vlen);
+		for (index_t j = 0; j < dim; j++)
+			EXPECT_NEAR(expected.vector[j], example.vector[j], 1E-5);
+
+		feats->release_example();
+		i++;
+		// the parser is cancelled when the reader stops early
+		if (i==n/2)
+			break;
+	}
+	feats->end_parser();
+	EXPECT_EQ(n/2, i);
+
+	SG_UNREF(orig_feats);
+	SG_UNREF(feats);
+
+	std::remove(fname);
+}
+
 TEST(StreamingDenseFeaturesTest, example_reading_from_features)
 {
 	index_t n=20;
@@ -78,3 +78,112 @@ TEST(StreamingSparseFeaturesTest, parse_file)
 
   std::remove(fname);
 }
+
+TEST(StreamingSparseFeaturesTest, parallel_parse_file)
+{
+  char fname[] = "StreamingSparseFeatures_parallel_parse_file.XXXXXX";
+  generate_temp_filename(fname);
+
+  int32_t max_num_entries=20;
+  CRandom* rand=new CRandom();
+
+  int32_t num_vec=300;
+  int32_t num_feat=0;
+
+  SGSparseVector<float64_t>* data=SG_MALLOC(SGSparseVector<float64_t>, num_vec);
+  float64_t* labels=SG_MALLOC(float64_t, num_vec);
+  for (int32_t i=0; i<num_vec; i++)
+  {
+    data[i]=SGSparseVector<float64_t>(rand->random(1, max_num_entries));
+    labels[i]=i%2 ? 1 : -1;
+    for (int32_t j=0; j<data[i].num_feat_entries; j++)
+    {
+      int32_t feat_index=(j+1)*2;
+      if (feat_index>num_feat)
+        num_feat=feat_index;
+
+      data[i].features[j].feat_index=feat_index-1;
+      data[i].features[j].entry=rand->random(-10., 10.);
+    }
+  }
+  CLibSVMFile* fout = new CLibSVMFile(fname, 'w', NULL);
+  fout->set_sparse_matrix(data, num_feat, num_vec, labels);
+  SG_UNREF(fout);
+  SG_UNREF(rand);
+
+  CStreamingAsciiFile *file = new CStreamingAsciiFile(fname);
+  CStreamingSparseFeatures<float64_t> *stream_features =
+    new CStreamingSparseFeatures<float64_t>(file, true, 8);
+  stream_features->set_num_parsers(3);
+
+  stream_features->start_parser();
+  index_t i = 0;
+  while (stream_features->get_next_example())
+  {
+      SGSparseVector<float64_t> v = stream_features->get_vector();
+      EXPECT_EQ(labels[i], stream_features->get_label());
+      EXPECT_EQ(data[i].num_feat_entries, v.num_feat_entries);
+
+      for (index_t j = 0; j < data[i].num_feat_entries; j++)
+      {
+        EXPECT_EQ(data[i].features[j].feat_index, v.features[j].feat_index);
+        EXPECT_DOUBLE_EQ(data[i].features[j].entry, v.features[j].entry);
+      }
+
+      stream_features->release_example();
+      i++;
+  }
+  stream_features->end_parser();
+  EXPECT_EQ(num_vec, i);
+
+  SG_UNREF(stream_features);
+  SG_FREE(data);
+  SG_FREE(labels);
+
+  std::remove(fname);
+}
+
+TEST(StreamingSparseFeaturesTest, parallel_parse_bare_label)
+{
+  char fname[] = "StreamingSparseFeatures_parallel_parse_bare_label.XXXXXX";
+  generate_temp_filename(fname);
+
+  // a line with a bare label ends the input, as for a single parser
+  FILE* fout=fopen(fname, "w");
+  for (int32_t i=0; i<20; i++)
+  {
+    if (i==7)
+      fprintf(fout, "1\n");
+    else
+      fprintf(fout, "%d 1:0.5 3:%d.25\n", i%2 ? 1 : -1, i);
+  }
+  fclose(fout);
+
+  for (int32_t num_parsers=1; num_parsers<=3; num_parsers+=2)
+  {
+    CStreamingAsciiFile *file = new CStreamingAsciiFile(fname);
+    CStreamingSparseFeatures<float64_t> *stream_features =
+      new CStreamingSparseFeatures<float64_t>(file, true, 4);
+    stream_features->set_num_parsers(num_parsers);
+
+    stream_features->start_parser();
+    index_t i = 0;
+    while (stream_features->get_next_example())
+    {
+        SGSparseVector<float64_t> v = stream_features->get_vector();
+        EXPECT_EQ(i%2 ? 1 : -1, stream_features->get_label());
+        ASSERT_EQ(2, v.num_feat_entries);
+        EXPECT_EQ(2, v.features[1].feat_index);
+        EXPECT_DOUBLE_EQ(i+0.25, v.features[1].entry);
+
+        stream_features->release_example();
+        i++;
+    }
+    stream_features->end_parser();
+    EXPECT_EQ(7, i);
+
+    SG_UNREF(stream_features);
+  }
+
+  std::remove(fname);
+}
@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include <shogun/io/SGIO.h>
 #include <stdexcept>
+#include <stdio.h>
+#include <stdlib.h>
 
 using namespace shogun;
 
@@ -13,3 +15,27 @@ TEST(SGIO, exception)
 	EXPECT_THROW(
 	    REQUIRE_E(0, std::invalid_argument, "Error"), std::invalid_argument);
 }
+
+TEST(SGIO, parse_double)
+{
+	const char* numbers[]={"0", "-0", "1e5", "1.5E-3", "  42", "+.5", "5.",
+		"-1e400", "inf", "1e-30", "123456789012345678901234", "1e", "3.14abc",
+		"0.1", "-2.5e+10", "0x1p3", "", "-"};
+	for (auto str : numbers)
+	{
+		char* end=NULL;
+		char* expected_end=NULL;
+		float64_t value=SGIO::parse_double(str, &end);
+		EXPECT_EQ(strtod(str, &expected_end), value) << str;
+		EXPECT_EQ(expected_end, end) << str;
+	}
+
+	// round trip of printed doubles
+	char buffer[64];
+	for (int32_t i=0; i<10000; i++)
+	{
+		float64_t value=(i-5000)*0.7531+i*1e-7;
+		snprintf(buffer, sizeof(buffer), "%.*g", i%17+1, value);
+		EXPECT_EQ(strtod(buffer, NULL), SGIO::parse_double(buffer)) << buffer;
+	}
+}
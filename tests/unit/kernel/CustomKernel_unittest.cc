@@ -14,6 +14,9 @@
 #include <shogun/features/streaming/generators/MeanShiftDataGenerator.h>
 #include <shogun/mathematics/eigen3.h>
 #include <shogun/mathematics/Math.h>
+#include "../utils/Utils.h"
+
+#include <cstdio>
 
 using namespace shogun;
 using namespace Eigen;
@@ -635,3 +638,70 @@ TEST(CustomKernelTest, row_col_wise_sum_block_no_diag)
 	SG_UNREF(feats_p);
 	SG_UNREF(feats_q);
 }
+
+TEST(CustomKernelTest, memory_mapped_file)
+{
+	const index_t num_lhs=20;
+	const index_t num_rhs=15;
+	const index_t dim=3;
+
+	CMath::init_random(100);
+	SGMatrix<float64_t> data_p(dim, num_lhs);
+	SGMatrix<float64_t> data_q(dim, num_rhs);
+	for (index_t i=0; i<dim*num_lhs; ++i)
+		data_p.matrix[i]=CMath::randn_double();
+	for (index_t i=0; i<dim*num_rhs; ++i)
+		data_q.matrix[i]=CMath::randn_double();
+
+	CDenseFeatures<float64_t>* feats_p=new CDenseFeatures<float64_t>(data_p);
+	CDenseFeatures<float64_t>* feats_q=new CDenseFeatures<float64_t>(data_q);
+	CGaussianKernel* kernel=new CGaussianKernel(feats_p, feats_q, 2);
+	SGMatrix<float64_t> km=kernel->get_kernel_matrix();
+
+	char fname[]="CustomKernel_memory_mapped.XXXXXX";
+	generate_temp_filename(fname);
+
+	CCustomKernel* custom=new CCustomKernel(kernel, fname);
+	EXPECT_TRUE(custom->is_memory_mapped());
+	ASSERT_EQ(custom->get_num_vec_lhs(), num_lhs);
+	ASSERT_EQ(custom->get_num_vec_rhs(), num_rhs);
+	for (index_t j=0; j<num_rhs; ++j)
+		for (index_t i=0; i<num_lhs; ++i)
+			EXPECT_NEAR(custom->kernel(i, j), km(i, j), 1E-6);
+
+	// subsets work on the mapped matrix
+	SGVector<index_t> subset(2);
+	subset[0]=7;
+	subset[1]=3;
+	custom->add_row_subset(subset);
+	EXPECT_NEAR(custom->kernel(1, 4), km(3, 4), 1E-6);
+	custom->remove_row_subset();
+
+	// the file can be mapped again later on
+	CCustomKernel* reloaded=new CCustomKernel();
+	reloaded->set_kernel_matrix_from_file(fname);
+	EXPECT_TRUE(reloaded->is_memory_mapped());
+	EXPECT_NEAR(reloaded->kernel(5, 6), km(5, 6), 1E-6);
+	SG_UNREF(reloaded);
+
+	// symmetric kernel matrix as upper triangle
+	kernel->init(feats_p, feats_p);
+	km=kernel->get_kernel_matrix();
+	char tri_fname[]="CustomKernel_memory_mapped_triangle.XXXXXX";
+	generate_temp_filename(tri_fname);
+	CCustomKernel::compute_kernel_matrix_file(kernel, tri_fname, true);
+	custom->set_kernel_matrix_from_file(tri_fname);
+	ASSERT_EQ(custom->get_num_vec_lhs(), num_lhs);
+	ASSERT_EQ(custom->get_num_vec_rhs(), num_lhs);
+	for (index_t j=0; j<num_lhs; ++j)
+		for (index_t i=0; i<num_lhs; ++i)
+			EXPECT_NEAR(custom->kernel(i, j), km(i, j), 1E-6);
+
+	custom->set_full_kernel_matrix_from_full(km);
+	EXPECT_FALSE(custom->is_memory_mapped());
+
+	SG_UNREF(custom);
+	SG_UNREF(kernel);
+	std::remove(fname);
+	std::remove(tri_fname);
+}
@@ -0,0 +1,279 @@
+/*
+ * This software is distributed under BSD 3-clause license (see LICENSE file).
+ */
+
+#include <gtest/gtest.h>
+
+#include <shogun/classifier/svm/LibSVM.h>
+#include <shogun/features/DenseFeatures.h>
+#include <shogun/kernel/GaussianKernel.h>
+#include <shogun/kernel/KernelRowCache.h>
+#include <shogun/labels/BinaryLabels.h>
+#include <shogun/mathematics/Math.h>
+
+#include "environments/LinearTestEnvironment.h"
+
+using namespace shogun;
+
+extern LinearTestEnvironment* linear_test_env;
+
+class KernelRowCache : public ::testing::Test
+{
+public:
+	CDenseFeatures<float64_t>* features;
+	CBinaryLabels* labels;
+	CGaussianKernel* kernel;
+	index_t num_vectors;
+
+	virtual void SetUp()
+	{
+		std::shared_ptr<GaussianCheckerboard> mock_data=
+			linear_test_env->getBinaryLabelData();
+		features=mock_data->get_features_train();
+		labels=(CBinaryLabels*) mock_data->get_labels_train();
+		num_vectors=features->get_num_vectors();
+
+		kernel=new CGaussianKernel(features, features, 2.0);
+		SG_REF(kernel);
+	}
+
+	virtual void TearDown()
+	{
+		SG_UNREF(kernel);
+	}
+};
+
+TEST_F(KernelRowCache, get_row)
+{
+	CKernelRowCache* cache=new CKernelRowCache(kernel, 1, 4);
+
+	SGMatrix<float64_t> km=kernel->get_kernel_matrix();
+	for (index_t i=0; i<num_vectors; ++i)
+	{
+		SGVector<float64_t> row=cache->get_row(i);
+		ASSERT_EQ(row.vlen, num_vectors);
+		for (index_t j=0; j<num_vectors; ++j)
+			EXPECT_NEAR(row[j], km(i, j), 1E-6);
+	}
+
+	EXPECT_EQ(cache->get_num_misses(), num_vectors);
+	EXPECT_EQ(cache->get_num_hits(), 0);
+
+	for (index_t i=0; i<num_vectors; ++i)
+		cache->get_row(i);
+
+	EXPECT_EQ(cache->get_num_hits(), num_vectors);
+	EXPECT_EQ(cache->get_num_evictions(), 0);
+	EXPECT_EQ(cache->get_num_cached_rows(), num_vectors);
+	EXPECT_NEAR(cache->get_hit_rate(), 0.5, 1E-15);
+
+	cache->reset_statistics();
+	EXPECT_EQ(cache->get_num_hits(), 0);
+	EXPECT_EQ(cache->get_num_misses(), 0);
+
+	SG_UNREF(cache);
+}
+
+TEST_F(KernelRowCache, lru_eviction)
+{
+	CKernelRowCache* cache=new CKernelRowCache(kernel, 1, 1);
+	cache->set_max_rows(3);
+
+	cache->get_row(0);
+	cache->get_row(1);
+	cache->get_row(2);
+	// touch 0 so that 1 is the least recently used row
+	cache->get_row(0);
+	cache->get_row(3);
+
+	EXPECT_EQ(cache->get_num_evictions(), 1);
+	EXPECT_EQ(cache->get_num_cached_rows(), 3);
+	EXPECT_TRUE(cache->is_cached(0));
+	EXPECT_FALSE(cache->is_cached(1));
+	EXPECT_TRUE(cache->is_cached(2));
+	EXPECT_TRUE(cache->is_cached(3));
+
+	// an evicted row stays valid for whoever still holds it
+	SGVector<float64_t> row=cache->get_row(2);
+	cache->clear();
+	EXPECT_EQ(cache->get_num_cached_rows(), 0);
+	EXPECT_NEAR(row[2], 1.0, 1E-6);
+
+	SG_UNREF(cache);
+}
+
+TEST_F(KernelRowCache, concurrent_access)
+{
+	CKernelRowCache* cache=new CKernelRowCache(kernel, 1, 3);
+	cache->set_max_rows(16);
+
+	SGMatrix<float64_t> km=kernel->get_kernel_matrix();
+	const index_t num_requests=1000;
+	int32_t num_errors=0;
+
+	#pragma omp parallel for reduction(+:num_errors)
+	for (index_t r=0; r<num_requests; ++r)
+	{
+		index_t i=(r*7)%num_vectors;
+		SGVector<float64_t> row=cache->get_row(i);
+		for (index_t j=0; j<num_vectors; ++j)
+		{
+			if (CMath::abs(row[j]-km(i, j))>1E-6)
+				num_errors++;
+		}
+	}
+
+	EXPECT_EQ(num_errors, 0);
+	EXPECT_EQ(cache->get_num_hits()+cache->get_num_misses(), num_requests);
+	EXPECT_LE(cache->get_num_cached_rows(), 16);
+
+	SGVector<int32_t> rows(num_vectors);
+	rows.range_fill();
+	cache->clear();
+	cache->set_max_rows(num_vectors);
+	cache->prefetch_rows(rows);
+	EXPECT_EQ(cache->get_num_cached_rows(), num_vectors);
+
+	SG_UNREF(cache);
+}
+
+TEST_F(KernelRowCache, prefetch_duplicate_rows)
+{
+	CKernelRowCache* cache=new CKernelRowCache(kernel);
+	cache->set_max_rows(num_vectors);
+
+	SGVector<int32_t> rows(6);
+	rows[0]=3; rows[1]=1; rows[2]=3;
+	rows[3]=1; rows[4]=5; rows[5]=3;
+	cache->prefetch_rows(rows);
+	EXPECT_EQ(cache->get_num_cached_rows(), 3);
+	EXPECT_EQ(cache->get_num_misses(), 3);
+
+	// rows that are cached already are no misses
+	cache->prefetch_rows(rows);
+	EXPECT_EQ(cache->get_num_misses(), 3);
+
+	SG_UNREF(cache);
+}
+
+TEST_F(KernelRowCache, num_shards)
+{
+	CKernelRowCache* cache=new CKernelRowCache(kernel, 1, 3);
+	EXPECT_EQ(cache->get_num_shards(), 3);
+
+	// the automatic choice reports the number of shards actually in use
+	CKernelRowCache* auto_cache=new CKernelRowCache(kernel);
+	EXPECT_EQ(auto_cache->get_num_shards(),
+			4*CMath::max(1, auto_cache->parallel->get_num_threads()));
+
+	// never more shards than rows
+	auto_cache->set_max_rows(2);
+	EXPECT_EQ(auto_cache->get_num_shards(), 2);
+
+	SG_UNREF(auto_cache);
+	SG_UNREF(cache);
+}
+
+TEST_F(KernelRowCache, libsvm_shared_cache)
+{
+	CLibSVM* reference=new CLibSVM(1.0, kernel, labels);
+	SG_REF(reference);
+	reference->train();
+
+	CKernelRowCache* cache=new CKernelRowCache(kernel);
+	CLibSVM* svm[2];
+	for (int32_t t=0; t<2; t++)
+	{
+		svm[t]=new CLibSVM(1.0, kernel, labels);
+		SG_REF(svm[t]);
+		svm[t]->set_row_cache(cache);
+	}
+
+	#pragma omp parallel for
+	for (int32_t t=0; t<2; t++)
+		svm[t]->train();
+
+	EXPECT_GT(cache->get_num_cached_rows(), 0);
+	for (int32_t t=0; t<2; t++)
+	{
+		EXPECT_NEAR(svm[t]->get_bias(), reference->get_bias(), 1E-10);
+		SGVector<float64_t> alphas=svm[t]->get_alphas();
+		SGVector<int32_t> sv=svm[t]->get_support_vectors();
+		ASSERT_EQ(alphas.vlen, reference->get_alphas().vlen);
+		for (index_t i=0; i<alphas.vlen; i++)
+		{
+			EXPECT_NEAR(alphas[i], reference->get_alphas()[i], 1E-10);
+			EXPECT_EQ(sv[i], reference->get_support_vectors()[i]);
+		}
+	}
+
+	// all rows the solver needs are cached by now
+	cache->reset_statistics();
+	svm[0]->train();
+	EXPECT_GT(cache->get_num_hits(), 0);
+	EXPECT_EQ(cache->get_num_misses(), 0);
+
+	// rows of another kernel are rejected
+	CGaussianKernel* other=new CGaussianKernel(features, features, 1.0);
+	CKernelRowCache* other_cache=new CKernelRowCache(other);
+	svm[1]->set_row_cache(other_cache);
+	EXPECT_THROW(svm[1]->train(), ShogunException);
+
+	SG_UNREF(other_cache);
+	SG_UNREF(cache);
+	SG_UNREF(svm[0]);
+	SG_UNREF(svm[1]);
+	SG_UNREF(reference);
+}
+
+TEST_F(KernelRowCache, single_precision)
+{
+	CKernelRowCache* cache=new CKernelRowCache(kernel, 1, 2, PT_FLOAT32);
+	int64_t max_rows_single=cache->get_max_rows();
+
+	SGMatrix<float64_t> km=kernel->get_kernel_matrix();
+	for (index_t i=0; i<num_vectors; ++i)
+	{
+		SGVector<float32_t> row=cache->get_row<float32_t>(i);
+		ASSERT_EQ(row.vlen, num_vectors);
+		for (index_t j=0; j<num_vectors; ++j)
+			EXPECT_NEAR(row[j], km(i, j), 1E-6);
+	}
+	EXPECT_THROW(cache->get_row<float64_t>(0), ShogunException);
+
+	// double precision rows take twice the memory
+	cache->set_precision(PT_FLOAT64);
+	EXPECT_EQ(cache->get_num_cached_rows(), 0);
+	EXPECT_EQ(cache->get_max_rows(), max_rows_single/2);
+	EXPECT_NEAR(cache->get_row(3)[4], km(3, 4), 1E-15);
+
+	SG_UNREF(cache);
+}
+
+TEST_F(KernelRowCache, libsvm_single_precision)
+{
+	CLibSVM* reference=new CLibSVM(1.0, kernel, labels);
+	SG_REF(reference);
+	reference->train();
+
+	CKernelRowCache* cache=new CKernelRowCache(kernel, 1, 0, PT_FLOAT32);
+	CLibSVM* svm=new CLibSVM(1.0, kernel, labels);
+	SG_REF(svm);
+	svm->set_row_cache(cache);
+	svm->train();
+
+	EXPECT_GT(cache->get_num_cached_rows(), 0);
+	// rounding the rows to single precision barely moves the solution
+	CBinaryLabels* output=svm->apply_binary(features);
+	CBinaryLabels* expected=reference->apply_binary(features);
+	SG_REF(output);
+	SG_REF(expected);
+	ASSERT_EQ(output->get_num_labels(), expected->get_num_labels());
+	for (index_t i=0; i<output->get_num_labels(); i++)
+		EXPECT_NEAR(output->get_value(i), expected->get_value(i), 1E-4);
+
+	SG_UNREF(expected);
+	SG_UNREF(output);
+	SG_UNREF(svm);
+	SG_UNREF(reference);
+}
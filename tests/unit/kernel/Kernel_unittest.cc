@@ -34,6 +34,9 @@
 #include <shogun/lib/SGMatrix.h>
 #include <shogun/features/DenseFeatures.h>
 #include <shogun/kernel/GaussianKernel.h>
+#include <shogun/kernel/LinearKernel.h>
+#include <shogun/kernel/PolyKernel.h>
+#include <shogun/kernel/SigmoidKernel.h>
 
 using namespace shogun;
 
@@ -406,9 +409,166 @@ TEST(Kernel, gaussian_get_kernel_matrix)
 	// initialize a Gaussian kernel of width 1
 	CGaussianKernel* kernel=new CGaussianKernel(feats_p, feats_q, 2);
 	SGMatrix<float64_t> km=kernel->get_kernel_matrix();
+	// the matrix is computed blockwise via matrix products, which round
+	// differently than the elementwise dot products
 	for (index_t i=0; i<km.num_rows; i++)
 		for (index_t j=0; j<km.num_cols; ++j)
-			EXPECT_NEAR(kernel->kernel(i,j), km(i, j), 1E-15);
+			EXPECT_NEAR(kernel->kernel(i,j), km(i, j), 1E-13);
 
 	SG_UNREF(kernel);
 }
+
+static void check_blocked_kernel_matrix(CKernel* kernel, float64_t eps=1E-10)
+{
+	SGMatrix<float64_t> km=kernel->get_kernel_matrix();
+	ASSERT_EQ(km.num_rows, kernel->get_num_vec_lhs());
+	ASSERT_EQ(km.num_cols, kernel->get_num_vec_rhs());
+
+	for (index_t j=0; j<km.num_cols; ++j)
+		for (index_t i=0; i<km.num_rows; ++i)
+			EXPECT_NEAR(kernel->kernel(i, j), km(i, j), eps);
+}
+
+TEST(Kernel, get_kernel_matrix_blocked)
+{
+	// sizes that are not multiples of the block size
+	const index_t num_feats_p=300;
+	const index_t num_feats_q=270;
+	const index_t dim=5;
+
+	CMath::init_random(17);
+	SGMatrix<float64_t> data_p=generate_std_norm_matrix(num_feats_p, dim);
+	SGMatrix<float64_t> data_q=generate_std_norm_matrix(num_feats_q, dim);
+	CDenseFeatures<float64_t>* feats_p=new CDenseFeatures<float64_t>(data_p);
+	CDenseFeatures<float64_t>* feats_q=new CDenseFeatures<float64_t>(data_q);
+	SG_REF(feats_p);
+	SG_REF(feats_q);
+
+	CKernel* kernels[]={
+		new CGaussianKernel(10, 3.0),
+		new CLinearKernel(),
+		new CPolyKernel(10, 3, true),
+		new CSigmoidKernel(10, 0.1, 0.5)
+	};
+
+	for (auto kernel : kernels)
+	{
+		SG_REF(kernel);
+
+		kernel->init(feats_p, feats_q);
+		check_blocked_kernel_matrix(kernel);
+
+		kernel->init(feats_p, feats_p);
+		check_blocked_kernel_matrix(kernel);
+
+		// subsets are resolved when gathering the vectors of a block
+		SGVector<index_t> subset(num_feats_p/2);
+		for (index_t i=0; i<subset.vlen; ++i)
+			subset[i]=2*i+1;
+		feats_p->add_subset(subset);
+		kernel->init(feats_p, feats_q);
+		check_blocked_kernel_matrix(kernel);
+		feats_p->remove_subset();
+
+		SG_UNREF(kernel);
+	}
+
+	SG_UNREF(feats_p);
+	SG_UNREF(feats_q);
+}
+
+TEST(Kernel, get_kernel_matrix_blocked_single_precision)
+{
+	const index_t num_feats_p=300;
+	const index_t num_feats_q=270;
+	const index_t dim=5;
+
+	CMath::init_random(17);
+	SGMatrix<float64_t> data_p=generate_std_norm_matrix(num_feats_p, dim);
+	SGMatrix<float64_t> data_q=generate_std_norm_matrix(num_feats_q, dim);
+	CDenseFeatures<float64_t>* dfeats_p=new CDenseFeatures<float64_t>(data_p);
+	CDenseFeatures<float64_t>* dfeats_q=new CDenseFeatures<float64_t>(data_q);
+	CDenseFeatures<float32_t>* feats_p=new CDenseFeatures<float32_t>(dfeats_p);
+	CDenseFeatures<float32_t>* feats_q=new CDenseFeatures<float32_t>(dfeats_q);
+	SG_REF(feats_p);
+	SG_REF(feats_q);
+	SG_UNREF(dfeats_p);
+	SG_UNREF(dfeats_q);
+
+	CKernel* kernels[]={
+		new CGaussianKernel(10, 3.0),
+		new CLinearKernel()
+	};
+
+	// products of float32_t features are computed in single precision
+	for (auto kernel : kernels)
+	{
+		SG_REF(kernel);
+
+		kernel->init(feats_p, feats_q);
+		check_blocked_kernel_matrix(kernel, 1E-4);
+
+		kernel->init(feats_p, feats_p);
+		check_blocked_kernel_matrix(kernel, 1E-4);
+
+		SG_UNREF(kernel);
+	}
+
+	SG_UNREF(feats_p);
+	SG_UNREF(feats_q);
+}
+
+TEST(Kernel, compute_expansion)
+{
+	// more expansion vectors than a block holds and than dimensions
+	const index_t num_feats_p=600;
+	const index_t num_feats_q=270;
+	const index_t dim=5;
+
+	CMath::init_random(19);
+	SGMatrix<float64_t> data_p=generate_std_norm_matrix(num_feats_p, dim);
+	SGMatrix<float64_t> data_q=generate_std_norm_matrix(num_feats_q, dim);
+	CDenseFeatures<float64_t>* feats_p=new CDenseFeatures<float64_t>(data_p);
+	CDenseFeatures<float64_t>* feats_q=new CDenseFeatures<float64_t>(data_q);
+	SG_REF(feats_p);
+	SG_REF(feats_q);
+
+	SGVector<index_t> idx(num_feats_p/2);
+	SGVector<float64_t> weights(idx.vlen);
+	for (index_t i=0; i<idx.vlen; ++i)
+	{
+		idx[i]=2*i+(i%3 ? 1 : 0);
+		weights[i]=CMath::randn_double();
+	}
+
+	// linear and polynomial kernels of degree one and two are collapsed
+	CKernel* kernels[]={
+		new CGaussianKernel(10, 3.0),
+		new CLinearKernel(),
+		new CPolyKernel(10, 1, true),
+		new CPolyKernel(10, 2, true),
+		new CPolyKernel(10, 3, true),
+		new CSigmoidKernel(10, 0.1, 0.5)
+	};
+
+	for (auto kernel : kernels)
+	{
+		SG_REF(kernel);
+		kernel->init(feats_p, feats_q);
+
+		SGVector<float64_t> outputs=kernel->compute_expansion(idx, weights);
+		ASSERT_EQ(outputs.vlen, num_feats_q);
+		for (index_t j=0; j<num_feats_q; ++j)
+		{
+			float64_t expected=0;
+			for (index_t i=0; i<idx.vlen; ++i)
+				expected+=weights[i]*kernel->kernel(idx[i], j);
+			EXPECT_NEAR(outputs[j], expected, 1E-9);
+		}
+
+		SG_UNREF(kernel);
+	}
+
+	SG_UNREF(feats_p);
+	SG_UNREF(feats_q);
+}
@@ -0,0 +1,148 @@
+/*
+ * This software is distributed under BSD 3-clause license (see LICENSE file).
+ */
+
+#include <gtest/gtest.h>
+
+#include <shogun/base/Parallel.h>
+#include <shogun/base/SGObject.h>
+#include <shogun/base/init.h>
+#include <shogun/lib/ThreadPool.h>
+#include <shogun/lib/exception/ShogunException.h>
+#include <shogun/io/SGIO.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace shogun;
+
+TEST(ThreadPool, parallel_for)
+{
+	ThreadPool pool(4);
+	std::vector<int32_t> visited(1000, 0);
+
+	pool.parallel_for(0, visited.size(), [&](int64_t begin, int64_t end) {
+		for (int64_t i = begin; i < end; ++i)
+			visited[i]++;
+	});
+
+	for (auto v : visited)
+		EXPECT_EQ(v, 1);
+
+	// empty and single chunk ranges
+	pool.parallel_for(5, 5, [&](int64_t, int64_t) { FAIL(); });
+	int64_t num_calls = 0;
+	pool.parallel_for(
+	    0, 10, [&](int64_t, int64_t) { num_calls++; }, 100);
+	EXPECT_EQ(num_calls, 1);
+}
+
+TEST(ThreadPool, nested_parallel_for)
+{
+	ThreadPool pool(4);
+	std::atomic<int64_t> sum(0);
+
+	pool.parallel_for(0, 50, [&](int64_t begin, int64_t end) {
+		for (int64_t i = begin; i < end; ++i)
+		{
+			pool.parallel_for(0, 100, [&](int64_t b, int64_t e) {
+				int64_t local = 0;
+				for (int64_t j = b; j < e; ++j)
+					local += j;
+				sum += local;
+			});
+		}
+	});
+
+	EXPECT_EQ(sum.load(), 50 * 4950);
+}
+
+TEST(ThreadPool, task_group)
+{
+	ThreadPool pool(3);
+	ThreadPool::TaskGroup group(&pool);
+	std::atomic<int32_t> count(0);
+
+	for (int32_t i = 0; i < 100; ++i)
+		group.run([&]() { count++; });
+	group.wait();
+
+	EXPECT_EQ(count.load(), 100);
+}
+
+TEST(ThreadPool, exceptions_are_rethrown)
+{
+	ThreadPool pool(4);
+
+	EXPECT_THROW(
+	    pool.parallel_for(
+	        0, 100,
+	        [&](int64_t begin, int64_t) {
+		        if (begin >= 50)
+			        SG_SERROR("failed chunk\n");
+	        },
+	        10),
+	    ShogunException);
+
+	// the pool is still usable afterwards
+	std::atomic<int32_t> count(0);
+	pool.parallel_for(0, 10, [&](int64_t begin, int64_t end) {
+		count += end - begin;
+	});
+	EXPECT_EQ(count.load(), 10);
+}
+
+TEST(ThreadPool, parallel_follows_num_threads)
+{
+	Parallel* parallel = get_global_parallel();
+	int32_t orig_num_threads = parallel->get_num_threads();
+
+	parallel->set_num_threads(3);
+	EXPECT_EQ(parallel->get_thread_pool()->get_num_threads(), 3);
+
+	std::atomic<int32_t> count(0);
+	parallel->parallel_for(0, 100, [&](int64_t begin, int64_t end) {
+		count += end - begin;
+	});
+	EXPECT_EQ(count.load(), 100);
+
+	parallel->set_num_threads(orig_num_threads);
+	EXPECT_EQ(
+	    parallel->get_thread_pool()->get_num_threads(), orig_num_threads);
+	SG_UNREF(parallel);
+}
+
+TEST(ThreadPool, set_num_threads_while_running)
+{
+	Parallel* parallel = get_global_parallel();
+	int32_t orig_num_threads = parallel->get_num_threads();
+	parallel->set_num_threads(4);
+
+	// the pool used by the running loop is replaced but stays alive
+	std::atomic<int32_t> count(0);
+	std::atomic<bool> started(false);
+	std::thread runner([&]() {
+		parallel->parallel_for(0, 40, [&](int64_t begin, int64_t end) {
+			started = true;
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+			count += end - begin;
+		}, 1);
+	});
+	while (!started)
+		std::this_thread::yield();
+	parallel->set_num_threads(2);
+	EXPECT_EQ(parallel->get_thread_pool()->get_num_threads(), 2);
+	runner.join();
+	EXPECT_EQ(count.load(), 40);
+
+	// changing the number of threads from a task applies to later loops
+	parallel->parallel_for(0, 4, [&](int64_t begin, int64_t end) {
+		if (begin == 0)
+			parallel->set_num_threads(3);
+	}, 1);
+	EXPECT_EQ(parallel->get_thread_pool()->get_num_threads(), 3);
+
+	parallel->set_num_threads(orig_num_threads);
+	SG_UNREF(parallel);
+}
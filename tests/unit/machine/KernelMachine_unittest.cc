@@ -0,0 +1,197 @@
+/*
+ * This software is distributed under BSD 3-clause license (see LICENSE file).
+ */
+
+#include <gtest/gtest.h>
+
+#include <shogun/classifier/svm/LibSVM.h>
+#include <shogun/features/DenseFeatures.h>
+#include <shogun/kernel/CustomKernel.h>
+#include <shogun/kernel/GaussianKernel.h>
+#include <shogun/kernel/LinearKernel.h>
+#include <shogun/labels/BinaryLabels.h>
+#include <shogun/mathematics/Math.h>
+
+using namespace shogun;
+
+static CDenseFeatures<float64_t>* overlapping_data(int32_t num, SGVector<float64_t>& lab)
+{
+	SGMatrix<float64_t> data(2, num);
+	lab=SGVector<float64_t>(num);
+	for (index_t i=0; i<num; i++)
+	{
+		lab[i]=i%2 ? 1 : -1;
+		data(0, i)=0.5*lab[i]+CMath::randn_double();
+		data(1, i)=CMath::randn_double();
+	}
+	return new CDenseFeatures<float64_t>(data);
+}
+
+TEST(KernelMachine, reduce_support_vectors)
+{
+	CMath::init_random(29);
+	SGVector<float64_t> train_lab;
+	SGVector<float64_t> test_lab;
+	CDenseFeatures<float64_t>* train=overlapping_data(400, train_lab);
+	CDenseFeatures<float64_t>* test=overlapping_data(200, test_lab);
+	SG_REF(train);
+	SG_REF(test);
+
+	CGaussianKernel* kernel=new CGaussianKernel(10, 2.0);
+	CLibSVM* svm=new CLibSVM(1.0, kernel, new CBinaryLabels(train_lab));
+	SG_REF(svm);
+	svm->train(train);
+	int32_t num_sv=svm->get_num_support_vectors();
+	ASSERT_GT(num_sv, 100);
+
+	// ||w||^2=sum_i alpha_i f(x_i) without bias
+	CBinaryLabels* train_out=svm->apply_binary(train);
+	SG_REF(train_out);
+	float64_t norm2=0;
+	for (index_t i=0; i<num_sv; i++)
+	{
+		norm2+=svm->get_alpha(i)*
+			(train_out->get_value(svm->get_support_vector(i))-svm->get_bias());
+	}
+	SG_UNREF(train_out);
+	CKernelMachine* original=new CKernelMachine(svm);
+	SG_REF(original);
+
+	CBinaryLabels* before=svm->apply_binary(test);
+	SG_REF(before);
+	EXPECT_EQ(svm->reduce_support_vectors(num_sv), 0);
+	EXPECT_EQ(svm->get_num_support_vectors(), num_sv);
+
+	float64_t error=svm->reduce_support_vectors(40);
+	EXPECT_EQ(svm->get_num_support_vectors(), 40);
+	EXPECT_GT(error, 0);
+	EXPECT_LT(error, 0.1);
+
+	// outputs of a Gaussian kernel machine change by at most ||w-w'||
+	CBinaryLabels* after=svm->apply_binary(test);
+	SG_REF(after);
+	for (index_t j=0; j<test_lab.vlen; j++)
+	{
+		EXPECT_LE(CMath::abs(after->get_value(j)-before->get_value(j)),
+				error*std::sqrt(norm2)+1E-8);
+	}
+
+	// the first vectors selected are the same, fewer approximate worse
+	EXPECT_GT(original->reduce_support_vectors(10), error);
+	EXPECT_EQ(original->get_num_support_vectors(), 10);
+
+	SG_UNREF(original);
+	SG_UNREF(after);
+	SG_UNREF(before);
+	SG_UNREF(svm);
+	SG_UNREF(test);
+	SG_UNREF(train);
+}
+
+TEST(KernelMachine, reduce_support_vectors_rebuilds_linadd)
+{
+	CMath::init_random(31);
+	SGVector<float64_t> train_lab;
+	SGVector<float64_t> test_lab;
+	CDenseFeatures<float64_t>* train=overlapping_data(200, train_lab);
+	CDenseFeatures<float64_t>* test=overlapping_data(100, test_lab);
+	SG_REF(train);
+	SG_REF(test);
+
+	CLinearKernel* kernel=new CLinearKernel();
+	CLibSVM* svm=new CLibSVM(1.0, kernel, new CBinaryLabels(train_lab));
+	SG_REF(svm);
+	svm->train(train);
+	svm->init_kernel_optimization();
+	ASSERT_TRUE(kernel->get_is_initialized());
+
+	// a single vector cannot represent w, the outputs change
+	EXPECT_GT(svm->reduce_support_vectors(1), 0);
+	EXPECT_TRUE(kernel->get_is_initialized());
+	CBinaryLabels* optimized=svm->apply_binary(test);
+	SG_REF(optimized);
+
+	kernel->delete_optimization();
+	CBinaryLabels* plain=svm->apply_binary(test);
+	SG_REF(plain);
+	for (index_t j=0; j<test_lab.vlen; j++)
+		EXPECT_NEAR(optimized->get_value(j), plain->get_value(j), 1E-8);
+
+	SG_UNREF(plain);
+	SG_UNREF(optimized);
+	SG_UNREF(svm);
+	SG_UNREF(test);
+	SG_UNREF(train);
+}
+
+TEST(KernelMachine, reduce_support_vectors_custom_kernel)
+{
+	CMath::init_random(37);
+	SGVector<float64_t> train_lab;
+	CDenseFeatures<float64_t>* train=overlapping_data(200, train_lab);
+	SG_REF(train);
+
+	CGaussianKernel* gaussian=new CGaussianKernel(train, train, 2.0);
+	SG_REF(gaussian);
+	CCustomKernel* kernel=new CCustomKernel(gaussian->get_kernel_matrix());
+	CLibSVM* svm=new CLibSVM(1.0, kernel, new CBinaryLabels(train_lab));
+	SG_REF(svm);
+	svm->train();
+	ASSERT_GT(svm->get_num_support_vectors(), 20);
+
+	float64_t error=svm->reduce_support_vectors(20);
+	EXPECT_EQ(svm->get_num_support_vectors(), 20);
+	EXPECT_GT(error, 0);
+	EXPECT_LT(error, 1);
+
+	// the kernel between the support vectors needs the training matrix
+	SGMatrix<float64_t> rectangular(200, 10);
+	rectangular.zero();
+	kernel->set_full_kernel_matrix_from_full(rectangular);
+	EXPECT_ANY_THROW(svm->reduce_support_vectors(10));
+
+	SG_UNREF(svm);
+	SG_UNREF(gaussian);
+	SG_UNREF(train);
+}
+
+TEST(KernelMachine, apply_cancelled_expansion)
+{
+	CMath::init_random(31);
+	SGVector<float64_t> train_lab;
+	SGVector<float64_t> test_lab;
+	CDenseFeatures<float64_t>* train=overlapping_data(200, train_lab);
+	CDenseFeatures<float64_t>* test=overlapping_data(1000, test_lab);
+	SG_REF(train);
+	SG_REF(test);
+
+	CGaussianKernel* kernel=new CGaussianKernel(10, 2.0);
+	CLibSVM* svm=new CLibSVM(1.0, kernel, new CBinaryLabels(train_lab));
+	SG_REF(svm);
+	svm->train(train);
+	svm->set_batch_computation_enabled(false);
+
+	// a cancelled machine leaves the outputs of all tiles at the bias
+	svm->set_callback([]() { return true; });
+	CBinaryLabels* cancelled=svm->apply_binary(test);
+	SG_REF(cancelled);
+	for (index_t j=0; j<test_lab.vlen; j++)
+		EXPECT_EQ(cancelled->get_value(j), svm->get_bias());
+
+	svm->set_callback(nullptr);
+	CBinaryLabels* outputs=svm->apply_binary(test);
+	SG_REF(outputs);
+	int32_t num_at_bias=0;
+	for (index_t j=0; j<test_lab.vlen; j++)
+	{
+		if (outputs->get_value(j)==svm->get_bias())
+			num_at_bias++;
+	}
+	EXPECT_EQ(num_at_bias, 0);
+
+	SG_UNREF(outputs);
+	SG_UNREF(cancelled);
+	SG_UNREF(svm);
+	SG_UNREF(test);
+	SG_UNREF(train);
+}
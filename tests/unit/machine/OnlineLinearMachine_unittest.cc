@@ -0,0 +1,116 @@
+/*
+ * This software is distributed under BSD 3-clause license (see LICENSE file).
+ */
+
+#include <gtest/gtest.h>
+
+#include <shogun/base/Parallel.h>
+#include <shogun/classifier/svm/OnlineLibLinear.h>
+#include <shogun/classifier/svm/OnlineSVMSGD.h>
+#include <shogun/features/DenseFeatures.h>
+#include <shogun/features/streaming/StreamingDenseFeatures.h>
+#include <shogun/labels/BinaryLabels.h>
+#include <shogun/mathematics/Math.h>
+
+using namespace shogun;
+
+class OnlineLinearMachine : public ::testing::Test
+{
+public:
+	virtual void SetUp()
+	{
+		CMath::init_random(13);
+		int32_t dim=20;
+		int32_t num=4000;
+		SGMatrix<float32_t> data(dim, num);
+		labels=SGVector<float64_t>(num);
+		for (index_t i=0; i<num; i++)
+		{
+			labels[i]=i%2 ? 1 : -1;
+			for (index_t j=0; j<dim; j++)
+			{
+				// a few informative features among sparse noise
+				float32_t value=CMath::random(0, 4) ? 0 : CMath::randn_float();
+				if (j<3)
+					value+=labels[i];
+				data(j, i)=value;
+			}
+		}
+		dense=new CDenseFeatures<float32_t>(data);
+		SG_REF(dense);
+	}
+
+	virtual void TearDown()
+	{
+		SG_UNREF(dense);
+	}
+
+	/** train a machine on the data and return its training accuracy */
+	float64_t accuracy(COnlineLinearMachine* machine)
+	{
+		CStreamingDenseFeatures<float32_t>* train_stream=
+			new CStreamingDenseFeatures<float32_t>(dense, labels.vector);
+		machine->train(train_stream);
+
+		CStreamingDenseFeatures<float32_t>* test_stream=
+			new CStreamingDenseFeatures<float32_t>(dense, labels.vector);
+		CBinaryLabels* predicted=machine->apply_binary(test_stream);
+		EXPECT_EQ(predicted->get_num_labels(), labels.vlen);
+
+		int32_t correct=0;
+		for (index_t i=0; i<labels.vlen; i++)
+			correct+=predicted->get_label(i)==labels[i];
+
+		SG_UNREF(predicted);
+		return float64_t(correct)/labels.vlen;
+	}
+
+	CDenseFeatures<float32_t>* dense;
+	SGVector<float64_t> labels;
+};
+
+TEST_F(OnlineLinearMachine, svmsgd_learners)
+{
+	bool average[]={false, true};
+	for (auto average_learners: average)
+	{
+		COnlineSVMSGD* svm=new COnlineSVMSGD(1.0);
+		SG_REF(svm);
+		svm->set_num_learners(4);
+		svm->set_average_learners(average_learners);
+		EXPECT_GT(accuracy(svm), 0.95);
+		SG_UNREF(svm);
+	}
+}
+
+TEST_F(OnlineLinearMachine, liblinear_learners)
+{
+	bool average[]={false, true};
+	for (auto average_learners: average)
+	{
+		COnlineLibLinear* svm=new COnlineLibLinear(1.0);
+		SG_REF(svm);
+		svm->set_num_learners(4);
+		svm->set_average_learners(average_learners);
+		EXPECT_GT(accuracy(svm), 0.95);
+		SG_UNREF(svm);
+	}
+}
+
+TEST_F(OnlineLinearMachine, learners_on_single_thread)
+{
+	// without workers the pool runs all learners in a single call
+	bool average[]={false, true};
+	for (auto average_learners: average)
+	{
+		COnlineSVMSGD* svm=new COnlineSVMSGD(1.0);
+		SG_REF(svm);
+		int32_t old_num_threads=svm->parallel->get_num_threads();
+		svm->parallel->set_num_threads(1);
+		svm->set_num_learners(4);
+		svm->set_average_learners(average_learners);
+		EXPECT_GT(accuracy(svm), 0.95);
+		svm->parallel->set_num_threads(old_num_threads);
+		SG_UNREF(svm);
+	}
+}
@@ -170,3 +170,47 @@ TEST_F(StochasticGBMachine, sinusoid_curve_fitting_subset_fraction)
 	EXPECT_NEAR(ret[8], -0.4258681695, epsilon);
 	EXPECT_NEAR(ret[9], 0.5964289106, epsilon);
 }
+
+TEST_F(StochasticGBMachine, sinusoid_curve_fitting_second_order)
+{
+	SGVector<bool> ft(1);
+	ft[0] = false;
+	CCARTree* tree = new CCARTree(ft);
+	tree->set_max_depth(2);
+	tree->set_num_bins(32);
+	CSquaredLoss* sq = new CSquaredLoss();
+
+	auto sgbm = some<CStochasticGBMachine>(tree, sq, 100, 0.1, 1.0);
+	sgbm->set_second_order(true);
+	sgbm->set_labels(train_labels);
+	sgbm->train(train_feats);
+	EXPECT_EQ(sgbm->get_num_learners(), 100);
+
+	auto ret_labels = wrap(sgbm->apply_regression(test_feats));
+	auto mse = some<CMeanSquaredError>();
+	EXPECT_LT(mse->evaluate(ret_labels, test_labels), 0.1);
+}
+
+TEST_F(StochasticGBMachine, early_stopping)
+{
+	SGVector<bool> ft(1);
+	ft[0] = false;
+	CCARTree* tree = new CCARTree(ft);
+	tree->set_max_depth(2);
+	CSquaredLoss* sq = new CSquaredLoss();
+
+	auto sgbm = some<CStochasticGBMachine>(tree, sq, 500, 0.5, 1.0);
+	sgbm->set_validation_data(test_feats, test_labels);
+	sgbm->set_early_stopping_rounds(5);
+	sgbm->set_labels(train_labels);
+	sgbm->train(train_feats);
+
+	int32_t num_learners = sgbm->get_num_learners();
+	EXPECT_GT(num_learners, 0);
+	EXPECT_LT(num_learners, 500);
+
+	// the kept model is the best one seen on the validation data
+	auto ret_labels = wrap(sgbm->apply_regression(test_feats));
+	auto mse = some<CMeanSquaredError>();
+	EXPECT_LT(mse->evaluate(ret_labels, test_labels), 0.1);
+}
@@ -36,6 +36,7 @@
 #include <shogun/labels/RegressionLabels.h>
 #include <shogun/features/DenseFeatures.h>
 #include <shogun/kernel/GaussianKernel.h>
+#include <shogun/kernel/LinearKernel.h>
 #include <shogun/machine/gp/ExactInferenceMethod.h>
 #include <shogun/machine/gp/ZeroMean.h>
 #include <shogun/machine/gp/GaussianLikelihood.h>
@@ -489,3 +490,147 @@ TEST(ExactInferenceMethod,get_posterior_mean2)
 	// clean up
 	SG_UNREF(inf);
 }
+
+TEST(ExactInferenceMethod,width_derivative_after_width_change)
+{
+	CMath::init_random(11);
+	index_t n=50;
+	SGMatrix<float64_t> X(2, n);
+	SGVector<float64_t> Y(n);
+	for (index_t i=0; i<n; i++)
+	{
+		X(0, i)=CMath::randn_double();
+		X(1, i)=CMath::randn_double();
+		Y[i]=std::sin(X(0, i))+0.1*CMath::randn_double();
+	}
+
+	CDenseFeatures<float64_t>* features=new CDenseFeatures<float64_t>(X);
+	CRegressionLabels* labels=new CRegressionLabels(Y);
+	CGaussianKernel* kernel=new CGaussianKernel(10, 2.0);
+	CExactInferenceMethod* inf=new CExactInferenceMethod(kernel, features,
+			new CZeroMean(), labels, new CGaussianLikelihood(0.5));
+	SG_REF(inf);
+
+	// squared distances computed for the first width are reused afterwards
+	inf->get_negative_log_marginal_likelihood();
+	kernel->set_width(0.5);
+
+	CExactInferenceMethod* reference=new CExactInferenceMethod(
+			new CGaussianKernel(10, 0.5), features, new CZeroMean(), labels,
+			new CGaussianLikelihood(0.5));
+	SG_REF(reference);
+	EXPECT_NEAR(inf->get_negative_log_marginal_likelihood(),
+			reference->get_negative_log_marginal_likelihood(), 1E-10);
+
+	CMap<TParameter*, CSGObject*>* parameter_dictionary=new CMap<TParameter*, CSGObject*>();
+	inf->build_gradient_parameter_dictionary(parameter_dictionary);
+	CMap<TParameter*, SGVector<float64_t> >* gradient=
+		inf->get_negative_log_marginal_likelihood_derivatives(parameter_dictionary);
+	TParameter* width_param=kernel->m_gradient_parameters->get_parameter("log_width");
+	float64_t dnlZ_ell=(gradient->get_element(width_param))[0];
+
+	// central differences wrt log_width, where width=2*exp(2*log_width)
+	float64_t log_width=std::log(0.5/2.0)/2.0;
+	float64_t h=1E-5;
+	kernel->set_width(2.0*std::exp(2.0*(log_width+h)));
+	float64_t nlZ_plus=inf->get_negative_log_marginal_likelihood();
+	kernel->set_width(2.0*std::exp(2.0*(log_width-h)));
+	float64_t nlZ_minus=inf->get_negative_log_marginal_likelihood();
+	EXPECT_NEAR(dnlZ_ell, (nlZ_plus-nlZ_minus)/(2*h), 1E-5);
+
+	SG_UNREF(gradient);
+	SG_UNREF(parameter_dictionary);
+	SG_UNREF(reference);
+	SG_UNREF(inf);
+}
+
+TEST(ExactInferenceMethod,append_observations)
+{
+	// more observations than fit in one block of the Cholesky factorization
+	CMath::init_random(17);
+	index_t n=300;
+	index_t n_first=200;
+	SGMatrix<float64_t> X(3, n);
+	SGVector<float64_t> Y(n);
+	for (index_t i=0; i<n; i++)
+	{
+		for (index_t j=0; j<X.num_rows; j++)
+			X(j, i)=CMath::randn_double();
+		Y[i]=std::sin(X(0, i))+0.1*CMath::randn_double();
+	}
+
+	SGMatrix<float64_t> X_first(3, n_first);
+	SGMatrix<float64_t> X_new(3, n-n_first);
+	SGVector<float64_t> Y_first(n_first);
+	SGVector<float64_t> Y_new(n-n_first);
+	for (index_t i=0; i<n; i++)
+	{
+		for (index_t j=0; j<X.num_rows; j++)
+		{
+			if (i<n_first)
+				X_first(j, i)=X(j, i);
+			else
+				X_new(j, i-n_first)=X(j, i);
+		}
+		if (i<n_first)
+			Y_first[i]=Y[i];
+		else
+			Y_new[i-n_first]=Y[i];
+	}
+
+	// the Gaussian kernel is computed from squared distances, the linear not
+	for (index_t k=0; k<2; k++)
+	{
+		CKernel* kernel=k ? (CKernel*) new CLinearKernel() :
+			(CKernel*) new CGaussianKernel(10, 2.0);
+		CKernel* reference_kernel=k ? (CKernel*) new CLinearKernel() :
+			(CKernel*) new CGaussianKernel(10, 2.0);
+
+		CExactInferenceMethod* inf=new CExactInferenceMethod(kernel,
+				new CDenseFeatures<float64_t>(X_first), new CZeroMean(),
+				new CRegressionLabels(Y_first), new CGaussianLikelihood(0.5));
+		SG_REF(inf);
+
+		// the factor is up to date and is extended by the new observations
+		inf->get_cholesky();
+		inf->append_observations(new CDenseFeatures<float64_t>(X_new),
+				new CRegressionLabels(Y_new));
+		SGMatrix<float64_t> L=inf->get_cholesky();
+		SGVector<float64_t> alpha=inf->get_alpha();
+		float64_t nlZ=inf->get_negative_log_marginal_likelihood();
+
+		CExactInferenceMethod* reference=new CExactInferenceMethod(
+				reference_kernel, new CDenseFeatures<float64_t>(X),
+				new CZeroMean(), new CRegressionLabels(Y),
+				new CGaussianLikelihood(0.5));
+		SG_REF(reference);
+		SGMatrix<float64_t> L_ref=reference->get_cholesky();
+		SGVector<float64_t> alpha_ref=reference->get_alpha();
+
+		ASSERT_EQ(L.num_rows, n);
+		ASSERT_EQ(alpha.vlen, n);
+		for (index_t i=0; i<n; i++)
+		{
+			for (index_t j=0; j<n; j++)
+				EXPECT_NEAR(L(i, j), L_ref(i, j), 1E-10);
+			EXPECT_NEAR(alpha[i], alpha_ref[i], 1E-8);
+		}
+		EXPECT_NEAR(nlZ, reference->get_negative_log_marginal_likelihood(), 1E-8);
+
+		// blocked factorization: L'*L=K*scale/sigma^2+I
+		SGMatrix<float64_t> K=reference_kernel->get_kernel_matrix();
+		for (index_t i=0; i<n; i++)
+		{
+			for (index_t j=0; j<n; j++)
+			{
+				float64_t sum=0;
+				for (index_t l=0; l<=CMath::min(i, j); l++)
+					sum+=L_ref(l, i)*L_ref(l, j);
+				EXPECT_NEAR(sum, K(i, j)/0.25+(i==j), 1E-10);
+			}
+		}
+
+		SG_UNREF(reference);
+		SG_UNREF(inf);
+	}
+}
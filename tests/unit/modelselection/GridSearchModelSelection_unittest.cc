@@ -0,0 +1,194 @@
+/*
+ * This software is distributed under BSD 3-clause license (see LICENSE file).
+ */
+
+#include <gtest/gtest.h>
+
+#include <shogun/classifier/svm/LibSVM.h>
+#include <shogun/evaluation/ContingencyTableEvaluation.h>
+#include <shogun/evaluation/CrossValidation.h>
+#include <shogun/evaluation/TimeSeriesSplitting.h>
+#include <shogun/features/DenseFeatures.h>
+#include <shogun/kernel/GaussianKernel.h>
+#include <shogun/labels/BinaryLabels.h>
+#include <shogun/modelselection/GridSearchModelSelection.h>
+#include <shogun/modelselection/ModelSelectionParameters.h>
+#include <shogun/modelselection/ParameterCombination.h>
+
+#include <cmath>
+#include <map>
+
+using namespace shogun;
+
+/** cross-validation which counts its evaluations by number of folds */
+class CountingCrossValidation : public CCrossValidation
+{
+public:
+	CountingCrossValidation(CMachine* machine, CFeatures* features,
+			CLabels* labels, CSplittingStrategy* splitting_strategy,
+			CEvaluation* evaluation_criterion)
+		: CCrossValidation(machine, features, labels, splitting_strategy,
+				evaluation_criterion)
+	{
+	}
+
+	/** number of evaluations on each number of folds */
+	std::map<index_t, int32_t> num_evaluations;
+
+protected:
+	virtual CEvaluationResult* evaluate_impl()
+	{
+		num_evaluations[get_num_evaluated_folds()]++;
+		return CCrossValidation::evaluate_impl();
+	}
+};
+
+class GridSearchModelSelectionTest : public ::testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		index_t num_vectors=60;
+		SGMatrix<float64_t> data(2, num_vectors);
+		SGVector<float64_t> labels(num_vectors);
+
+		// two interleaved, noisy classes, no random numbers needed
+		for (index_t i=0; i<num_vectors; i++)
+		{
+			labels[i]=i%2 ? 1 : -1;
+			data(0, i)=labels[i]+std::sin(1.7*i);
+			data(1, i)=labels[i]*0.5+std::cos(2.3*i);
+		}
+
+		auto features=new CDenseFeatures<float64_t>(data);
+		auto binary_labels=new CBinaryLabels(labels);
+
+		m_kernel=new CGaussianKernel(10, 1.0);
+		SG_REF(m_kernel);
+		m_svm=new CLibSVM(1.0, m_kernel, binary_labels);
+		SG_REF(m_svm);
+
+		// time series splitting only draws random numbers to shuffle the
+		// order of the folds, which does not change the mean accuracy, so
+		// the results do not depend on the order of the evaluations
+		auto splitting=new CTimeSeriesSplitting(binary_labels, 4);
+		auto criterion=new CContingencyTableEvaluation(ACCURACY);
+		m_cross_validation=new CountingCrossValidation(
+				m_svm, features, binary_labels, splitting, criterion);
+		SG_REF(m_cross_validation);
+
+		m_model_parameters=new CModelSelectionParameters();
+		auto c1=new CModelSelectionParameters("C1");
+		c1->build_values(-2.0, 2.0, R_EXP);
+		m_model_parameters->append_child(c1);
+
+		auto param_kernel=new CModelSelectionParameters("kernel", m_kernel);
+		auto width=new CModelSelectionParameters("log_width");
+		width->build_values(-1.0, 1.0, R_LINEAR, 1.0);
+		param_kernel->append_child(width);
+		m_model_parameters->append_child(param_kernel);
+		SG_REF(m_model_parameters);
+	}
+
+	virtual void TearDown()
+	{
+		SG_UNREF(m_model_parameters);
+		SG_UNREF(m_cross_validation);
+		SG_UNREF(m_svm);
+		SG_UNREF(m_kernel);
+	}
+
+	/** apply a combination and read back the parameters it sets */
+	void get_parameters(CParameterCombination* combination, float64_t& C,
+			float64_t& width)
+	{
+		ASSERT_NE(combination, nullptr);
+		combination->apply_to_machine(m_svm);
+		C=m_svm->get_C1();
+		auto kernel=(CGaussianKernel*)m_svm->get_kernel();
+		width=kernel->get_width();
+		SG_UNREF(kernel);
+	}
+
+	CGaussianKernel* m_kernel;
+	CLibSVM* m_svm;
+	CountingCrossValidation* m_cross_validation;
+	CModelSelectionParameters* m_model_parameters;
+};
+
+TEST_F(GridSearchModelSelectionTest, concurrent_evaluation_matches_serial)
+{
+	auto grid_search=new CGridSearchModelSelection(
+			m_cross_validation, m_model_parameters);
+	SG_REF(grid_search);
+
+	float64_t C, width;
+	auto serial=grid_search->select_model();
+	get_parameters(serial, C, width);
+	SG_UNREF(serial);
+
+	grid_search->set_num_concurrent_evaluations(3);
+	auto concurrent=grid_search->select_model();
+	float64_t concurrent_C, concurrent_width;
+	get_parameters(concurrent, concurrent_C, concurrent_width);
+	SG_UNREF(concurrent);
+
+	EXPECT_EQ(C, concurrent_C);
+	EXPECT_EQ(width, concurrent_width);
+
+	// the kernel matrix is only kept during the search
+	EXPECT_FALSE(m_svm->get_reuse_locked_kernel());
+
+	SG_UNREF(grid_search);
+}
+
+TEST_F(GridSearchModelSelectionTest, successive_halving)
+{
+	auto grid_search=new CGridSearchModelSelection(
+			m_cross_validation, m_model_parameters);
+	SG_REF(grid_search);
+
+	EXPECT_ANY_THROW(grid_search->set_halving_rate(1));
+	grid_search->set_halving_rate(2);
+
+	auto best=grid_search->select_model();
+	EXPECT_NE(best, nullptr);
+	SG_UNREF(best);
+
+	// 5x3 combinations on one fold, the best 8 on two, the best 4 on all
+	auto& num_evaluations=m_cross_validation->num_evaluations;
+	EXPECT_EQ(num_evaluations.size(), 3u);
+	EXPECT_EQ(num_evaluations[1], 15);
+	EXPECT_EQ(num_evaluations[2], 8);
+	EXPECT_EQ(num_evaluations[4], 4);
+
+	// the cross-validation evaluates all folds again afterwards
+	EXPECT_EQ(m_cross_validation->get_num_evaluated_folds(), 0);
+
+	SG_UNREF(grid_search);
+}
+
+TEST_F(GridSearchModelSelectionTest, reused_kernel_matrix_gives_same_result)
+{
+	auto result=(CCrossValidationResult*)m_cross_validation->evaluate();
+	float64_t mean=result->get_mean();
+	SG_UNREF(result);
+
+	// the second evaluation locks on the kept kernel matrix
+	m_svm->set_reuse_locked_kernel(true);
+	for (int32_t i=0; i<2; i++)
+	{
+		result=(CCrossValidationResult*)m_cross_validation->evaluate();
+		EXPECT_NEAR(result->get_mean(), mean, 1e-12);
+		SG_UNREF(result);
+	}
+
+	// a changed kernel parameter invalidates the kept matrix
+	m_kernel->set_width(100.0);
+	auto reused=(CCrossValidationResult*)m_cross_validation->evaluate();
+	m_svm->set_reuse_locked_kernel(false);
+	auto recomputed=(CCrossValidationResult*)m_cross_validation->evaluate();
+	EXPECT_NEAR(reused->get_mean(), recomputed->get_mean(), 1e-12);
+	SG_UNREF(reused);
+	SG_UNREF(recomputed);
+}
@@ -0,0 +1,164 @@
+/*
+ * This software is distributed under BSD 3-clause license (see LICENSE file).
+ */
+
+#include <gtest/gtest.h>
+
+#include <shogun/distance/EuclideanDistance.h>
+#include <shogun/features/DenseFeatures.h>
+#include <shogun/mathematics/Math.h>
+#include <shogun/multiclass/HNSWIndex.h>
+
+#include <algorithm>
+#include <set>
+
+using namespace shogun;
+
+class HNSWIndexTest : public ::testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		CMath::init_random(17);
+		SGMatrix<float64_t> data(dim, num_train);
+		SGMatrix<float64_t> queries(dim, num_test);
+		for (index_t i=0; i<data.num_rows*data.num_cols; i++)
+			data.matrix[i]=CMath::randn_double();
+		for (index_t i=0; i<queries.num_rows*queries.num_cols; i++)
+			queries.matrix[i]=CMath::randn_double();
+
+		features=new CDenseFeatures<float64_t>(data);
+		SG_REF(features);
+		features_test=new CDenseFeatures<float64_t>(queries);
+		SG_REF(features_test);
+		distance=new CEuclideanDistance(features, features_test);
+		SG_REF(distance);
+	}
+
+	virtual void TearDown()
+	{
+		SG_UNREF(distance);
+		SG_UNREF(features_test);
+		SG_UNREF(features);
+	}
+
+	/** @return fraction of the exact k nearest neighbors that are found */
+	float64_t recall(SGMatrix<index_t> found)
+	{
+		index_t num_hits=0;
+		SGVector<float64_t> dists(num_train);
+		SGVector<index_t> order(num_train);
+		for (index_t i=0; i<num_test; i++)
+		{
+			for (index_t j=0; j<num_train; j++)
+			{
+				dists[j]=distance->distance(j, i);
+				order[j]=j;
+			}
+			CMath::qsort_index(dists.vector, order.vector, num_train);
+
+			std::set<index_t> exact(order.vector, order.vector+k);
+			for (index_t j=0; j<k; j++)
+				num_hits+=exact.count(found(j, i));
+		}
+
+		return float64_t(num_hits)/(k*num_test);
+	}
+
+	const index_t num_train=500;
+	const index_t num_test=50;
+	const index_t dim=16;
+	const int32_t k=5;
+
+	CDenseFeatures<float64_t>* features;
+	CDenseFeatures<float64_t>* features_test;
+	CDistance* distance;
+};
+
+TEST_F(HNSWIndexTest, recall)
+{
+	auto index=some<CHNSWIndex>(8, 100);
+	index->build(distance);
+	EXPECT_EQ(index->get_num_points(), num_train);
+
+	// building must not change the queries of the distance
+	EXPECT_EQ(distance->get_num_vec_rhs(), num_test);
+
+	index->set_ef_search(100);
+	index->query_knn(distance, k);
+	SGMatrix<index_t> found=index->get_knn_indices();
+	SGMatrix<float64_t> dists=index->get_knn_dists();
+	EXPECT_GE(recall(found), 0.95);
+
+	for (index_t i=0; i<num_test; i++)
+	{
+		for (index_t j=0; j<k; j++)
+		{
+			EXPECT_NEAR(dists(j, i), distance->distance(found(j, i), i), 1e-12);
+		}
+		for (index_t j=1; j<k; j++)
+			EXPECT_LE(dists(j-1, i), dists(j, i));
+	}
+}
+
+TEST_F(HNSWIndexTest, incremental_insertion)
+{
+	auto index=some<CHNSWIndex>(8, 100);
+	index->set_ef_search(100);
+
+	// index the first half, then the rest of the same features
+	SGVector<index_t> first_half(num_train/2);
+	first_half.range_fill();
+	features->add_subset(first_half);
+	distance->init(features, features_test);
+	index->build(distance);
+	EXPECT_EQ(index->get_num_points(), num_train/2);
+
+	features->remove_subset();
+	distance->init(features, features_test);
+	index->add_points(distance);
+	EXPECT_EQ(index->get_num_points(), num_train);
+
+	index->query_knn(distance, k);
+	EXPECT_GE(recall(index->get_knn_indices()), 0.95);
+
+	// fewer vectors than indexed points
+	features->add_subset(first_half);
+	distance->init(features, features_test);
+	EXPECT_ANY_THROW(index->add_points(distance));
+	features->remove_subset();
+	distance->init(features, features_test);
+}
+
+TEST_F(HNSWIndexTest, clone_keeps_graph)
+{
+	auto index=some<CHNSWIndex>(8, 100);
+	index->build(distance);
+	index->query_knn(distance, k);
+	SGMatrix<index_t> found=index->get_knn_indices();
+
+	auto copy=(CHNSWIndex*)index->clone();
+	EXPECT_EQ(copy->get_num_points(), num_train);
+	copy->query_knn(distance, k);
+	SGMatrix<index_t> copy_found=copy->get_knn_indices();
+	for (index_t i=0; i<found.num_rows*found.num_cols; i++)
+		EXPECT_EQ(found.matrix[i], copy_found.matrix[i]);
+
+	SG_UNREF(copy);
+}
+
+TEST_F(HNSWIndexTest, parameters)
+{
+	auto index=some<CHNSWIndex>();
+	EXPECT_ANY_THROW(index->set_max_connections(1));
+	EXPECT_ANY_THROW(index->set_ef_search(0));
+	EXPECT_ANY_THROW(index->query_knn(distance, k));
+
+	index->build(distance);
+	EXPECT_ANY_THROW(index->set_max_connections(4));
+	EXPECT_ANY_THROW(index->query_knn(distance, num_train+1));
+
+	index->clear();
+	EXPECT_EQ(index->get_num_points(), 0);
+	index->set_max_connections(4);
+}
@@ -93,6 +93,31 @@ TEST_F(KNNTest, brute_solver)
 	SG_UNREF(output);
 }
 
+TEST_F(KNNTest, batched_nearest_neighbors)
+{
+	auto knn = some<CKNN>(k, distance, labels, KNN_BRUTE);
+	knn->train(features);
+	distance->init(features, features_test);
+
+	// several partial tiles in both directions
+	knn->set_batch_size(7);
+	SGMatrix<index_t> batched = knn->nearest_neighbors();
+	knn->set_batch_size(0);
+	SGMatrix<index_t> pairwise = knn->nearest_neighbors();
+
+	// duplicated vectors make the indices of ties arbitrary, so compare the
+	// distances of the neighbors
+	for (index_t i = 0; i < batched.num_cols; ++i)
+	{
+		for (index_t j = 0; j < k; ++j)
+		{
+			EXPECT_NEAR(
+			    distance->distance(batched(j, i), i),
+			    distance->distance(pairwise(j, i), i), 1e-10);
+		}
+	}
+}
+
 TEST_F(KNNTest, kdtree_solver)
 {
 	auto knn = some<CKNN>(k, distance, labels, KNN_KDTREE);
@@ -119,6 +144,51 @@ TEST_F(KNNTest, lsh_solver)
 	SG_UNREF(output);
 }
 
+TEST_F(KNNTest, hnsw_solver)
+{
+	auto knn = some<CKNN>(k, distance, labels, KNN_HNSW);
+	knn->set_hnsw_parameters(4, 50, 20);
+	knn->train(features);
+	auto output = knn->apply(features_test)->as<CMulticlassLabels>();
+	SG_REF(output);
+
+	for ( index_t i = 0; i < labels_test->get_num_labels(); ++i )
+		EXPECT_EQ(output->get_label(i), ((CMulticlassLabels*)labels_test)->get_label(i));
+
+	SG_UNREF(output);
+}
+
+TEST_F(KNNTest, hnsw_solver_all_neighbors)
+{
+	// a sparse graph which the search can hardly cover completely, queries
+	// for which it does not are answered by brute force
+	SGMatrix<float64_t> feat=CDataGenerator::generate_gaussians(10, classes, feats);
+	SGVector<float64_t> lab(10*classes);
+	for (index_t i=0; i<lab.vlen; i++)
+		lab[i]=i/10;
+	auto train_features=new CDenseFeatures<float64_t>(feat);
+	auto train_labels=new CMulticlassLabels(lab);
+	SG_REF(train_features);
+
+	auto brute=some<CKNN>(lab.vlen, distance, train_labels, KNN_BRUTE);
+	brute->train(train_features);
+	brute->set_distance(new CEuclideanDistance(train_features, features_test));
+	SGMatrix<int32_t> expected=brute->classify_for_multiple_k();
+
+	auto hnsw=some<CKNN>(lab.vlen, distance, train_labels, KNN_HNSW);
+	hnsw->set_hnsw_parameters(2, 1, 1);
+	hnsw->train(train_features);
+	hnsw->set_distance(new CEuclideanDistance(train_features, features_test));
+	SGMatrix<int32_t> output=hnsw->classify_for_multiple_k();
+
+	ASSERT_EQ(output.num_rows, expected.num_rows);
+	ASSERT_EQ(output.num_cols, expected.num_cols);
+	for (index_t i=0; i<output.num_rows*output.num_cols; i++)
+		EXPECT_EQ(output.matrix[i], expected.matrix[i]);
+
+	SG_UNREF(train_features);
+}
+
 TEST_F(KNNTest, lsh_solver_sparse)
 {
 	auto knn = some<CKNN>(k, distance, labels, KNN_LSH);
@@ -637,3 +637,169 @@ TEST(CARTree,cv_prune_simple)
 	SG_UNREF(c);
 	SG_UNREF(root);
 }
+
+TEST(CARTree, histogram_splits_classification)
+{
+	const index_t num_vecs=200;
+	CMath::init_random(7);
+
+	// few distinct values, so that every value gets its own bin
+	SGMatrix<float64_t> data(3,num_vecs);
+	SGVector<float64_t> lab(num_vecs);
+	for (index_t i=0;i<num_vecs;++i)
+	{
+		for (index_t j=0;j<3;++j)
+			data(j,i)=CMath::random(0,7);
+
+		lab[i]=(data(0,i)>=4 ? 1.0 : 0.0)+(data(2,i)>=6 ? 1.0 : 0.0);
+	}
+
+	auto feats=some<CDenseFeatures<float64_t>>(data);
+	auto labels=some<CMulticlassLabels>(lab);
+	SGVector<bool> ft(3);
+	ft.set_const(false);
+
+	auto exact=some<CCARTree>(ft, PT_MULTICLASS);
+	exact->set_labels(labels);
+	exact->train(feats);
+
+	auto binned=some<CCARTree>(ft, PT_MULTICLASS);
+	binned->set_num_bins(16);
+	binned->set_labels(labels);
+	binned->train(feats);
+
+	auto res_exact=wrap(exact->apply_multiclass(feats));
+	auto res_binned=wrap(binned->apply_multiclass(feats));
+	for (index_t i=0;i<num_vecs;++i)
+	{
+		EXPECT_EQ(lab[i], res_binned->get_label(i));
+		EXPECT_EQ(res_exact->get_label(i), res_binned->get_label(i));
+	}
+}
+
+TEST(CARTree, histogram_splits_regression)
+{
+	const index_t num_vecs=500;
+	CMath::init_random(7);
+
+	SGMatrix<float64_t> data(2,num_vecs);
+	SGVector<float64_t> lab(num_vecs);
+	for (index_t i=0;i<num_vecs;++i)
+	{
+		data(0,i)=CMath::randn_double();
+		data(1,i)=CMath::randn_double();
+		lab[i]=(data(1,i)>0.5) ? 2.0 : -1.0;
+	}
+
+	auto feats=some<CDenseFeatures<float64_t>>(data);
+	auto labels=some<CRegressionLabels>(lab);
+	SGVector<bool> ft(2);
+	ft.set_const(false);
+
+	auto c=some<CCARTree>(ft, PT_REGRESSION);
+	c->set_num_bins(32);
+	c->set_max_depth(1);
+	c->set_labels(labels);
+	c->train(feats);
+
+	SGMatrix<float64_t> test(2,2);
+	test(0,0)=0.0;
+	test(1,0)=-2.0;
+	test(0,1)=0.0;
+	test(1,1)=2.0;
+
+	auto test_feats=some<CDenseFeatures<float64_t>>(test);
+	auto result=wrap(c->apply_regression(test_feats));
+	EXPECT_NEAR(-1.0, result->get_label(0), 0.3);
+	EXPECT_NEAR(2.0, result->get_label(1), 0.3);
+}
+
+TEST(CARTree, histogram_splits_nominal)
+{
+	// more categories than fit into the split code of an exhaustive search
+	const index_t num_categories=70;
+	const index_t num_vecs=10*num_categories;
+	CMath::init_random(7);
+
+	SGVector<float64_t> group(num_categories);
+	for (index_t c=0;c<num_categories;++c)
+		group[c]=CMath::random(0,1);
+
+	SGMatrix<float64_t> data(2,num_vecs);
+	SGVector<float64_t> lab(num_vecs);
+	SGVector<float64_t> lab_regression(num_vecs);
+	for (index_t i=0;i<num_vecs;++i)
+	{
+		index_t c=i%num_categories;
+		data(0,i)=c;
+		data(1,i)=CMath::randn_double();
+		lab[i]=group[c];
+		lab_regression[i]=c%3;
+	}
+
+	auto feats=some<CDenseFeatures<float64_t>>(data);
+	SGVector<bool> ft(2);
+	ft[0]=true;
+	ft[1]=false;
+
+	// ordering the categories by class fraction finds the perfect split
+	auto c=some<CCARTree>(ft, PT_MULTICLASS);
+	c->set_num_bins(128);
+	c->set_max_depth(1);
+	c->set_labels(some<CMulticlassLabels>(lab));
+	c->train(feats);
+
+	auto result=wrap(c->apply_multiclass(feats));
+	for (index_t i=0;i<num_vecs;++i)
+		EXPECT_EQ(lab[i], result->get_label(i));
+
+	// ordering by mean label separates the three levels in two splits
+	auto r=some<CCARTree>(ft, PT_REGRESSION);
+	r->set_num_bins(128);
+	r->set_max_depth(2);
+	r->set_labels(some<CRegressionLabels>(lab_regression));
+	r->train(feats);
+
+	auto result_regression=wrap(r->apply_regression(feats));
+	for (index_t i=0;i<num_vecs;++i)
+		EXPECT_NEAR(lab_regression[i], result_regression->get_label(i), 1E-10);
+}
+
+TEST(CARTree, histogram_splits_nominal_multiclass)
+{
+	const index_t num_vecs=120;
+	CMath::init_random(7);
+
+	// few categories and three classes, all divisions are tested
+	SGMatrix<float64_t> data(2,num_vecs);
+	SGVector<float64_t> lab(num_vecs);
+	for (index_t i=0;i<num_vecs;++i)
+	{
+		data(0,i)=i%6;
+		data(1,i)=CMath::randn_double();
+		lab[i]=(i%6)%3;
+	}
+
+	auto feats=some<CDenseFeatures<float64_t>>(data);
+	auto labels=some<CMulticlassLabels>(lab);
+	SGVector<bool> ft(2);
+	ft[0]=true;
+	ft[1]=false;
+
+	auto exact=some<CCARTree>(ft, PT_MULTICLASS);
+	exact->set_labels(labels);
+	exact->train(feats);
+
+	auto binned=some<CCARTree>(ft, PT_MULTICLASS);
+	binned->set_num_bins(8);
+	binned->set_labels(labels);
+	binned->train(feats);
+
+	auto res_exact=wrap(exact->apply_multiclass(feats));
+	auto res_binned=wrap(binned->apply_multiclass(feats));
+	for (index_t i=0;i<num_vecs;++i)
+	{
+		EXPECT_EQ(lab[i], res_binned->get_label(i));
+		EXPECT_EQ(res_exact->get_label(i), res_binned->get_label(i));
+	}
+}
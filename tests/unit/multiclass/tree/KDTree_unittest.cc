@@ -120,3 +120,51 @@ TEST(KDTree, knn_query)
 	SG_UNREF(feats);
 	SG_UNREF(tree);
 }
+
+TEST(KDTree, knn_query_dual_and_single_precision)
+{
+	index_t num_vectors=200;
+	SGMatrix<float64_t> data(3,num_vectors);
+	for (index_t i=0;i<num_vectors;i++)
+	{
+		data(0,i)=std::sin(0.7*i);
+		data(1,i)=std::cos(1.3*i);
+		data(2,i)=std::sin(2.9*i+1);
+	}
+
+	CDenseFeatures<float64_t>* feats=new CDenseFeatures<float64_t>(data);
+	int32_t k=5;
+
+	CKDTree* tree=new CKDTree(4);
+	tree->build_tree(feats);
+	tree->query_knn(feats,k);
+	SGMatrix<float64_t> dists=tree->get_knn_dists();
+
+	// all-knn with a query tree over the same vectors
+	CKDTree* query_tree=new CKDTree(4);
+	query_tree->build_tree(feats);
+	CBinaryTreeMachineNode<NbodyTreeNodeData>* qroot=dynamic_cast<CBinaryTreeMachineNode<NbodyTreeNodeData>*>(query_tree->get_root());
+	tree->query_knn_dual(data,query_tree->get_rearranged_vector_ids(),qroot,k);
+	SGMatrix<float64_t> dual_dists=tree->get_knn_dists();
+
+	CKDTree* tree32=new CKDTree(4);
+	tree32->set_single_precision(true);
+	tree32->build_tree(feats);
+	tree32->query_knn(feats,k);
+	SGMatrix<float64_t> dists32=tree32->get_knn_dists();
+
+	for (index_t i=0;i<num_vectors;i++)
+	{
+		for (int32_t j=0;j<k;j++)
+		{
+			EXPECT_NEAR(dists(j,i),dual_dists(j,i),1e-12);
+			EXPECT_NEAR(dists(j,i),dists32(j,i),1e-5);
+		}
+	}
+
+	SG_UNREF(qroot);
+	SG_UNREF(query_tree);
+	SG_UNREF(tree32);
+	SG_UNREF(tree);
+	SG_UNREF(feats);
+}
@@ -265,4 +265,117 @@ TEST_F(RandomForest, score_consistent_with_binary_trivial_data)
 	EXPECT_NEAR(1.0, values_vector[9], 1e-1);
 
 	SG_UNREF(result);
-}
\ No newline at end of file
+}
+
+TEST_F(RandomForest, compiled_trees_predict_identically)
+{
+	CRandomForest* c =
+	    new CRandomForest(weather_features_train, weather_labels_train, 20, 2);
+	c->set_feature_types(weather_ft);
+	CMajorityVote* mv = new CMajorityVote();
+	c->set_combination_rule(mv);
+	c->train(weather_features_train);
+
+	CMulticlassLabels* result = c->apply_multiclass(weather_features_test);
+	EXPECT_FALSE(c->is_compiled());
+
+	c->compile_trees();
+	EXPECT_TRUE(c->is_compiled());
+	CMulticlassLabels* compiled = c->apply_multiclass(weather_features_test);
+
+	for (index_t i = 0; i < result->get_num_labels(); ++i)
+	{
+		EXPECT_EQ(result->get_label(i), compiled->get_label(i));
+		SGVector<float64_t> conf = result->get_multiclass_confidences(i);
+		SGVector<float64_t> compiled_conf =
+		    compiled->get_multiclass_confidences(i);
+		for (index_t j = 0; j < conf.vlen; ++j)
+			EXPECT_EQ(conf[j], compiled_conf[j]);
+	}
+
+	// retraining drops the compiled trees
+	c->train(weather_features_train);
+	EXPECT_FALSE(c->is_compiled());
+
+	SG_UNREF(compiled);
+	SG_UNREF(result);
+	SG_UNREF(c);
+}
+
+TEST_F(RandomForest, compiled_trees_regression)
+{
+	int32_t num_vecs = 300;
+	SGMatrix<float64_t> data(2, num_vecs);
+	SGVector<float64_t> lab(num_vecs);
+	for (index_t i = 0; i < num_vecs; ++i)
+	{
+		data(0, i) = CMath::random(0.0, 10.0);
+		data(1, i) = CMath::random(0.0, 10.0);
+		lab[i] = std::sin(data(0, i)) + data(1, i);
+	}
+
+	CDenseFeatures<float64_t>* feats = new CDenseFeatures<float64_t>(data);
+	CRegressionLabels* labels = new CRegressionLabels(lab);
+	SGVector<bool> ft(2);
+	ft.set_const(false);
+
+	CRandomForest* c = new CRandomForest(feats, labels, 10, 1);
+	c->set_feature_types(ft);
+	c->set_machine_problem_type(PT_REGRESSION);
+	c->set_combination_rule(new CMeanRule());
+	c->train(feats);
+
+	CRegressionLabels* result = c->apply_regression(feats);
+	c->compile_trees();
+	EXPECT_EQ(c->get_num_bags(), 10);
+	CRegressionLabels* compiled = c->apply_regression(feats);
+
+	for (index_t i = 0; i < num_vecs; ++i)
+		EXPECT_EQ(result->get_label(i), compiled->get_label(i));
+
+	SG_UNREF(compiled);
+	SG_UNREF(result);
+	SG_UNREF(c);
+}
+
+TEST_F(RandomForest, histogram_splits)
+{
+	const index_t num_categories = 80;
+	const index_t num_vecs = 10 * num_categories;
+
+	SGVector<float64_t> group(num_categories);
+	for (index_t c = 0; c < num_categories; ++c)
+		group[c] = CMath::random(0, 1);
+
+	// a nominal attribute with many categories and a continuous one
+	SGMatrix<float64_t> data(2, num_vecs);
+	SGVector<float64_t> lab(num_vecs);
+	for (index_t i = 0; i < num_vecs; ++i)
+	{
+		index_t c = i % num_categories;
+		data(0, i) = c;
+		data(1, i) = CMath::random(0.0, 10.0);
+		lab[i] = group[c];
+	}
+
+	CDenseFeatures<float64_t>* feats = new CDenseFeatures<float64_t>(data);
+	CMulticlassLabels* labels = new CMulticlassLabels(lab);
+	SGVector<bool> ft(2);
+	ft[0] = true;
+	ft[1] = false;
+
+	CRandomForest* c = new CRandomForest(feats, labels, 10, 2);
+	c->set_feature_types(ft);
+	c->set_combination_rule(new CMajorityVote());
+	c->set_num_bins(128);
+	EXPECT_EQ(c->get_num_bins(), 128);
+	c->train(feats);
+
+	CMulticlassLabels* result = c->apply_multiclass(feats);
+	CMulticlassAccuracy* eval = new CMulticlassAccuracy();
+	EXPECT_GT(eval->evaluate(result, labels), 0.95);
+
+	SG_UNREF(eval);
+	SG_UNREF(result);
+	SG_UNREF(c);
+}